@@ -0,0 +1,215 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#include "BlueprintHttpAssetCache.h"
+
+namespace BlueprintHttpAssetCache
+{
+	// Smaller files don't gain enough to be worth a variant.
+	static constexpr size_t MinGzipSize = 256;
+
+	static bool Gzip(const std::string& Input, std::string& Output)
+	{
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+		z_stream Stream;
+		FMemory::Memzero(Stream);
+
+		// Compressed once per load, so spend the time on the best ratio.
+		if (deflateInit2(&Stream, Z_BEST_COMPRESSION, Z_DEFLATED, 31, 9, Z_DEFAULT_STRATEGY) != Z_OK)
+		{
+			return false;
+		}
+
+		Output.resize(deflateBound(&Stream, static_cast<uLong>(Input.size())));
+
+		Stream.next_in	 = reinterpret_cast<Bytef*>(const_cast<char*>(Input.data()));
+		Stream.avail_in	 = static_cast<uInt>(Input.size());
+		Stream.next_out	 = reinterpret_cast<Bytef*>(&Output[0]);
+		Stream.avail_out = static_cast<uInt>(Output.size());
+
+		const int Result = deflate(&Stream, Z_FINISH);
+		Output.resize(Stream.total_out);
+		deflateEnd(&Stream);
+
+		return Result == Z_STREAM_END;
+#else
+		return false;
+#endif
+	}
+}
+
+FBlueprintHttpAssetCache::FBlueprintHttpAssetCache(const int64 InMaxBytes, const int64 InMaxFileBytes)
+	: MaxBytes(InMaxBytes)
+	, MaxFileBytes(FMath::Min(InMaxFileBytes, InMaxBytes))
+	, Bytes(0)
+	, Hits(0)
+	, Misses(0)
+	, Evictions(0)
+{
+}
+
+bool FBlueprintHttpAssetCache::Serve(const httplib::Request& Request, httplib::Response& Response, const httplib::Server::FileInfo& File)
+{
+	if (static_cast<int64>(File.size) > MaxFileBytes)
+	{
+		return false;
+	}
+
+	FEntryPtr Entry = Find(File);
+
+	if (Entry)
+	{
+		Hits++;
+	}
+	else
+	{
+		Misses++;
+
+		Entry = Load(File);
+		if (!Entry)
+		{
+			return false;
+		}
+
+		Insert(File.path, Entry);
+	}
+
+	// Ranges are always taken from the identity variant.
+	const bool bGzip = !Entry->Gzip.empty() && !Request.has_header("Range")
+		&& httplib::detail::accepts_encoding(Request.get_header_value("Accept-Encoding"), "gzip");
+
+	if (!Entry->Gzip.empty())
+	{
+		httplib::detail::add_vary(Response, "Accept-Encoding");
+	}
+
+	if (bGzip)
+	{
+		Response.set_header("Content-Encoding", "gzip");
+
+		// Validated by a tag of its own, the file's one belongs to the identity variant.
+		httplib::detail::make_encoded_etag(Response, "gzip");
+	}
+
+	const std::string& Content = bGzip ? Entry->Gzip : Entry->Identity;
+
+	if (Content.empty())
+	{
+		Response.set_header("Content-Type", Entry->ContentType);
+		return true;
+	}
+
+	// Written straight from the entry, which lives as long as the provider.
+	Response.set_content_provider(Content.size(), Entry->ContentType.c_str(),
+		[Entry, Data = Content.data()](size_t Offset, size_t Length, httplib::DataSink& Sink) -> bool
+	{
+		Sink.write(Data + Offset, Length);
+		return true;
+	});
+
+	return true;
+}
+
+FHttpServerAssetCacheStats FBlueprintHttpAssetCache::GetStats() const
+{
+	FHttpServerAssetCacheStats Stats;
+
+	Stats.Hits		= Hits.load();
+	Stats.Misses	= Misses.load();
+	Stats.Evictions = Evictions.load();
+
+	const int64 Requests = Stats.Hits + Stats.Misses;
+	Stats.HitRate = Requests > 0 ? static_cast<float>(static_cast<double>(Stats.Hits) / Requests) : 0.f;
+
+	FScopeLock Lock(&Mutex);
+	Stats.Entries	  = static_cast<int32>(Entries.size());
+	Stats.MemoryBytes = Bytes;
+
+	return Stats;
+}
+
+FBlueprintHttpAssetCache::FEntryPtr FBlueprintHttpAssetCache::Find(const httplib::Server::FileInfo& File)
+{
+	FScopeLock Lock(&Mutex);
+
+	auto Slot = Entries.find(File.path);
+	if (Slot == Entries.end())
+	{
+		return nullptr;
+	}
+
+	const FEntry& Entry = *Slot->second.Entry;
+	if (Entry.Size != File.size || Entry.ModificationTime != File.mtime)
+	{
+		Remove(Slot);
+		return nullptr;
+	}
+
+	Lru.splice(Lru.begin(), Lru, Slot->second.LruPosition);
+
+	return Slot->second.Entry;
+}
+
+FBlueprintHttpAssetCache::FEntryPtr FBlueprintHttpAssetCache::Load(const httplib::Server::FileInfo& File)
+{
+	httplib::detail::mmap Mapped(File.path.c_str());
+
+	// The file changed since httplib checked it.
+	if (!Mapped.is_open() || Mapped.size() != File.size)
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<FEntry> Entry = std::make_shared<FEntry>();
+
+	Entry->Size				= File.size;
+	Entry->ModificationTime = File.mtime;
+	Entry->ContentType		= File.content_type ? File.content_type : "application/octet-stream";
+	Entry->Identity.assign(Mapped.data(), Mapped.size());
+
+	if (Entry->Size >= BlueprintHttpAssetCache::MinGzipSize && httplib::detail::can_compress_content_type(Entry->ContentType))
+	{
+		if (!BlueprintHttpAssetCache::Gzip(Entry->Identity, Entry->Gzip) || Entry->Gzip.size() >= Entry->Identity.size())
+		{
+			Entry->Gzip.clear();
+			Entry->Gzip.shrink_to_fit();
+		}
+	}
+
+	Entry->Cost = static_cast<int64>(Entry->Identity.size() + Entry->Gzip.size() + File.path.size());
+
+	return Entry;
+}
+
+void FBlueprintHttpAssetCache::Insert(const std::string& Path, const FEntryPtr& Entry)
+{
+	if (Entry->Cost > MaxBytes)
+	{
+		return;
+	}
+
+	FScopeLock Lock(&Mutex);
+
+	// Another worker may have loaded it meanwhile.
+	auto Existing = Entries.find(Path);
+	if (Existing != Entries.end())
+	{
+		Remove(Existing);
+	}
+
+	while (Bytes + Entry->Cost > MaxBytes && !Lru.empty())
+	{
+		Remove(Entries.find(Lru.back()));
+		Evictions++;
+	}
+
+	Lru.push_front(Path);
+	Entries.emplace(Path, FSlot{ Entry, Lru.begin() });
+	Bytes += Entry->Cost;
+}
+
+void FBlueprintHttpAssetCache::Remove(std::unordered_map<std::string, FSlot>::iterator Slot)
+{
+	Bytes -= Slot->second.Entry->Cost;
+	Lru.erase(Slot->second.LruPosition);
+	Entries.erase(Slot);
+}
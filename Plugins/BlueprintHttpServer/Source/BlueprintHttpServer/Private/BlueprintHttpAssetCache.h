@@ -0,0 +1,102 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BlueprintHttpServer.h"
+
+#include "BlueprintHttpLib.h"
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/**
+ * In-memory cache of the files served by mount points.
+ * Entries are checked against the file size and modification time on each
+ * request, so edited files are reloaded. Compressible files also keep a gzip
+ * variant made once when loaded, served to clients accepting it.
+ * The least recently used entries are evicted to stay under the byte budget.
+*/
+class FBlueprintHttpAssetCache final
+{
+public:
+	/**
+	 * @param InMaxBytes	 The memory budget of all the entries.
+	 * @param InMaxFileBytes Larger files are never cached.
+	*/
+	FBlueprintHttpAssetCache(const int64 InMaxBytes, const int64 InMaxFileBytes);
+
+	/**
+	 * Serves a mounted file from the cache, loading it on a miss.
+	 * Called by httplib before it opens the file.
+	 * @return False if the file isn't cached and couldn't be loaded.
+	*/
+	bool Serve(const httplib::Request& Request, httplib::Response& Response, const httplib::Server::FileInfo& File);
+
+	/**
+	 * Gets the hit rate and memory use of the cache.
+	*/
+	FHttpServerAssetCacheStats GetStats() const;
+
+private:
+	struct FEntry
+	{
+		size_t Size;
+		time_t ModificationTime;
+
+		std::string ContentType;
+		std::string Identity;
+
+		/**
+		 * Empty if the file isn't compressible or didn't get smaller.
+		*/
+		std::string Gzip;
+
+		int64 Cost;
+	};
+
+	using FEntryPtr = std::shared_ptr<const FEntry>;
+
+	struct FSlot
+	{
+		FEntryPtr Entry;
+		std::list<std::string>::iterator LruPosition;
+	};
+
+	/**
+	 * Finds a valid entry and marks it as recently used. Drops it if stale.
+	*/
+	FEntryPtr Find(const httplib::Server::FileInfo& File);
+
+	/**
+	 * Reads and compresses the file, nullptr if it changed while being read.
+	*/
+	static FEntryPtr Load(const httplib::Server::FileInfo& File);
+
+	void Insert(const std::string& Path, const FEntryPtr& Entry);
+
+	// Mutex must be held.
+	void Remove(std::unordered_map<std::string, FSlot>::iterator Slot);
+
+private:
+	const int64 MaxBytes;
+	const int64 MaxFileBytes;
+
+	mutable FCriticalSection Mutex;
+
+	std::unordered_map<std::string, FSlot> Entries;
+
+	/**
+	 * Paths from the most to the least recently used.
+	*/
+	std::list<std::string> Lru;
+
+	int64 Bytes;
+
+	std::atomic<int64> Hits;
+	std::atomic<int64> Misses;
+	std::atomic<int64> Evictions;
+};
@@ -0,0 +1,1290 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#include "BlueprintHttpServer.h"
+
+#include "BlueprintHttpLib.h"
+#include "BlueprintHttpMultipart.h"
+#include "BlueprintHttpServerModule.h"
+
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#include <algorithm>
+#include <atomic>
+#include <regex>
+#include <thread>
+
+#if PLATFORM_WINDOWS
+#	include "Windows/WindowsHWrapper.h"
+#else
+#	include <sys/resource.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////
+// HttpServer.Benchmark
+
+namespace BlueprintHttpBenchmark
+{
+	struct FScenario
+	{
+		const TCHAR* Name;
+		const char*	 Path;
+	};
+
+	// Small JSON and binary payloads, served from a worker and from the game thread.
+	static const FScenario Scenarios[] =
+	{
+		{ TEXT("json_worker"),		 "/bench/json"		 },
+		{ TEXT("json_game_thread"),	 "/bench/json/game"	 },
+		{ TEXT("image_worker"),		 "/bench/image"		 },
+		{ TEXT("image_game_thread"), "/bench/image/game" },
+	};
+
+	// A drone status as served by the control routes.
+	static const TCHAR* const DroneStatus = TEXT("{\"id\":\"drone-07\",\"state\":\"flying\",\"battery\":0.82,\"position\":{\"x\":1520.5,\"y\":-340.25,\"z\":880.0},\"heading\":271.5,\"speed\":12.4}");
+
+	// A camera frame.
+	static constexpr int32 ImageSize = 64 * 1024;
+
+	// Only one benchmark runs at a time, it uses a fixed port.
+	static std::atomic<bool> bRunning(false);
+
+	struct FResult
+	{
+		int32  Requests = 0;
+		int32  Errors	= 0;
+		double RequestsPerSecond = 0.0;
+		float  P50 = 0.f;
+		float  P90 = 0.f;
+		float  P99 = 0.f;
+		float  P999 = 0.f;
+		double CpuMicrosecondsPerRequest = 0.0;
+	};
+
+	/**
+	 * CPU time used by all the threads of the process, in seconds.
+	*/
+	static double GetProcessCpuSeconds()
+	{
+#if PLATFORM_WINDOWS
+		FILETIME CreationTime, ExitTime, KernelTime, UserTime;
+		if (!GetProcessTimes(GetCurrentProcess(), &CreationTime, &ExitTime, &KernelTime, &UserTime))
+		{
+			return 0.0;
+		}
+
+		const auto ToSeconds = [](const FILETIME& Time) -> double
+		{
+			return ((static_cast<uint64>(Time.dwHighDateTime) << 32) | Time.dwLowDateTime) * 1e-7;
+		};
+
+		return ToSeconds(KernelTime) + ToSeconds(UserTime);
+#else
+		rusage Usage;
+		if (getrusage(RUSAGE_SELF, &Usage) != 0)
+		{
+			return 0.0;
+		}
+
+		return Usage.ru_utime.tv_sec + Usage.ru_stime.tv_sec + (Usage.ru_utime.tv_usec + Usage.ru_stime.tv_usec) * 1e-6;
+#endif
+	}
+
+	/**
+	 * Drives a route with keep-alive clients for a duration.
+	*/
+	static FResult RunScenario(const FScenario& Scenario, const int32 Port, const double Seconds, const int32 NumClients)
+	{
+		TArray<TArray<float>> LatenciesMs;
+		TArray<int32>		  Errors;
+		TArray<std::thread>	  Clients;
+
+		LatenciesMs.SetNum(NumClients);
+		Errors.SetNumZeroed(NumClients);
+
+		std::atomic<int32> NumConnected(0);
+		std::atomic<bool>  bStarted(false);
+
+		double EndTime = 0.0;
+
+		for (int32 i = 0; i < NumClients; ++i)
+		{
+			Clients.Emplace([&, i]() -> void
+			{
+				httplib::Client Client("127.0.0.1", Port);
+				Client.set_keep_alive(true);
+
+				// Not measured, opens the connection.
+				Client.Get(Scenario.Path);
+				NumConnected++;
+
+				while (!bStarted)
+				{
+					FPlatformProcess::Sleep(0.f);
+				}
+
+				while (FPlatformTime::Seconds() < EndTime)
+				{
+					const double Start = FPlatformTime::Seconds();
+					const httplib::Result Result = Client.Get(Scenario.Path);
+
+					if (Result && Result->status == 200)
+					{
+						LatenciesMs[i].Add(static_cast<float>((FPlatformTime::Seconds() - Start) * 1000.0));
+					}
+					else
+					{
+						Errors[i]++;
+					}
+				}
+			});
+		}
+
+		while (NumConnected < NumClients)
+		{
+			FPlatformProcess::Sleep(0.001f);
+		}
+
+		const double CpuStart	= GetProcessCpuSeconds();
+		const double StartTime	= FPlatformTime::Seconds();
+
+		EndTime	 = StartTime + Seconds;
+		bStarted = true;
+
+		for (std::thread& Client : Clients)
+		{
+			Client.join();
+		}
+
+		const double Elapsed = FPlatformTime::Seconds() - StartTime;
+		const double CpuUsed = GetProcessCpuSeconds() - CpuStart;
+
+		TArray<float> All;
+		FResult Result;
+
+		for (int32 i = 0; i < NumClients; ++i)
+		{
+			All.Append(LatenciesMs[i]);
+			Result.Errors += Errors[i];
+		}
+		All.Sort();
+
+		const auto Percentile = [&All](const float Fraction) -> float
+		{
+			return All.Num() > 0 ? All[FMath::Clamp(FMath::CeilToInt(Fraction * All.Num()) - 1, 0, All.Num() - 1)] : 0.f;
+		};
+
+		Result.Requests			 = All.Num();
+		Result.RequestsPerSecond = All.Num() / Elapsed;
+		Result.P50				 = Percentile(0.50f);
+		Result.P90				 = Percentile(0.90f);
+		Result.P99				 = Percentile(0.99f);
+		Result.P999				 = Percentile(0.999f);
+
+		// Includes the clients, which run in the same process.
+		Result.CpuMicrosecondsPerRequest = All.Num() > 0 ? CpuUsed * 1e6 / All.Num() : 0.0;
+
+		return Result;
+	}
+
+	static FString ToJson(const TArray<FResult>& Results, const double Seconds, const int32 NumClients)
+	{
+		FString Json = FString::Printf(TEXT("{\"seconds\":%.3f,\"clients\":%d,\"scenarios\":["), Seconds, NumClients);
+
+		for (int32 i = 0; i < Results.Num(); ++i)
+		{
+			const FResult& Result = Results[i];
+
+			Json += FString::Printf(TEXT("%s{\"name\":\"%s\",\"requests\":%d,\"errors\":%d,\"requests_per_second\":%.1f,")
+				TEXT("\"latency_ms\":{\"p50\":%.4f,\"p90\":%.4f,\"p99\":%.4f,\"p999\":%.4f},\"cpu_us_per_request\":%.2f}"),
+				i > 0 ? TEXT(",") : TEXT(""), Scenarios[i].Name, Result.Requests, Result.Errors, Result.RequestsPerSecond,
+				Result.P50, Result.P90, Result.P99, Result.P999, Result.CpuMicrosecondsPerRequest);
+		}
+
+		Json += TEXT("]}");
+
+		return Json;
+	}
+
+	static void Report(const FString& Json)
+	{
+		UE_LOG(LogHttpServer, Display, TEXT("Benchmark results: %s"), *Json);
+
+		const FString FilePath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Benchmarks"),
+			FString::Printf(TEXT("HttpServer-%s.json"), *FDateTime::Now().ToString()));
+
+		if (FFileHelper::SaveStringToFile(Json, *FilePath))
+		{
+			UE_LOG(LogHttpServer, Display, TEXT("Benchmark results saved to %s."), *FilePath);
+		}
+	}
+
+	static void AddRoutes(UBlueprintHttpServer* const Server)
+	{
+		TSharedRef<TArray<uint8>, ESPMode::ThreadSafe> Image = MakeShared<TArray<uint8>, ESPMode::ThreadSafe>();
+		Image->SetNumUninitialized(ImageSize);
+
+		// Random bytes, compress as badly as an encoded image.
+		FRandomStream Random(ImageSize);
+		for (uint8& Byte : *Image)
+		{
+			Byte = static_cast<uint8>(Random.RandRange(0, 255));
+		}
+
+		for (const bool bGameThread : { false, true })
+		{
+			Server->Get(bGameThread ? TEXT("/bench/json/game") : TEXT("/bench/json"), FHttpServerRouteCallback::CreateLambda([](const FBlueprintHttpRequest&, FBlueprintHttpResponse& Response) -> void
+			{
+				Response.SetContent(DroneStatus, TEXT("application/json"));
+				Response.Send();
+			}), bGameThread);
+
+			Server->Get(bGameThread ? TEXT("/bench/image/game") : TEXT("/bench/image"), FHttpServerRouteCallback::CreateLambda([Image](const FBlueprintHttpRequest&, FBlueprintHttpResponse& Response) -> void
+			{
+				Response.SetContent(*Image, TEXT("image/png"));
+				Response.Send();
+			}), bGameThread);
+		}
+	}
+
+	static void Run(const TArray<FString>& Args)
+	{
+		const double Seconds	= Args.Num() > 0 ? FCString::Atod(*Args[0]) : 5.0;
+		const int32  NumClients = Args.Num() > 1 ? FMath::Clamp(FCString::Atoi(*Args[1]), 1, 256) : 8;
+		const int32  Port		= Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 18480;
+
+		if (bRunning.exchange(true))
+		{
+			UE_LOG(LogHttpServer, Warning, TEXT("A benchmark is already running."));
+			return;
+		}
+
+		UBlueprintHttpServer* const Server = UBlueprintHttpServer::CreateHttpServer();
+		Server->AddToRoot();
+
+		AddRoutes(Server);
+
+		const auto Finish = [Server]() -> void
+		{
+			Server->Stop();
+			Server->RemoveFromRoot();
+			bRunning = false;
+		};
+
+		// The game thread must keep ticking to serve its routes, the clients run on their own thread.
+		Server->Listen(TEXT("127.0.0.1"), static_cast<uint16>(Port), FHttpServerListenCallback::CreateLambda([Finish, Port, Seconds, NumClients](const bool bSuccess) -> void
+		{
+			if (!bSuccess)
+			{
+				UE_LOG(LogHttpServer, Error, TEXT("Benchmark server failed to listen on port %d."), Port);
+				Finish();
+				return;
+			}
+
+			UE_LOG(LogHttpServer, Display, TEXT("Benchmarking %d scenarios for %.1f seconds each with %d clients..."), UE_ARRAY_COUNT(Scenarios), Seconds, NumClients);
+
+			Async(EAsyncExecution::Thread, [Finish, Port, Seconds, NumClients]() -> void
+			{
+				TArray<FResult> Results;
+
+				for (const FScenario& Scenario : Scenarios)
+				{
+					Results.Add(RunScenario(Scenario, Port, Seconds, NumClients));
+				}
+
+				FString Json = ToJson(Results, Seconds, NumClients);
+
+				AsyncTask(ENamedThreads::GameThread, [Finish, Json = MoveTemp(Json)]() -> void
+				{
+					Report(Json);
+					Finish();
+				});
+			});
+		}));
+	}
+}
+
+static FAutoConsoleCommand BenchmarkHttpServerCommand(
+	TEXT("HttpServer.Benchmark"),
+	TEXT("Serves JSON and binary routes from workers and from the game thread on loopback, drives each with keep-alive clients and logs req/s, latency percentiles and CPU per request as JSON, also saved under Saved/Benchmarks. Args: [SecondsPerScenario=5] [Clients=8] [Port=18480]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BlueprintHttpBenchmark::Run));
+
+//////////////////////////////////////////////////////////////////////////
+// HttpServer.BenchmarkParsers
+
+namespace BlueprintHttpParserBenchmark
+{
+	/**
+	 * The std::regex parsers httplib used, kept as the reference of the hand-written ones.
+	*/
+	namespace Regex
+	{
+		static std::string FileExtension(const std::string& Path)
+		{
+			std::smatch Match;
+			static const std::regex Re("\\.([a-zA-Z0-9]+)$");
+			return std::regex_search(Path, Match, Re) ? Match[1].str() : std::string();
+		}
+
+		static char QueryDelimiter(const char* const Path)
+		{
+			static const std::regex Re("[^?]+\\?.*");
+			return std::regex_match(Path, Re) ? '&' : '?';
+		}
+
+		static bool ContentDisposition(const std::string& Header, std::string& Name, std::string& FileName)
+		{
+			static const std::regex Re("^Content-Disposition:\\s*form-data;\\s*name=\"(.*?)\"(?:;\\s*filename=\"(.*?)\")?\\s*$", std::regex_constants::icase);
+
+			std::smatch Match;
+			if (!std::regex_match(Header, Match, Re))
+			{
+				return false;
+			}
+
+			Name	 = Match[1];
+			FileName = Match[2];
+			return true;
+		}
+
+		static bool RequestLine(const char* const Line, httplib::Request& Request)
+		{
+			static const std::regex Re(
+				"(GET|HEAD|POST|PUT|DELETE|CONNECT|OPTIONS|TRACE|PATCH|PRI) "
+				"(([^? ]+)(?:\\?([^ ]*?))?) (HTTP/1\\.[01])\r\n");
+
+			std::cmatch Match;
+			if (!std::regex_match(Line, Match, Re))
+			{
+				return false;
+			}
+
+			Request.version = std::string(Match[5]);
+			Request.method	= std::string(Match[1]);
+			Request.target	= std::string(Match[2]);
+			Request.path	= httplib::detail::decode_url(Match[3], false);
+
+			if (Match.length(4) > 0)
+			{
+				httplib::detail::parse_query_text(Match[4], Request.params);
+			}
+
+			return true;
+		}
+
+		static bool Range(const std::string& Value, httplib::Ranges& Ranges)
+		{
+			static const std::regex ReFirst(R"(bytes=(\d*-\d*(?:,\s*\d*-\d*)*))");
+			static const std::regex ReAnother(R"(\s*(\d*)-(\d*))");
+
+			std::smatch Match;
+			if (!std::regex_match(Value, Match, ReFirst))
+			{
+				return false;
+			}
+
+			bool bValid = true;
+			const size_t Position = static_cast<size_t>(Match.position(1));
+
+			httplib::detail::split(&Value[Position], &Value[Position + Match.length(1)], ',', [&](const char* Begin, const char* End) -> void
+			{
+				std::cmatch Another;
+				if (!bValid || !std::regex_match(Begin, End, Another, ReAnother))
+				{
+					return;
+				}
+
+				const ssize_t First = Another.length(1) > 0 ? static_cast<ssize_t>(std::stoll(Another.str(1))) : -1;
+				const ssize_t Last	= Another.length(2) > 0 ? static_cast<ssize_t>(std::stoll(Another.str(2))) : -1;
+
+				bValid = First == -1 || Last == -1 || First <= Last;
+				Ranges.emplace_back(First, Last);
+			});
+
+			return bValid;
+		}
+	}
+
+	// Inputs both parsers agree on. The Range parser now also accepts optional
+	// whitespace and rejects "bytes=-", which the regex didn't, so those aren't listed.
+	static const char* const Paths[] =
+	{
+		"/www/index.html", "/captures/2021-06-01/drone-07.tar.gz", "/img/frame.PNG", "/noext", "/dir.d/file",
+		"/trailing.", "/.hidden", "/a.b.c9", "/weird.ex-t", "/path/archive.7z", "",
+	};
+
+	static const char* const QueryPaths[] =
+	{
+		"/search", "/search?q=drone", "?only=query", "/a?", "/a?b?c", "", "/captures/latest?format=json&limit=10",
+	};
+
+	static const char* const Dispositions[] =
+	{
+		"Content-Disposition: form-data; name=\"field\"",
+		"content-disposition: FORM-DATA;name=\"image\"; filename=\"frame 01.png\"",
+		"Content-Disposition:form-data; name=\"a\";filename=\"\"  ",
+		"Content-Disposition: form-data; name=\"quoted\"name\"",
+		"Content-Disposition: form-data; name=\"x\"; filename=\"a\"b.png\"",
+		"Content-Disposition: form-data; name=\"x\"; other=\"y\"",
+		"Content-Disposition: attachment; name=\"x\"",
+		"Content-Disposition: form-data; name=x",
+		"Content-Disposition: form-data; name=\"",
+		"Content-Disposition: form-data; name=\"\"",
+		"Content-Type: image/png",
+	};
+
+	static const char* const RangeValues[] =
+	{
+		"bytes=0-99", "bytes=-500", "bytes=1000-", "bytes=0-0,-1", "bytes=0-9, 20-29,  40-", "bytes=5-1",
+		"bytes=", "bytes=abc", "items=0-1", "bytes=0-1;",
+	};
+
+	static const char* const RequestLines[] =
+	{
+		"GET / HTTP/1.1\r\n", "GET /api/status HTTP/1.1\r\n", "POST /drone/07/command?ack=1&mode=%41 HTTP/1.0\r\n",
+		"GET /a%20b?x HTTP/1.1\r\n", "GET /a? HTTP/1.1\r\n", "GET /a?b?c HTTP/1.1\r\n", "PRI * HTTP/1.1\r\n",
+		"GET ?q HTTP/1.1\r\n", "get / HTTP/1.1\r\n", "GET  / HTTP/1.1\r\n", "GET / HTTP/1.2\r\n", "GET / HTTP/1.1\n",
+		"GET / HTTP/1.1 \r\n", "BREW / HTTP/1.1\r\n", "GET /\r HTTP/1.1\r\n", "GET", "",
+	};
+
+	/**
+	 * Runs a parser over its inputs, returns the nanoseconds per call.
+	*/
+	template<typename InputType, size_t NumInputs, typename FunctorType>
+	static double Time(const InputType (&Inputs)[NumInputs], const int32 Iterations, FunctorType&& Function)
+	{
+		size_t Sink = 0;
+
+		const double Start = FPlatformTime::Seconds();
+
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			for (const InputType& Input : Inputs)
+			{
+				Sink += Function(Input);
+			}
+		}
+
+		const double Elapsed = FPlatformTime::Seconds() - Start;
+
+		// Keeps the calls from being optimized away.
+		if (Sink == static_cast<size_t>(-1))
+		{
+			UE_LOG(LogHttpServer, Verbose, TEXT("%llu"), static_cast<uint64>(Sink));
+		}
+
+		return Elapsed * 1e9 / (static_cast<double>(Iterations) * NumInputs);
+	}
+
+	static void Report(const TCHAR* const Name, const int32 Mismatches, const double RegexNs, const double ParserNs)
+	{
+		UE_LOG(LogHttpServer, Display, TEXT("  %-20s %4d mismatches, regex %8.1f ns, hand-written %7.1f ns, x%.1f"),
+			Name, Mismatches, RegexNs, ParserNs, ParserNs > 0.0 ? RegexNs / ParserNs : 0.0);
+	}
+
+	static void Run(const TArray<FString>& Args)
+	{
+		const int32 Iterations = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 20000;
+
+		int32 Mismatches = 0;
+
+		UE_LOG(LogHttpServer, Display, TEXT("Parsers, per call over %d iterations:"), Iterations);
+
+		// File extension, once per mounted file served.
+		{
+			Mismatches = 0;
+			for (const char* const Path : Paths)
+			{
+				Mismatches += Regex::FileExtension(Path) != httplib::detail::file_extension(Path);
+			}
+
+			const std::string Inputs[] = { Paths[0], Paths[1], Paths[2], Paths[3], Paths[4] };
+
+			Report(TEXT("file_extension"), Mismatches,
+				Time(Inputs, Iterations, [](const std::string& Path) -> size_t { return Regex::FileExtension(Path).size(); }),
+				Time(Inputs, Iterations, [](const std::string& Path) -> size_t { return httplib::detail::file_extension(Path).size(); }));
+		}
+
+		// Query string append, once per client request with parameters.
+		{
+			const httplib::Params Params = { { "limit", "10" } };
+
+			Mismatches = 0;
+			for (const char* const Path : QueryPaths)
+			{
+				const std::string Expected = Path + std::string(1, Regex::QueryDelimiter(Path)) + httplib::detail::params_to_query_str(Params);
+				Mismatches += Expected != httplib::detail::append_query_params(Path, Params);
+			}
+
+			Report(TEXT("append_query_params"), Mismatches,
+				Time(QueryPaths, Iterations, [&Params](const char* const Path) -> size_t
+				{
+					return (Path + std::string(1, Regex::QueryDelimiter(Path)) + httplib::detail::params_to_query_str(Params)).size();
+				}),
+				Time(QueryPaths, Iterations, [&Params](const char* const Path) -> size_t
+				{
+					return httplib::detail::append_query_params(Path, Params).size();
+				}));
+		}
+
+		// Content-Disposition, once per part of a multipart body.
+		{
+			Mismatches = 0;
+			for (const char* const Header : Dispositions)
+			{
+				std::string RegexName = "unset", RegexFileName = "unset";
+				std::string Name	  = "unset", FileName	   = "unset";
+
+				const bool bRegex  = Regex::ContentDisposition(Header, RegexName, RegexFileName);
+				const bool bParser = httplib::detail::parse_content_disposition(Header, Name, FileName);
+
+				Mismatches += bRegex != bParser || RegexName != Name || RegexFileName != FileName;
+			}
+
+			const std::string Inputs[] = { Dispositions[0], Dispositions[1] };
+
+			Report(TEXT("Content-Disposition"), Mismatches,
+				Time(Inputs, Iterations, [](const std::string& Header) -> size_t
+				{
+					std::string Name, FileName;
+					return Regex::ContentDisposition(Header, Name, FileName) ? Name.size() : 0;
+				}),
+				Time(Inputs, Iterations, [](const std::string& Header) -> size_t
+				{
+					std::string Name, FileName;
+					return httplib::detail::parse_content_disposition(Header, Name, FileName) ? Name.size() : 0;
+				}));
+		}
+
+		// Range, once per request with the header.
+		{
+			Mismatches = 0;
+			for (const char* const Value : RangeValues)
+			{
+				httplib::Ranges RegexRanges, Ranges;
+
+				const bool bRegex  = Regex::Range(Value, RegexRanges);
+				const bool bParser = httplib::detail::parse_range_header(Value, Ranges);
+
+				Mismatches += bRegex != bParser || (bRegex && RegexRanges != Ranges);
+			}
+
+			const std::string Inputs[] = { RangeValues[0], RangeValues[1], RangeValues[4] };
+
+			Report(TEXT("Range"), Mismatches,
+				Time(Inputs, Iterations, [](const std::string& Value) -> size_t
+				{
+					httplib::Ranges Ranges;
+					return Regex::Range(Value, Ranges) ? Ranges.size() : 0;
+				}),
+				Time(Inputs, Iterations, [](const std::string& Value) -> size_t
+				{
+					httplib::Ranges Ranges;
+					return httplib::detail::parse_range_header(Value, Ranges) ? Ranges.size() : 0;
+				}));
+		}
+
+		// Request line, once per request.
+		{
+			Mismatches = 0;
+			for (const char* const Line : RequestLines)
+			{
+				httplib::Request RegexRequest, Request;
+
+				const bool bRegex  = Regex::RequestLine(Line, RegexRequest);
+				const bool bParser = httplib::detail::parse_request_line(Line, Line + FCStringAnsi::Strlen(Line), Request);
+
+				Mismatches += bRegex != bParser || RegexRequest.method != Request.method || RegexRequest.target != Request.target
+					|| RegexRequest.path != Request.path || RegexRequest.version != Request.version || RegexRequest.params != Request.params;
+			}
+
+			const std::string Inputs[] = { RequestLines[1], RequestLines[2] };
+
+			Report(TEXT("request line"), Mismatches,
+				Time(Inputs, Iterations, [](const std::string& Line) -> size_t
+				{
+					httplib::Request Request;
+					return Regex::RequestLine(Line.c_str(), Request) ? Request.path.size() : 0;
+				}),
+				Time(Inputs, Iterations, [](const std::string& Line) -> size_t
+				{
+					httplib::Request Request;
+					return httplib::detail::parse_request_line(Line.data(), Line.data() + Line.size(), Request) ? Request.path.size() : 0;
+				}));
+		}
+	}
+}
+
+static FAutoConsoleCommand BenchmarkParsersCommand(
+	TEXT("HttpServer.BenchmarkParsers"),
+	TEXT("Checks the hand-written httplib parsers (file extension, query append, Content-Disposition, Range, request line) against the std::regex ones they replaced and logs the time per call of both. Args: [Iterations=20000]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BlueprintHttpParserBenchmark::Run));
+
+//////////////////////////////////////////////////////////////////////////
+// HttpServer.BenchmarkHeaders
+
+namespace BlueprintHttpHeaderBenchmark
+{
+	/**
+	 * Forwards to the allocator in use and counts the allocations made by one thread.
+	*/
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		explicit FCountingMalloc(FMalloc* const InInner)
+			: Inner(InInner)
+			, ThreadId(FPlatformTLS::GetCurrentThreadId())
+			, Allocations(0)
+		{}
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			Track();
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			Track();
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override
+		{
+			Inner->Free(Original);
+		}
+
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+		{
+			return Inner->QuantizeSize(Count, Alignment);
+		}
+
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+		{
+			return Inner->GetAllocationSize(Original, SizeOut);
+		}
+
+		virtual bool IsInternallyThreadSafe() const override
+		{
+			return Inner->IsInternallyThreadSafe();
+		}
+
+		virtual const TCHAR* GetDescriptiveName() override
+		{
+			return Inner->GetDescriptiveName();
+		}
+
+		uint64 GetAllocations() const { return Allocations; }
+
+	private:
+		void Track()
+		{
+			if (FPlatformTLS::GetCurrentThreadId() == ThreadId)
+			{
+				++Allocations;
+			}
+		}
+
+		FMalloc* const Inner;
+		const uint32   ThreadId;
+		uint64		   Allocations;
+	};
+
+	struct FSample
+	{
+		const TCHAR* Name;
+		const char*	 Request;
+	};
+
+	// Requests of a control panel and of a browser. Paths and header values longer
+	// than the small string buffer of std::string allocate in the header map.
+	static const FSample Samples[] =
+	{
+		{ TEXT("control_get"),  "GET /api/status HTTP/1.1\r\nHost: 127.0.0.1:8080\r\nUser-Agent: DroneControl/1.0\r\nAccept: application/json\r\nConnection: keep-alive\r\n\r\n" },
+		{ TEXT("control_post"), "POST /api/command HTTP/1.1\r\nHost: 127.0.0.1:8080\r\nContent-Type: application/json\r\nContent-Length: 42\r\nX-Request-Id: 7f3a9c2e-4b1d-4e8a-9f60-2d5c8b7e1a04\r\nConnection: keep-alive\r\n\r\n" },
+		{ TEXT("browser"),		"GET /index.html HTTP/1.1\r\nHost: 127.0.0.1:8080\r\nUser-Agent: Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/96.0.4664.110 Safari/537.36\r\n"
+								"Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\nAccept-Encoding: gzip, deflate, br\r\n"
+								"Accept-Language: en-US,en;q=0.9,fr;q=0.8\r\nCookie: session=9b2f4c1e8a7d6b5c; theme=dark\r\nReferer: http://127.0.0.1:8080/\r\nConnection: keep-alive\r\n\r\n" },
+	};
+
+	// Both parsers must agree on these, including what they skip.
+	static const char* const Malformed[] =
+	{
+		"GET /a HTTP/1.1\r\nX-Empty:\r\nX-Spaces: \t \r\nNoColon\r\nX-Trail: v \t\r\n X-Lead: w\r\nBare: lf\nX-Encoded: a%20b%zz\r\n:nokey\r\nx-dup: 1\r\nX-Dup: 2\r\n\r\n",
+		"GET /b HTTP/1.1\r\nA: b\r\n\n\r\nC: d\r\n\r\n",
+		"BREW /c HTTP/1.1\r\nA: b\r\n\r\n",
+		"GET / HTTP/1.1\r\n\r\n",
+	};
+
+	/**
+	 * Reads the request line then the headers line by line into the header map.
+	*/
+	static bool ParseWithMap(httplib::Stream& Stream, httplib::Request& Request)
+	{
+		char Buffer[2048];
+		httplib::detail::stream_line_reader LineReader(Stream, Buffer, sizeof(Buffer));
+
+		return LineReader.getline()
+			&& httplib::detail::parse_request_line(LineReader.ptr(), LineReader.ptr() + LineReader.size(), Request)
+			&& httplib::detail::read_headers(Stream, Request.headers);
+	}
+
+	static bool ParseInPlace(httplib::Stream& Stream, httplib::detail::header_buffer& Buffer, httplib::Request& Request)
+	{
+		return Buffer.read(Stream) && Buffer.parse(Request);
+	}
+
+	/**
+	 * The lookups the server makes for every request.
+	*/
+	static size_t Lookup(const httplib::Request& Request)
+	{
+		return Request.get_header_value("Connection").size() + Request.has_header("Range") + Request.get_header_value("Expect").size();
+	}
+
+	/**
+	 * The headers with lowercase keys, sorted, to compare both parsers.
+	*/
+	static std::vector<std::pair<std::string, std::string>> SortedHeaders(const httplib::Request& Request)
+	{
+		std::vector<std::pair<std::string, std::string>> Headers;
+		Request.for_each_header([&Headers](const std::string_view Key, const std::string_view Value)
+		{
+			std::string LowerKey(Key);
+			for (char& Character : LowerKey)
+			{
+				Character = FCharAnsi::ToLower(Character);
+			}
+			Headers.emplace_back(MoveTemp(LowerKey), std::string(Value));
+		});
+		std::sort(Headers.begin(), Headers.end());
+		return Headers;
+	}
+
+	static bool Matches(const char* const Data, httplib::detail::header_buffer& Buffer)
+	{
+		static const std::string RemoteAddress;
+
+		const size_t Size = FCStringAnsi::Strlen(Data);
+
+		httplib::Request MapRequest, Request;
+
+		httplib::detail::ExternalStream MapStream(Data, Size, RemoteAddress, 0);
+		httplib::detail::ExternalStream Stream	 (Data, Size, RemoteAddress, 0);
+
+		const bool bMap		= ParseWithMap(MapStream, MapRequest);
+		const bool bInPlace = ParseInPlace(Stream, Buffer, Request);
+
+		return bMap == bInPlace && MapRequest.method == Request.method && MapRequest.path == Request.path
+			&& MapRequest.version == Request.version && SortedHeaders(MapRequest) == SortedHeaders(Request);
+	}
+
+	/**
+	 * Parses a request the given number of times.
+	 * @param OutNanoseconds The time per request.
+	 * @param OutAllocations The allocations per request.
+	*/
+	template<typename FunctorType>
+	static void Measure(const char* const Data, const int32 Iterations, FunctorType&& Parse, double& OutNanoseconds, double& OutAllocations)
+	{
+		static const std::string RemoteAddress;
+
+		const size_t Size = FCStringAnsi::Strlen(Data);
+		size_t Sink = 0;
+
+		// Only for the duration of the loop, the blocks are freed by the same allocator.
+		FMalloc* const Previous = GMalloc;
+		FCountingMalloc Counting(Previous);
+		GMalloc = &Counting;
+
+		const double Start = FPlatformTime::Seconds();
+
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			httplib::detail::ExternalStream Stream(Data, Size, RemoteAddress, 0);
+			httplib::Request Request;
+
+			if (Parse(Stream, Request))
+			{
+				Sink += Lookup(Request);
+			}
+		}
+
+		const double Elapsed = FPlatformTime::Seconds() - Start;
+
+		GMalloc = Previous;
+
+		// Keeps the calls from being optimized away.
+		if (Sink == static_cast<size_t>(-1))
+		{
+			UE_LOG(LogHttpServer, Verbose, TEXT("%llu"), static_cast<uint64>(Sink));
+		}
+
+		OutNanoseconds = Elapsed * 1e9 / Iterations;
+		OutAllocations = static_cast<double>(Counting.GetAllocations()) / Iterations;
+	}
+
+	static void Run(const TArray<FString>& Args)
+	{
+		const int32 Iterations = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 100000;
+
+		// Kept by the connection in the server, allocated once.
+		const TUniquePtr<httplib::detail::header_buffer> Buffer = MakeUnique<httplib::detail::header_buffer>();
+
+		int32 Mismatches = 0;
+		for (const FSample& Sample : Samples)
+		{
+			Mismatches += !Matches(Sample.Request, *Buffer);
+		}
+		for (const char* const Data : Malformed)
+		{
+			Mismatches += !Matches(Data, *Buffer);
+		}
+
+		UE_LOG(LogHttpServer, Display, TEXT("Request line and headers, per request over %d iterations, %d mismatches:"), Iterations, Mismatches);
+
+		for (const FSample& Sample : Samples)
+		{
+			double MapNs, MapAllocations, InPlaceNs, InPlaceAllocations;
+
+			Measure(Sample.Request, Iterations, [](httplib::Stream& Stream, httplib::Request& Request) -> bool
+			{
+				return ParseWithMap(Stream, Request);
+			}, MapNs, MapAllocations);
+
+			Measure(Sample.Request, Iterations, [&Buffer](httplib::Stream& Stream, httplib::Request& Request) -> bool
+			{
+				return ParseInPlace(Stream, *Buffer, Request);
+			}, InPlaceNs, InPlaceAllocations);
+
+			UE_LOG(LogHttpServer, Display, TEXT("  %-14s map %8.1f ns %5.1f allocations, in place %7.1f ns %5.1f allocations, x%.1f"),
+				Sample.Name, MapNs, MapAllocations, InPlaceNs, InPlaceAllocations, InPlaceNs > 0.0 ? MapNs / InPlaceNs : 0.0);
+		}
+	}
+}
+
+static FAutoConsoleCommand BenchmarkHeadersCommand(
+	TEXT("HttpServer.BenchmarkHeaders"),
+	TEXT("Parses typical requests into the header map and in place in a connection buffer (SetUseBufferedHeaderParsing), checks both agree and logs the time and allocations per request of both. Args: [Iterations=100000]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BlueprintHttpHeaderBenchmark::Run));
+
+//////////////////////////////////////////////////////////////////////////
+// HttpServer.BenchmarkMultipart
+
+namespace BlueprintHttpMultipartBenchmark
+{
+	class FCountingListener final : public FBlueprintHttpMultipartParser::IListener
+	{
+	public:
+		virtual bool OnPartBegin(const FBlueprintHttpMultipartParser::FPart& Part) override
+		{
+			Sizes.push_back({ Part.Name, 0 });
+			return true;
+		}
+
+		virtual bool OnPartData(const char* const, const size_t Size) override
+		{
+			Sizes.back().second += Size;
+			return true;
+		}
+
+		virtual bool OnPartEnd() override
+		{
+			return true;
+		}
+
+		std::vector<std::pair<std::string, size_t>> Sizes;
+	};
+
+	static void Run(const TArray<FString>& Args)
+	{
+		const int32 NumParts   = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 16;
+		const int32 PartSize   = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) * 1024 : 1024 * 1024;
+		const int32 ChunkSize  = Args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Args[2])) : CPPHTTPLIB_RECV_BUFSIZ;
+		const int32 Iterations = Args.Num() > 3 ? FMath::Max(1, FCString::Atoi(*Args[3])) : 10;
+
+		const std::string Boundary = "----BlueprintHttpBenchmarkBoundary7MA4YWxkTrZu0gW";
+
+		// Image parts with random bytes, so line breaks show up like in real files.
+		std::string Body;
+		FRandomStream Random(PartSize);
+
+		for (int32 Index = 0; Index < NumParts; ++Index)
+		{
+			Body += "--" + Boundary + "\r\n";
+			Body += "Content-Disposition: form-data; name=\"image" + std::to_string(Index) + "\"; filename=\"capture" + std::to_string(Index) + ".png\"\r\n";
+			Body += "Content-Type: image/png\r\n\r\n";
+
+			const size_t Start = Body.size();
+			Body.resize(Start + PartSize);
+
+			for (int32 Byte = 0; Byte < PartSize; ++Byte)
+			{
+				Body[Start + Byte] = static_cast<char>(Random.RandRange(0, 255));
+			}
+
+			Body += "\r\n";
+		}
+
+		Body += "--" + Boundary + "--\r\n";
+
+		const double Megabytes = Body.size() / (1024.0 * 1024.0) * Iterations;
+
+		// The path of httplib routes: regex on each part header, every part kept in memory.
+		std::vector<std::pair<std::string, size_t>> HttplibSizes;
+		size_t HttplibHeld = 0;
+
+		double Start = FPlatformTime::Seconds();
+
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			httplib::detail::MultipartFormDataParser Parser;
+			Parser.set_boundary(std::string(Boundary));
+
+			httplib::MultipartFormDataMap Files;
+			httplib::MultipartFormDataMap::iterator Current;
+
+			for (size_t Offset = 0; Offset < Body.size(); Offset += ChunkSize)
+			{
+				const size_t Length = std::min<size_t>(ChunkSize, Body.size() - Offset);
+
+				Parser.parse(Body.data() + Offset, Length, [&Current](const char* const Data, const size_t Size) -> bool
+				{
+					Current->second.content.append(Data, Size);
+					return true;
+				},
+				[&Files, &Current](const httplib::MultipartFormData& File) -> bool
+				{
+					Current = Files.emplace(File.name, File);
+					return true;
+				});
+			}
+
+			HttplibSizes.clear();
+			HttplibHeld = 0;
+
+			for (const auto& File : Files)
+			{
+				HttplibSizes.push_back({ File.first, File.second.content.size() });
+				HttplibHeld += File.second.content.capacity();
+			}
+		}
+
+		const double HttplibSeconds = FPlatformTime::Seconds() - Start;
+
+		// The streaming parser, parts handed over chunk by chunk.
+		FCountingListener Listener;
+		bool bValid = true;
+
+		Start = FPlatformTime::Seconds();
+
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			FBlueprintHttpMultipartParser Parser(Boundary);
+			Listener.Sizes.clear();
+
+			for (size_t Offset = 0; Offset < Body.size() && bValid; Offset += ChunkSize)
+			{
+				bValid = Parser.Parse(Body.data() + Offset, std::min<size_t>(ChunkSize, Body.size() - Offset), Listener);
+			}
+
+			bValid = bValid && Parser.IsComplete();
+		}
+
+		const double StreamingSeconds = FPlatformTime::Seconds() - Start;
+
+		std::sort(Listener.Sizes.begin(), Listener.Sizes.end());
+
+		if (!bValid || Listener.Sizes != HttplibSizes)
+		{
+			UE_LOG(LogHttpServer, Error, TEXT("Multipart parsers disagree on the benchmark body."));
+		}
+
+		UE_LOG(LogHttpServer, Display, TEXT("Multipart, %d parts of %d KB in %d byte chunks:"), NumParts, PartSize / 1024, ChunkSize);
+		UE_LOG(LogHttpServer, Display, TEXT("  httplib   %8.1f MB/s, %8.1f MB held"), Megabytes / HttplibSeconds, HttplibHeld / (1024.0 * 1024.0));
+		UE_LOG(LogHttpServer, Display, TEXT("  streaming %8.1f MB/s, %8d bytes held at most"), Megabytes / StreamingSeconds, static_cast<int32>(Boundary.size() + 4));
+	}
+}
+
+static FAutoConsoleCommand BenchmarkMultipartCommand(
+	TEXT("HttpServer.BenchmarkMultipart"),
+	TEXT("Compares the httplib multipart parser with the streaming one on an in-memory body of image parts. Args: [Parts=16] [PartKB=1024] [ChunkBytes=4096] [Iterations=10]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BlueprintHttpMultipartBenchmark::Run));
+
+//////////////////////////////////////////////////////////////////////////
+// HttpServer.BenchmarkAcceptors
+
+namespace BlueprintHttpAcceptorBenchmark
+{
+	static std::atomic<bool> bRunning(false);
+
+	/**
+	 * Drives the server with clients for a duration.
+	 * @param bKeepAlive If the clients reuse their connection, otherwise each request opens one.
+	 * @return The requests answered per second.
+	*/
+	static double Drive(const int32 Port, const double Seconds, const int32 NumClients, const bool bKeepAlive)
+	{
+		TArray<std::thread> Clients;
+		std::atomic<int64>	Requests(0);
+
+		const double StartTime = FPlatformTime::Seconds();
+		const double EndTime   = StartTime + Seconds;
+
+		for (int32 i = 0; i < NumClients; ++i)
+		{
+			Clients.Emplace([&]() -> void
+			{
+				httplib::Client Client("127.0.0.1", Port);
+				Client.set_keep_alive(bKeepAlive);
+				Client.set_tcp_nodelay(true);
+
+				int64 Answered = 0;
+				while (FPlatformTime::Seconds() < EndTime)
+				{
+					const httplib::Result Result = Client.Get("/bench/json");
+					Answered += Result && Result->status == 200;
+				}
+
+				Requests += Answered;
+			});
+		}
+
+		for (std::thread& Client : Clients)
+		{
+			Client.join();
+		}
+
+		return Requests / (FPlatformTime::Seconds() - StartTime);
+	}
+
+	static void Run(const TArray<FString>& Args)
+	{
+		const double Seconds	  = Args.Num() > 0 ? FCString::Atod(*Args[0]) : 2.0;
+		const int32  NumClients	  = Args.Num() > 1 ? FMath::Clamp(FCString::Atoi(*Args[1]), 1, 256) : 32;
+		int32		 MaxAcceptors = Args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Args[2])) : FPlatformMisc::NumberOfCores();
+		const int32  Port		  = Args.Num() > 3 ? FCString::Atoi(*Args[3]) : 18490;
+
+		if (bRunning.exchange(true))
+		{
+			UE_LOG(LogHttpServer, Warning, TEXT("A benchmark is already running."));
+			return;
+		}
+
+#if !PLATFORM_LINUX
+		// Windows has no SO_REUSEPORT, only the single acceptor the server falls back to is measured.
+		UE_LOG(LogHttpServer, Warning, TEXT("SO_REUSEPORT acceptors are only available on Linux, measuring a single one."));
+		MaxAcceptors = 1;
+#endif
+
+		// Blocks for the whole run, the game thread keeps ticking.
+		Async(EAsyncExecution::Thread, [Seconds, NumClients, MaxAcceptors, Port]() -> void
+		{
+			const std::string Body = TCHAR_TO_UTF8(BlueprintHttpBenchmark::DroneStatus);
+
+			UE_LOG(LogHttpServer, Display, TEXT("Acceptors, %.1f seconds per run with %d clients, %d cores:"), Seconds, NumClients, FPlatformMisc::NumberOfCores());
+
+			double BaseConnections = 0.0;
+			double BaseRequests	   = 0.0;
+
+			for (int32 NumAcceptors = 1; ; NumAcceptors = FMath::Min(NumAcceptors * 2, MaxAcceptors))
+			{
+				httplib::Server Server;
+				Server.set_acceptor_count(static_cast<size_t>(NumAcceptors));
+				Server.set_tcp_nodelay(true);
+				Server.Get("/bench/json", [&Body](const httplib::Request&, httplib::Response& Response) -> void
+				{
+					Response.set_content(Body, "application/json");
+				});
+
+				if (!Server.bind_to_port("127.0.0.1", Port))
+				{
+					UE_LOG(LogHttpServer, Error, TEXT("Benchmark server failed to listen on port %d."), Port);
+					break;
+				}
+
+				std::thread Listener([&Server]() -> void
+				{
+					Server.listen_after_bind();
+				});
+
+				while (!Server.is_running())
+				{
+					FPlatformProcess::Sleep(0.001f);
+				}
+
+				// A connection per request measures the accept path, keep-alive the workers.
+				const double Connections = Drive(Port, Seconds, NumClients, false);
+				const double Requests	 = Drive(Port, Seconds, NumClients, true);
+
+				Server.stop();
+				Listener.join();
+
+				if (NumAcceptors == 1)
+				{
+					BaseConnections = Connections;
+					BaseRequests	= Requests;
+				}
+
+				UE_LOG(LogHttpServer, Display, TEXT("  %3d acceptors: %9.0f connections/s x%.2f, %9.0f keep-alive req/s x%.2f"),
+					NumAcceptors, Connections, BaseConnections > 0.0 ? Connections / BaseConnections : 0.0,
+					Requests, BaseRequests > 0.0 ? Requests / BaseRequests : 0.0);
+
+				if (NumAcceptors >= MaxAcceptors)
+				{
+					break;
+				}
+			}
+
+			bRunning = false;
+		});
+	}
+}
+
+static FAutoConsoleCommand BenchmarkAcceptorsCommand(
+	TEXT("HttpServer.BenchmarkAcceptors"),
+	TEXT("Serves a JSON route on loopback with 1, 2, 4... SO_REUSEPORT acceptors (SetAcceptorCount), drives it with a new connection per request then with keep-alive clients and logs connections/s and req/s of each run. Run it on the target machine before raising the acceptor count from its default of 1. Linux only, a single acceptor is measured elsewhere. Args: [SecondsPerRun=2] [Clients=32] [MaxAcceptors=Cores] [Port=18490]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BlueprintHttpAcceptorBenchmark::Run));
+
+//////////////////////////////////////////////////////////////////////////
+// HttpServer.CheckPipelining
+
+namespace BlueprintHttpPipeliningCheck
+{
+	/**
+	 * Sends raw bytes on a new connection and reads until the server closes it.
+	 * @return Everything the server answered.
+	*/
+	static std::string Exchange(const int32 Port, const std::string& Data)
+	{
+		httplib::Error Error = httplib::Error::Success;
+		const socket_t Socket = httplib::detail::create_client_socket("127.0.0.1", Port, true, nullptr, 2, 0, std::string(), Error);
+		if (Socket == INVALID_SOCKET)
+		{
+			return std::string();
+		}
+
+		std::string Answer;
+		{
+			httplib::detail::SocketStream Stream(Socket, 2, 0, 2, 0);
+			Stream.write(Data.data(), Data.size());
+
+			char Buffer[4096];
+			for (ssize_t Read = Stream.read(Buffer, sizeof(Buffer)); Read > 0; Read = Stream.read(Buffer, sizeof(Buffer)))
+			{
+				Answer.append(Buffer, static_cast<size_t>(Read));
+			}
+		}
+
+		httplib::detail::close_socket(Socket);
+		return Answer;
+	}
+
+	static int32 CountResponses(const std::string& Answer)
+	{
+		int32 Count = 0;
+		for (size_t Position = Answer.find("HTTP/1.1 "); Position != std::string::npos; Position = Answer.find("HTTP/1.1 ", Position + 1))
+		{
+			++Count;
+		}
+		return Count;
+	}
+
+	static void Run(const TArray<FString>& Args)
+	{
+		const int32 Port = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 18491;
+
+		Async(EAsyncExecution::Thread, [Port]() -> void
+		{
+			std::atomic<int32> Executed(0);
+
+			// Rejects /limited before its body is read, as AddRateLimit does.
+			httplib::Server Server;
+			Server.set_pre_routing_handler([](const httplib::Request& Request, httplib::Response& Response) -> httplib::Server::HandlerResponse
+			{
+				if (Request.path == "/limited")
+				{
+					Response.status = 429;
+					return httplib::Server::HandlerResponse::Handled;
+				}
+				return httplib::Server::HandlerResponse::Unhandled;
+			});
+			Server.Get("/smuggled", [&Executed](const httplib::Request&, httplib::Response& Response) -> void
+			{
+				++Executed;
+				Response.set_content("smuggled", "text/plain");
+			});
+
+			if (!Server.bind_to_port("127.0.0.1", Port))
+			{
+				UE_LOG(LogHttpServer, Error, TEXT("Pipelining check server failed to listen on port %d."), Port);
+				return;
+			}
+
+			std::thread Listener([&Server]() -> void
+			{
+				Server.listen_after_bind();
+			});
+
+			while (!Server.is_running())
+			{
+				FPlatformProcess::Sleep(0.001f);
+			}
+
+			// A request hidden in the body of one the server doesn't read.
+			const std::string Smuggled = "GET /smuggled HTTP/1.1\r\nHost: localhost\r\n\r\n";
+			const std::string Length   = std::to_string(Smuggled.size());
+
+			char ChunkSize[16];
+			FCStringAnsi::Snprintf(ChunkSize, sizeof(ChunkSize), "%zx", Smuggled.size());
+
+			struct FCase
+			{
+				const TCHAR* Name;
+				std::string	 Data;
+			};
+
+			const FCase Cases[] =
+			{
+				{ TEXT("rejected POST with Content-Length"), "POST /limited HTTP/1.1\r\nHost: localhost\r\nContent-Length: " + Length + "\r\n\r\n" + Smuggled },
+				{ TEXT("rejected POST chunked"),			 std::string("POST /limited HTTP/1.1\r\nHost: localhost\r\nTransfer-Encoding: chunked\r\n\r\n") + ChunkSize + "\r\n" + Smuggled + "\r\n0\r\n\r\n" },
+				{ TEXT("rejected GET with a body"),			 "GET /limited HTTP/1.1\r\nHost: localhost\r\nContent-Length: " + Length + "\r\n\r\n" + Smuggled },
+			};
+
+			int32 Failures = 0;
+			for (const FCase& Case : Cases)
+			{
+				Executed = 0;
+
+				const std::string Answer	= Exchange(Port, Case.Data);
+				const int32		  Responses = CountResponses(Answer);
+				const bool		  bPassed	= Responses == 1 && Executed == 0;
+
+				Failures += !bPassed;
+
+				UE_LOG(LogHttpServer, Display, TEXT("  %-36s %s (%d responses, %d smuggled requests executed)"),
+					Case.Name, bPassed ? TEXT("ok") : TEXT("FAILED"), Responses, Executed.load());
+			}
+
+			Server.stop();
+			Listener.join();
+
+			if (Failures > 0)
+			{
+				UE_LOG(LogHttpServer, Error, TEXT("Pipelining check: %d of %d cases let a request through the body of another."), Failures, static_cast<int32>(UE_ARRAY_COUNT(Cases)));
+			}
+			else
+			{
+				UE_LOG(LogHttpServer, Display, TEXT("Pipelining check: bodies of unread requests are never parsed as requests."));
+			}
+		});
+	}
+}
+
+static FAutoConsoleCommand CheckPipeliningCommand(
+	TEXT("HttpServer.CheckPipelining"),
+	TEXT("Pipelines a request in the body of requests the server answers without reading it (rejected before routing, GET with a body) and checks it is never executed. Args: [Port=18491]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BlueprintHttpPipeliningCheck::Run));
@@ -0,0 +1,1071 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#include "BlueprintHttpEpollServer.h"
+
+#if PLATFORM_LINUX
+
+#include "BlueprintHttpServerModule.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+
+#ifndef EPOLLEXCLUSIVE
+#	define EPOLLEXCLUSIVE (1u << 28)
+#endif
+
+namespace BlueprintHttpEpoll
+{
+	// Request heads larger than this are rejected.
+	static constexpr size_t MaxHeadLength = 64 * 1024;
+
+	// Pipelined bytes read ahead while a response is pending.
+	static constexpr size_t MaxReadAhead = 64 * 1024;
+
+	// Longest chunk-size line, extensions included.
+	static constexpr size_t MaxChunkLine = 1024;
+
+	static constexpr size_t ReadChunkSize = 16 * 1024;
+	static constexpr int	MaxEvents	  = 256;
+	static constexpr int	WaitTimeoutMs = 1000;
+
+	static constexpr uint32 ConnectionEvents = EPOLLIN | EPOLLRDHUP | EPOLLET;
+
+	static int64 NowMs()
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static bool EqualsNoCase(const char* Data, const size_t Length, const char* Literal)
+	{
+		return strlen(Literal) == Length && strncasecmp(Data, Literal, Length) == 0;
+	}
+
+	static size_t AddClamped(const size_t A, const size_t B)
+	{
+		return A > SIZE_MAX - B ? SIZE_MAX : A + B;
+	}
+
+	static int32 HexValue(const char Character)
+	{
+		if (Character >= '0' && Character <= '9') return Character - '0';
+		if (Character >= 'a' && Character <= 'f') return Character - 'a' + 10;
+		if (Character >= 'A' && Character <= 'F') return Character - 'A' + 10;
+		return -1;
+	}
+}
+
+struct FBlueprintHttpEpollServer::FConnection
+{
+	int	   Socket = -1;
+	uint64 Id	  = 0;
+
+	std::string RemoteAddress;
+	int			RemotePort = 0;
+
+	/**
+	 * Received bytes, may hold several pipelined requests.
+	*/
+	std::string Input;
+
+	/**
+	 * Framing state of the first request in Input.
+	*/
+	size_t HeadScanOffset  = 0;
+	size_t HeadLength	   = 0;
+	size_t RequestLength   = 0;
+	size_t ChunkOffset	   = 0;
+	size_t BodyLength	   = 0;
+	bool   bChunked		   = false;
+	bool   bExpectContinue = false;
+	bool   bContinueSent   = false;
+	bool   bCloseRequested = false;
+
+	std::string Output;
+	size_t		OutputOffset = 0;
+
+	size_t NumRequests		= 0;
+	bool   bDispatched		= false;
+	bool   bWantWrite		= false;
+	bool   bReadPaused		= false;
+	bool   bPeerClosed		= false;
+	bool   bCloseAfterWrite = false;
+	bool   bClosed			= false;
+
+	/**
+	 * Intrusive list of the connections waiting on the client,
+	 * least recently active first.
+	*/
+	int64		 LastActivityMs = 0;
+	FConnection* Prev			= nullptr;
+	FConnection* Next			= nullptr;
+	bool		 bLinked		= false;
+
+	bool HasPendingOutput() const { return OutputOffset < Output.size(); }
+
+	void ResetFrame()
+	{
+		HeadScanOffset	= 0;
+		HeadLength		= 0;
+		RequestLength	= 0;
+		ChunkOffset		= 0;
+		BodyLength		= 0;
+		bChunked		= false;
+		bExpectContinue = false;
+		bContinueSent	= false;
+		bCloseRequested = false;
+	}
+};
+
+struct FBlueprintHttpEpollServer::FLoop
+{
+	struct FCompletion
+	{
+		int			Socket;
+		uint64		Id;
+		std::string Response;
+	};
+
+	int			EpollFd = -1;
+	int			WakeFd	= -1;
+	std::thread Thread;
+
+	std::weak_ptr<FLoop> Self;
+
+	/**
+	 * Only touched by the loop's thread.
+	*/
+	std::unordered_map<int, std::unique_ptr<FConnection>> Connections;
+	std::vector<int> Closed;
+	FConnection*	 IdleHead = nullptr;
+	FConnection*	 IdleTail = nullptr;
+
+	std::atomic<int32> NumConnections{ 0 };
+
+	std::mutex				 CompletionMutex;
+	std::vector<FCompletion> Completions;
+	bool					 bAcceptsCompletions = true;
+
+	/**
+	 * Queues a response from a worker and wakes the loop up.
+	*/
+	void Post(FCompletion&& Completion)
+	{
+		std::lock_guard<std::mutex> Lock(CompletionMutex);
+
+		if (!bAcceptsCompletions)
+		{
+			return;
+		}
+
+		// The loop drains all completions per wake up.
+		const bool bWasEmpty = Completions.empty();
+		Completions.push_back(MoveTemp(Completion));
+
+		if (bWasEmpty)
+		{
+			const uint64 One = 1;
+			ensure(write(WakeFd, &One, sizeof(One)) == sizeof(One));
+		}
+	}
+};
+
+FBlueprintHttpEpollServer::FBlueprintHttpEpollServer(const TSharedRef<httplib::Server, ESPMode::ThreadSafe>& InServer, const int32 InNumIoThreads)
+	: Server(InServer)
+	, NumIoThreads(FMath::Max(1, InNumIoThreads))
+	, ListenSocket(-1)
+	, Stopping(false)
+	, NextConnectionId(1)
+	, MaxPayloadLength(0)
+	, MaxRequestsPerConnection(0)
+	, IdleTimeoutMs(0)
+{
+}
+
+FBlueprintHttpEpollServer::~FBlueprintHttpEpollServer()
+{
+	Stop();
+}
+
+bool FBlueprintHttpEpollServer::Listen(const char* Host, const int32 Port)
+{
+	if (ListenSocket >= 0)
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("Epoll server is already listening."));
+		return false;
+	}
+
+	addrinfo Hints;
+	FMemory::Memzero(Hints);
+	Hints.ai_family	  = AF_UNSPEC;
+	Hints.ai_socktype = SOCK_STREAM;
+	Hints.ai_flags	  = AI_PASSIVE;
+
+	addrinfo* Results = nullptr;
+	const std::string Service = std::to_string(Port);
+
+	const int AddressError = getaddrinfo(Host, Service.c_str(), &Hints, &Results);
+	if (AddressError != 0)
+	{
+		UE_LOG(LogHttpServer, Error, TEXT("Failed to resolve %s. %s"), UTF8_TO_TCHAR(Host), UTF8_TO_TCHAR(gai_strerror(AddressError)));
+		return false;
+	}
+
+	int BindError = 0;
+	for (addrinfo* Info = Results; Info && ListenSocket < 0; Info = Info->ai_next)
+	{
+		const int Socket = socket(Info->ai_family, Info->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, Info->ai_protocol);
+		if (Socket < 0)
+		{
+			BindError = errno;
+			continue;
+		}
+
+		int Yes = 1;
+		setsockopt(Socket, SOL_SOCKET, SO_REUSEADDR, &Yes, sizeof(Yes));
+
+		if (bind(Socket, Info->ai_addr, Info->ai_addrlen) == 0 && listen(Socket, SOMAXCONN) == 0)
+		{
+			ListenSocket = Socket;
+		}
+		else
+		{
+			BindError = errno;
+			close(Socket);
+		}
+	}
+
+	freeaddrinfo(Results);
+
+	if (ListenSocket < 0)
+	{
+		UE_LOG(LogHttpServer, Error, TEXT("Failed to bind epoll server to %s:%d. %s"), UTF8_TO_TCHAR(Host), Port, UTF8_TO_TCHAR(strerror(BindError)));
+		return false;
+	}
+
+	// Settings are read once, like httplib does when it starts listening.
+	MaxPayloadLength		 = Server->get_payload_max_length();
+	MaxRequestsPerConnection = FMath::Max<size_t>(1, Server->get_keep_alive_max_count());
+	IdleTimeoutMs			 = FMath::Max<int64>(1, Server->get_keep_alive_timeout()) * 1000;
+
+	Workers.reset(Server->new_task_queue());
+	Server->set_external_task_queue(Workers.get());
+
+	Stopping = false;
+
+	for (int32 Index = 0; Index < NumIoThreads; ++Index)
+	{
+		std::shared_ptr<FLoop> Loop = std::make_shared<FLoop>();
+		Loop->Self	  = Loop;
+		Loop->EpollFd = epoll_create1(EPOLL_CLOEXEC);
+		Loop->WakeFd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+		Loops.push_back(Loop);
+
+		epoll_event WakeEvent = {};
+		WakeEvent.events  = EPOLLIN;
+		WakeEvent.data.fd = Loop->WakeFd;
+
+		// Each loop accepts for itself, EPOLLEXCLUSIVE wakes one of them per connection.
+		epoll_event ListenEvent = {};
+		ListenEvent.events	= EPOLLIN | EPOLLEXCLUSIVE;
+		ListenEvent.data.fd = ListenSocket;
+
+		if (Loop->EpollFd < 0 || Loop->WakeFd < 0
+			|| epoll_ctl(Loop->EpollFd, EPOLL_CTL_ADD, Loop->WakeFd, &WakeEvent) != 0
+			|| epoll_ctl(Loop->EpollFd, EPOLL_CTL_ADD, ListenSocket, &ListenEvent) != 0)
+		{
+			UE_LOG(LogHttpServer, Error, TEXT("Failed to create epoll instance. %s"), UTF8_TO_TCHAR(strerror(errno)));
+			Stop();
+			return false;
+		}
+	}
+
+	for (const std::shared_ptr<FLoop>& Loop : Loops)
+	{
+		Loop->Thread = std::thread([this, Loop = Loop.get()]() -> void
+		{
+			LoopMain(*Loop);
+		});
+	}
+
+	return true;
+}
+
+void FBlueprintHttpEpollServer::Stop()
+{
+	if (ListenSocket < 0)
+	{
+		return;
+	}
+
+	// Deferred responses sent from now on are dropped.
+	Server->set_external_task_queue(nullptr);
+
+	Stopping = true;
+
+	for (const std::shared_ptr<FLoop>& Loop : Loops)
+	{
+		if (Loop->WakeFd >= 0)
+		{
+			const uint64 One = 1;
+			ensure(write(Loop->WakeFd, &One, sizeof(One)) == sizeof(One));
+		}
+	}
+
+	for (const std::shared_ptr<FLoop>& Loop : Loops)
+	{
+		if (Loop->Thread.joinable())
+		{
+			Loop->Thread.join();
+		}
+
+		{
+			std::lock_guard<std::mutex> Lock(Loop->CompletionMutex);
+			Loop->bAcceptsCompletions = false;
+			Loop->Completions.clear();
+		}
+
+		for (const auto& Connection : Loop->Connections)
+		{
+			close(Connection.first);
+		}
+		Loop->Connections.clear();
+		Loop->NumConnections = 0;
+
+		if (Loop->EpollFd >= 0) close(Loop->EpollFd);
+		if (Loop->WakeFd  >= 0) close(Loop->WakeFd);
+	}
+
+	// Pending workers only hold weak references to the loops.
+	Loops.clear();
+
+	close(ListenSocket);
+	ListenSocket = -1;
+
+	if (Workers)
+	{
+		// Draining waits for pending callbacks, and game thread routes need
+		// the game thread to tick before they finish. Like the httplib listen
+		// thread, the pool is left to finish on its own.
+		std::thread([PendingWorkers = MoveTemp(Workers)]() -> void
+		{
+			PendingWorkers->shutdown();
+		}).detach();
+	}
+}
+
+int32 FBlueprintHttpEpollServer::GetNumConnections() const
+{
+	int32 NumConnections = 0;
+
+	for (const std::shared_ptr<FLoop>& Loop : Loops)
+	{
+		NumConnections += Loop->NumConnections.load(std::memory_order_relaxed);
+	}
+
+	return NumConnections;
+}
+
+void FBlueprintHttpEpollServer::LoopMain(FLoop& Loop)
+{
+	epoll_event Events[BlueprintHttpEpoll::MaxEvents];
+
+	while (!Stopping)
+	{
+		const int NumEvents = epoll_wait(Loop.EpollFd, Events, BlueprintHttpEpoll::MaxEvents, BlueprintHttpEpoll::WaitTimeoutMs);
+
+		if (NumEvents < 0 && errno != EINTR)
+		{
+			UE_LOG(LogHttpServer, Error, TEXT("epoll_wait failed. %s"), UTF8_TO_TCHAR(strerror(errno)));
+			break;
+		}
+
+		bool bWokenUp = false;
+
+		for (int Index = 0; Index < NumEvents; ++Index)
+		{
+			const int	 Fd		= Events[Index].data.fd;
+			const uint32 Flags	= Events[Index].events;
+
+			if (Fd == Loop.WakeFd)
+			{
+				bWokenUp = true;
+				continue;
+			}
+
+			if (Fd == ListenSocket)
+			{
+				Accept(Loop);
+				continue;
+			}
+
+			const auto Found = Loop.Connections.find(Fd);
+			if (Found == Loop.Connections.end() || Found->second->bClosed)
+			{
+				continue;
+			}
+
+			FConnection& Connection = *Found->second;
+
+			if (Flags & EPOLLERR)
+			{
+				CloseConnection(Loop, Connection);
+				continue;
+			}
+
+			if (Flags & EPOLLOUT)
+			{
+				FlushOutput(Loop, Connection);
+			}
+
+			if (!Connection.bClosed && (Flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)))
+			{
+				OnReadable(Loop, Connection);
+			}
+		}
+
+		if (bWokenUp)
+		{
+			uint64 Value;
+			while (read(Loop.WakeFd, &Value, sizeof(Value)) < 0 && errno == EINTR);
+
+			ProcessCompletions(Loop);
+		}
+
+		CloseIdleConnections(Loop);
+		ReleaseClosedConnections(Loop);
+	}
+}
+
+void FBlueprintHttpEpollServer::Accept(FLoop& Loop)
+{
+	while (!Stopping)
+	{
+		sockaddr_storage Address;
+		socklen_t		 AddressLength = sizeof(Address);
+
+		const int Socket = accept4(ListenSocket, reinterpret_cast<sockaddr*>(&Address), &AddressLength, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+		if (Socket < 0)
+		{
+			if (errno == EINTR || errno == ECONNABORTED)
+			{
+				continue;
+			}
+
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+			{
+				UE_LOG(LogHttpServer, Warning, TEXT("Failed to accept connection. %s"), UTF8_TO_TCHAR(strerror(errno)));
+			}
+
+			return;
+		}
+
+		// Responses are written in one go, Nagle would only delay them.
+		int Yes = 1;
+		setsockopt(Socket, IPPROTO_TCP, TCP_NODELAY, &Yes, sizeof(Yes));
+
+		std::unique_ptr<FConnection> Connection = std::make_unique<FConnection>();
+		Connection->Socket = Socket;
+		Connection->Id	   = NextConnectionId.fetch_add(1, std::memory_order_relaxed);
+
+		char Host[INET6_ADDRSTRLEN] = {};
+		if (Address.ss_family == AF_INET)
+		{
+			const sockaddr_in& Address4 = reinterpret_cast<const sockaddr_in&>(Address);
+			inet_ntop(AF_INET, &Address4.sin_addr, Host, sizeof(Host));
+			Connection->RemotePort = ntohs(Address4.sin_port);
+		}
+		else if (Address.ss_family == AF_INET6)
+		{
+			const sockaddr_in6& Address6 = reinterpret_cast<const sockaddr_in6&>(Address);
+			inet_ntop(AF_INET6, &Address6.sin6_addr, Host, sizeof(Host));
+			Connection->RemotePort = ntohs(Address6.sin6_port);
+		}
+		Connection->RemoteAddress = Host;
+
+		epoll_event Event = {};
+		Event.events  = BlueprintHttpEpoll::ConnectionEvents;
+		Event.data.fd = Socket;
+
+		if (epoll_ctl(Loop.EpollFd, EPOLL_CTL_ADD, Socket, &Event) != 0)
+		{
+			close(Socket);
+			continue;
+		}
+
+		FConnection& Added = *Connection;
+		Loop.Connections[Socket] = MoveTemp(Connection);
+		Loop.NumConnections.fetch_add(1, std::memory_order_relaxed);
+
+		Touch(Loop, Added);
+	}
+}
+
+void FBlueprintHttpEpollServer::OnReadable(FLoop& Loop, FConnection& Connection)
+{
+	// Framing what was read tells how much more the request can take.
+	while (ReadInput(Loop, Connection))
+	{
+		TryDispatch(Loop, Connection);
+
+		if (!Connection.bReadPaused || Connection.bClosed || Connection.bDispatched || Connection.HasPendingOutput()
+			|| Connection.Input.size() >= ReadLimit(Connection))
+		{
+			return;
+		}
+	}
+}
+
+size_t FBlueprintHttpEpollServer::ReadLimit(const FConnection& Connection) const
+{
+	using namespace BlueprintHttpEpoll;
+
+	if (Connection.bDispatched || Connection.HasPendingOutput())
+	{
+		return MaxReadAhead;
+	}
+
+	// One byte over the cap is enough to answer 431.
+	if (Connection.HeadLength == 0)
+	{
+		return MaxHeadLength + 1;
+	}
+
+	if (!Connection.bChunked)
+	{
+		return AddClamped(Connection.HeadLength + Connection.BodyLength, MaxReadAhead);
+	}
+
+	// The next chunk line, the rest of the payload, and the trailers.
+	const size_t Remaining = MaxPayloadLength - FMath::Min(MaxPayloadLength, Connection.BodyLength);
+	return AddClamped(AddClamped(Connection.ChunkOffset + MaxChunkLine + MaxHeadLength, Remaining), MaxReadAhead);
+}
+
+bool FBlueprintHttpEpollServer::ReadInput(FLoop& Loop, FConnection& Connection)
+{
+	const size_t Limit = ReadLimit(Connection);
+
+	char Buffer[BlueprintHttpEpoll::ReadChunkSize];
+
+	// Edge triggered: read until the socket would block, or remember we stopped early.
+	Connection.bReadPaused = false;
+	while (!Connection.bPeerClosed)
+	{
+		if (Connection.Input.size() >= Limit)
+		{
+			Connection.bReadPaused = true;
+			break;
+		}
+
+		const size_t  ToRead = FMath::Min(sizeof(Buffer), Limit - Connection.Input.size());
+		const ssize_t Read	 = recv(Connection.Socket, Buffer, ToRead, 0);
+
+		if (Read > 0)
+		{
+			Connection.Input.append(Buffer, Read);
+		}
+		else if (Read == 0)
+		{
+			Connection.bPeerClosed = true;
+		}
+		else if (errno == EAGAIN || errno == EWOULDBLOCK)
+		{
+			break;
+		}
+		else if (errno != EINTR)
+		{
+			CloseConnection(Loop, Connection);
+			return false;
+		}
+	}
+
+	if (!Connection.bDispatched)
+	{
+		Touch(Loop, Connection);
+	}
+
+	return true;
+}
+
+void FBlueprintHttpEpollServer::TryDispatch(FLoop& Loop, FConnection& Connection)
+{
+	if (Connection.bClosed || Connection.bDispatched || Connection.HasPendingOutput())
+	{
+		return;
+	}
+
+	int32 Status = 0;
+	switch (FrameRequest(Connection, Status))
+	{
+	case EFrameResult::Error:
+		SendErrorAndClose(Loop, Connection, Status);
+		return;
+
+	case EFrameResult::Incomplete:
+		if (Connection.bPeerClosed)
+		{
+			CloseConnection(Loop, Connection);
+		}
+		else if (Connection.bExpectContinue && !Connection.bContinueSent)
+		{
+			// The client waits for it before sending the body.
+			static constexpr char Continue[] = "HTTP/1.1 100 Continue\r\n\r\n";
+			send(Connection.Socket, Continue, sizeof(Continue) - 1, MSG_NOSIGNAL);
+			Connection.bContinueSent = true;
+		}
+		return;
+
+	case EFrameResult::Complete:
+	default:
+		break;
+	}
+
+	std::string Request;
+	if (Connection.RequestLength == Connection.Input.size())
+	{
+		Request = MoveTemp(Connection.Input);
+		Connection.Input.clear();
+	}
+	else
+	{
+		Request = Connection.Input.substr(0, Connection.RequestLength);
+		Connection.Input.erase(0, Connection.RequestLength);
+	}
+
+	const bool bClose = Connection.bCloseRequested || Connection.bPeerClosed
+		|| ++Connection.NumRequests >= MaxRequestsPerConnection;
+
+	Connection.ResetFrame();
+	Connection.bDispatched		= true;
+	Connection.bCloseAfterWrite = bClose;
+
+	// The route callback has its own timeout, don't count it as idle time.
+	Unlink(Loop, Connection);
+
+	Workers->enqueue([Server = this->Server, WeakLoop = Loop.Self, Socket = Connection.Socket, Id = Connection.Id,
+		Request = MoveTemp(Request), Address = Connection.RemoteAddress, Port = Connection.RemotePort, bClose]() -> void
+	{
+		Server->process_external_request(Request.data(), Request.size(), Address, Port, bClose,
+			[WeakLoop, Socket, Id](std::string&& Response) -> void
+		{
+			if (std::shared_ptr<FLoop> Loop = WeakLoop.lock())
+			{
+				Loop->Post({ Socket, Id, MoveTemp(Response) });
+			}
+		});
+	});
+}
+
+FBlueprintHttpEpollServer::EFrameResult FBlueprintHttpEpollServer::FrameRequest(FConnection& Connection, int32& OutStatus) const
+{
+	const std::string& Input = Connection.Input;
+
+	// Only the headers needed to find the end of the request are read here,
+	// httplib parses and validates the whole request on the worker.
+	if (Connection.HeadLength == 0)
+	{
+		const size_t ScanFrom = Connection.HeadScanOffset > 3 ? Connection.HeadScanOffset - 3 : 0;
+		const size_t HeadEnd  = Input.find("\r\n\r\n", ScanFrom);
+
+		if (HeadEnd == std::string::npos)
+		{
+			Connection.HeadScanOffset = Input.size();
+
+			if (Input.size() > BlueprintHttpEpoll::MaxHeadLength)
+			{
+				OutStatus = 431;
+				return EFrameResult::Error;
+			}
+
+			return EFrameResult::Incomplete;
+		}
+
+		Connection.HeadLength = HeadEnd + 4;
+
+		if (Connection.HeadLength > BlueprintHttpEpoll::MaxHeadLength)
+		{
+			OutStatus = 431;
+			return EFrameResult::Error;
+		}
+
+		size_t LineEnd = Input.find("\r\n");
+
+		const size_t VersionStart = Input.rfind(' ', LineEnd);
+		const bool	 bHttp10	  = VersionStart != std::string::npos
+			&& Input.compare(VersionStart + 1, LineEnd - VersionStart - 1, "HTTP/1.0") == 0;
+
+		bool bKeepAlive		= false;
+		bool bClose			= false;
+		bool bContentLength = false;
+
+		for (size_t LineStart = LineEnd + 2; LineStart < HeadEnd; LineStart = LineEnd + 2)
+		{
+			LineEnd = Input.find("\r\n", LineStart);
+
+			const size_t Colon = Input.find(':', LineStart);
+			if (Colon == std::string::npos || Colon > LineEnd)
+			{
+				continue;
+			}
+
+			size_t ValueStart = Colon + 1;
+			size_t ValueEnd	  = LineEnd;
+			while (ValueStart < ValueEnd && (Input[ValueStart]	 == ' ' || Input[ValueStart]   == '\t')) ++ValueStart;
+			while (ValueEnd > ValueStart && (Input[ValueEnd - 1] == ' ' || Input[ValueEnd - 1] == '\t')) --ValueEnd;
+
+			const char* const Name		  = Input.data() + LineStart;
+			const size_t	  NameLength  = Colon - LineStart;
+			const char* const Value		  = Input.data() + ValueStart;
+			const size_t	  ValueLength = ValueEnd - ValueStart;
+
+			if (BlueprintHttpEpoll::EqualsNoCase(Name, NameLength, "Content-Length"))
+			{
+				size_t Length = 0;
+				for (size_t Index = 0; Index < ValueLength; ++Index)
+				{
+					const char Digit = Value[Index];
+					if (Digit < '0' || Digit > '9' || Length > (SIZE_MAX - 9) / 10)
+					{
+						OutStatus = 400;
+						return EFrameResult::Error;
+					}
+					Length = Length * 10 + (Digit - '0');
+				}
+
+				// Differing lengths can't be framed the same way by every hop.
+				if (ValueLength == 0 || (bContentLength && Length != Connection.BodyLength))
+				{
+					OutStatus = 400;
+					return EFrameResult::Error;
+				}
+
+				Connection.BodyLength = Length;
+				bContentLength		  = true;
+			}
+			else if (BlueprintHttpEpoll::EqualsNoCase(Name, NameLength, "Transfer-Encoding"))
+			{
+				Connection.bChunked = BlueprintHttpEpoll::EqualsNoCase(Value, ValueLength, "chunked");
+			}
+			else if (BlueprintHttpEpoll::EqualsNoCase(Name, NameLength, "Connection"))
+			{
+				bClose	   = BlueprintHttpEpoll::EqualsNoCase(Value, ValueLength, "close");
+				bKeepAlive = BlueprintHttpEpoll::EqualsNoCase(Value, ValueLength, "keep-alive");
+			}
+			else if (BlueprintHttpEpoll::EqualsNoCase(Name, NameLength, "Expect"))
+			{
+				Connection.bExpectContinue = BlueprintHttpEpoll::EqualsNoCase(Value, ValueLength, "100-continue");
+			}
+		}
+
+		Connection.bCloseRequested = bClose || (bHttp10 && !bKeepAlive);
+
+		// Like httplib, a chunked body ignores Content-Length.
+		if (Connection.bChunked)
+		{
+			Connection.BodyLength  = 0;
+			Connection.ChunkOffset = Connection.HeadLength;
+		}
+		else if (Connection.BodyLength > MaxPayloadLength)
+		{
+			OutStatus = 413;
+			return EFrameResult::Error;
+		}
+	}
+
+	if (!Connection.bChunked)
+	{
+		Connection.RequestLength = Connection.HeadLength + Connection.BodyLength;
+		return Input.size() >= Connection.RequestLength ? EFrameResult::Complete : EFrameResult::Incomplete;
+	}
+
+	// Chunks already received are skipped, only the last line is parsed again.
+	while (true)
+	{
+		const size_t LineEnd = Input.find("\r\n", Connection.ChunkOffset);
+
+		if (LineEnd == std::string::npos)
+		{
+			if (Input.size() - Connection.ChunkOffset > BlueprintHttpEpoll::MaxChunkLine)
+			{
+				OutStatus = 400;
+				return EFrameResult::Error;
+			}
+
+			return EFrameResult::Incomplete;
+		}
+
+		size_t ChunkSize = 0;
+		size_t NumDigits = 0;
+		for (size_t Index = Connection.ChunkOffset; Index < LineEnd; ++Index, ++NumDigits)
+		{
+			const int32 Digit = BlueprintHttpEpoll::HexValue(Input[Index]);
+			if (Digit < 0)
+			{
+				break;
+			}
+
+			if (ChunkSize > (SIZE_MAX >> 4))
+			{
+				OutStatus = 400;
+				return EFrameResult::Error;
+			}
+
+			ChunkSize = (ChunkSize << 4) | Digit;
+		}
+
+		if (NumDigits == 0)
+		{
+			OutStatus = 400;
+			return EFrameResult::Error;
+		}
+
+		// Last chunk, followed by optional trailers and an empty line.
+		if (ChunkSize == 0)
+		{
+			const size_t TrailerStart = LineEnd + 2;
+
+			if (Input.size() < TrailerStart + 2)
+			{
+				return EFrameResult::Incomplete;
+			}
+
+			if (Input.compare(TrailerStart, 2, "\r\n") == 0)
+			{
+				Connection.RequestLength = TrailerStart + 2;
+				return EFrameResult::Complete;
+			}
+
+			const size_t TrailerEnd = Input.find("\r\n\r\n", TrailerStart);
+			if (TrailerEnd == std::string::npos)
+			{
+				if (Input.size() - TrailerStart > BlueprintHttpEpoll::MaxHeadLength)
+				{
+					OutStatus = 431;
+					return EFrameResult::Error;
+				}
+
+				return EFrameResult::Incomplete;
+			}
+
+			Connection.RequestLength = TrailerEnd + 4;
+			return EFrameResult::Complete;
+		}
+
+		if (ChunkSize > MaxPayloadLength - Connection.BodyLength)
+		{
+			OutStatus = 413;
+			return EFrameResult::Error;
+		}
+
+		const size_t NextChunk = LineEnd + 2 + ChunkSize + 2;
+		if (Input.size() < NextChunk)
+		{
+			return EFrameResult::Incomplete;
+		}
+
+		Connection.BodyLength += ChunkSize;
+		Connection.ChunkOffset = NextChunk;
+	}
+}
+
+void FBlueprintHttpEpollServer::ProcessCompletions(FLoop& Loop)
+{
+	std::vector<FLoop::FCompletion> Completions;
+	{
+		std::lock_guard<std::mutex> Lock(Loop.CompletionMutex);
+		Completions.swap(Loop.Completions);
+	}
+
+	for (FLoop::FCompletion& Completion : Completions)
+	{
+		// The connection may have been closed, and its descriptor reused, meanwhile.
+		const auto Found = Loop.Connections.find(Completion.Socket);
+		if (Found == Loop.Connections.end() || Found->second->Id != Completion.Id || Found->second->bClosed)
+		{
+			continue;
+		}
+
+		FConnection& Connection = *Found->second;
+		Connection.bDispatched = false;
+
+		if (Completion.Response.empty())
+		{
+			CloseConnection(Loop, Connection);
+			continue;
+		}
+
+		Connection.Output		= MoveTemp(Completion.Response);
+		Connection.OutputOffset = 0;
+
+		Touch(Loop, Connection);
+		FlushOutput(Loop, Connection);
+	}
+}
+
+void FBlueprintHttpEpollServer::FlushOutput(FLoop& Loop, FConnection& Connection)
+{
+	while (Connection.HasPendingOutput())
+	{
+		const ssize_t Sent = send(Connection.Socket, Connection.Output.data() + Connection.OutputOffset,
+			Connection.Output.size() - Connection.OutputOffset, MSG_NOSIGNAL);
+
+		if (Sent > 0)
+		{
+			Connection.OutputOffset += Sent;
+		}
+		else if (Sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			if (!Connection.bWantWrite)
+			{
+				UpdateEvents(Loop, Connection, true);
+			}
+
+			Touch(Loop, Connection);
+			return;
+		}
+		else if (Sent == 0 || errno != EINTR)
+		{
+			CloseConnection(Loop, Connection);
+			return;
+		}
+	}
+
+	// Don't keep the capacity of large responses on idle connections.
+	std::string().swap(Connection.Output);
+	Connection.OutputOffset = 0;
+
+	if (Connection.bWantWrite)
+	{
+		UpdateEvents(Loop, Connection, false);
+	}
+
+	if (Connection.bCloseAfterWrite)
+	{
+		CloseConnection(Loop, Connection);
+		return;
+	}
+
+	Touch(Loop, Connection);
+
+	// Reads were paused while the response was pending, and
+	// the next request may already be buffered.
+	if (Connection.bReadPaused)
+	{
+		OnReadable(Loop, Connection);
+	}
+	else
+	{
+		TryDispatch(Loop, Connection);
+	}
+}
+
+void FBlueprintHttpEpollServer::SendErrorAndClose(FLoop& Loop, FConnection& Connection, const int32 Status)
+{
+	Connection.Input.clear();
+	Connection.bCloseAfterWrite = true;
+
+	Connection.Output = "HTTP/1.1 " + std::to_string(Status) + " " + httplib::detail::status_message(Status) +
+		"\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+	Connection.OutputOffset = 0;
+
+	FlushOutput(Loop, Connection);
+}
+
+void FBlueprintHttpEpollServer::UpdateEvents(FLoop& Loop, FConnection& Connection, const bool bWantWrite)
+{
+	Connection.bWantWrite = bWantWrite;
+
+	epoll_event Event = {};
+	Event.events  = BlueprintHttpEpoll::ConnectionEvents | (bWantWrite ? EPOLLOUT : 0);
+	Event.data.fd = Connection.Socket;
+
+	epoll_ctl(Loop.EpollFd, EPOLL_CTL_MOD, Connection.Socket, &Event);
+}
+
+void FBlueprintHttpEpollServer::CloseIdleConnections(FLoop& Loop)
+{
+	const int64 Now = BlueprintHttpEpoll::NowMs();
+
+	while (Loop.IdleHead && Now - Loop.IdleHead->LastActivityMs > IdleTimeoutMs)
+	{
+		CloseConnection(Loop, *Loop.IdleHead);
+	}
+}
+
+void FBlueprintHttpEpollServer::CloseConnection(FLoop& Loop, FConnection& Connection)
+{
+	if (Connection.bClosed)
+	{
+		return;
+	}
+
+	Connection.bClosed = true;
+	Unlink(Loop, Connection);
+
+	epoll_ctl(Loop.EpollFd, EPOLL_CTL_DEL, Connection.Socket, nullptr);
+
+	Loop.Closed.push_back(Connection.Socket);
+}
+
+void FBlueprintHttpEpollServer::ReleaseClosedConnections(FLoop& Loop)
+{
+	for (const int Socket : Loop.Closed)
+	{
+		shutdown(Socket, SHUT_RDWR);
+		close(Socket);
+
+		Loop.Connections.erase(Socket);
+		Loop.NumConnections.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	Loop.Closed.clear();
+}
+
+void FBlueprintHttpEpollServer::Touch(FLoop& Loop, FConnection& Connection)
+{
+	Unlink(Loop, Connection);
+
+	Connection.LastActivityMs = BlueprintHttpEpoll::NowMs();
+	Connection.Prev			  = Loop.IdleTail;
+	Connection.Next			  = nullptr;
+	Connection.bLinked		  = true;
+
+	if (Loop.IdleTail)
+	{
+		Loop.IdleTail->Next = &Connection;
+	}
+	else
+	{
+		Loop.IdleHead = &Connection;
+	}
+
+	Loop.IdleTail = &Connection;
+}
+
+void FBlueprintHttpEpollServer::Unlink(FLoop& Loop, FConnection& Connection)
+{
+	if (!Connection.bLinked)
+	{
+		return;
+	}
+
+	(Connection.Prev ? Connection.Prev->Next : Loop.IdleHead) = Connection.Next;
+	(Connection.Next ? Connection.Next->Prev : Loop.IdleTail) = Connection.Prev;
+
+	Connection.Prev	   = nullptr;
+	Connection.Next	   = nullptr;
+	Connection.bLinked = false;
+}
+
+#endif // PLATFORM_LINUX
@@ -0,0 +1,140 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if PLATFORM_LINUX
+
+#include "BlueprintHttpLib.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Event driven server core for Linux.
+ * A few I/O threads each own an epoll instance and the connections they
+ * accepted. Sockets are non-blocking and requests are framed as bytes
+ * arrive, so an idle keep-alive connection costs a buffer instead of a
+ * thread. Complete requests are routed by the httplib server on its task
+ * queue and the responses are written back by the connection's I/O thread.
+ * Content providers are fully buffered before being written.
+*/
+class FBlueprintHttpEpollServer final
+{
+public:
+	/**
+	 * @param InServer		 The server routing the requests.
+	 * @param InNumIoThreads The number of threads waiting on sockets.
+	*/
+	FBlueprintHttpEpollServer(const TSharedRef<httplib::Server, ESPMode::ThreadSafe>& InServer, const int32 InNumIoThreads = 2);
+
+	~FBlueprintHttpEpollServer();
+
+	/**
+	 * Binds the listening socket and starts the I/O threads.
+	 * @return False if the socket couldn't be bound.
+	*/
+	bool Listen(const char* Host, const int32 Port);
+
+	/**
+	 * Closes all connections and joins the threads.
+	*/
+	void Stop();
+
+	/**
+	 * Gets the number of open connections.
+	*/
+	int32 GetNumConnections() const;
+
+private:
+	struct FConnection;
+	struct FLoop;
+
+	enum class EFrameResult : uint8
+	{
+		Incomplete,
+		Complete,
+		Error
+	};
+
+	void LoopMain(FLoop& Loop);
+
+	void Accept(FLoop& Loop);
+	void OnReadable(FLoop& Loop, FConnection& Connection);
+	void ProcessCompletions(FLoop& Loop);
+	void CloseIdleConnections(FLoop& Loop);
+
+	/**
+	 * Stops watching the connection. The socket is closed once the
+	 * current events are handled so its descriptor can't be reused before.
+	*/
+	void CloseConnection(FLoop& Loop, FConnection& Connection);
+	void ReleaseClosedConnections(FLoop& Loop);
+
+	/**
+	 * Reads the socket until it would block, or until ReadLimit() is reached.
+	 * @return False if the connection was closed.
+	*/
+	bool ReadInput(FLoop& Loop, FConnection& Connection);
+
+	/**
+	 * The input that can be buffered: the read-ahead if a response is pending,
+	 * else as much as the request being framed can still be within its caps.
+	*/
+	size_t ReadLimit(const FConnection& Connection) const;
+
+	/**
+	 * Hands the first buffered request to the task queue, if complete.
+	*/
+	void TryDispatch(FLoop& Loop, FConnection& Connection);
+
+	/**
+	 * Finds where the first buffered request ends, without copying it.
+	 * @param OutStatus The status to answer with if the request is rejected.
+	*/
+	EFrameResult FrameRequest(FConnection& Connection, int32& OutStatus) const;
+
+	/**
+	 * Writes the pending output until the socket would block.
+	*/
+	void FlushOutput(FLoop& Loop, FConnection& Connection);
+
+	/**
+	 * Writes an empty response with this status, then closes the connection.
+	*/
+	void SendErrorAndClose(FLoop& Loop, FConnection& Connection, const int32 Status);
+
+	void UpdateEvents(FLoop& Loop, FConnection& Connection, const bool bWantWrite);
+
+	static void Touch (FLoop& Loop, FConnection& Connection);
+	static void Unlink(FLoop& Loop, FConnection& Connection);
+
+private:
+	TSharedRef<httplib::Server, ESPMode::ThreadSafe> Server;
+
+	const int32 NumIoThreads;
+
+	int ListenSocket;
+
+	std::vector<std::shared_ptr<FLoop>> Loops;
+
+	std::unique_ptr<httplib::TaskQueue> Workers;
+
+	std::atomic<bool>	Stopping;
+	std::atomic<uint64> NextConnectionId;
+
+	/**
+	 * Limits read from the httplib server when listening.
+	*/
+	size_t MaxPayloadLength;
+	size_t MaxRequestsPerConnection;
+	int64  IdleTimeoutMs;
+};
+
+#endif // PLATFORM_LINUX
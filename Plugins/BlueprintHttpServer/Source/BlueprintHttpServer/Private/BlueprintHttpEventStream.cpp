@@ -0,0 +1,407 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#include "BlueprintHttpEventStream.h"
+
+#include "BlueprintHttpServerModule.h"
+
+namespace BlueprintHttpEventStream
+{
+	// A comment is sent after this much silence so proxies keep the connection.
+	static constexpr double KeepAliveSeconds = 15.0;
+
+	// How often the thread checks the keep-alives while there are subscribers.
+	static constexpr int KeepAlivePollMs = 1000;
+
+	// Sent first, how long EventSource waits before reconnecting.
+	static const std::shared_ptr<const std::string> Retry = std::make_shared<const std::string>("retry: 1000\n\n");
+
+	static const std::shared_ptr<const std::string> KeepAlive = std::make_shared<const std::string>(":\n\n");
+}
+
+struct FBlueprintHttpEventStreamHub::FTopic
+{
+	/**
+	 * The latest event, null until published.
+	*/
+	FEventPtr Latest;
+
+	/**
+	 * Incremented with each event, subscribers compare it to the last version they sent.
+	*/
+	uint64 Version = 0;
+};
+
+struct FBlueprintHttpEventStreamHub::FStream
+{
+	std::vector<FTopicPtr> Topics;
+};
+
+struct FBlueprintHttpEventStreamHub::FSubscriber
+{
+	socket_t Socket = INVALID_SOCKET;
+	FStreamPtr Stream;
+
+	/**
+	 * The version of each topic of the stream last taken.
+	*/
+	std::vector<uint64> Versions;
+
+	/**
+	 * The event being written and the bytes already written.
+	*/
+	FEventPtr Current;
+	size_t	  Offset = 0;
+
+	double LastWrite = 0.0;
+};
+
+FBlueprintHttpEventStreamHub::FBlueprintHttpEventStreamHub()
+	: bDisconnectAll(false)
+	, bStopping(false)
+{
+	Thread = std::thread([this]() -> void
+	{
+		Run();
+	});
+}
+
+FBlueprintHttpEventStreamHub::~FBlueprintHttpEventStreamHub()
+{
+	bStopping = true;
+	WakeSocket.Wake();
+
+	if (Thread.joinable())
+	{
+		Thread.join();
+	}
+
+	for (const FSubscriberPtr& Subscriber : Subscribers)
+	{
+		httplib::detail::close_socket(Subscriber->Socket);
+	}
+
+	for (const auto& Socket : Subscribed)
+	{
+		httplib::detail::close_socket(Socket.second);
+	}
+}
+
+FBlueprintHttpEventStreamHub::FStreamPtr FBlueprintHttpEventStreamHub::MakeStream(const TArray<FString>& TopicNames)
+{
+	std::shared_ptr<FStream> Stream = std::make_shared<FStream>();
+
+	FScopeLock Lock(&Mutex);
+
+	for (const FString& TopicName : TopicNames)
+	{
+		Stream->Topics.push_back(FindOrAddTopic(TCHAR_TO_UTF8(*TopicName)));
+	}
+
+	return Stream;
+}
+
+void FBlueprintHttpEventStreamHub::Subscribe(const FStreamPtr& Stream, const httplib::Request& Request, httplib::Response& Response)
+{
+	Response.status = 200;
+	Response.set_header("Content-Type",		 "text/event-stream");
+	Response.set_header("Cache-Control",	 "no-cache");
+	Response.set_header("Connection",		 "close");
+	Response.set_header("X-Accel-Buffering", "no");
+
+	// The stream ends when the connection is closed.
+	Response.upgrade([this, Stream](socket_t Socket) -> void
+	{
+		{
+			FScopeLock Lock(&Mutex);
+			Subscribed.emplace_back(Stream, Socket);
+		}
+
+		WakeSocket.Wake();
+	});
+}
+
+void FBlueprintHttpEventStreamHub::Publish(const std::string& TopicName, const char* const Data, const size_t Size)
+{
+	std::shared_ptr<std::string> Event = std::make_shared<std::string>();
+	Event->reserve(TopicName.size() + Size + 32);
+
+	Event->append("event: ").append(TopicName).append("\n");
+
+	// Each line is a data field, EventSource joins them back with line feeds.
+	size_t Start = 0;
+	for (;;)
+	{
+		size_t End = Start;
+		while (End < Size && Data[End] != '\n' && Data[End] != '\r')
+		{
+			++End;
+		}
+
+		Event->append("data: ").append(Data + Start, End - Start).append("\n");
+
+		if (End == Size)
+		{
+			break;
+		}
+
+		Start = End + (Data[End] == '\r' && End + 1 < Size && Data[End + 1] == '\n' ? 2 : 1);
+
+		if (Start == Size)
+		{
+			break;
+		}
+	}
+
+	Event->append("\n");
+
+	{
+		FScopeLock Lock(&Mutex);
+
+		const FTopicPtr Topic = FindOrAddTopic(TopicName);
+		Topic->Latest = MoveTemp(Event);
+		Topic->Version++;
+	}
+
+	WakeSocket.Wake();
+}
+
+void FBlueprintHttpEventStreamHub::DisconnectAll()
+{
+	bDisconnectAll = true;
+	WakeSocket.Wake();
+}
+
+int32 FBlueprintHttpEventStreamHub::GetNumSubscribers() const
+{
+	FScopeLock Lock(&Mutex);
+
+	return static_cast<int32>(Subscribers.size());
+}
+
+void FBlueprintHttpEventStreamHub::Run()
+{
+	std::vector<pollfd>			Fds;
+	std::vector<FSubscriberPtr> Polled;
+	std::vector<FSubscriberPtr> Dropped;
+
+	while (!bStopping)
+	{
+		AcceptSubscribed();
+
+		if (bDisconnectAll.exchange(false))
+		{
+			{
+				FScopeLock Lock(&Mutex);
+				Dropped.swap(Subscribers);
+			}
+
+			Disconnect(Dropped);
+		}
+
+		Fds.clear();
+		Polled.clear();
+
+		if (WakeSocket.IsValid())
+		{
+			pollfd& Fd = Fds.emplace_back();
+			Fd.fd	   = WakeSocket.GetSocket();
+			Fd.events  = POLLIN;
+			Fd.revents = 0;
+		}
+
+		const size_t FirstSubscriber = Fds.size();
+
+		{
+			const double Now = FPlatformTime::Seconds();
+
+			FScopeLock Lock(&Mutex);
+
+			for (const FSubscriberPtr& Subscriber : Subscribers)
+			{
+				// Polled for reads to notice disconnections, subscribers don't send anything.
+				pollfd& Fd = Fds.emplace_back();
+				Fd.fd	   = Subscriber->Socket;
+				Fd.events  = NextEvent(*Subscriber, Now) ? (POLLIN | POLLOUT) : POLLIN;
+				Fd.revents = 0;
+
+				Polled.push_back(Subscriber);
+			}
+		}
+
+		const int TimeoutMs = !WakeSocket.IsValid() ? 10 : (Polled.empty() ? -1 : BlueprintHttpEventStream::KeepAlivePollMs);
+
+		if (BlueprintHttpSocket::Poll(Fds.data(), Fds.size(), TimeoutMs) < 0 && !BlueprintHttpSocket::WouldBlock())
+		{
+			UE_LOG(LogHttpServer, Error, TEXT("Event stream poll() failed, disconnecting all subscribers."));
+
+			bDisconnectAll = true;
+			FPlatformProcess::Sleep(0.1f);
+			continue;
+		}
+
+		if (FirstSubscriber > 0 && Fds[0].revents != 0)
+		{
+			WakeSocket.Drain();
+		}
+
+		const double Now = FPlatformTime::Seconds();
+
+		for (size_t Index = 0; Index < Polled.size(); ++Index)
+		{
+			FSubscriber& Subscriber = *Polled[Index];
+			const short Events = Fds[FirstSubscriber + Index].revents;
+
+			bool bKeep = (Events & (POLLERR | POLLNVAL)) == 0;
+
+			if (bKeep && (Events & (POLLIN | POLLHUP)))
+			{
+				char Buffer[256];
+				const ssize_t Read = BlueprintHttpSocket::Recv(Subscriber.Socket, Buffer, sizeof(Buffer));
+
+				bKeep = Read > 0 || (Read < 0 && BlueprintHttpSocket::WouldBlock());
+			}
+
+			if (bKeep && (Events & POLLOUT))
+			{
+				bKeep = OnWritable(Subscriber, Now);
+			}
+
+			if (!bKeep)
+			{
+				Dropped.push_back(Polled[Index]);
+			}
+		}
+
+		if (Dropped.size() > 0)
+		{
+			{
+				FScopeLock Lock(&Mutex);
+
+				for (const FSubscriberPtr& Subscriber : Dropped)
+				{
+					Subscribers.erase(std::remove(Subscribers.begin(), Subscribers.end(), Subscriber), Subscribers.end());
+				}
+			}
+
+			Disconnect(Dropped);
+		}
+	}
+}
+
+void FBlueprintHttpEventStreamHub::Disconnect(std::vector<FSubscriberPtr>& Dropped)
+{
+	for (const FSubscriberPtr& Subscriber : Dropped)
+	{
+		httplib::detail::shutdown_socket(Subscriber->Socket);
+		httplib::detail::close_socket(Subscriber->Socket);
+	}
+
+	Dropped.clear();
+}
+
+void FBlueprintHttpEventStreamHub::AcceptSubscribed()
+{
+	std::vector<std::pair<FStreamPtr, socket_t>> Sockets;
+
+	{
+		FScopeLock Lock(&Mutex);
+		Sockets.swap(Subscribed);
+	}
+
+	for (auto& Socket : Sockets)
+	{
+		BlueprintHttpSocket::Adopt(Socket.second);
+
+		FSubscriberPtr Subscriber = std::make_shared<FSubscriber>();
+		Subscriber->Socket	  = Socket.second;
+		Subscriber->Stream	  = MoveTemp(Socket.first);
+		Subscriber->Current	  = BlueprintHttpEventStream::Retry;
+		Subscriber->LastWrite = FPlatformTime::Seconds();
+
+		// Topics are never published with version 0, the latest events are sent first.
+		Subscriber->Versions.resize(Subscriber->Stream->Topics.size(), 0);
+
+		FScopeLock Lock(&Mutex);
+		Subscribers.push_back(MoveTemp(Subscriber));
+	}
+}
+
+bool FBlueprintHttpEventStreamHub::NextEvent(FSubscriber& Subscriber, const double Now)
+{
+	if (Subscriber.Current)
+	{
+		return true;
+	}
+
+	const std::vector<FTopicPtr>& StreamTopics = Subscriber.Stream->Topics;
+
+	for (size_t Index = 0; Index < StreamTopics.size(); ++Index)
+	{
+		const FTopic& Topic = *StreamTopics[Index];
+
+		// Events published meanwhile are skipped, only the latest is sent.
+		if (Topic.Version != Subscriber.Versions[Index])
+		{
+			Subscriber.Versions[Index] = Topic.Version;
+			Subscriber.Current		   = Topic.Latest;
+			Subscriber.Offset		   = 0;
+			return true;
+		}
+	}
+
+	if (Now - Subscriber.LastWrite >= BlueprintHttpEventStream::KeepAliveSeconds)
+	{
+		Subscriber.Current = BlueprintHttpEventStream::KeepAlive;
+		Subscriber.Offset  = 0;
+		return true;
+	}
+
+	return false;
+}
+
+bool FBlueprintHttpEventStreamHub::OnWritable(FSubscriber& Subscriber, const double Now)
+{
+	for (;;)
+	{
+		if (!Subscriber.Current)
+		{
+			FScopeLock Lock(&Mutex);
+
+			if (!NextEvent(Subscriber, Now))
+			{
+				return true;
+			}
+		}
+
+		const std::string& Event = *Subscriber.Current;
+
+		const ssize_t Written = BlueprintHttpSocket::Send(Subscriber.Socket, Event.data() + Subscriber.Offset, Event.size() - Subscriber.Offset);
+
+		if (Written < 0)
+		{
+			return BlueprintHttpSocket::WouldBlock();
+		}
+
+		Subscriber.LastWrite = Now;
+		Subscriber.Offset	+= static_cast<size_t>(Written);
+
+		if (Subscriber.Offset < Event.size())
+		{
+			return true;
+		}
+
+		Subscriber.Current.reset();
+	}
+}
+
+FBlueprintHttpEventStreamHub::FTopicPtr FBlueprintHttpEventStreamHub::FindOrAddTopic(const std::string& Name)
+{
+	FTopicPtr& Topic = Topics[Name];
+
+	if (!Topic)
+	{
+		Topic = std::make_shared<FTopic>();
+	}
+
+	return Topic;
+}
@@ -0,0 +1,117 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "BlueprintHttpLib.h"
+#include "BlueprintHttpSocket.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The Server-Sent Events subscribers of a server.
+ * A topic only keeps its latest event, serialized once when published, so
+ * publishing costs the same whatever the number of subscribers.
+ * Subscriber sockets leave the HTTP workers and are all written by one
+ * thread. A subscriber still writing an event when newer ones are published
+ * skips to the latest: slow clients lag by at most one event per topic.
+*/
+class FBlueprintHttpEventStreamHub final
+{
+public:
+	struct FStream;
+
+	using FStreamPtr = std::shared_ptr<const FStream>;
+
+	FBlueprintHttpEventStreamHub();
+	~FBlueprintHttpEventStreamHub();
+
+	/**
+	 * Creates the stream of a route.
+	 * @param Topics The topics its subscribers receive.
+	*/
+	FStreamPtr MakeStream(const TArray<FString>& Topics);
+
+	/**
+	 * Answers a subscription request. The connection is handed over
+	 * to the hub once the response headers are written.
+	*/
+	void Subscribe(const FStreamPtr& Stream, const httplib::Request& Request, httplib::Response& Response);
+
+	/**
+	 * Replaces the event of a topic. Thread safe.
+	 * @param Data The event data, UTF-8 encoded. Sent as one data field per line.
+	*/
+	void Publish(const std::string& Topic, const char* const Data, const size_t Size);
+
+	/**
+	 * Disconnects all subscribers, used when the server stops. Thread safe.
+	*/
+	void DisconnectAll();
+
+	int32 GetNumSubscribers() const;
+
+private:
+	struct FTopic;
+	struct FSubscriber;
+
+	using FEventPtr		 = std::shared_ptr<const std::string>;
+	using FTopicPtr		 = std::shared_ptr<FTopic>;
+	using FSubscriberPtr = std::shared_ptr<FSubscriber>;
+
+	void Run();
+
+	/**
+	 * Registers the subscribers handed over since the last iteration.
+	*/
+	void AcceptSubscribed();
+
+	/**
+	 * Takes the next event to write, if any. Mutex must be held.
+	*/
+	bool NextEvent(FSubscriber& Subscriber, const double Now);
+
+	/**
+	 * Writes the pending events until the socket is full.
+	 * @return False if the subscriber must be dropped.
+	*/
+	bool OnWritable(FSubscriber& Subscriber, const double Now);
+
+	/**
+	 * Closes the sockets of subscribers no longer in the list.
+	*/
+	static void Disconnect(std::vector<FSubscriberPtr>& Dropped);
+
+	/**
+	 * Gets or creates a topic. Mutex must be held.
+	*/
+	FTopicPtr FindOrAddTopic(const std::string& Name);
+
+private:
+	mutable FCriticalSection Mutex;
+
+	std::unordered_map<std::string, FTopicPtr> Topics;
+
+	/**
+	 * Only touched by the thread, the mutex is held to modify it.
+	*/
+	std::vector<FSubscriberPtr> Subscribers;
+
+	/**
+	 * Sockets handed over by the HTTP workers, waiting for the thread.
+	*/
+	std::vector<std::pair<FStreamPtr, socket_t>> Subscribed;
+
+	FBlueprintHttpWakeSocket WakeSocket;
+
+	std::atomic<bool> bDisconnectAll;
+	std::atomic<bool> bStopping;
+
+	std::thread Thread;
+};
@@ -0,0 +1,114 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#include "BlueprintHttpGameThreadDispatcher.h"
+
+#include "HAL/IConsoleManager.h"
+#include "BlueprintHttpServerModule.h"
+
+static float GHttpGameThreadBudgetMs = 2.f;
+static FAutoConsoleVariableRef CVarHttpGameThreadBudgetMs(
+	TEXT("HttpServer.GameThreadBudgetMs"),
+	GHttpGameThreadBudgetMs,
+	TEXT("Time in milliseconds spent each frame running HTTP route callbacks that require the game thread."));
+
+FBlueprintHttpGameThreadDispatcher& FBlueprintHttpGameThreadDispatcher::Get()
+{
+	static FBlueprintHttpGameThreadDispatcher Instance;
+	return Instance;
+}
+
+void FBlueprintHttpGameThreadDispatcher::Startup()
+{
+	if (!TickerHandle.IsValid())
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FBlueprintHttpGameThreadDispatcher::Tick));
+	}
+}
+
+void FBlueprintHttpGameThreadDispatcher::Shutdown()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	// Pending responses are sent by their timeout.
+	TUniqueFunction<void()> Job;
+	while (Jobs.Dequeue(Job))
+	{
+		NumPending--;
+	}
+}
+
+void FBlueprintHttpGameThreadDispatcher::Enqueue(TUniqueFunction<void()> Job)
+{
+	NumPending++;
+	Jobs.Enqueue(MoveTemp(Job));
+}
+
+void FBlueprintHttpGameThreadDispatcher::SetBudget(const float BudgetMilliseconds)
+{
+	ensure(BudgetMilliseconds >= 0.f);
+
+	GHttpGameThreadBudgetMs = FMath::Max(0.f, BudgetMilliseconds);
+}
+
+FHttpGameThreadDispatchStats FBlueprintHttpGameThreadDispatcher::GetStats() const
+{
+	FHttpGameThreadDispatchStats ReturnValue = Stats;
+	ReturnValue.Pending = NumPending;
+	return ReturnValue;
+}
+
+bool FBlueprintHttpGameThreadDispatcher::Tick(float DeltaTime)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_BlueprintHttpGameThreadDispatch);
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double EndTime   = StartTime + GHttpGameThreadBudgetMs / 1000.0;
+
+	int32 Drained = 0;
+
+	TUniqueFunction<void()> Job;
+	while ((Drained == 0 || FPlatformTime::Seconds() < EndTime) && Jobs.Dequeue(Job))
+	{
+		NumPending--;
+		Job();
+		Drained++;
+	}
+
+	const float TickMs = static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	Stats.LastFrameDispatched = Drained;
+	Stats.LastFrameMs		  = TickMs;
+	Stats.MaxFrameMs		  = FMath::Max(Stats.MaxFrameMs, TickMs);
+	Stats.TotalDispatched	 += Drained;
+
+	if (Drained > 0 && !Jobs.IsEmpty())
+	{
+		Stats.OverflowFrames++;
+
+		UE_LOG(LogHttpServer, Verbose, TEXT("Game thread budget of %.2f ms reached after %d callbacks, %d left for next frame."), 
+			GHttpGameThreadBudgetMs, Drained, NumPending.Load());
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// HttpServer.DispatchStats
+
+static void LogHttpDispatchStats()
+{
+	const FHttpGameThreadDispatchStats Stats = FBlueprintHttpGameThreadDispatcher::Get().GetStats();
+
+	UE_LOG(LogHttpServer, Display, TEXT("Game thread dispatch: budget %.2f ms, last frame %d callbacks in %.2f ms, max %.2f ms, pending %d, overflow frames %lld, total %lld."),
+		GHttpGameThreadBudgetMs, Stats.LastFrameDispatched, Stats.LastFrameMs, Stats.MaxFrameMs, 
+		Stats.Pending, Stats.OverflowFrames, Stats.TotalDispatched);
+}
+
+static FAutoConsoleCommand HttpDispatchStatsCommand(
+	TEXT("HttpServer.DispatchStats"),
+	TEXT("Logs the statistics of the HTTP route callbacks run on the game thread."),
+	FConsoleCommandDelegate::CreateStatic(&LogHttpDispatchStats));
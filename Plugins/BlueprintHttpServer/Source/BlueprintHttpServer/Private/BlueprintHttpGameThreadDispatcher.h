@@ -0,0 +1,61 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Containers/Ticker.h"
+#include "BlueprintHttpServer.h"
+
+/**
+ * Runs the route callbacks requiring the game thread.
+ * HTTP workers push callbacks into a lock-free MPSC queue that is drained
+ * once per frame from the core ticker, within a time budget, instead of
+ * creating one task graph task per request.
+ * At least one callback runs each frame so the queue always progresses.
+*/
+class FBlueprintHttpGameThreadDispatcher final
+{
+public:
+	static FBlueprintHttpGameThreadDispatcher& Get();
+
+	/**
+	 * Registers the ticker. Called at module startup.
+	*/
+	void Startup();
+
+	/**
+	 * Removes the ticker and drops the queued callbacks. Called at module shutdown.
+	*/
+	void Shutdown();
+
+	/**
+	 * Queues a callback to run on the game thread. Thread safe.
+	 * @param Job The callback.
+	*/
+	void Enqueue(TUniqueFunction<void()> Job);
+
+	/**
+	 * Sets the time spent running callbacks each frame. Game thread only.
+	 * @param BudgetMilliseconds The budget, in milliseconds.
+	*/
+	void SetBudget(const float BudgetMilliseconds);
+
+	/**
+	 * Gets the dispatch statistics. Game thread only.
+	*/
+	FHttpGameThreadDispatchStats GetStats() const;
+
+private:
+	FBlueprintHttpGameThreadDispatcher() = default;
+
+	bool Tick(float DeltaTime);
+
+private:
+	TQueue<TUniqueFunction<void()>, EQueueMode::Mpsc> Jobs;
+	TAtomic<int32> NumPending { 0 };
+
+	FTSTicker::FDelegateHandle TickerHandle;
+
+	FHttpGameThreadDispatchStats Stats;
+};
@@ -0,0 +1,19 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if PLATFORM_WINDOWS
+#	include "Windows/AllowWindowsPlatformTypes.h"
+#endif // PLATFORM_WINDOWS
+
+#define UI UI_ST
+THIRD_PARTY_INCLUDES_START
+#	include <httplib.h>
+THIRD_PARTY_INCLUDES_END
+#undef UI
+
+#if PLATFORM_WINDOWS
+#	include "Windows/HideWindowsPlatformTypes.h"
+#endif // PLATFORM_WINDOWS
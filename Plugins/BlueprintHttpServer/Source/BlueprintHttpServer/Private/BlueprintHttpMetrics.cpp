@@ -0,0 +1,515 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#include "BlueprintHttpMetrics.h"
+
+#include "BlueprintHttpServerModule.h"
+
+#include <cstdarg>
+#include <unordered_map>
+
+namespace BlueprintHttpMetrics
+{
+	static std::atomic<uint64> NextMetricsId{ 1 };
+
+	// Queue wait of the job running on this thread.
+	static thread_local uint64 PendingQueueWaitUs = 0;
+
+	static uint64 CyclesToMicroseconds(const uint64 Cycles)
+	{
+		return static_cast<uint64>(FPlatformTime::ToSeconds64(Cycles) * 1000000.0);
+	}
+
+	static uint64 MicrosecondsSince(const uint64 StartCycles)
+	{
+		const uint64 Now = FPlatformTime::Cycles64();
+		return Now > StartCycles ? CyclesToMicroseconds(Now - StartCycles) : 0;
+	}
+
+	static void AppendEscaped(std::string& Out, const std::string& Value)
+	{
+		for (const char Character : Value)
+		{
+			switch (Character)
+			{
+			case '\\': Out += "\\\\"; break;
+			case '"':  Out += "\\\""; break;
+			case '\n': Out += "\\n";  break;
+			default:   Out += Character;
+			}
+		}
+	}
+
+	static void AppendFormat(std::string& Out, const char* Format, ...)
+	{
+		char Buffer[256];
+
+		va_list Args;
+		va_start(Args, Format);
+		const int Length = vsnprintf(Buffer, sizeof(Buffer), Format, Args);
+		va_end(Args);
+
+		if (Length > 0)
+		{
+			Out.append(Buffer, FMath::Min<int>(Length, sizeof(Buffer) - 1));
+		}
+	}
+
+	static void AppendHeader(std::string& Out, const char* Name, const char* Type, const char* Help)
+	{
+		AppendFormat(Out, "# HELP %s %s\n# TYPE %s %s\n", Name, Help, Name, Type);
+	}
+
+	static int64 RequestBytes(const httplib::Request& Request)
+	{
+		// Request line and headers as sent, ignoring the ones httplib adds.
+		int64 Bytes = Request.method.size() + Request.target.size() + Request.version.size() + 4;
+		Request.for_each_header([&Bytes](const std::string_view Key, const std::string_view Value)
+		{
+			if (Key != "REMOTE_ADDR" && Key != "REMOTE_PORT")
+			{
+				Bytes += Key.size() + Value.size() + 4;
+			}
+		});
+
+		return Bytes + 2 + Request.body.size();
+	}
+
+	static int64 ResponseBytes(const httplib::Request& Request, const httplib::Response& Response)
+	{
+		int64 Bytes = 32;
+		for (const auto& Header : Response.headers)
+		{
+			Bytes += Header.first.size() + Header.second.size() + 4;
+		}
+
+		// Bodies compressed while streamed are counted by the compression metrics.
+		if (Request.method != "HEAD" && (!Response.body.empty() || Response.content_provider_encoding_ == httplib::detail::EncodingType::None))
+		{
+			Bytes += Response.body.empty() ? Response.content_length_ : Response.body.size();
+		}
+
+		return Bytes;
+	}
+}
+
+class FBlueprintHttpMetrics::FInstrumentedQueue final : public httplib::TaskQueue
+{
+public:
+	FInstrumentedQueue(const TSharedRef<FBlueprintHttpMetrics, ESPMode::ThreadSafe>& InMetrics, httplib::TaskQueue* const InQueue)
+		: Metrics(InMetrics)
+		, Queue(InQueue)
+	{
+	}
+
+	virtual void enqueue(std::function<void()> Job) override
+	{
+		Metrics->GetShard().QueueDepth.Add(1);
+
+		Queue->enqueue([this, EnqueueCycles = FPlatformTime::Cycles64(), Job = MoveTemp(Job)]() -> void
+		{
+			Metrics->GetShard().QueueDepth.Add(-1);
+
+			BlueprintHttpMetrics::PendingQueueWaitUs = BlueprintHttpMetrics::MicrosecondsSince(EnqueueCycles);
+			Job();
+			BlueprintHttpMetrics::PendingQueueWaitUs = 0;
+		});
+	}
+
+	virtual void shutdown() override
+	{
+		Queue->shutdown();
+	}
+
+	virtual void on_idle() override
+	{
+		Queue->on_idle();
+	}
+
+private:
+	TSharedRef<FBlueprintHttpMetrics, ESPMode::ThreadSafe> Metrics;
+	std::unique_ptr<httplib::TaskQueue> Queue;
+};
+
+void FBlueprintHttpRequestTiming::RecordGameThreadWait(const uint64 EnqueueCycles) const
+{
+	if (Metrics && RouteIndex != INDEX_NONE)
+	{
+		Metrics->GetShard().GetRoute(RouteIndex).GameThreadWait.Record(BlueprintHttpMetrics::MicrosecondsSince(EnqueueCycles));
+	}
+}
+
+void FBlueprintHttpRequestTiming::End() const
+{
+	if (!Metrics)
+	{
+		return;
+	}
+
+	FBlueprintHttpMetrics::FShard& Shard = Metrics->GetShard();
+	Shard.InFlight.Add(-1);
+
+	if (RouteIndex != INDEX_NONE)
+	{
+		FBlueprintHttpMetrics::FRouteShard& Route = Shard.GetRoute(RouteIndex);
+		Route.Requests.Add(1);
+		Route.QueueWait.Record(QueueWaitUs);
+		Route.Total.Record(QueueWaitUs + BlueprintHttpMetrics::MicrosecondsSince(StartCycles));
+	}
+}
+
+void FBlueprintHttpMetrics::FHistogram::Record(const uint64 Microseconds)
+{
+	Buckets[GetBucketIndex(Microseconds)].Add(1);
+	SumUs.Add(static_cast<int64>(Microseconds));
+}
+
+FBlueprintHttpMetrics::FShard::~FShard()
+{
+	for (std::atomic<FRouteShard*>& Route : Routes)
+	{
+		delete Route.load(std::memory_order_relaxed);
+	}
+}
+
+FBlueprintHttpMetrics::FRouteShard& FBlueprintHttpMetrics::FShard::GetRoute(const int32 RouteIndex)
+{
+	FRouteShard* Route = Routes[RouteIndex].load(std::memory_order_relaxed);
+
+	if (!Route)
+	{
+		// Only the owning thread writes the slot, readers see it once published.
+		Route = new FRouteShard();
+		Routes[RouteIndex].store(Route, std::memory_order_release);
+	}
+
+	return *Route;
+}
+
+FBlueprintHttpMetrics::FBlueprintHttpMetrics()
+	: Id(BlueprintHttpMetrics::NextMetricsId.fetch_add(1))
+{
+}
+
+FBlueprintHttpMetrics::~FBlueprintHttpMetrics() = default;
+
+int32 FBlueprintHttpMetrics::RegisterRoute(const EHttpServerVerb Verb, const FString& Path)
+{
+	std::lock_guard<std::mutex> Lock(Mutex);
+
+	const TCHAR* Method = TEXT("GET");
+	switch (Verb)
+	{
+	case EHttpServerVerb::Post:	   Method = TEXT("POST");	 break;
+	case EHttpServerVerb::Delete:  Method = TEXT("DELETE");	 break;
+	case EHttpServerVerb::Options: Method = TEXT("OPTIONS"); break;
+	case EHttpServerVerb::Patch:   Method = TEXT("PATCH");	 break;
+	case EHttpServerVerb::Put:	   Method = TEXT("PUT");	 break;
+	default: break;
+	}
+
+	FRoute Route{ TCHAR_TO_UTF8(Method), TCHAR_TO_UTF8(*Path) };
+
+	// Routes removed and added again while running keep their series.
+	for (size_t RouteIndex = 0; RouteIndex < Routes.size(); ++RouteIndex)
+	{
+		if (Routes[RouteIndex].Method == Route.Method && Routes[RouteIndex].Path == Route.Path)
+		{
+			return static_cast<int32>(RouteIndex);
+		}
+	}
+
+	if (Routes.size() >= MaxRoutes)
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("Route %s isn't measured, metrics are limited to %d routes."), *Path, MaxRoutes);
+		return INDEX_NONE;
+	}
+
+	Routes.push_back(MoveTemp(Route));
+
+	return static_cast<int32>(Routes.size()) - 1;
+}
+
+FBlueprintHttpRequestTiming FBlueprintHttpMetrics::BeginRequest(const TSharedPtr<FBlueprintHttpMetrics, ESPMode::ThreadSafe>& Metrics, const int32 RouteIndex)
+{
+	FBlueprintHttpRequestTiming Timing;
+
+	if (Metrics)
+	{
+		Metrics->GetShard().InFlight.Add(1);
+
+		Timing.Metrics	   = Metrics;
+		Timing.RouteIndex  = RouteIndex;
+		Timing.QueueWaitUs = ConsumeQueueWait();
+		Timing.StartCycles = FPlatformTime::Cycles64();
+	}
+
+	return Timing;
+}
+
+void FBlueprintHttpMetrics::RecordResponse(const httplib::Request& Request, const httplib::Response& Response)
+{
+	FShard& Shard = GetShard();
+
+	if (Response.status >= 0 && Response.status < NumStatusCodes)
+	{
+		Shard.StatusCodes[Response.status].Add(1);
+	}
+
+	Shard.BytesIn .Add(BlueprintHttpMetrics::RequestBytes(Request));
+	Shard.BytesOut.Add(BlueprintHttpMetrics::ResponseBytes(Request, Response));
+}
+
+void FBlueprintHttpMetrics::RecordCompression(const size_t InLength, const size_t OutLength, const int64 Nanoseconds)
+{
+	FShard& Shard = GetShard();
+
+	Shard.CompressedResponses.Add(1);
+	Shard.CompressionNs		 .Add(Nanoseconds);
+	Shard.CompressionBytesIn .Add(static_cast<int64>(InLength));
+	Shard.CompressionBytesOut.Add(static_cast<int64>(OutLength));
+}
+
+httplib::TaskQueue* FBlueprintHttpMetrics::InstrumentQueue(const TSharedRef<FBlueprintHttpMetrics, ESPMode::ThreadSafe>& Metrics, httplib::TaskQueue* const Queue)
+{
+	return new FInstrumentedQueue(Metrics, Queue);
+}
+
+FBlueprintHttpMetrics::FShard& FBlueprintHttpMetrics::GetShard()
+{
+	// Most threads only ever record for one server.
+	static thread_local uint64  CachedId	= 0;
+	static thread_local FShard* CachedShard = nullptr;
+
+	if (CachedId == Id)
+	{
+		return *CachedShard;
+	}
+
+	// Ids are never reused, entries of destroyed servers are never matched again.
+	static thread_local std::unordered_map<uint64, FShard*> ThreadShards;
+
+	FShard*& Shard = ThreadShards[Id];
+	if (!Shard)
+	{
+		std::unique_ptr<FShard> NewShard = std::make_unique<FShard>();
+		Shard = NewShard.get();
+
+		std::lock_guard<std::mutex> Lock(Mutex);
+		Shards.push_back(MoveTemp(NewShard));
+	}
+
+	CachedId	= Id;
+	CachedShard = Shard;
+
+	return *Shard;
+}
+
+uint64 FBlueprintHttpMetrics::ConsumeQueueWait()
+{
+	const uint64 QueueWaitUs = BlueprintHttpMetrics::PendingQueueWaitUs;
+	BlueprintHttpMetrics::PendingQueueWaitUs = 0;
+	return QueueWaitUs;
+}
+
+int32 FBlueprintHttpMetrics::GetBucketIndex(const uint64 Microseconds)
+{
+	// [0, 16us), then [2^n, 1.5 * 2^n) and [1.5 * 2^n, 2^(n + 1)) up to 2^26us, then overflow.
+	if (Microseconds < 16)
+	{
+		return 0;
+	}
+
+	const int32 Log2 = static_cast<int32>(FMath::FloorLog2_64(Microseconds));
+	if (Log2 >= 26)
+	{
+		return NumBuckets - 1;
+	}
+
+	const int32 Half = static_cast<int32>((Microseconds >> (Log2 - 1)) & 1);
+	return 1 + (Log2 - 4) * 2 + Half;
+}
+
+double FBlueprintHttpMetrics::GetBucketUpperBound(const int32 BucketIndex)
+{
+	if (BucketIndex == 0)
+	{
+		return 16e-6;
+	}
+
+	const int32	 Log2  = 4 + (BucketIndex - 1) / 2;
+	const double Lower = static_cast<double>(1ull << Log2);
+
+	return ((BucketIndex - 1) % 2 == 0 ? Lower * 1.5 : Lower * 2.0) * 1e-6;
+}
+
+std::string FBlueprintHttpMetrics::Export() const
+{
+	using namespace BlueprintHttpMetrics;
+
+	struct FRouteTotals
+	{
+		int64 Requests = 0;
+		int64 Buckets[3][NumBuckets] = {};
+		int64 SumUs[3] = {};
+	};
+
+	std::vector<FRoute>		  RouteLabels;
+	std::vector<FRouteTotals> RouteTotals;
+
+	int64 StatusCodes[NumStatusCodes] = {};
+	int64 InFlight	 = 0;
+	int64 QueueDepth = 0;
+	int64 BytesIn	 = 0;
+	int64 BytesOut	 = 0;
+
+	int64 CompressedResponses = 0;
+	int64 CompressionNs		  = 0;
+	int64 CompressionBytesIn  = 0;
+	int64 CompressionBytesOut = 0;
+
+	{
+		std::lock_guard<std::mutex> Lock(Mutex);
+
+		RouteLabels = Routes;
+		RouteTotals.resize(Routes.size());
+
+		for (const std::unique_ptr<FShard>& Shard : Shards)
+		{
+			for (int32 Code = 0; Code < NumStatusCodes; ++Code)
+			{
+				StatusCodes[Code] += Shard->StatusCodes[Code].Get();
+			}
+
+			InFlight   += Shard->InFlight.Get();
+			QueueDepth += Shard->QueueDepth.Get();
+			BytesIn	   += Shard->BytesIn.Get();
+			BytesOut   += Shard->BytesOut.Get();
+
+			CompressedResponses += Shard->CompressedResponses.Get();
+			CompressionNs		+= Shard->CompressionNs		 .Get();
+			CompressionBytesIn	+= Shard->CompressionBytesIn .Get();
+			CompressionBytesOut += Shard->CompressionBytesOut.Get();
+
+			for (size_t RouteIndex = 0; RouteIndex < RouteTotals.size(); ++RouteIndex)
+			{
+				const FRouteShard* const Route = Shard->Routes[RouteIndex].load(std::memory_order_acquire);
+				if (!Route)
+				{
+					continue;
+				}
+
+				FRouteTotals& Totals = RouteTotals[RouteIndex];
+				Totals.Requests += Route->Requests.Get();
+
+				const FHistogram* const Histograms[3] = { &Route->Total, &Route->QueueWait, &Route->GameThreadWait };
+				for (int32 Kind = 0; Kind < 3; ++Kind)
+				{
+					for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+					{
+						Totals.Buckets[Kind][Bucket] += Histograms[Kind]->Buckets[Bucket].Get();
+					}
+					Totals.SumUs[Kind] += Histograms[Kind]->SumUs.Get();
+				}
+			}
+		}
+	}
+
+	std::string Out;
+	Out.reserve(4096 + RouteLabels.size() * 3 * NumBuckets * 96);
+
+	auto AppendLabels = [&Out](const FRoute& Route) -> void
+	{
+		Out += "method=\"";
+		AppendEscaped(Out, Route.Method);
+		Out += "\",route=\"";
+		AppendEscaped(Out, Route.Path);
+		Out += '"';
+	};
+
+	AppendHeader(Out, "blueprint_http_requests_total", "counter", "Requests handled by a route.");
+	for (size_t RouteIndex = 0; RouteIndex < RouteLabels.size(); ++RouteIndex)
+	{
+		Out += "blueprint_http_requests_total{";
+		AppendLabels(RouteLabels[RouteIndex]);
+		AppendFormat(Out, "} %lld\n", static_cast<long long>(RouteTotals[RouteIndex].Requests));
+	}
+
+	static const char* const HistogramNames[3][2] =
+	{
+		{ "blueprint_http_request_duration_seconds",  "Time from the request being queued to its response being ready." },
+		{ "blueprint_http_queue_wait_seconds",		  "Time spent in the task queue before a worker picked the request up." },
+		{ "blueprint_http_game_thread_wait_seconds",  "Time game thread callbacks waited for a frame to run them." },
+	};
+
+	for (int32 Kind = 0; Kind < 3; ++Kind)
+	{
+		const char* const Name = HistogramNames[Kind][0];
+		AppendHeader(Out, Name, "histogram", HistogramNames[Kind][1]);
+
+		for (size_t RouteIndex = 0; RouteIndex < RouteLabels.size(); ++RouteIndex)
+		{
+			const FRouteTotals& Totals = RouteTotals[RouteIndex];
+
+			int64 Cumulative = 0;
+			for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+			{
+				Cumulative += Totals.Buckets[Kind][Bucket];
+
+				AppendFormat(Out, "%s_bucket{", Name);
+				AppendLabels(RouteLabels[RouteIndex]);
+
+				if (Bucket == NumBuckets - 1)
+				{
+					AppendFormat(Out, ",le=\"+Inf\"} %lld\n", static_cast<long long>(Cumulative));
+				}
+				else
+				{
+					AppendFormat(Out, ",le=\"%g\"} %lld\n", GetBucketUpperBound(Bucket), static_cast<long long>(Cumulative));
+				}
+			}
+
+			AppendFormat(Out, "%s_sum{", Name);
+			AppendLabels(RouteLabels[RouteIndex]);
+			AppendFormat(Out, "} %.6f\n", Totals.SumUs[Kind] * 1e-6);
+
+			AppendFormat(Out, "%s_count{", Name);
+			AppendLabels(RouteLabels[RouteIndex]);
+			AppendFormat(Out, "} %lld\n", static_cast<long long>(Cumulative));
+		}
+	}
+
+	AppendHeader(Out, "blueprint_http_responses_total", "counter", "Responses written, by status code.");
+	for (int32 Code = 0; Code < NumStatusCodes; ++Code)
+	{
+		if (StatusCodes[Code] > 0)
+		{
+			AppendFormat(Out, "blueprint_http_responses_total{code=\"%d\"} %lld\n", Code, static_cast<long long>(StatusCodes[Code]));
+		}
+	}
+
+	AppendHeader(Out, "blueprint_http_in_flight_requests", "gauge", "Requests being handled by a route callback.");
+	AppendFormat(Out, "blueprint_http_in_flight_requests %lld\n", static_cast<long long>(InFlight));
+
+	AppendHeader(Out, "blueprint_http_task_queue_depth", "gauge", "Jobs waiting for an HTTP worker thread.");
+	AppendFormat(Out, "blueprint_http_task_queue_depth %lld\n", static_cast<long long>(QueueDepth));
+
+	AppendHeader(Out, "blueprint_http_received_bytes_total", "counter", "Request bytes received, excluding transfer framing.");
+	AppendFormat(Out, "blueprint_http_received_bytes_total %lld\n", static_cast<long long>(BytesIn));
+
+	AppendHeader(Out, "blueprint_http_sent_bytes_total", "counter", "Response bytes sent, excluding transfer framing.");
+	AppendFormat(Out, "blueprint_http_sent_bytes_total %lld\n", static_cast<long long>(BytesOut));
+
+	AppendHeader(Out, "blueprint_http_compressed_responses_total", "counter", "Response bodies compressed by the server.");
+	AppendFormat(Out, "blueprint_http_compressed_responses_total %lld\n", static_cast<long long>(CompressedResponses));
+
+	AppendHeader(Out, "blueprint_http_compression_seconds_total", "counter", "Time spent compressing response bodies.");
+	AppendFormat(Out, "blueprint_http_compression_seconds_total %.6f\n", CompressionNs * 1e-9);
+
+	AppendHeader(Out, "blueprint_http_compression_input_bytes_total", "counter", "Response bytes before compression.");
+	AppendFormat(Out, "blueprint_http_compression_input_bytes_total %lld\n", static_cast<long long>(CompressionBytesIn));
+
+	AppendHeader(Out, "blueprint_http_compression_output_bytes_total", "counter", "Response bytes after compression.");
+	AppendFormat(Out, "blueprint_http_compression_output_bytes_total %lld\n", static_cast<long long>(CompressionBytesOut));
+
+	return Out;
+}
@@ -0,0 +1,176 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BlueprintHttpServer.h"
+
+#include "BlueprintHttpLib.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class FBlueprintHttpMetrics;
+
+/**
+ * Timing of one request handled by a route. Empty when metrics are disabled.
+*/
+struct FBlueprintHttpRequestTiming
+{
+	TSharedPtr<FBlueprintHttpMetrics, ESPMode::ThreadSafe> Metrics;
+
+	int32  RouteIndex  = INDEX_NONE;
+	uint64 QueueWaitUs = 0;
+	uint64 StartCycles = 0;
+
+	/**
+	 * Records the time a game thread callback waited in the dispatcher.
+	 * @param EnqueueCycles When the callback was queued.
+	*/
+	void RecordGameThreadWait(const uint64 EnqueueCycles) const;
+
+	/**
+	 * Records the total time, once the response is ready.
+	*/
+	void End() const;
+};
+
+/**
+ * Request metrics of a server, exported in Prometheus text format.
+ * Each thread records into its own shard with plain relaxed stores, so
+ * recording never contends. Shards are summed when the metrics are scraped.
+ * Latencies go in log-linear histograms with two buckets per power of two,
+ * from 16us to 67s.
+*/
+class FBlueprintHttpMetrics final
+{
+public:
+	/**
+	 * Routes above this count aren't measured individually.
+	*/
+	static constexpr int32 MaxRoutes = 128;
+
+	static constexpr int32 NumBuckets	  = 46;
+	static constexpr int32 NumStatusCodes = 600;
+
+	FBlueprintHttpMetrics();
+	~FBlueprintHttpMetrics();
+
+	/**
+	 * Adds a route to the exported labels.
+	 * @return The index to record the route's requests with, INDEX_NONE if there are too many routes.
+	*/
+	int32 RegisterRoute(const EHttpServerVerb Verb, const FString& Path);
+
+	/**
+	 * Starts measuring a request, on the worker that routed it.
+	*/
+	static FBlueprintHttpRequestTiming BeginRequest(const TSharedPtr<FBlueprintHttpMetrics, ESPMode::ThreadSafe>& Metrics, const int32 RouteIndex);
+
+	/**
+	 * Records a written response. Called from the httplib logger.
+	*/
+	void RecordResponse(const httplib::Request& Request, const httplib::Response& Response);
+
+	/**
+	 * Records a compressed response body. Called from the httplib compression logger.
+	 * @param Nanoseconds The time spent in the compressor.
+	*/
+	void RecordCompression(const size_t InLength, const size_t OutLength, const int64 Nanoseconds);
+
+	/**
+	 * Wraps a task queue to measure its depth and the time jobs wait in it.
+	 * @return The wrapping queue, owning Queue.
+	*/
+	static httplib::TaskQueue* InstrumentQueue(const TSharedRef<FBlueprintHttpMetrics, ESPMode::ThreadSafe>& Metrics, httplib::TaskQueue* const Queue);
+
+	/**
+	 * Formats the metrics in Prometheus text exposition format.
+	*/
+	std::string Export() const;
+
+private:
+	friend struct FBlueprintHttpRequestTiming;
+
+	class FInstrumentedQueue;
+
+	/**
+	 * A counter written by one thread only.
+	*/
+	struct FCounter
+	{
+		std::atomic<int64> Value{ 0 };
+
+		void Add(const int64 Delta) { Value.store(Value.load(std::memory_order_relaxed) + Delta, std::memory_order_relaxed); }
+		int64 Get() const { return Value.load(std::memory_order_relaxed); }
+	};
+
+	struct FHistogram
+	{
+		FCounter Buckets[NumBuckets];
+		FCounter SumUs;
+
+		void Record(const uint64 Microseconds);
+	};
+
+	struct FRouteShard
+	{
+		FCounter   Requests;
+		FHistogram Total;
+		FHistogram QueueWait;
+		FHistogram GameThreadWait;
+	};
+
+	struct FShard
+	{
+		~FShard();
+
+		/**
+		 * Allocated by the owning thread the first time it records the route.
+		*/
+		std::atomic<FRouteShard*> Routes[MaxRoutes] = {};
+
+		FCounter StatusCodes[NumStatusCodes];
+		FCounter InFlight;
+		FCounter QueueDepth;
+		FCounter BytesIn;
+		FCounter BytesOut;
+
+		FCounter CompressedResponses;
+		FCounter CompressionNs;
+		FCounter CompressionBytesIn;
+		FCounter CompressionBytesOut;
+
+		FRouteShard& GetRoute(const int32 RouteIndex);
+	};
+
+	struct FRoute
+	{
+		std::string Method;
+		std::string Path;
+	};
+
+	FShard& GetShard();
+
+	/**
+	 * The time the job running on this thread waited in the queue,
+	 * reset once read so only the first request of a connection counts it.
+	*/
+	static uint64 ConsumeQueueWait();
+
+	static int32 GetBucketIndex(const uint64 Microseconds);
+	static double GetBucketUpperBound(const int32 BucketIndex);
+
+private:
+	/**
+	 * Unique across all instances, identifies the shards cached by threads.
+	*/
+	const uint64 Id;
+
+	mutable std::mutex Mutex;
+	std::vector<std::unique_ptr<FShard>> Shards;
+	std::vector<FRoute> Routes;
+};
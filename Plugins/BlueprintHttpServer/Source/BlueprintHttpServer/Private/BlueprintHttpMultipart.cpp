@@ -0,0 +1,526 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#include "BlueprintHttpMultipart.h"
+
+#include "BlueprintHttpLib.h"
+#include "BlueprintHttpServerModule.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace BlueprintHttpMultipart
+{
+	// The headers of a part, more means the body is malformed or hostile.
+	static constexpr size_t MaxHeaderBytes = 8 * 1024;
+
+	// RFC 2046 limits boundaries to 70 characters, some clients go further.
+	static constexpr size_t MaxBoundaryLength = 256;
+
+	static bool IsSpace(const char Character)
+	{
+		return Character == ' ' || Character == '\t';
+	}
+
+	static void Trim(const char*& Begin, const char*& End)
+	{
+		while (Begin < End && IsSpace(*Begin))
+		{
+			++Begin;
+		}
+
+		while (End > Begin && IsSpace(End[-1]))
+		{
+			--End;
+		}
+	}
+
+	static bool EqualsIgnoreCase(const char* const Begin, const char* const End, const char* const Other)
+	{
+		const size_t Length = std::strlen(Other);
+
+		if (static_cast<size_t>(End - Begin) != Length)
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < Length; ++i)
+		{
+			if (FCharAnsi::ToLower(Begin[i]) != FCharAnsi::ToLower(Other[i]))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static int32 HexValue(const char Character)
+	{
+		if (Character >= '0' && Character <= '9') return Character - '0';
+		if (Character >= 'a' && Character <= 'f') return Character - 'a' + 10;
+		if (Character >= 'A' && Character <= 'F') return Character - 'A' + 10;
+		return INDEX_NONE;
+	}
+
+	/**
+	 * Decodes an RFC 5987 extended value: charset'language'percent-encoded.
+	*/
+	static bool DecodeExtendedValue(const std::string& Value, std::string& OutDecoded)
+	{
+		const size_t CharsetEnd = Value.find('\'');
+		const size_t LanguageEnd = CharsetEnd == std::string::npos ? std::string::npos : Value.find('\'', CharsetEnd + 1);
+
+		if (LanguageEnd == std::string::npos)
+		{
+			return false;
+		}
+
+		OutDecoded.clear();
+
+		for (size_t i = LanguageEnd + 1; i < Value.size(); ++i)
+		{
+			if (Value[i] != '%')
+			{
+				OutDecoded += Value[i];
+				continue;
+			}
+
+			const int32 High = i + 2 < Value.size() ? HexValue(Value[i + 1]) : INDEX_NONE;
+			const int32 Low	 = i + 2 < Value.size() ? HexValue(Value[i + 2]) : INDEX_NONE;
+
+			if (High == INDEX_NONE || Low == INDEX_NONE)
+			{
+				return false;
+			}
+
+			OutDecoded += static_cast<char>(High * 16 + Low);
+			i += 2;
+		}
+
+		return true;
+	}
+
+	/**
+	 * Calls a function with the name and value of each "; key=value" parameter of a header.
+	 * Values can be quoted, with backslash escapes.
+	*/
+	template<typename FunctorType>
+	static bool ForEachParameter(const char* Cursor, const char* const End, FunctorType&& Function)
+	{
+		std::string Value;
+
+		for (;;)
+		{
+			Cursor = static_cast<const char*>(std::memchr(Cursor, ';', End - Cursor));
+
+			if (!Cursor)
+			{
+				return true;
+			}
+
+			++Cursor;
+
+			const char* const KeyBegin = Cursor;
+			while (Cursor < End && *Cursor != '=' && *Cursor != ';')
+			{
+				++Cursor;
+			}
+
+			const char* TrimmedBegin = KeyBegin;
+			const char* TrimmedEnd	 = Cursor;
+			Trim(TrimmedBegin, TrimmedEnd);
+
+			Value.clear();
+
+			if (Cursor < End && *Cursor == '=')
+			{
+				++Cursor;
+
+				while (Cursor < End && IsSpace(*Cursor))
+				{
+					++Cursor;
+				}
+
+				if (Cursor < End && *Cursor == '"')
+				{
+					for (++Cursor; Cursor < End && *Cursor != '"'; ++Cursor)
+					{
+						// Browsers send Windows paths unescaped, only quotes and backslashes are escaped.
+						if (*Cursor == '\\' && Cursor + 1 < End && (Cursor[1] == '"' || Cursor[1] == '\\'))
+						{
+							++Cursor;
+						}
+
+						Value += *Cursor;
+					}
+
+					if (Cursor == End)
+					{
+						return false;
+					}
+
+					++Cursor;
+				}
+				else
+				{
+					const char* const ValueBegin = Cursor;
+					while (Cursor < End && *Cursor != ';')
+					{
+						++Cursor;
+					}
+
+					const char* ValueTrimmedBegin = ValueBegin;
+					const char* ValueTrimmedEnd	  = Cursor;
+					Trim(ValueTrimmedBegin, ValueTrimmedEnd);
+
+					Value.assign(ValueTrimmedBegin, ValueTrimmedEnd);
+				}
+			}
+
+			Function(TrimmedBegin, TrimmedEnd, Value);
+		}
+	}
+}
+
+FBlueprintHttpMultipartParser::FBlueprintHttpMultipartParser(const std::string& Boundary)
+	: Delimiter("\r\n--" + Boundary)
+	, State(EState::Preamble)
+	// The first delimiter has no line break before it when there is no preamble.
+	, Pending("\r\n")
+	, HeaderBytes(0)
+{
+}
+
+bool FBlueprintHttpMultipartParser::ParseBoundary(const std::string& ContentType, std::string& OutBoundary)
+{
+	const char* Begin = ContentType.data();
+	const char* End	  = ContentType.data() + ContentType.size();
+
+	const char* TypeEnd = static_cast<const char*>(std::memchr(Begin, ';', End - Begin));
+	if (!TypeEnd)
+	{
+		return false;
+	}
+
+	const char* TypeBegin = Begin;
+	BlueprintHttpMultipart::Trim(TypeBegin, TypeEnd);
+
+	if (!BlueprintHttpMultipart::EqualsIgnoreCase(TypeBegin, TypeEnd, "multipart/form-data"))
+	{
+		return false;
+	}
+
+	OutBoundary.clear();
+
+	const bool bValid = BlueprintHttpMultipart::ForEachParameter(TypeEnd, End, [&OutBoundary](const char* const KeyBegin, const char* const KeyEnd, const std::string& Value) -> void
+	{
+		if (BlueprintHttpMultipart::EqualsIgnoreCase(KeyBegin, KeyEnd, "boundary"))
+		{
+			OutBoundary = Value;
+		}
+	});
+
+	return bValid && !OutBoundary.empty() && OutBoundary.size() <= BlueprintHttpMultipart::MaxBoundaryLength;
+}
+
+bool FBlueprintHttpMultipartParser::Parse(const char* Data, size_t Size, IListener& Listener)
+{
+	const auto Fail = [this]() -> bool
+	{
+		State = EState::Error;
+		return false;
+	};
+
+	while (Size > 0)
+	{
+		switch (State)
+		{
+		case EState::Preamble:
+		case EState::Content:
+		{
+			const int64 Consumed = ParseContent(Data, Size, Listener);
+
+			if (Consumed == INDEX_NONE)
+			{
+				return Fail();
+			}
+
+			Data += Consumed;
+			Size -= static_cast<size_t>(Consumed);
+			break;
+		}
+
+		case EState::AfterDelimiter:
+		{
+			// Transport padding is allowed before the line break.
+			if (*Data == '-')
+			{
+				State = EState::AfterDelimiterDash;
+			}
+			else if (*Data == '\r')
+			{
+				State = EState::AfterDelimiterCR;
+			}
+			else if (!BlueprintHttpMultipart::IsSpace(*Data))
+			{
+				return Fail();
+			}
+
+			++Data;
+			--Size;
+			break;
+		}
+
+		case EState::AfterDelimiterDash:
+		{
+			if (*Data != '-')
+			{
+				return Fail();
+			}
+
+			State = EState::Done;
+			++Data;
+			--Size;
+			break;
+		}
+
+		case EState::AfterDelimiterCR:
+		{
+			if (*Data != '\n')
+			{
+				return Fail();
+			}
+
+			State		= EState::Headers;
+			Part		= FPart();
+			HeaderBytes = 0;
+			Line.clear();
+
+			++Data;
+			--Size;
+			break;
+		}
+
+		case EState::Headers:
+		{
+			const char* const LineFeed = static_cast<const char*>(std::memchr(Data, '\n', Size));
+			const size_t	  Length   = LineFeed ? LineFeed - Data + 1 : Size;
+
+			HeaderBytes += Length;
+
+			if (HeaderBytes > BlueprintHttpMultipart::MaxHeaderBytes)
+			{
+				return Fail();
+			}
+
+			Line.append(Data, Length);
+
+			Data += Length;
+			Size -= Length;
+
+			if (!LineFeed)
+			{
+				break;
+			}
+
+			if (Line.size() < 2 || Line[Line.size() - 2] != '\r')
+			{
+				return Fail();
+			}
+
+			// An empty line ends the headers, a part must have a name.
+			if (Line.size() == 2)
+			{
+				if (Part.Name.empty() || !Listener.OnPartBegin(Part))
+				{
+					return Fail();
+				}
+
+				State = EState::Content;
+			}
+			else if (!ParseHeader(Line.data(), Line.data() + Line.size() - 2))
+			{
+				return Fail();
+			}
+
+			Line.clear();
+			break;
+		}
+
+		case EState::Done:
+			// The epilogue is ignored.
+			return true;
+
+		case EState::Error:
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int64 FBlueprintHttpMultipartParser::ParseContent(const char* const Data, const size_t Size, IListener& Listener)
+{
+	const size_t DelimiterSize = Delimiter.size();
+
+	const auto OnDelimiter = [this, &Listener]() -> bool
+	{
+		const bool bPartEnded = State != EState::Content || Listener.OnPartEnd();
+
+		State = EState::AfterDelimiter;
+
+		return bPartEnded;
+	};
+
+	// The previous chunk ended with the start of a delimiter, it can only be confirmed with this one.
+	if (Pending.size() > 0)
+	{
+		std::string Joined = Pending;
+		Joined.append(Data, std::min(Size, DelimiterSize));
+
+		for (size_t Index = 0; Index < Pending.size(); ++Index)
+		{
+			const size_t Compared = std::min(Joined.size() - Index, DelimiterSize);
+
+			if (Joined[Index] != '\r' || std::memcmp(Joined.data() + Index, Delimiter.data(), Compared) != 0)
+			{
+				continue;
+			}
+
+			if (!EmitContent(Joined.data(), Index, Listener))
+			{
+				return INDEX_NONE;
+			}
+
+			if (Compared < DelimiterSize)
+			{
+				// Still a candidate, this chunk was too short to tell.
+				Pending = Joined.substr(Index);
+				return static_cast<int64>(Size);
+			}
+
+			const size_t Consumed = Index + DelimiterSize - Pending.size();
+
+			Pending.clear();
+
+			return OnDelimiter() ? static_cast<int64>(Consumed) : INDEX_NONE;
+		}
+
+		if (!EmitContent(Pending.data(), Pending.size(), Listener))
+		{
+			return INDEX_NONE;
+		}
+
+		Pending.clear();
+	}
+
+	const char* const End = Data + Size;
+
+	for (const char* Cursor = Data; Cursor < End;)
+	{
+		const char* const CarriageReturn = static_cast<const char*>(std::memchr(Cursor, '\r', End - Cursor));
+
+		if (!CarriageReturn)
+		{
+			break;
+		}
+
+		const size_t Compared = std::min(static_cast<size_t>(End - CarriageReturn), DelimiterSize);
+
+		if (std::memcmp(CarriageReturn, Delimiter.data(), Compared) != 0)
+		{
+			Cursor = CarriageReturn + 1;
+			continue;
+		}
+
+		if (!EmitContent(Data, CarriageReturn - Data, Listener))
+		{
+			return INDEX_NONE;
+		}
+
+		if (Compared < DelimiterSize)
+		{
+			Pending.assign(CarriageReturn, Compared);
+			return static_cast<int64>(Size);
+		}
+
+		return OnDelimiter() ? static_cast<int64>(CarriageReturn - Data + DelimiterSize) : INDEX_NONE;
+	}
+
+	return EmitContent(Data, Size, Listener) ? static_cast<int64>(Size) : INDEX_NONE;
+}
+
+bool FBlueprintHttpMultipartParser::EmitContent(const char* const Data, const size_t Size, IListener& Listener)
+{
+	return State != EState::Content || Size == 0 || Listener.OnPartData(Data, Size);
+}
+
+bool FBlueprintHttpMultipartParser::ParseHeader(const char* const Begin, const char* const End)
+{
+	const char* const Colon = static_cast<const char*>(std::memchr(Begin, ':', End - Begin));
+
+	if (!Colon)
+	{
+		return false;
+	}
+
+	const char* NameBegin = Begin;
+	const char* NameEnd	  = Colon;
+	BlueprintHttpMultipart::Trim(NameBegin, NameEnd);
+
+	const char* ValueBegin = Colon + 1;
+	const char* ValueEnd   = End;
+	BlueprintHttpMultipart::Trim(ValueBegin, ValueEnd);
+
+	if (BlueprintHttpMultipart::EqualsIgnoreCase(NameBegin, NameEnd, "Content-Disposition"))
+	{
+		return ParseContentDisposition(ValueBegin, ValueEnd);
+	}
+
+	if (BlueprintHttpMultipart::EqualsIgnoreCase(NameBegin, NameEnd, "Content-Type"))
+	{
+		Part.ContentType.assign(ValueBegin, ValueEnd);
+	}
+
+	return true;
+}
+
+bool FBlueprintHttpMultipartParser::ParseContentDisposition(const char* Begin, const char* const End)
+{
+	const char* TypeEnd = static_cast<const char*>(std::memchr(Begin, ';', End - Begin));
+	if (!TypeEnd)
+	{
+		TypeEnd = End;
+	}
+
+	const char* TypeBegin = Begin;
+	BlueprintHttpMultipart::Trim(TypeBegin, TypeEnd);
+
+	if (!BlueprintHttpMultipart::EqualsIgnoreCase(TypeBegin, TypeEnd, "form-data"))
+	{
+		return false;
+	}
+
+	bool bExtendedFileName = false;
+
+	return BlueprintHttpMultipart::ForEachParameter(TypeEnd, End, [this, &bExtendedFileName](const char* const KeyBegin, const char* const KeyEnd, const std::string& Value) -> void
+	{
+		if (BlueprintHttpMultipart::EqualsIgnoreCase(KeyBegin, KeyEnd, "name"))
+		{
+			Part.Name = Value;
+		}
+		else if (BlueprintHttpMultipart::EqualsIgnoreCase(KeyBegin, KeyEnd, "filename"))
+		{
+			if (!bExtendedFileName)
+			{
+				Part.FileName = Value;
+			}
+		}
+		// Takes precedence, it can hold any character.
+		else if (BlueprintHttpMultipart::EqualsIgnoreCase(KeyBegin, KeyEnd, "filename*"))
+		{
+			bExtendedFileName = BlueprintHttpMultipart::DecodeExtendedValue(Value, Part.FileName);
+		}
+	});
+}
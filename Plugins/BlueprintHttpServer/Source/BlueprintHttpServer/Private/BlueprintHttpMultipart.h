@@ -0,0 +1,121 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <string>
+
+/**
+ * Streaming multipart/form-data parser (RFC 7578).
+ * A state machine fed with the body as it is read, nothing is buffered but the
+ * part headers and the few bytes that could start a delimiter across two chunks.
+ * Part contents are handed to the listener as is, without regular expressions.
+*/
+class FBlueprintHttpMultipartParser final
+{
+public:
+	struct FPart
+	{
+		std::string Name;
+		std::string FileName;
+		std::string ContentType;
+	};
+
+	class IListener
+	{
+	public:
+		virtual ~IListener() = default;
+
+		/**
+		 * Called once the headers of a part are parsed.
+		 * @return False to stop parsing.
+		*/
+		virtual bool OnPartBegin(const FPart& Part) = 0;
+		virtual bool OnPartData(const char* const Data, const size_t Size) = 0;
+		virtual bool OnPartEnd() = 0;
+	};
+
+	/**
+	 * @param Boundary The boundary, without the leading dashes.
+	*/
+	explicit FBlueprintHttpMultipartParser(const std::string& Boundary);
+
+	/**
+	 * Extracts the boundary parameter of a Content-Type.
+	 * @return False if it isn't multipart/form-data or has no boundary.
+	*/
+	static bool ParseBoundary(const std::string& ContentType, std::string& OutBoundary);
+
+	/**
+	 * Parses the next bytes of the body.
+	 * @return False if the body is malformed or the listener stopped, parsing can't continue.
+	*/
+	bool Parse(const char* Data, size_t Size, IListener& Listener);
+
+	/**
+	 * If the final delimiter was parsed.
+	*/
+	bool IsComplete() const { return State == EState::Done; }
+
+private:
+	enum class EState : uint8
+	{
+		// Skipping the data before the first delimiter.
+		Preamble,
+		// After a delimiter, either "--" or the line break before the headers.
+		AfterDelimiter,
+		AfterDelimiterDash,
+		AfterDelimiterCR,
+		Headers,
+		Content,
+		Done,
+		Error
+	};
+
+	/**
+	 * Consumes the content of a part or the preamble up to the next delimiter.
+	 * @return The bytes consumed, or INDEX_NONE on error.
+	*/
+	int64 ParseContent(const char* const Data, const size_t Size, IListener& Listener);
+
+	/**
+	 * Hands content to the listener, dropped in the preamble.
+	*/
+	bool EmitContent(const char* const Data, const size_t Size, IListener& Listener);
+
+	/**
+	 * Parses a header line of a part.
+	*/
+	bool ParseHeader(const char* const Begin, const char* const End);
+
+	/**
+	 * Parses the parameters of a Content-Disposition header.
+	*/
+	bool ParseContentDisposition(const char* Begin, const char* const End);
+
+private:
+	/**
+	 * "\r\n--" followed by the boundary.
+	*/
+	std::string Delimiter;
+
+	EState State;
+
+	/**
+	 * The end of the previous chunk that matched the start of the delimiter.
+	*/
+	std::string Pending;
+
+	/**
+	 * The header line being read.
+	*/
+	std::string Line;
+
+	/**
+	 * The bytes of headers read for the current part.
+	*/
+	size_t HeaderBytes;
+
+	FPart Part;
+};
@@ -60,6 +60,83 @@ void UBlueprintHttpServerLibrary::AddRoute(UBlueprintHttpServer* HttpServer, con
 	}), bRequireGameThread);
 }
 
+void UBlueprintHttpServerLibrary::RemoveRoute(UBlueprintHttpServer* HttpServer, const EHttpServerVerb Verb, const FString& Route, ESuccessFailBranching& Branch)
+{
+	Branch =
+		HttpServer && HttpServer->RemoveRoute(Verb, Route) ?
+		ESuccessFailBranching::Done : ESuccessFailBranching::Failed;
+}
+
+void UBlueprintHttpServerLibrary::AddFileUploadListener(UBlueprintHttpServer* HttpServer, const EHttpServerVerb Verb, const FString& Route, const FString& Directory, const bool bRequireGameThread, FHttpServerFileUploadDynamicCallback Callback)
+{
+	if (!HttpServer)
+	{
+		FFrame::KismetExecutionMessage(TEXT("Called AddFileUploadListener with an invalid HttpServer pointer."), ELogVerbosity::Error);
+		return;
+	}
+
+	if (!Callback.IsBound())
+	{
+		FFrame::KismetExecutionMessage(TEXT("Called AddFileUploadListener with an unbound callback."), ELogVerbosity::Warning);
+		return;
+	}
+
+	HttpServer->AddFileUploadListener(Verb, Route, Directory, FHttpServerUploadCallback::CreateLambda(
+		[Callback = MoveTemp(Callback)](const FBlueprintHttpRequest& Request, const FHttpServerUploadSinkPtr& Sink, FBlueprintHttpResponse& Response) -> void
+	{
+		const FHttpServerFileUploadSink& File = static_cast<const FHttpServerFileUploadSink&>(*Sink);
+
+		Callback.ExecuteIfBound(Request, Response, File.GetFilePath(), File.GetSize());
+	}), bRequireGameThread);
+}
+
+void UBlueprintHttpServerLibrary::AddMultipartUploadListener(UBlueprintHttpServer* HttpServer, const EHttpServerVerb Verb, const FString& Route, const FString& Directory, const bool bRequireGameThread, FHttpServerMultipartDynamicCallback Callback)
+{
+	if (!HttpServer)
+	{
+		FFrame::KismetExecutionMessage(TEXT("Called AddMultipartUploadListener with an invalid HttpServer pointer."), ELogVerbosity::Error);
+		return;
+	}
+
+	if (!Callback.IsBound())
+	{
+		FFrame::KismetExecutionMessage(TEXT("Called AddMultipartUploadListener with an unbound callback."), ELogVerbosity::Warning);
+		return;
+	}
+
+	HttpServer->AddMultipartFileUploadListener(Verb, Route, Directory, FHttpServerMultipartCallback::CreateLambda(
+		[Callback = MoveTemp(Callback)](const FBlueprintHttpRequest& Request, const TArray<FHttpServerMultipartPart>& Parts, FBlueprintHttpResponse& Response) -> void
+	{
+		Callback.ExecuteIfBound(Request, Response, Parts);
+	}), bRequireGameThread);
+}
+
+void UBlueprintHttpServerLibrary::AddWebSocketListener(UBlueprintHttpServer* HttpServer, const FString& Route, const bool bRequireGameThread, FHttpServerWebSocketDynamicCallback Callback)
+{
+	if (!HttpServer)
+	{
+		FFrame::KismetExecutionMessage(TEXT("Called AddWebSocketListener with an invalid HttpServer pointer."), ELogVerbosity::Error);
+		return;
+	}
+
+	if (!Callback.IsBound())
+	{
+		FFrame::KismetExecutionMessage(TEXT("Called AddWebSocketListener with an unbound callback."), ELogVerbosity::Warning);
+		return;
+	}
+
+	HttpServer->AddWebSocketListener(Route, FHttpServerWebSocketCallback::CreateLambda(
+		[Callback = MoveTemp(Callback)](const TArray<FHttpServerWebSocketMessage>& Messages) -> void
+	{
+		Callback.ExecuteIfBound(Messages);
+	}), bRequireGameThread);
+}
+
+FString UBlueprintHttpServerLibrary::GetWebSocketMessageText(const FHttpServerWebSocketMessage& Message)
+{
+	return Message.GetText();
+}
+
 void UBlueprintHttpServerLibrary::SetupRoutes(UBlueprintHttpServer* HttpServer, const TArray<FHttpServerMountFolder>& FoldersToMount, const TArray<FHttpServerRouteListener>& RouteListeners)
 {
 	if (!HttpServer)
@@ -104,6 +181,11 @@ void UBlueprintHttpServerLibrary::SetBinaryContent(UPARAM(ref)FBlueprintHttpResp
 	HttpResponse.SetContent(Content, MimeType);
 }
 
+bool UBlueprintHttpServerLibrary::SetFileContent(UPARAM(ref)FBlueprintHttpResponse& HttpResponse, const FString& FilePath, const FString& MimeType)
+{
+	return HttpResponse.SetContentFromFile(FilePath, MimeType);
+}
+
 void UBlueprintHttpServerLibrary::AddHeader(UPARAM(ref)FBlueprintHttpResponse& HttpResponse, const FString& Key, const FString& Value)
 {
 	HttpResponse.AddHeader(Key, Value);
@@ -164,6 +246,11 @@ FString UBlueprintHttpServerLibrary::GetBody(UPARAM(ref) const FBlueprintHttpReq
 	return HttpRequest.GetBody();
 }
 
+TArray<uint8> UBlueprintHttpServerLibrary::GetBodyBytes(UPARAM(ref) const FBlueprintHttpRequest& HttpRequest)
+{
+	return HttpRequest.GetBodyBytes();
+}
+
 bool	UBlueprintHttpServerLibrary::HasUrlParameter(UPARAM(ref) const FBlueprintHttpRequest& HttpRequest, const FString& Name)
 {
 	return HttpRequest.HasUrlParameter(Name);
@@ -174,6 +261,16 @@ FString UBlueprintHttpServerLibrary::GetUrlParameter(UPARAM(ref) const FBlueprin
 	return HttpRequest.GetUrlParameter(Name);
 }
 
+bool UBlueprintHttpServerLibrary::HasPathParameter(UPARAM(ref) const FBlueprintHttpRequest& HttpRequest, const FString& Name)
+{
+	return HttpRequest.HasPathParameter(Name);
+}
+
+FString UBlueprintHttpServerLibrary::GetPathParameter(UPARAM(ref) const FBlueprintHttpRequest& HttpRequest, const FString& Name)
+{
+	return HttpRequest.GetPathParameter(Name);
+}
+
 FString UBlueprintHttpServerLibrary::GetRemoteAddress(UPARAM(ref) const FBlueprintHttpRequest& HttpRequest)
 {
 	return HttpRequest.GetRemoteAddress();
@@ -11,6 +11,15 @@
 UDELEGATE()
 DECLARE_DYNAMIC_DELEGATE_TwoParams(FHttpServerRouteMulticastCallback, const FBlueprintHttpRequest&, HttpRequest, FBlueprintHttpResponse, HttpResponse);
 
+UDELEGATE()
+DECLARE_DYNAMIC_DELEGATE_FourParams(FHttpServerFileUploadDynamicCallback, const FBlueprintHttpRequest&, HttpRequest, FBlueprintHttpResponse, HttpResponse, const FString&, FilePath, int64, Size);
+
+UDELEGATE()
+DECLARE_DYNAMIC_DELEGATE_ThreeParams(FHttpServerMultipartDynamicCallback, const FBlueprintHttpRequest&, HttpRequest, FBlueprintHttpResponse, HttpResponse, const TArray<FHttpServerMultipartPart>&, Parts);
+
+UDELEGATE()
+DECLARE_DYNAMIC_DELEGATE_OneParam(FHttpServerWebSocketDynamicCallback, const TArray<FHttpServerWebSocketMessage>&, Messages);
+
 UENUM()
 enum class ESuccessFailBranching : uint8
 {
@@ -116,6 +125,53 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Http|Server")
 	static void AddRoute(UBlueprintHttpServer* HttpServer, const EHttpServerVerb Verb, const FString& Route, const bool bRequireGameThread, FHttpServerRouteMulticastCallback Callback);
 
+	/**
+	 * Removes a route, also while the server is running.
+	 * @param HttpServer The Http Server the route was added to.
+	 * @param Verb The verb of the route.
+	 * @param Route The address the route was added with.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server", meta = (ExpandEnumAsExecs = "Branch"))
+	static void RemoveRoute(UBlueprintHttpServer* HttpServer, const EHttpServerVerb Verb, const FString& Route, ESuccessFailBranching& Branch);
+
+	/**
+	 * Adds a route streaming uploaded bodies to new files, without holding them in memory.
+	 * @param HttpServer The Http Server we want to bind the callback to.
+	 * @param Verb The verb of the route: POST, PUT, PATCH or DELETE.
+	 * @param Route The address of the route.
+	 * @param Directory Where the files are created, with unique names.
+	 * @param Callback Callback called with the file once the body was received. It owns the file.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server")
+	static void AddFileUploadListener(UBlueprintHttpServer* HttpServer, const EHttpServerVerb Verb, const FString& Route, const FString& Directory, const bool bRequireGameThread, FHttpServerFileUploadDynamicCallback Callback);
+
+	/**
+	 * Adds a route parsing multipart/form-data uploads as they arrive, file parts are streamed to new files.
+	 * @param HttpServer The Http Server we want to bind the callback to.
+	 * @param Verb The verb of the route: POST, PUT, PATCH or DELETE.
+	 * @param Route The address of the route.
+	 * @param Directory Where the files are created, with unique names.
+	 * @param Callback Callback called with the parts once the body was received. It owns their files.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server")
+	static void AddMultipartUploadListener(UBlueprintHttpServer* HttpServer, const EHttpServerVerb Verb, const FString& Route, const FString& Directory, const bool bRequireGameThread, FHttpServerMultipartDynamicCallback Callback);
+
+	/**
+	 * Accepts WebSocket connections on a route.
+	 * @param HttpServer The Http Server we want to bind the callback to.
+	 * @param Route The address of the route.
+	 * @param Callback Callback called with the events received since its previous call.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server|WebSocket")
+	static void AddWebSocketListener(UBlueprintHttpServer* HttpServer, const FString& Route, const bool bRequireGameThread, FHttpServerWebSocketDynamicCallback Callback);
+
+	/**
+	 * Decodes the payload of a WebSocket text message.
+	 * @param Message The message.
+	*/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Http|Server|WebSocket")
+	static UPARAM(DisplayName = "Text") FString GetWebSocketMessageText(const FHttpServerWebSocketMessage& Message);
+
 
 	///////////////////////////////////////////////////////
 	// FBlueprintHttpResponse nodes.
@@ -143,6 +199,16 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Http|Server|Response")
 	static void SetBinaryContent(UPARAM(ref)FBlueprintHttpResponse& HttpResponse, const TArray<uint8>& Content, const FString& MimeType);
 
+	/**
+	 * Set the response's content to a file, read from disk as it is sent.
+	 * Range requests only read the requested parts, so downloads can be resumed.
+	 * @param FilePath	The file to send.
+	 * @param MimeType	The response's Mime-Type.
+	 * @return False if the file couldn't be opened.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server|Response")
+	static bool SetFileContent(UPARAM(ref)FBlueprintHttpResponse& HttpResponse, const FString& FilePath, const FString& MimeType);
+
 	/**
 	 * Appends a string to the current body content.
 	 * @param Body What to append to the body.
@@ -250,6 +316,14 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Http|Server|Request")
 	static UPARAM(DisplayName = "Body") FString GetBody(UPARAM(ref) const FBlueprintHttpRequest& HttpRequest);
 
+	/**
+	 * Gets the request's raw body, without any conversion.
+	 * Use it for binary uploads.
+	 * @return The body bytes.
+	*/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Http|Server|Request")
+	static UPARAM(DisplayName = "Body") TArray<uint8> GetBodyBytes(UPARAM(ref) const FBlueprintHttpRequest& HttpRequest);
+
 	/**
 	 * Checks if the URL contains the specified parameter.
 	 * @param Name The name of the parameter.
@@ -266,6 +340,23 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Http|Server|Request")
 	static UPARAM(DisplayName = "Parameter") FString GetUrlParameter(UPARAM(ref) const FBlueprintHttpRequest& HttpRequest, const FString& Name);
 
+	/**
+	 * Checks if the route captured the specified path parameter.
+	 * @param Name The name of the parameter, as written in the route pattern.
+	 * @return True if the parameter was captured.
+	*/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Http|Server|Request")
+	static UPARAM(DisplayName = "Has Parameter") bool HasPathParameter(UPARAM(ref) const FBlueprintHttpRequest& HttpRequest, const FString& Name);
+
+	/**
+	 * Gets a path parameter, e.g. "id" for the route /drone/:id.
+	 * Only routes added with the radix router capture path parameters.
+	 * @param Name The name of the parameter, as written in the route pattern.
+	 * @return The value of the parameter.
+	*/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Http|Server|Request")
+	static UPARAM(DisplayName = "Parameter") FString GetPathParameter(UPARAM(ref) const FBlueprintHttpRequest& HttpRequest, const FString& Name);
+
 	/**
 	 * Get the request's remote address.
 	 * @return The request's remote address.
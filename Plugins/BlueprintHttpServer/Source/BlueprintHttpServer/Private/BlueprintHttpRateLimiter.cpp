@@ -0,0 +1,217 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#include "BlueprintHttpRateLimiter.h"
+
+#include "BlueprintHttpServerModule.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace BlueprintHttpRateLimiter
+{
+	// Buckets of a shard are swept of idle clients past this size.
+	static constexpr size_t MinSweepThreshold = 1024;
+
+	// Sent with 503, the cap usually clears within the second.
+	static constexpr const char* InFlightRetryAfter = "1";
+}
+
+FBlueprintHttpRateLimiter::FBlueprintHttpRateLimiter()
+	: MaxInFlight(0)
+	, InFlight(0)
+	, RateLimited(0)
+	, InFlightRejected(0)
+{
+}
+
+FBlueprintHttpRateLimiter::~FBlueprintHttpRateLimiter() = default;
+
+void FBlueprintHttpRateLimiter::AddRule(const FString& PathPrefix, const float RequestsPerSecond, const int32 Burst, const EHttpServerRateLimitKey Key, const FString& HeaderName)
+{
+	std::unique_ptr<FRule> Rule = std::make_unique<FRule>();
+	Rule->Prefix	 = TCHAR_TO_UTF8(*PathPrefix);
+	Rule->Rate		 = RequestsPerSecond;
+	Rule->Burst		 = FMath::Max(1, Burst);
+	Rule->Key		 = Key;
+	Rule->HeaderName = TCHAR_TO_UTF8(*HeaderName);
+
+	for (FShard& Shard : Rule->Shards)
+	{
+		Shard.SweepThreshold = BlueprintHttpRateLimiter::MinSweepThreshold;
+	}
+
+	// A rule replaces the one with the same prefix.
+	Rules.erase(std::remove_if(Rules.begin(), Rules.end(), [&Rule](const std::unique_ptr<FRule>& Other) -> bool
+	{
+		return Other->Prefix == Rule->Prefix;
+	}), Rules.end());
+
+	Rules.push_back(MoveTemp(Rule));
+
+	std::stable_sort(Rules.begin(), Rules.end(), [](const std::unique_ptr<FRule>& A, const std::unique_ptr<FRule>& B) -> bool
+	{
+		return A->Prefix.size() > B->Prefix.size();
+	});
+}
+
+bool FBlueprintHttpRateLimiter::Admit(const httplib::Request& Request, httplib::Response& Response)
+{
+	FRule* Rule = nullptr;
+
+	for (const std::unique_ptr<FRule>& Candidate : Rules)
+	{
+		if (Request.path.compare(0, Candidate->Prefix.size(), Candidate->Prefix) == 0)
+		{
+			Rule = Candidate.get();
+			break;
+		}
+	}
+
+	if (!Rule)
+	{
+		return true;
+	}
+
+	const std::string ClientKey = MakeClientKey(*Rule, Request);
+	const double	  Now		= FPlatformTime::Seconds();
+
+	FShard& Shard = Rule->Shards[std::hash<std::string>()(ClientKey) % NumShards];
+
+	double RetryAfter = 0.0;
+
+	{
+		FScopeLock Lock(&Shard.Mutex);
+
+		auto Found = Shard.Buckets.find(ClientKey);
+
+		if (Found == Shard.Buckets.end())
+		{
+			if (Shard.Buckets.size() >= Shard.SweepThreshold)
+			{
+				Sweep(*Rule, Shard, Now);
+			}
+
+			Found = Shard.Buckets.emplace(ClientKey, FBucket{ Rule->Burst, Now }).first;
+		}
+
+		FBucket& Bucket = Found->second;
+
+		Bucket.Tokens	  = FMath::Min(Rule->Burst, Bucket.Tokens + (Now - Bucket.LastRefill) * Rule->Rate);
+		Bucket.LastRefill = Now;
+
+		if (Bucket.Tokens >= 1.0)
+		{
+			Bucket.Tokens -= 1.0;
+			return true;
+		}
+
+		RetryAfter = (1.0 - Bucket.Tokens) / Rule->Rate;
+	}
+
+	RateLimited.fetch_add(1, std::memory_order_relaxed);
+
+	Response.status = 429;
+	Response.set_header("Retry-After", std::to_string(FMath::Max<int64>(1, static_cast<int64>(std::ceil(RetryAfter)))));
+
+	return false;
+}
+
+bool FBlueprintHttpRateLimiter::BeginRequest(httplib::Response& Response)
+{
+	const int32 Max = MaxInFlight.load(std::memory_order_relaxed);
+
+	if (Max <= 0)
+	{
+		InFlight.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	if (InFlight.fetch_add(1, std::memory_order_relaxed) >= Max)
+	{
+		InFlight.fetch_sub(1, std::memory_order_relaxed);
+		InFlightRejected.fetch_add(1, std::memory_order_relaxed);
+
+		Response.status = 503;
+		Response.set_header("Retry-After", BlueprintHttpRateLimiter::InFlightRetryAfter);
+
+		return false;
+	}
+
+	return true;
+}
+
+void FBlueprintHttpRateLimiter::EndRequest()
+{
+	InFlight.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void FBlueprintHttpRateLimiter::SetMaxInFlight(const int32 MaxRequests)
+{
+	MaxInFlight = FMath::Max(0, MaxRequests);
+}
+
+FHttpServerRateLimitStats FBlueprintHttpRateLimiter::GetStats() const
+{
+	FHttpServerRateLimitStats Stats;
+	Stats.RateLimited	   = RateLimited.load(std::memory_order_relaxed);
+	Stats.InFlightRejected = InFlightRejected.load(std::memory_order_relaxed);
+	Stats.InFlight		   = InFlight.load(std::memory_order_relaxed);
+
+	for (const std::unique_ptr<FRule>& Rule : Rules)
+	{
+		for (FShard& Shard : Rule->Shards)
+		{
+			FScopeLock Lock(&Shard.Mutex);
+			Stats.TrackedClients += static_cast<int32>(Shard.Buckets.size());
+		}
+	}
+
+	return Stats;
+}
+
+std::string FBlueprintHttpRateLimiter::MakeClientKey(const FRule& Rule, const httplib::Request& Request)
+{
+	if (Rule.Key == EHttpServerRateLimitKey::RemoteAddress)
+	{
+		return Request.remote_addr;
+	}
+
+	// Null when missing, the headers may be parsed in place.
+	const std::string_view Header = Request.get_header_value_view(Rule.HeaderName.c_str());
+
+	// Clients without the header are limited by address, kept apart from the tokens.
+	if (!Header.data())
+	{
+		return std::string(1, '\0') + Request.remote_addr;
+	}
+
+	if (Rule.Key == EHttpServerRateLimitKey::Header)
+	{
+		return std::string(Header);
+	}
+
+	std::string Key = Request.remote_addr;
+	Key += '\0';
+	Key += Header;
+	return Key;
+}
+
+void FBlueprintHttpRateLimiter::Sweep(const FRule& Rule, FShard& Shard, const double Now)
+{
+	const double RefillSeconds = Rule.Burst / Rule.Rate;
+
+	for (auto It = Shard.Buckets.begin(); It != Shard.Buckets.end();)
+	{
+		if (Now - It->second.LastRefill >= RefillSeconds)
+		{
+			It = Shard.Buckets.erase(It);
+		}
+		else
+		{
+			++It;
+		}
+	}
+
+	// Sweeping again is only worth it once the map doubled.
+	Shard.SweepThreshold = FMath::Max(BlueprintHttpRateLimiter::MinSweepThreshold, Shard.Buckets.size() * 2);
+}
@@ -0,0 +1,113 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BlueprintHttpServer.h"
+
+#include "BlueprintHttpLib.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Admission control of a server.
+ * Requests are limited per client with token buckets, one set per route class,
+ * and rejected with 429 before their body is read or any callback is dispatched.
+ * Requests served by route callbacks are also capped globally: over the cap,
+ * new ones fail fast with 503 instead of queuing for a worker or the game thread.
+*/
+class FBlueprintHttpRateLimiter final
+{
+public:
+	FBlueprintHttpRateLimiter();
+	~FBlueprintHttpRateLimiter();
+
+	/**
+	 * Adds a route class. Not thread safe, rules can't change while the server runs.
+	 * A request is limited by the rule with the longest prefix of its path.
+	*/
+	void AddRule(const FString& PathPrefix, const float RequestsPerSecond, const int32 Burst, const EHttpServerRateLimitKey Key, const FString& HeaderName);
+
+	bool HasRules() const { return Rules.size() > 0; }
+
+	/**
+	 * Takes a token from the bucket of the request's client.
+	 * @return False if the request was rejected, the response is set.
+	*/
+	bool Admit(const httplib::Request& Request, httplib::Response& Response);
+
+	/**
+	 * Counts a request handed to a route callback. Thread safe.
+	 * @return False if the in-flight cap is reached, the response is set and EndRequest() must not be called.
+	*/
+	bool BeginRequest(httplib::Response& Response);
+
+	/**
+	 * Called once the response of an admitted request is sent.
+	*/
+	void EndRequest();
+
+	/**
+	 * @param MaxRequests The max requests in flight, 0 for no limit.
+	*/
+	void SetMaxInFlight(const int32 MaxRequests);
+
+	FHttpServerRateLimitStats GetStats() const;
+
+private:
+	struct FBucket
+	{
+		double Tokens;
+		double LastRefill;
+	};
+
+	struct FShard
+	{
+		FCriticalSection Mutex;
+		std::unordered_map<std::string, FBucket> Buckets;
+
+		/**
+		 * Idle buckets are swept when the map grows over it.
+		*/
+		size_t SweepThreshold;
+	};
+
+	/**
+	 * Clients are spread on shards so workers rarely wait on each other.
+	*/
+	static constexpr size_t NumShards = 16;
+
+	struct FRule
+	{
+		std::string Prefix;
+		double Rate;
+		double Burst;
+		EHttpServerRateLimitKey Key;
+		std::string HeaderName;
+
+		FShard Shards[NumShards];
+	};
+
+	static std::string MakeClientKey(const FRule& Rule, const httplib::Request& Request);
+
+	/**
+	 * Removes the buckets that refilled completely, they are the same as new ones. Mutex must be held.
+	*/
+	static void Sweep(const FRule& Rule, FShard& Shard, const double Now);
+
+private:
+	/**
+	 * Sorted by decreasing prefix length.
+	*/
+	std::vector<std::unique_ptr<FRule>> Rules;
+
+	std::atomic<int32> MaxInFlight;
+	std::atomic<int32> InFlight;
+
+	std::atomic<int64> RateLimited;
+	std::atomic<int64> InFlightRejected;
+};
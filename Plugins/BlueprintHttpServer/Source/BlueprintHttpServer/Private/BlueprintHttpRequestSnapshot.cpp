@@ -0,0 +1,125 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#include "BlueprintHttpRequestSnapshot.h"
+
+#include "BlueprintHttpLib.h"
+
+TSharedRef<const FBlueprintHttpRequestSnapshot, ESPMode::ThreadSafe> FBlueprintHttpRequestSnapshot::Create(const httplib::Request& Request)
+{
+	TSharedRef<FBlueprintHttpRequestSnapshot, ESPMode::ThreadSafe> Snapshot = MakeShareable(new FBlueprintHttpRequestSnapshot());
+
+	// Size the buffers once to avoid growing them for each string.
+	size_t StringsSize = Request.method.size() + Request.path.size() + Request.remote_addr.size() + 3;
+	int32  HeaderCount = 0;
+	Request.for_each_header([&StringsSize, &HeaderCount](const std::string_view Key, const std::string_view Value)
+	{
+		StringsSize += Key.size() + Value.size() + 2;
+		++HeaderCount;
+	});
+	for (const auto& Param : Request.params)
+	{
+		StringsSize += Param.first.size() + Param.second.size() + 2;
+	}
+	for (const auto& Param : Request.path_params)
+	{
+		StringsSize += Param.first.size() + Param.second.size() + 2;
+	}
+
+	Snapshot->Strings.Reserve(static_cast<int32>(StringsSize));
+	Snapshot->Headers.Reserve(HeaderCount);
+	Snapshot->Params .Reserve(static_cast<int32>(Request.params .size()));
+	Snapshot->PathParams.Reserve(static_cast<int32>(Request.path_params.size()));
+
+	Snapshot->Method		= Snapshot->AddString(Request.method.data(),	  Request.method.size());
+	Snapshot->Path			= Snapshot->AddString(Request.path.data(),		  Request.path.size());
+	Snapshot->RemoteAddress = Snapshot->AddString(Request.remote_addr.data(), Request.remote_addr.size());
+	Snapshot->RemotePort	= Request.remote_port;
+
+	Request.for_each_header([&Snapshot](const std::string_view HeaderKey, const std::string_view HeaderValue)
+	{
+		const FSlice Key   = Snapshot->AddString(HeaderKey  .data(), HeaderKey  .size());
+		const FSlice Value = Snapshot->AddString(HeaderValue.data(), HeaderValue.size());
+		Snapshot->Headers.Add({ Key, Value });
+	});
+
+	for (const auto& Param : Request.params)
+	{
+		const FSlice Key   = Snapshot->AddString(Param.first .data(), Param.first .size());
+		const FSlice Value = Snapshot->AddString(Param.second.data(), Param.second.size());
+		Snapshot->Params.Add({ Key, Value });
+	}
+
+	for (const auto& Param : Request.path_params)
+	{
+		const FSlice Key   = Snapshot->AddString(Param.first .data(), Param.first .size());
+		const FSlice Value = Snapshot->AddString(Param.second.data(), Param.second.size());
+		Snapshot->PathParams.Add({ Key, Value });
+	}
+
+	Snapshot->Body.SetNumUninitialized(static_cast<int32>(Request.body.size()));
+	if (Request.body.size() > 0)
+	{
+		FMemory::Memcpy(Snapshot->Body.GetData(), Request.body.data(), Request.body.size());
+	}
+
+	return Snapshot;
+}
+
+FBlueprintHttpRequestSnapshot::FSlice FBlueprintHttpRequestSnapshot::AddString(const char* const Data, const size_t Length)
+{
+	FSlice Slice;
+	Slice.Offset = Strings.Num();
+	Slice.Length = static_cast<int32>(Length);
+
+	// Strings are NUL terminated so they can be handed to C APIs as-is.
+	Strings.Append(Data, Slice.Length);
+	Strings.Add('\0');
+
+	return Slice;
+}
+
+const FBlueprintHttpRequestSnapshot::FEntry* FBlueprintHttpRequestSnapshot::FindHeader(const ANSICHAR* Key, const int32 KeyLength) const
+{
+	for (const FEntry& Header : Headers)
+	{
+		if (Header.Key.Length == KeyLength && FCStringAnsi::Strnicmp(GetData(Header.Key), Key, KeyLength) == 0)
+		{
+			return &Header;
+		}
+	}
+
+	return nullptr;
+}
+
+const FBlueprintHttpRequestSnapshot::FEntry* FBlueprintHttpRequestSnapshot::FindParam(const ANSICHAR* Key, const int32 KeyLength) const
+{
+	for (const FEntry& Param : Params)
+	{
+		if (Param.Key.Length == KeyLength && FMemory::Memcmp(GetData(Param.Key), Key, KeyLength) == 0)
+		{
+			return &Param;
+		}
+	}
+
+	return nullptr;
+}
+
+const FBlueprintHttpRequestSnapshot::FEntry* FBlueprintHttpRequestSnapshot::FindPathParam(const ANSICHAR* Key, const int32 KeyLength) const
+{
+	for (const FEntry& Param : PathParams)
+	{
+		if (Param.Key.Length == KeyLength && FMemory::Memcmp(GetData(Param.Key), Key, KeyLength) == 0)
+		{
+			return &Param;
+		}
+	}
+
+	return nullptr;
+}
+
+FString FBlueprintHttpRequestSnapshot::ToString(const FSlice& Slice) const
+{
+	const FUTF8ToTCHAR Converted(GetData(Slice), Slice.Length);
+
+	return FString(Converted.Length(), Converted.Get());
+}
@@ -0,0 +1,99 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace httplib { struct Request; }
+
+/**
+ * Immutable copy of a parsed request.
+ * All strings are stored UTF-8 encoded in a single buffer and referenced
+ * by offset, so a snapshot is a handful of allocations and can be read
+ * from any thread without locking, after the httplib request is gone.
+*/
+class FBlueprintHttpRequestSnapshot final
+{
+public:
+	/**
+	 * A string stored in the snapshot's buffer.
+	*/
+	struct FSlice
+	{
+		int32 Offset = 0;
+		int32 Length = 0;
+	};
+
+	/**
+	 * A key/value pair stored in the snapshot's buffer.
+	*/
+	struct FEntry
+	{
+		FSlice Key;
+		FSlice Value;
+	};
+
+public:
+	/**
+	 * Copies the request's data.
+	 * @param Request The parsed request.
+	 * @return The immutable snapshot.
+	*/
+	static TSharedRef<const FBlueprintHttpRequestSnapshot, ESPMode::ThreadSafe> Create(const httplib::Request& Request);
+
+	/**
+	 * Finds the first header with this key, case insensitive.
+	 * @return The header or nullptr.
+	*/
+	const FEntry* FindHeader(const ANSICHAR* Key, const int32 KeyLength) const;
+
+	/**
+	 * Finds the first URL parameter with this name, case sensitive.
+	 * @return The parameter or nullptr.
+	*/
+	const FEntry* FindParam(const ANSICHAR* Key, const int32 KeyLength) const;
+
+	/**
+	 * Finds the path parameter with this name, case sensitive.
+	 * @return The parameter or nullptr.
+	*/
+	const FEntry* FindPathParam(const ANSICHAR* Key, const int32 KeyLength) const;
+
+	const TArray<FEntry>& GetHeaders	() const { return Headers;	  }
+	const TArray<FEntry>& GetParams		() const { return Params;	  }
+	const TArray<FEntry>& GetPathParams () const { return PathParams; }
+
+	const TArray<uint8>& GetBody() const { return Body; }
+
+	FSlice GetMethod		() const { return Method;		 }
+	FSlice GetPath			() const { return Path;			 }
+	FSlice GetRemoteAddress () const { return RemoteAddress; }
+	int32  GetRemotePort	() const { return RemotePort;	 }
+
+	/**
+	 * Gets a pointer to the first character of a slice.
+	*/
+	const ANSICHAR* GetData(const FSlice& Slice) const { return Strings.GetData() + Slice.Offset; }
+
+	/**
+	 * Converts a slice to an FString.
+	*/
+	FString ToString(const FSlice& Slice) const;
+
+private:
+	FBlueprintHttpRequestSnapshot() = default;
+
+	FSlice AddString(const char* const Data, const size_t Length);
+
+private:
+	TArray<ANSICHAR> Strings;
+	TArray<FEntry>	 Headers;
+	TArray<FEntry>	 Params;
+	TArray<FEntry>	 PathParams;
+	TArray<uint8>	 Body;
+
+	FSlice Method;
+	FSlice Path;
+	FSlice RemoteAddress;
+	int32  RemotePort = -1;
+};
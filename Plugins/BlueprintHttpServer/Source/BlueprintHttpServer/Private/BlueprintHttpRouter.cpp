@@ -0,0 +1,476 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#include "BlueprintHttpRouter.h"
+
+#include "Hash/CityHash.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "BlueprintHttpServerModule.h"
+
+namespace BlueprintHttpRouter
+{
+	enum class EParameterType : uint8
+	{
+		// Sorted by priority.
+		UInt,
+		Int,
+		Any
+	};
+
+	static bool IsValueOfType(const char* Value, const char* const End, const EParameterType Type)
+	{
+		if (Type == EParameterType::Any)
+		{
+			return true;
+		}
+
+		if (Type == EParameterType::Int && Value < End && *Value == '-')
+		{
+			++Value;
+		}
+
+		if (Value == End)
+		{
+			return false;
+		}
+
+		for (; Value < End; ++Value)
+		{
+			if (*Value < '0' || *Value > '9')
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static uint32 HashSegment(const char* const Segment, const int32 Length)
+	{
+		return CityHash32(Segment, static_cast<uint32>(Length));
+	}
+
+	static int32 GetVerbIndex(const std::string& Method)
+	{
+		if (Method == "GET" || Method == "HEAD") return static_cast<int32>(EHttpServerVerb::Get);
+		if (Method == "POST")					 return static_cast<int32>(EHttpServerVerb::Post);
+		if (Method == "PUT")					 return static_cast<int32>(EHttpServerVerb::Put);
+		if (Method == "DELETE")					 return static_cast<int32>(EHttpServerVerb::Delete);
+		if (Method == "OPTIONS")				 return static_cast<int32>(EHttpServerVerb::Options);
+		if (Method == "PATCH")					 return static_cast<int32>(EHttpServerVerb::Patch);
+		return INDEX_NONE;
+	}
+}
+
+struct FBlueprintHttpRouter::FNode
+{
+	struct FLiteral
+	{
+		uint32			  Hash;
+		std::string		  Segment;
+		TUniquePtr<FNode> Node;
+	};
+
+	struct FParameter
+	{
+		BlueprintHttpRouter::EParameterType Type;
+		std::string							Name;
+		TUniquePtr<FNode>					Node;
+	};
+
+	// std::vector as std::string isn't trivially relocatable.
+	// Sorted by hash.
+	std::vector<FLiteral>	Literals;
+	// Sorted by type priority.
+	std::vector<FParameter> Parameters;
+
+	std::string WildcardName;
+	FHandler	WildcardHandler;
+
+	// Handler of the route ending on this node.
+	FHandler Handler;
+};
+
+struct FBlueprintHttpRouter::FCapture
+{
+	const std::string* Name;
+	const char*		   Value;
+	int32			   Length;
+};
+
+FBlueprintHttpRouter::FBlueprintHttpRouter()
+	: Routes(std::make_unique<const FRoutes>())
+{
+}
+
+FBlueprintHttpRouter::~FBlueprintHttpRouter() = default;
+
+TUniquePtr<FBlueprintHttpRouter::FNode> FBlueprintHttpRouter::CloneNode(const FNode& Node)
+{
+	TUniquePtr<FNode> Clone = MakeUnique<FNode>();
+
+	Clone->Literals.reserve(Node.Literals.size());
+	for (const FNode::FLiteral& Literal : Node.Literals)
+	{
+		Clone->Literals.push_back(FNode::FLiteral{ Literal.Hash, Literal.Segment, CloneNode(*Literal.Node) });
+	}
+
+	Clone->Parameters.reserve(Node.Parameters.size());
+	for (const FNode::FParameter& Parameter : Node.Parameters)
+	{
+		Clone->Parameters.push_back(FNode::FParameter{ Parameter.Type, Parameter.Name, CloneNode(*Parameter.Node) });
+	}
+
+	Clone->WildcardName	   = Node.WildcardName;
+	Clone->WildcardHandler = Node.WildcardHandler;
+	Clone->Handler		   = Node.Handler;
+
+	return Clone;
+}
+
+bool FBlueprintHttpRouter::PruneNode(FNode& Node)
+{
+	Node.Literals.erase(std::remove_if(Node.Literals.begin(), Node.Literals.end(), [](FNode::FLiteral& Literal) -> bool
+	{
+		return PruneNode(*Literal.Node);
+	}), Node.Literals.end());
+
+	Node.Parameters.erase(std::remove_if(Node.Parameters.begin(), Node.Parameters.end(), [](FNode::FParameter& Parameter) -> bool
+	{
+		return PruneNode(*Parameter.Node);
+	}), Node.Parameters.end());
+
+	return Node.Literals.empty() && Node.Parameters.empty() && !Node.WildcardHandler && !Node.Handler;
+}
+
+bool FBlueprintHttpRouter::Add(const EHttpServerVerb Verb, const FString& Pattern, TFunctionRef<FHandler()> MakeHandler)
+{
+	return Update(Verb, [&](FNode& Root) -> bool
+	{
+		bool		bWildcard = false;
+		std::string WildcardName;
+
+		FNode* const Node = FindNode(Root, Pattern, true, bWildcard, WildcardName);
+		if (!Node)
+		{
+			return false;
+		}
+
+		FHandler& Target = bWildcard ? Node->WildcardHandler : Node->Handler;
+		if (Target)
+		{
+			UE_LOG(LogHttpServer, Error, TEXT("Route `%s` is already registered."), *Pattern);
+			return false;
+		}
+
+		if (bWildcard)
+		{
+			Node->WildcardName = MoveTemp(WildcardName);
+		}
+
+		Target = MakeHandler();
+
+		return true;
+	});
+}
+
+bool FBlueprintHttpRouter::Remove(const EHttpServerVerb Verb, const FString& Pattern)
+{
+	return Update(Verb, [&](FNode& Root) -> bool
+	{
+		bool		bWildcard = false;
+		std::string WildcardName;
+
+		FNode* const Node = FindNode(Root, Pattern, false, bWildcard, WildcardName);
+		if (!Node)
+		{
+			return false;
+		}
+
+		FHandler& Target = bWildcard ? Node->WildcardHandler : Node->Handler;
+		if (!Target)
+		{
+			return false;
+		}
+
+		Target = nullptr;
+
+		if (bWildcard)
+		{
+			Node->WildcardName.clear();
+		}
+
+		PruneNode(Root);
+
+		return true;
+	});
+}
+
+bool FBlueprintHttpRouter::Update(const EHttpServerVerb Verb, TFunctionRef<bool(FNode&)> Modifier)
+{
+	check(Verb != EHttpServerVerb::MAX);
+
+	std::lock_guard<std::mutex> Lock(UpdateMutex);
+
+	const FRoutes&						Current = Routes.current();
+	const std::shared_ptr<const FNode>& Root	= Current.Roots[static_cast<int32>(Verb)];
+
+	// The tree is only read by requests once published, the copy is ours.
+	TUniquePtr<FNode> NewRoot = Root ? CloneNode(*Root) : MakeUnique<FNode>();
+	if (!Modifier(*NewRoot))
+	{
+		return false;
+	}
+
+	std::unique_ptr<FRoutes> NewRoutes = std::make_unique<FRoutes>(Current);
+	NewRoutes->Roots[static_cast<int32>(Verb)] = std::shared_ptr<const FNode>(NewRoot.Release());
+
+	Routes.publish(MoveTemp(NewRoutes));
+
+	return true;
+}
+
+FBlueprintHttpRouter::FNode* FBlueprintHttpRouter::FindNode(FNode& Root, const FString& Pattern, const bool bCreate, bool& bWildcard, std::string& WildcardName)
+{
+	using namespace BlueprintHttpRouter;
+
+	const FTCHARToUTF8 Utf8Pattern(*Pattern);
+	const char* const  End = Utf8Pattern.Get() + Utf8Pattern.Length();
+
+	FNode* Node = &Root;
+
+	bWildcard = false;
+
+	for (const char* Segment = Utf8Pattern.Get(); Segment < End; )
+	{
+		if (*Segment == '/')
+		{
+			++Segment;
+			continue;
+		}
+
+		const char* SegmentEnd = Segment;
+		while (SegmentEnd < End && *SegmentEnd != '/')
+		{
+			++SegmentEnd;
+		}
+
+		// Wildcard, must be last.
+		if (*Segment == '*')
+		{
+			if (SegmentEnd != End)
+			{
+				UE_LOG(LogHttpServer, Error, TEXT("Invalid route `%s`: wildcards must be the last segment."), *Pattern);
+				return nullptr;
+			}
+
+			bWildcard	 = true;
+			WildcardName = SegmentEnd - Segment > 1 ? std::string(Segment + 1, SegmentEnd) : std::string("*");
+			return Node;
+		}
+
+		// Parameter, with an optional type.
+		if (*Segment == ':')
+		{
+			const char* NameEnd = Segment + 1;
+			while (NameEnd < SegmentEnd && *NameEnd != '<')
+			{
+				++NameEnd;
+			}
+
+			EParameterType Type = EParameterType::Any;
+			if (NameEnd < SegmentEnd)
+			{
+				const std::string TypeName(NameEnd, SegmentEnd);
+				if (TypeName == "<int>")
+				{
+					Type = EParameterType::Int;
+				}
+				else if (TypeName == "<uint>")
+				{
+					Type = EParameterType::UInt;
+				}
+				else
+				{
+					UE_LOG(LogHttpServer, Error, TEXT("Invalid route `%s`: unknown parameter type %s."), *Pattern, UTF8_TO_TCHAR(TypeName.c_str()));
+					return nullptr;
+				}
+			}
+
+			const std::string Name(Segment + 1, NameEnd);
+			if (Name.empty())
+			{
+				UE_LOG(LogHttpServer, Error, TEXT("Invalid route `%s`: unnamed parameter."), *Pattern);
+				return nullptr;
+			}
+
+			auto Parameter = std::find_if(Node->Parameters.begin(), Node->Parameters.end(), [&](const FNode::FParameter& Other)
+			{
+				return Other.Type == Type && Other.Name == Name;
+			});
+
+			if (Parameter == Node->Parameters.end())
+			{
+				if (!bCreate)
+				{
+					return nullptr;
+				}
+
+				const auto Position = std::upper_bound(Node->Parameters.begin(), Node->Parameters.end(), Type, [](const EParameterType Value, const FNode::FParameter& Other)
+				{
+					return Value < Other.Type;
+				});
+				Parameter = Node->Parameters.insert(Position, FNode::FParameter{ Type, Name, MakeUnique<FNode>() });
+			}
+
+			Node	= Parameter->Node.Get();
+			Segment = SegmentEnd;
+			continue;
+		}
+
+		// Literal.
+		const int32  Length = static_cast<int32>(SegmentEnd - Segment);
+		const uint32 Hash	= HashSegment(Segment, Length);
+
+		auto Literal = std::lower_bound(Node->Literals.begin(), Node->Literals.end(), Hash, [](const FNode::FLiteral& Other, const uint32 Value)
+		{
+			return Other.Hash < Value;
+		});
+		while (Literal != Node->Literals.end() && Literal->Hash == Hash && Literal->Segment.compare(0, std::string::npos, Segment, Length) != 0)
+		{
+			++Literal;
+		}
+
+		if (Literal == Node->Literals.end() || Literal->Hash != Hash)
+		{
+			if (!bCreate)
+			{
+				return nullptr;
+			}
+
+			Literal = Node->Literals.insert(Literal, FNode::FLiteral{ Hash, std::string(Segment, Length), MakeUnique<FNode>() });
+		}
+
+		Node	= Literal->Node.Get();
+		Segment = SegmentEnd;
+	}
+
+	return Node;
+}
+
+const FBlueprintHttpRouter::FHandler* FBlueprintHttpRouter::Match(const FNode& Node, const char* Path, const char* const End, TArray<FCapture, TInlineAllocator<8>>& Captures)
+{
+	using namespace BlueprintHttpRouter;
+
+	while (Path < End && *Path == '/')
+	{
+		++Path;
+	}
+
+	if (Path == End)
+	{
+		if (Node.Handler)
+		{
+			return &Node.Handler;
+		}
+		if (Node.WildcardHandler)
+		{
+			Captures.Add({ &Node.WildcardName, Path, 0 });
+			return &Node.WildcardHandler;
+		}
+		return nullptr;
+	}
+
+	const char* SegmentEnd = Path;
+	while (SegmentEnd < End && *SegmentEnd != '/')
+	{
+		++SegmentEnd;
+	}
+
+	const int32 Length = static_cast<int32>(SegmentEnd - Path);
+
+	if (!Node.Literals.empty())
+	{
+		const uint32 Hash = HashSegment(Path, Length);
+
+		auto Literal = std::lower_bound(Node.Literals.begin(), Node.Literals.end(), Hash, [](const FNode::FLiteral& Other, const uint32 Value)
+		{
+			return Other.Hash < Value;
+		});
+
+		for (; Literal != Node.Literals.end() && Literal->Hash == Hash; ++Literal)
+		{
+			if (Literal->Segment.size() == static_cast<size_t>(Length) && FMemory::Memcmp(Literal->Segment.data(), Path, Length) == 0)
+			{
+				if (const FHandler* const Handler = Match(*Literal->Node, SegmentEnd, End, Captures))
+				{
+					return Handler;
+				}
+				break;
+			}
+		}
+	}
+
+	for (const FNode::FParameter& Parameter : Node.Parameters)
+	{
+		if (!IsValueOfType(Path, SegmentEnd, Parameter.Type))
+		{
+			continue;
+		}
+
+		Captures.Add({ &Parameter.Name, Path, Length });
+
+		if (const FHandler* const Handler = Match(*Parameter.Node, SegmentEnd, End, Captures))
+		{
+			return Handler;
+		}
+
+		Captures.Pop(false);
+	}
+
+	if (Node.WildcardHandler)
+	{
+		Captures.Add({ &Node.WildcardName, Path, static_cast<int32>(End - Path) });
+		return &Node.WildcardHandler;
+	}
+
+	return nullptr;
+}
+
+bool FBlueprintHttpRouter::Dispatch(httplib::Request& Request, httplib::Response& Response) const
+{
+	const int32 VerbIndex = BlueprintHttpRouter::GetVerbIndex(Request.method);
+	if (VerbIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// Keeps the handler alive if its route is removed meanwhile.
+	const httplib::detail::epoch_ptr<FRoutes>::reader Current = Routes.read();
+
+	const FNode* const Root = Current->Roots[VerbIndex].get();
+	if (!Root)
+	{
+		return false;
+	}
+
+	TArray<FCapture, TInlineAllocator<8>> Captures;
+
+	const FHandler* const Handler = Match(*Root, Request.path.data(), Request.path.data() + Request.path.size(), Captures);
+	if (!Handler)
+	{
+		return false;
+	}
+
+	Request.path_params.clear();
+	for (const FCapture& Capture : Captures)
+	{
+		Request.path_params[*Capture.Name] = std::string(Capture.Value, Capture.Length);
+	}
+
+	(*Handler)(Request, Response);
+
+	return true;
+}
@@ -0,0 +1,101 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BlueprintHttpServer.h"
+
+#include "BlueprintHttpLib.h"
+
+#include <memory>
+#include <mutex>
+
+/**
+ * Route matcher replacing httplib's linear list of regexes.
+ * Patterns are compiled into a tree of path segments per verb, a lookup
+ * walks the request path once. Supported segments:
+ *  - literals:			  /drone/status
+ *  - named parameters:	  /drone/:id, matches any single segment.
+ *  - typed parameters:	  /drone/:id<int>, /drone/:id<uint>.
+ *  - trailing wildcards: /files/*path, or /files/* stored as "*". Matches the rest of the path.
+ * When several patterns match, literals win over typed parameters, over
+ * parameters, over wildcards. Empty segments are ignored so "/a/" matches "/a".
+ * Captured values are stored in httplib::Request::path_params.
+ * Routes can be added and removed while the server runs. A change copies
+ * the tree of its verb and publishes it, lookups keep the tree they started
+ * with. They don't lock, the trees they can still read are freed by a later
+ * change (see httplib::detail::epoch_ptr).
+*/
+class FBlueprintHttpRouter final
+{
+public:
+	using FHandler = httplib::Server::Handler;
+
+	FBlueprintHttpRouter();
+	~FBlueprintHttpRouter();
+
+	/**
+	 * Adds a route.
+	 * @param Verb	  The route's verb. GET routes also match HEAD requests.
+	 * @param Pattern The route pattern.
+	 * @param MakeHandler Creates the handler called when the route is requested, only if the route is added.
+	 * @return False if the pattern is invalid or already added.
+	*/
+	bool Add(const EHttpServerVerb Verb, const FString& Pattern, TFunctionRef<FHandler()> MakeHandler);
+
+	/**
+	 * Removes a route. Requests already dispatched to it complete.
+	 * @param Verb	  The route's verb.
+	 * @param Pattern The pattern the route was added with.
+	 * @return False if the route wasn't found.
+	*/
+	bool Remove(const EHttpServerVerb Verb, const FString& Pattern);
+
+	/**
+	 * Finds the route of a request and runs its handler.
+	 * @return False if no route matches.
+	*/
+	bool Dispatch(httplib::Request& Request, httplib::Response& Response) const;
+
+private:
+	struct FNode;
+	struct FCapture;
+
+	struct FRoutes
+	{
+		// Shared between the tables until their verb changes.
+		std::shared_ptr<const FNode> Roots[static_cast<int32>(EHttpServerVerb::MAX)];
+	};
+
+	static const FHandler* Match(const FNode& Node, const char* Path, const char* const End, TArray<FCapture, TInlineAllocator<8>>& Captures);
+
+	// Deep copy, handlers included.
+	static TUniquePtr<FNode> CloneNode(const FNode& Node);
+
+	/**
+	 * Removes the children without any route below them.
+	 * @return True if the node itself can be removed.
+	*/
+	static bool PruneNode(FNode& Node);
+
+	/**
+	 * Walks the segments of a pattern.
+	 * @param bCreate If missing segments should be added.
+	 * @param bWildcard Set if the pattern ends with a wildcard, handled by the returned node.
+	 * @param WildcardName The wildcard's capture name.
+	 * @return The node the pattern ends on, nullptr if it's invalid or not found.
+	*/
+	static FNode* FindNode(FNode& Root, const FString& Pattern, const bool bCreate, bool& bWildcard, std::string& WildcardName);
+
+	/**
+	 * Copies the current tree of a verb, modifies it and swaps it in.
+	 * @param Modifier Returns false to discard the copy.
+	*/
+	bool Update(const EHttpServerVerb Verb, TFunctionRef<bool(FNode&)> Modifier);
+
+private:
+	httplib::detail::epoch_ptr<FRoutes> Routes;
+
+	// Serializes the writers.
+	std::mutex UpdateMutex;
+};
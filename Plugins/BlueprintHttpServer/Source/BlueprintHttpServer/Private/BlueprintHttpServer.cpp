@@ -2,26 +2,30 @@
 
 #include "BlueprintHttpServer.h"
 
-#if PLATFORM_WINDOWS
-#	include "Windows/AllowWindowsPlatformTypes.h"
-#endif // PLATFORM_WINDOWS
-
-#define UI UI_ST
-THIRD_PARTY_INCLUDES_START
-#	include <httplib.h>
-THIRD_PARTY_INCLUDES_END
-#undef UI
-
-#if PLATFORM_WINDOWS
-#	include "Windows/HideWindowsPlatformTypes.h"
-#endif // PLATFORM_WINDOWS
+#include "BlueprintHttpLib.h"
 
 #include <mutex>
 #include <condition_variable>
 
 #include "Async/Async.h"
+#include "HAL/PlatformFileManager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Misc/Paths.h"
 
 #include "BlueprintHttpServerModule.h"
+#include "BlueprintHttpRequestSnapshot.h"
+#include "BlueprintHttpTimerWheel.h"
+#include "BlueprintHttpGameThreadDispatcher.h"
+#include "BlueprintHttpTaskQueue.h"
+#include "BlueprintHttpRouter.h"
+#include "BlueprintHttpEpollServer.h"
+#include "BlueprintHttpsServer.h"
+#include "BlueprintHttpMetrics.h"
+#include "BlueprintHttpAssetCache.h"
+#include "BlueprintHttpWebSocket.h"
+#include "BlueprintHttpEventStream.h"
+#include "BlueprintHttpRateLimiter.h"
+#include "BlueprintHttpMultipart.h"
 
 #define LAMBDA_MOVE(x) x = MoveTemp(x)
 
@@ -31,6 +35,7 @@ THIRD_PARTY_INCLUDES_END
 	});
 
 typedef httplib::Server& (httplib::Server::*FRouteSetupListener)(const char*, std::function<void(const httplib::Request&, httplib::Response&)>);
+typedef httplib::Server& (httplib::Server::*FUploadSetupListener)(const char*, httplib::Server::HandlerWithContentReader);
 
 template<class T>
 class FBlueprintHttpRequestInternal final
@@ -38,7 +43,6 @@ class FBlueprintHttpRequestInternal final
 private:
 	using FInternalType				= T;
 	using FConditionVariable		= std::condition_variable;
-	using FExecuteLockedFunction	= TUniqueFunction<void(FInternalType&)>;
 
 public:
 	FBlueprintHttpRequestInternal(T* const Request)
@@ -54,9 +58,12 @@ public:
 
 	void Invalidate()
 	{
+		TUniqueFunction<void()> Completion;
+
 		{
 			FScopeLock Lock(&Mutex);
-			Internal = nullptr;
+			Internal   = nullptr;
+			Completion = MoveTemp(OnInvalidated);
 		}
 		
 		if (Waiter)
@@ -64,9 +71,15 @@ public:
 			Waiter->notify_all();
 			Waiter = nullptr;
 		}
+
+		if (Completion)
+		{
+			Completion();
+		}
 	}
 
-	void ExecuteLocked(FExecuteLockedFunction Function)
+	template<typename FunctorType>
+	void ExecuteLocked(FunctorType&& Function)
 	{
 		FScopeLock Lock(&Mutex);
 
@@ -81,10 +94,145 @@ public:
 		Waiter = InWaiter;
 	}
 
+	/**
+	 * Sets a function called once, after the first call to Invalidate().
+	*/
+	void SetupCompletion(TUniqueFunction<void()> InCompletion)
+	{
+		FScopeLock Lock(&Mutex);
+		OnInvalidated = MoveTemp(InCompletion);
+	}
+
+private:
+	FCriticalSection		Mutex;
+	FInternalType*			Internal;
+	FConditionVariable*		Waiter;
+	TUniqueFunction<void()> OnInvalidated;
+};
+
+namespace BlueprintHttpMultipartUpload
+{
+	// Regular fields are kept in memory.
+	static constexpr size_t MaxFieldSize = 64 * 1024;
+	static constexpr int32	MaxParts	 = 256;
+}
+
+/**
+ * Dispatches the parts of a multipart upload to their sinks as they are parsed.
+*/
+class FMultipartUploadListener final : public FBlueprintHttpMultipartParser::IListener
+{
+public:
+	FMultipartUploadListener(const FHttpServerMultipartSinkFactory& InSinkFactory, const FBlueprintHttpRequest& InRequest)
+		: SinkFactory(InSinkFactory)
+		, Request(InRequest)
+		, Status(0)
+	{}
+
+	virtual bool OnPartBegin(const FBlueprintHttpMultipartParser::FPart& InPart) override
+	{
+		if (Parts.Num() >= BlueprintHttpMultipartUpload::MaxParts)
+		{
+			Status = 413;
+			return false;
+		}
+
+		FHttpServerMultipartPart& Part = Parts.AddDefaulted_GetRef();
+		Part.Name		 = UTF8_TO_TCHAR(InPart.Name.c_str());
+		Part.FileName	 = UTF8_TO_TCHAR(InPart.FileName.c_str());
+		Part.ContentType = UTF8_TO_TCHAR(InPart.ContentType.c_str());
+
+		if (!InPart.FileName.empty())
+		{
+			Part.Sink = SinkFactory.Execute(Request, Part);
+		}
+
+		Field.clear();
+
+		return true;
+	}
+
+	virtual bool OnPartData(const char* const Data, const size_t Size) override
+	{
+		FHttpServerMultipartPart& Part = Parts.Last();
+		Part.Size += Size;
+
+		if (Part.Sink)
+		{
+			if (!Part.Sink->Write(reinterpret_cast<const uint8*>(Data), static_cast<int64>(Size)))
+			{
+				Status = 500;
+				return false;
+			}
+		}
+		// Skipped files are dropped.
+		else if (Part.FileName.IsEmpty())
+		{
+			if (Field.size() + Size > BlueprintHttpMultipartUpload::MaxFieldSize)
+			{
+				Status = 413;
+				return false;
+			}
+
+			Field.append(Data, Size);
+		}
+
+		return true;
+	}
+
+	virtual bool OnPartEnd() override
+	{
+		FHttpServerMultipartPart& Part = Parts.Last();
+
+		if (!Part.Sink && Part.FileName.IsEmpty())
+		{
+			const FUTF8ToTCHAR Converted(Field.data(), static_cast<int32>(Field.size()));
+			Part.Value = FString(Converted.Length(), Converted.Get());
+		}
+
+		return true;
+	}
+
+	/**
+	 * Finishes the sinks once the whole body was received,
+	 * sinks of failed uploads are released unfinished.
+	 * If one fails, the ones already finished are discarded.
+	*/
+	bool Finish()
+	{
+		for (int32 Index = 0; Index < Parts.Num(); ++Index)
+		{
+			if (Parts[Index].Sink && !Parts[Index].Sink->Finish())
+			{
+				for (int32 Finished = 0; Finished < Index; ++Finished)
+				{
+					if (Parts[Finished].Sink)
+					{
+						Parts[Finished].Sink->Discard();
+					}
+				}
+
+				Status = 500;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+public:
+	const FHttpServerMultipartSinkFactory& SinkFactory;
+	const FBlueprintHttpRequest& Request;
+
+	TArray<FHttpServerMultipartPart> Parts;
+
+	/**
+	 * The status to answer with, set when a part is refused.
+	*/
+	int32 Status;
+
 private:
-	FCriticalSection	Mutex;
-	FInternalType*		Internal;
-	FConditionVariable* Waiter;
+	std::string Field;
 };
 
 class FRouteListener
@@ -92,10 +240,12 @@ class FRouteListener
 private:
 	FRouteListener() = delete;
 public:
-	static void SetupRouteListener(httplib::Server& Server, FRouteSetupListener Listener, const FString& Path, 
-		FHttpServerRouteCallback& Callback, const bool bRequireGameThread, const long long MillisecondsToWait)
+	static httplib::Server::Handler MakeRouteHandler(FHttpServerRouteCallback& Callback, const bool bRequireGameThread, 
+		const long long MillisecondsToWait, const bool bSnapshotRequest, const TSharedPtr<FBlueprintHttpTimerWheel, ESPMode::ThreadSafe>& DeferredDeadlines,
+		const TSharedPtr<FBlueprintHttpMetrics, ESPMode::ThreadSafe>& Metrics, const int32 RouteIndex,
+		const TSharedRef<FBlueprintHttpRateLimiter, ESPMode::ThreadSafe>& RateLimiter)
 	{
-		(Server.*Listener) (TCHAR_TO_UTF8(*Path), [LAMBDA_MOVE(Callback), bRequireGameThread, MillisecondsToWait]
+		return [LAMBDA_MOVE(Callback), bRequireGameThread, MillisecondsToWait, bSnapshotRequest, DeferredDeadlines, Metrics, RouteIndex, RateLimiter]
 	
 		(const httplib::Request& Req, httplib::Response& Res) -> void
 		{
@@ -104,63 +254,321 @@ public:
 				return;
 			}
 
-			FBlueprintHttpRequest  Request (&Req);
-			FBlueprintHttpResponse Response(&Res);
+			// Fails fast, before anything is queued for a worker or the game thread.
+			if (!RateLimiter->BeginRequest(Res))
+			{
+				return;
+			}
+
+			ServeAdmitted(Req, Res, Callback, bRequireGameThread, MillisecondsToWait, bSnapshotRequest, DeferredDeadlines, Metrics, RouteIndex, RateLimiter);
+		};
+	}
+
+	static httplib::Server::HandlerWithContentReader MakeUploadHandler(FHttpServerUploadSinkFactory& SinkFactory, FHttpServerUploadCallback& Callback, const bool bRequireGameThread,
+		const long long MillisecondsToWait, const bool bSnapshotRequest, const TSharedPtr<FBlueprintHttpTimerWheel, ESPMode::ThreadSafe>& DeferredDeadlines,
+		const TSharedPtr<FBlueprintHttpMetrics, ESPMode::ThreadSafe>& Metrics, const int32 RouteIndex,
+		const TSharedRef<FBlueprintHttpRateLimiter, ESPMode::ThreadSafe>& RateLimiter)
+	{
+		return [LAMBDA_MOVE(SinkFactory), LAMBDA_MOVE(Callback), bRequireGameThread, MillisecondsToWait, bSnapshotRequest, DeferredDeadlines, Metrics, RouteIndex, RateLimiter]
 
-			const auto DispatchCallback = [&]() -> void
+		(const httplib::Request& Req, httplib::Response& Res, const httplib::ContentReader& ContentReader) -> void
+		{
+			if (!SinkFactory.IsBound() || !Callback.IsBound())
 			{
-				if (bRequireGameThread)
-				{
-					AsyncTask(ENamedThreads::GameThread, [Callback, Request, Response]() mutable -> void
-					{
-						Callback.ExecuteIfBound(Request, Response);
-					});
-				}
-				else
+				return;
+			}
+
+			// Reserved before the body is streamed to the sink, a refused upload is never written.
+			// The body is left unread, httplib closes the connection.
+			if (!RateLimiter->BeginRequest(Res))
+			{
+				return;
+			}
+
+			FHttpServerUploadSinkPtr Sink;
+
+			{
+				FBlueprintHttpRequest Request(&Req);
+				Sink = SinkFactory.Execute(Request);
+				Request.Internal->Invalidate();
+			}
+
+			// The body is left unread, httplib closes the connection.
+			if (!Sink)
+			{
+				Res.status = 500;
+				RateLimiter->EndRequest();
+				return;
+			}
+
+			bool bSinkFailed = false;
+
+			const bool bReceived = ContentReader([&Sink, &bSinkFailed](const char* const Data, const size_t Size) -> bool
+			{
+				bSinkFailed = !Sink->Write(reinterpret_cast<const uint8*>(Data), static_cast<int64>(Size));
+				return !bSinkFailed;
+			});
+
+			if (!bReceived || !Sink->Finish())
+			{
+				// Otherwise httplib set the status of the failed read.
+				if (bReceived || bSinkFailed)
 				{
-					Callback.ExecuteIfBound(Request, Response);
+					Res.status = 500;
 				}
-			};
 
-			// We don't wait, no need for condition_variable or mutex.
-			if (FMath::IsNearlyEqual(MillisecondsToWait, 0.f))
+				UE_LOG(LogHttpServer, Warning, TEXT("Upload to %s failed with status %d."), UTF8_TO_TCHAR(Req.path.c_str()), Res.status);
+				RateLimiter->EndRequest();
+				return;
+			}
+
+			// The sink only exists for this request, the callback gets it through a route callback of its own.
+			FHttpServerRouteCallback RouteCallback = FHttpServerRouteCallback::CreateLambda([Callback, Sink](const FBlueprintHttpRequest& Request, FBlueprintHttpResponse& Response) -> void
+			{
+				Callback.ExecuteIfBound(Request, Sink, Response);
+			});
+
+			ServeAdmitted(Req, Res, RouteCallback, bRequireGameThread, MillisecondsToWait, bSnapshotRequest, DeferredDeadlines, Metrics, RouteIndex, RateLimiter);
+		};
+	}
+
+	static httplib::Server::HandlerWithContentReader MakeMultipartHandler(FHttpServerMultipartSinkFactory& SinkFactory, FHttpServerMultipartCallback& Callback, const bool bRequireGameThread,
+		const long long MillisecondsToWait, const bool bSnapshotRequest, const TSharedPtr<FBlueprintHttpTimerWheel, ESPMode::ThreadSafe>& DeferredDeadlines,
+		const TSharedPtr<FBlueprintHttpMetrics, ESPMode::ThreadSafe>& Metrics, const int32 RouteIndex,
+		const TSharedRef<FBlueprintHttpRateLimiter, ESPMode::ThreadSafe>& RateLimiter)
+	{
+		return [LAMBDA_MOVE(SinkFactory), LAMBDA_MOVE(Callback), bRequireGameThread, MillisecondsToWait, bSnapshotRequest, DeferredDeadlines, Metrics, RouteIndex, RateLimiter]
+
+		(const httplib::Request& Req, httplib::Response& Res, const httplib::ContentReader& ContentReader) -> void
+		{
+			if (!SinkFactory.IsBound() || !Callback.IsBound())
+			{
+				return;
+			}
+
+			// Reserved before any part is written, a refused upload leaves no file behind.
+			if (!RateLimiter->BeginRequest(Res))
+			{
+				return;
+			}
+
+			// The body is left unread, httplib closes the connection.
+			std::string Boundary;
+			if (!FBlueprintHttpMultipartParser::ParseBoundary(Req.get_header_value("Content-Type"), Boundary))
 			{
-				DispatchCallback();
+				Res.status = 415;
+				RateLimiter->EndRequest();
+				return;
 			}
 
-			// We have to wait for completion
-			else
+			TArray<FHttpServerMultipartPart> Parts;
+
 			{
-				std::mutex				LocalMutex;
-				std::condition_variable LocalWaiter;
+				FBlueprintHttpRequest Request(&Req);
 
-				Response.Internal->SetupWaiter(&LocalWaiter);
+				FBlueprintHttpMultipartParser Parser(Boundary);
+				FMultipartUploadListener	  Listener(SinkFactory, Request);
 
-				DispatchCallback();
+				bool bMalformed = false;
 
-				// If the response is still valid, we have to wait for it.
-				// It basically means Send() hasn't been called and the user
-				// is still performing treatment on it.
-				if (Response.Internal->IsValid())
+				// Reads the body as is, httplib's own multipart parsing buffers every part.
+				const bool bReceived = ContentReader([&Parser, &Listener, &bMalformed](const char* const Data, const size_t Size) -> bool
 				{
-					std::unique_lock<std::mutex>	Lock(LocalMutex);
+					bMalformed = !Parser.Parse(Data, Size, Listener) && Listener.Status == 0;
+					return !bMalformed && Listener.Status == 0;
+				});
 
-					const auto WaitUntil = std::chrono::steady_clock().now() + std::chrono::milliseconds(MillisecondsToWait);
-					const std::cv_status Status = LocalWaiter.wait_until(Lock, WaitUntil);
+				Request.Internal->Invalidate();
 
-					if (Status == std::cv_status::timeout)
+				if (!bReceived || !Parser.IsComplete() || !Listener.Finish())
+				{
+					// Otherwise httplib set the status of the failed read.
+					if (Listener.Status != 0)
 					{
-						UE_LOG(LogHttpServer, Warning, TEXT("Reached timeout of %.3f seconds for HTTP Request."), MillisecondsToWait / 1000.f);
+						Res.status = Listener.Status;
 					}
+					else if (bMalformed || bReceived)
+					{
+						Res.status = 400;
+					}
+
+					UE_LOG(LogHttpServer, Warning, TEXT("Multipart upload to %s failed with status %d."), UTF8_TO_TCHAR(Req.path.c_str()), Res.status);
+					RateLimiter->EndRequest();
+					return;
+				}
+
+				Parts = MoveTemp(Listener.Parts);
+			}
+
+			FHttpServerRouteCallback RouteCallback = FHttpServerRouteCallback::CreateLambda([Callback, Parts = MoveTemp(Parts)](const FBlueprintHttpRequest& Request, FBlueprintHttpResponse& Response) -> void
+			{
+				Callback.ExecuteIfBound(Request, Parts, Response);
+			});
+
+			ServeAdmitted(Req, Res, RouteCallback, bRequireGameThread, MillisecondsToWait, bSnapshotRequest, DeferredDeadlines, Metrics, RouteIndex, RateLimiter);
+		};
+	}
+
+private:
+	/**
+	 * The in-flight slot of an admitted request, released with its last reference.
+	*/
+	struct FInFlightSlot
+	{
+		FInFlightSlot(const TSharedRef<FBlueprintHttpRateLimiter, ESPMode::ThreadSafe>& InRateLimiter)
+			: RateLimiter(InRateLimiter)
+		{}
+
+		~FInFlightSlot()
+		{
+			RateLimiter->EndRequest();
+		}
+
+		TSharedRef<FBlueprintHttpRateLimiter, ESPMode::ThreadSafe> RateLimiter;
+	};
+
+	using FInFlightSlotPtr = TSharedPtr<FInFlightSlot, ESPMode::ThreadSafe>;
+
+	/**
+	 * Serves a request admitted by RateLimiter->BeginRequest(), ends it once the response
+	 * is sent and, for game thread routes, once the queued callback ran.
+	*/
+	static void ServeAdmitted(const httplib::Request& Req, httplib::Response& Res, const FHttpServerRouteCallback& Callback, const bool bRequireGameThread,
+		const long long MillisecondsToWait, const bool bSnapshotRequest, const TSharedPtr<FBlueprintHttpTimerWheel, ESPMode::ThreadSafe>& DeferredDeadlines,
+		const TSharedPtr<FBlueprintHttpMetrics, ESPMode::ThreadSafe>& Metrics, const int32 RouteIndex,
+		const TSharedRef<FBlueprintHttpRateLimiter, ESPMode::ThreadSafe>& RateLimiter)
+	{
+		const FBlueprintHttpRequestTiming Timing = FBlueprintHttpMetrics::BeginRequest(Metrics, RouteIndex);
+
+		const FInFlightSlotPtr Slot = MakeShared<FInFlightSlot, ESPMode::ThreadSafe>(RateLimiter);
+
+		if (DeferredDeadlines && MillisecondsToWait > 0 && DispatchDeferred(Req, Res, Callback, bRequireGameThread, MillisecondsToWait, *DeferredDeadlines, Timing, Slot))
+		{
+			return;
+		}
+
+		FBlueprintHttpRequest  Request = bSnapshotRequest 
+			? FBlueprintHttpRequest(FBlueprintHttpRequestSnapshot::Create(Req))
+			: FBlueprintHttpRequest(&Req);
+		FBlueprintHttpResponse Response(&Res);
+
+		// We don't wait, no need for condition_variable or mutex.
+		if (FMath::IsNearlyEqual(MillisecondsToWait, 0.f))
+		{
+			DispatchCallback(Callback, Request, Response, bRequireGameThread, Timing, Slot);
+		}
+
+		// We have to wait for completion
+		else
+		{
+			std::mutex				LocalMutex;
+			std::condition_variable LocalWaiter;
+
+			Response.Internal->SetupWaiter(&LocalWaiter);
+
+			DispatchCallback(Callback, Request, Response, bRequireGameThread, Timing, Slot);
+
+			// If the response is still valid, we have to wait for it.
+			// It basically means Send() hasn't been called and the user
+			// is still performing treatment on it.
+			if (Response.Internal->IsValid())
+			{
+				std::unique_lock<std::mutex>	Lock(LocalMutex);
+
+				const auto WaitUntil = std::chrono::steady_clock().now() + std::chrono::milliseconds(MillisecondsToWait);
+				const std::cv_status Status = LocalWaiter.wait_until(Lock, WaitUntil);
+
+				if (Status == std::cv_status::timeout)
+				{
+					UE_LOG(LogHttpServer, Warning, TEXT("Reached timeout of %.3f seconds for HTTP Request."), MillisecondsToWait / 1000.f);
 				}
 			}
+		}
+
+		Response.Internal->Invalidate();
+
+		// Snapshots don't reference the httplib request.
+		if (Request.Internal)
+		{
+			Request.Internal->Invalidate();
+		}
+
+		Timing.End();
+	}
+
+	/**
+	 * Runs the callback, or queues it for the game thread. A queued callback keeps
+	 * the request's slot until it ran, even if the response timed out meanwhile.
+	*/
+	static void DispatchCallback(const FHttpServerRouteCallback& Callback, const FBlueprintHttpRequest& Request, FBlueprintHttpResponse& Response, 
+		const bool bRequireGameThread, const FBlueprintHttpRequestTiming& Timing, const FInFlightSlotPtr& Slot)
+	{
+		if (bRequireGameThread)
+		{
+			FBlueprintHttpGameThreadDispatcher::Get().Enqueue([Callback, Request, Response, Timing, Slot, EnqueueCycles = FPlatformTime::Cycles64()]() mutable -> void
+			{
+				Timing.RecordGameThreadWait(EnqueueCycles);
+				Callback.ExecuteIfBound(Request, Response);
+				Slot.Reset();
+			});
+		}
+		else
+		{
+			Callback.ExecuteIfBound(Request, Response);
+		}
+	}
+
+	/**
+	 * Releases the worker thread: the response is written when Send() is called
+	 * or when the deadline expires.
+	 * @return False if the connection can't be deferred (SSL), the caller must wait instead.
+	*/
+	static bool DispatchDeferred(const httplib::Request& Req, httplib::Response& Res, const FHttpServerRouteCallback& Callback, 
+		const bool bRequireGameThread, const long long MillisecondsToWait, FBlueprintHttpTimerWheel& Deadlines, const FBlueprintHttpRequestTiming& Timing,
+		const FInFlightSlotPtr& Slot)
+	{
+		std::function<void(httplib::Response&)> Sender = Res.defer();
+		if (!Sender)
+		{
+			return false;
+		}
+
+		// The httplib request and response don't outlive this handler,
+		// the callback gets a snapshot and writes into a response we own.
+		TSharedRef<httplib::Response, ESPMode::ThreadSafe> DeferredResponse = MakeShared<httplib::Response, ESPMode::ThreadSafe>();
+
+		FBlueprintHttpRequest  Request(FBlueprintHttpRequestSnapshot::Create(Req));
+		FBlueprintHttpResponse Response(&DeferredResponse.Get());
+
+		Response.Internal->SetupCompletion([DeferredResponse, Sender = MoveTemp(Sender), Timing, Slot]() -> void
+		{
+			Sender(*DeferredResponse);
+			Timing.End();
+		});
 
-			Response.Internal->Invalidate();
-			Request .Internal->Invalidate();
+		// Keeps the response alive until the deadline so it is sent
+		// even if the callback dropped it without calling Send().
+		Deadlines.Schedule(MillisecondsToWait, [Internal = Response.Internal, MillisecondsToWait]() -> void
+		{
+			if (Internal->IsValid())
+			{
+				UE_LOG(LogHttpServer, Warning, TEXT("Reached timeout of %.3f seconds for HTTP Request."), MillisecondsToWait / 1000.f);
+				Internal->Invalidate();
+			}
 		});
+
+		DispatchCallback(Callback, Request, Response, bRequireGameThread, Timing, Slot);
+
+		return true;
 	}
 };
 
+namespace BlueprintHttpResponse
+{
+	// Files sent from routes are read by blocks of this size.
+	static constexpr size_t FileBlockSize = 64 * 1024;
+}
+
 void FBlueprintHttpResponse::SetBody(const FString& Body)
 {
 	START_INTERNAL_SYNCHRONIZED(httplib::Response & Response);
@@ -188,6 +596,59 @@ void FBlueprintHttpResponse::SetContent(const TArray<uint8>& Content, const FStr
 	END_INTERNAL_SYNCHRONIZED();
 }
 
+bool FBlueprintHttpResponse::SetContentFromFile(const FString& FilePath, const FString& MimeType)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	TSharedPtr<IFileHandle, ESPMode::ThreadSafe> File(PlatformFile.OpenRead(*FilePath));
+
+	if (!File)
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("Failed to open %s to send it."), *FilePath);
+		return false;
+	}
+
+	const size_t Size			  = static_cast<size_t>(File->Size());
+	const time_t ModificationTime = static_cast<time_t>(PlatformFile.GetTimeStamp(*FilePath).ToUnixTimestamp());
+
+	bool bValid = false;
+
+	START_INTERNAL_SYNCHRONIZED(httplib::Response & Response);
+
+	Response.set_header("ETag", httplib::detail::make_file_etag(Size, ModificationTime));
+	Response.set_header("Last-Modified", httplib::detail::format_http_date(ModificationTime));
+
+	if (Size == 0)
+	{
+		Response.set_content("", 0, TCHAR_TO_UTF8(*MimeType));
+	}
+	else
+	{
+		// Reads a block per call, the provider is called again from where the block ended.
+		Response.set_content_provider(Size, TCHAR_TO_UTF8(*MimeType),
+			[File, Buffer = MakeShared<TArray<uint8>, ESPMode::ThreadSafe>()](size_t Offset, size_t Length, httplib::DataSink& Sink) -> bool
+		{
+			const int64 BlockSize = static_cast<int64>(FMath::Min<size_t>(Length, BlueprintHttpResponse::FileBlockSize));
+
+			Buffer->SetNumUninitialized(BlockSize, false);
+
+			if (!File->Seek(static_cast<int64>(Offset)) || !File->Read(Buffer->GetData(), BlockSize))
+			{
+				return false;
+			}
+
+			Sink.write(reinterpret_cast<const char*>(Buffer->GetData()), static_cast<size_t>(BlockSize));
+			return true;
+		});
+	}
+
+	bValid = true;
+
+	END_INTERNAL_SYNCHRONIZED();
+
+	return bValid;
+}
+
 void FBlueprintHttpResponse::AppendToBody(const FString& Body)
 {
 	START_INTERNAL_SYNCHRONIZED(httplib::Response & Response);
@@ -274,6 +735,12 @@ void FBlueprintHttpResponse::SetReason(const FString& Reason)
 
 bool FBlueprintHttpRequest::HasHeader(const FString& HeaderKey) const
 {
+	if (Snapshot)
+	{
+		const FTCHARToUTF8 Key(*HeaderKey);
+		return Snapshot->FindHeader(Key.Get(), Key.Length()) != nullptr;
+	}
+
 	bool ReturnValue = false;
 
 	START_INTERNAL_SYNCHRONIZED(const httplib::Request & Request);
@@ -287,11 +754,19 @@ bool FBlueprintHttpRequest::HasHeader(const FString& HeaderKey) const
 
 FString FBlueprintHttpRequest::GetHeader(const FString& HeaderKey) const
 {
+	if (Snapshot)
+	{
+		const FTCHARToUTF8 Key(*HeaderKey);
+		const FBlueprintHttpRequestSnapshot::FEntry* const Header = Snapshot->FindHeader(Key.Get(), Key.Length());
+		return Header ? Snapshot->ToString(Header->Value) : FString();
+	}
+
 	FString ReturnValue;
 
 	START_INTERNAL_SYNCHRONIZED(const httplib::Request & Request);
 
-	ReturnValue = UTF8_TO_TCHAR(Request.get_header_value(TCHAR_TO_UTF8(*HeaderKey)).c_str());
+	const std::string_view Value = Request.get_header_value_view(TCHAR_TO_UTF8(*HeaderKey));
+	ReturnValue = FString(FUTF8ToTCHAR(Value.data(), static_cast<int32>(Value.size())));
 
 	END_INTERNAL_SYNCHRONIZED();
 
@@ -302,13 +777,24 @@ TMap<FString, FString> FBlueprintHttpRequest::GetHeaders() const
 {
 	TMap<FString, FString> ReturnValue;
 
+	if (Snapshot)
+	{
+		ReturnValue.Reserve(Snapshot->GetHeaders().Num());
+		for (const FBlueprintHttpRequestSnapshot::FEntry& Header : Snapshot->GetHeaders())
+		{
+			ReturnValue.Emplace(Snapshot->ToString(Header.Key), Snapshot->ToString(Header.Value));
+		}
+		return ReturnValue;
+	}
+
 	START_INTERNAL_SYNCHRONIZED(const httplib::Request & Request);
 
-	ReturnValue.Reserve(Request.headers.size());
-	for (const auto& Header : Request.headers)
+	Request.for_each_header([&ReturnValue](const std::string_view Key, const std::string_view Value)
 	{
-		ReturnValue.Emplace(UTF8_TO_TCHAR(Header.first.c_str()), UTF8_TO_TCHAR(Header.second.c_str()));
-	}
+		ReturnValue.Emplace(
+			FString(FUTF8ToTCHAR(Key  .data(), static_cast<int32>(Key  .size()))),
+			FString(FUTF8ToTCHAR(Value.data(), static_cast<int32>(Value.size()))));
+	});
 
 	END_INTERNAL_SYNCHRONIZED();
 
@@ -317,35 +803,156 @@ TMap<FString, FString> FBlueprintHttpRequest::GetHeaders() const
 
 FString FBlueprintHttpRequest::GetBody() const
 {
+	if (Snapshot)
+	{
+		const TArray<uint8>& Body = Snapshot->GetBody();
+		const FUTF8ToTCHAR Converted((const ANSICHAR*)Body.GetData(), Body.Num());
+		return FString(Converted.Length(), Converted.Get());
+	}
+
 	FString ReturnValue;
 
 	START_INTERNAL_SYNCHRONIZED(const httplib::Request & Request);
 
-	ReturnValue = UTF8_TO_TCHAR(Request.body.c_str());
+	// Convert with the length so bodies containing NUL aren't truncated.
+	const FUTF8ToTCHAR Converted(Request.body.data(), static_cast<int32>(Request.body.size()));
+	ReturnValue = FString(Converted.Length(), Converted.Get());
 
 	END_INTERNAL_SYNCHRONIZED();
 
 	return ReturnValue;
 }
 
-FString FBlueprintHttpRequest::GetUrlParameter(const FString& Name) const
+TArray<uint8> FBlueprintHttpRequest::GetBodyBytes() const
 {
-	FString ReturnValue;
+	return TArray<uint8>(GetBodyView());
+}
+
+TArrayView<const uint8> FBlueprintHttpRequest::GetBodyView() const
+{
+	if (Snapshot)
+	{
+		return Snapshot->GetBody();
+	}
+
+	TArrayView<const uint8> ReturnValue;
 
 	START_INTERNAL_SYNCHRONIZED(const httplib::Request & Request);
 
-	ReturnValue = UTF8_TO_TCHAR(Request.get_param_value(TCHAR_TO_UTF8(*Name)).c_str());
+	// The body isn't modified once parsed, the view stays valid until Invalidate().
+	ReturnValue = TArrayView<const uint8>(reinterpret_cast<const uint8*>(Request.body.data()), static_cast<int32>(Request.body.size()));
 
 	END_INTERNAL_SYNCHRONIZED();
 
 	return ReturnValue;
 }
 
-bool FBlueprintHttpRequest::HasUrlParameter(const FString& Name) const
+FUtf8StringView FBlueprintHttpRequest::GetBodyUtf8() const
 {
-	bool bReturnValue = false;
+	const TArrayView<const uint8> Body = GetBodyView();
 
-	START_INTERNAL_SYNCHRONIZED(const httplib::Request & Request);
+	return FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Body.GetData()), Body.Num());
+}
+
+FUtf8StringView FBlueprintHttpRequest::GetHeaderUtf8(const FUtf8StringView HeaderKey) const
+{
+	if (Snapshot)
+	{
+		const FBlueprintHttpRequestSnapshot::FEntry* const Header = Snapshot->FindHeader(reinterpret_cast<const ANSICHAR*>(HeaderKey.GetData()), HeaderKey.Len());
+		return Header ? FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Snapshot->GetData(Header->Value)), Header->Value.Length) : FUtf8StringView();
+	}
+
+	FUtf8StringView ReturnValue;
+
+	START_INTERNAL_SYNCHRONIZED(const httplib::Request & Request);
+
+	// The accessors take a NUL terminated key.
+	const std::string Key(reinterpret_cast<const char*>(HeaderKey.GetData()), HeaderKey.Len());
+	const std::string_view Value = Request.get_header_value_view(Key.c_str());
+	ReturnValue = FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Value.data()), static_cast<int32>(Value.size()));
+
+	END_INTERNAL_SYNCHRONIZED();
+
+	return ReturnValue;
+}
+
+FUtf8StringView FBlueprintHttpRequest::GetPathParameterUtf8(const FUtf8StringView Name) const
+{
+	if (Snapshot)
+	{
+		const FBlueprintHttpRequestSnapshot::FEntry* const Param = Snapshot->FindPathParam(reinterpret_cast<const ANSICHAR*>(Name.GetData()), Name.Len());
+		return Param ? FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Snapshot->GetData(Param->Value)), Param->Value.Length) : FUtf8StringView();
+	}
+
+	FUtf8StringView ReturnValue;
+
+	START_INTERNAL_SYNCHRONIZED(const httplib::Request & Request);
+
+	const auto Param = Request.path_params.find(std::string(reinterpret_cast<const char*>(Name.GetData()), Name.Len()));
+	if (Param != Request.path_params.end())
+	{
+		ReturnValue = FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Param->second.data()), static_cast<int32>(Param->second.size()));
+	}
+
+	END_INTERNAL_SYNCHRONIZED();
+
+	return ReturnValue;
+}
+
+FUtf8StringView FBlueprintHttpRequest::GetUrlParameterUtf8(const FUtf8StringView Name) const
+{
+	if (Snapshot)
+	{
+		const FBlueprintHttpRequestSnapshot::FEntry* const Param = Snapshot->FindParam(reinterpret_cast<const ANSICHAR*>(Name.GetData()), Name.Len());
+		return Param ? FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Snapshot->GetData(Param->Value)), Param->Value.Length) : FUtf8StringView();
+	}
+
+	FUtf8StringView ReturnValue;
+
+	START_INTERNAL_SYNCHRONIZED(const httplib::Request & Request);
+
+	const auto Param = Request.params.find(std::string(reinterpret_cast<const char*>(Name.GetData()), Name.Len()));
+	if (Param != Request.params.end())
+	{
+		ReturnValue = FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Param->second.data()), static_cast<int32>(Param->second.size()));
+	}
+
+	END_INTERNAL_SYNCHRONIZED();
+
+	return ReturnValue;
+}
+
+FString FBlueprintHttpRequest::GetUrlParameter(const FString& Name) const
+{
+	if (Snapshot)
+	{
+		const FTCHARToUTF8 Key(*Name);
+		const FBlueprintHttpRequestSnapshot::FEntry* const Param = Snapshot->FindParam(Key.Get(), Key.Length());
+		return Param ? Snapshot->ToString(Param->Value) : FString();
+	}
+
+	FString ReturnValue;
+
+	START_INTERNAL_SYNCHRONIZED(const httplib::Request & Request);
+
+	ReturnValue = UTF8_TO_TCHAR(Request.get_param_value(TCHAR_TO_UTF8(*Name)).c_str());
+
+	END_INTERNAL_SYNCHRONIZED();
+
+	return ReturnValue;
+}
+
+bool FBlueprintHttpRequest::HasUrlParameter(const FString& Name) const
+{
+	if (Snapshot)
+	{
+		const FTCHARToUTF8 Key(*Name);
+		return Snapshot->FindParam(Key.Get(), Key.Length()) != nullptr;
+	}
+
+	bool bReturnValue = false;
+
+	START_INTERNAL_SYNCHRONIZED(const httplib::Request & Request);
 
 	bReturnValue = Request.has_param(TCHAR_TO_UTF8(*Name));
 
@@ -354,8 +961,57 @@ bool FBlueprintHttpRequest::HasUrlParameter(const FString& Name) const
 	return bReturnValue;
 }
 
+bool FBlueprintHttpRequest::HasPathParameter(const FString& Name) const
+{
+	if (Snapshot)
+	{
+		const FTCHARToUTF8 Key(*Name);
+		return Snapshot->FindPathParam(Key.Get(), Key.Length()) != nullptr;
+	}
+
+	bool bReturnValue = false;
+
+	START_INTERNAL_SYNCHRONIZED(const httplib::Request & Request);
+
+	bReturnValue = Request.path_params.find(TCHAR_TO_UTF8(*Name)) != Request.path_params.end();
+
+	END_INTERNAL_SYNCHRONIZED();
+
+	return bReturnValue;
+}
+
+FString FBlueprintHttpRequest::GetPathParameter(const FString& Name) const
+{
+	if (Snapshot)
+	{
+		const FTCHARToUTF8 Key(*Name);
+		const FBlueprintHttpRequestSnapshot::FEntry* const Param = Snapshot->FindPathParam(Key.Get(), Key.Length());
+		return Param ? Snapshot->ToString(Param->Value) : FString();
+	}
+
+	FString ReturnValue;
+
+	START_INTERNAL_SYNCHRONIZED(const httplib::Request & Request);
+
+	const auto Param = Request.path_params.find(TCHAR_TO_UTF8(*Name));
+	if (Param != Request.path_params.end())
+	{
+		const FUTF8ToTCHAR Converted(Param->second.data(), static_cast<int32>(Param->second.size()));
+		ReturnValue = FString(Converted.Length(), Converted.Get());
+	}
+
+	END_INTERNAL_SYNCHRONIZED();
+
+	return ReturnValue;
+}
+
 FString FBlueprintHttpRequest::GetRemoteAddress() const
 {
+	if (Snapshot)
+	{
+		return Snapshot->ToString(Snapshot->GetRemoteAddress());
+	}
+
 	FString ReturnValue;
 
 	START_INTERNAL_SYNCHRONIZED(const httplib::Request & Request);
@@ -369,6 +1025,11 @@ FString FBlueprintHttpRequest::GetRemoteAddress() const
 
 int32 FBlueprintHttpRequest::GetRemotePort() const
 {
+	if (Snapshot)
+	{
+		return Snapshot->GetRemotePort();
+	}
+
 	int32 ReturnValue = -1;
 
 	START_INTERNAL_SYNCHRONIZED(const httplib::Request & Request);
@@ -382,6 +1043,11 @@ int32 FBlueprintHttpRequest::GetRemotePort() const
 
 FString FBlueprintHttpRequest::GetVerb() const
 {
+	if (Snapshot)
+	{
+		return Snapshot->ToString(Snapshot->GetMethod());
+	}
+
 	FString ReturnValue;
 
 	START_INTERNAL_SYNCHRONIZED(const httplib::Request & Request);
@@ -393,6 +1059,11 @@ FString FBlueprintHttpRequest::GetVerb() const
 	return ReturnValue;
 }
 
+bool FBlueprintHttpRequest::IsSnapshot() const
+{
+	return Snapshot.IsValid();
+}
+
 void FBlueprintHttpResponse::Send()
 {
 	Internal->Invalidate();
@@ -413,6 +1084,11 @@ FBlueprintHttpRequest::FBlueprintHttpRequest(const httplib::Request* const	Inter
 {	
 }
 
+FBlueprintHttpRequest::FBlueprintHttpRequest(TSharedRef<const FBlueprintHttpRequestSnapshot, ESPMode::ThreadSafe> InSnapshot)
+	: Snapshot(MoveTemp(InSnapshot))
+{
+}
+
 FBlueprintHttpResponse::FBlueprintHttpResponse(FBlueprintHttpResponse&& Other)
 	: Internal(MoveTemp(Other.Internal))
 {
@@ -420,11 +1096,13 @@ FBlueprintHttpResponse::FBlueprintHttpResponse(FBlueprintHttpResponse&& Other)
 
 FBlueprintHttpRequest::FBlueprintHttpRequest(const FBlueprintHttpRequest& Other)
 	: Internal(Other.Internal)
+	, Snapshot(Other.Snapshot)
 {
 }
 
 FBlueprintHttpRequest::FBlueprintHttpRequest(FBlueprintHttpRequest&& Other)
 	: Internal(MoveTemp(Other.Internal))
+	, Snapshot(MoveTemp(Other.Snapshot))
 {
 }
 
@@ -436,12 +1114,14 @@ FBlueprintHttpResponse::FBlueprintHttpResponse(const FBlueprintHttpResponse& Oth
 FBlueprintHttpRequest& FBlueprintHttpRequest::operator=(const FBlueprintHttpRequest& Other)
 {
 	Internal = Other.Internal;
+	Snapshot = Other.Snapshot;
 	return *this;
 }
 
 FBlueprintHttpRequest& FBlueprintHttpRequest::operator=(FBlueprintHttpRequest&& Other)
 {
 	Internal = MoveTemp(Other.Internal);
+	Snapshot = MoveTemp(Other.Snapshot);
 	return *this;
 }
 
@@ -471,9 +1151,31 @@ UBlueprintHttpServer::UBlueprintHttpServer()
 	: Super()
 	, Server(MakeShared<httplib::Server, ESPMode::ThreadSafe>())
 	, MaxSecondWaitTimeout(5.f)
+	, bUseRequestSnapshots(false)
+	, bUseDeferredResponses(false)
+	, bUseRadixRouter(false)
+	, bUseEventLoop(false)
+	, EventLoopThreadCount(2)
+	, AcceptorCount(1)
+	, RateLimiter(MakeShared<FBlueprintHttpRateLimiter, ESPMode::ThreadSafe>())
 {
 }
 
+TSharedPtr<FBlueprintHttpTimerWheel, ESPMode::ThreadSafe> UBlueprintHttpServer::GetDeferredDeadlines()
+{
+	if (!bUseDeferredResponses)
+	{
+		return nullptr;
+	}
+
+	if (!DeferredDeadlines)
+	{
+		DeferredDeadlines = MakeShared<FBlueprintHttpTimerWheel, ESPMode::ThreadSafe>();
+	}
+
+	return DeferredDeadlines;
+}
+
 UBlueprintHttpServer::~UBlueprintHttpServer()
 {
 	if (Server->is_running())
@@ -495,6 +1197,25 @@ UBlueprintHttpServer* UBlueprintHttpServer::CreateHttpServer()
 
 void UBlueprintHttpServer::Stop()
 {
+#if PLATFORM_LINUX
+	if (EventLoop)
+	{
+		EventLoop->Stop();
+		EventLoop.Reset();
+	}
+#endif
+
+	if (WebSockets)
+	{
+		// Going away.
+		WebSockets->CloseAll(1001);
+	}
+
+	if (EventStreams)
+	{
+		EventStreams->DisconnectAll();
+	}
+
 	Server->stop();	
 
 	UE_LOG(LogHttpServer, Log, TEXT("BlueprintHttpServer stopped."));
@@ -507,54 +1228,232 @@ bool UBlueprintHttpServer::IsRunning() const
 
 UBlueprintHttpServer* UBlueprintHttpServer::Get(const FString& Path, FHttpServerRouteCallback Callback, const bool bRequireGameThread)
 {
-	UE_LOG(LogHttpServer, Log, TEXT("New route added: { GET, %s }."), *Path);
-	FRouteListener::SetupRouteListener(*Server, &httplib::Server::Get, Path, Callback, bRequireGameThread, MaxSecondWaitTimeout * 1000);
+	if (AddRouteListener(EHttpServerVerb::Get, Path, Callback, bRequireGameThread))
+	{
+		UE_LOG(LogHttpServer, Log, TEXT("New route added: { GET, %s }."), *Path);
+	}
 	return this;
 }
 
 UBlueprintHttpServer* UBlueprintHttpServer::Post(const FString& Path, FHttpServerRouteCallback Callback, const bool bRequireGameThread)
 {
-	UE_LOG(LogHttpServer, Log, TEXT("New route added: { POST, %s }."), *Path);
-	FRouteListener::SetupRouteListener(*Server, &httplib::Server::Post, Path, Callback, bRequireGameThread, GetMillisecondsTimeout(MaxSecondWaitTimeout));
+	if (AddRouteListener(EHttpServerVerb::Post, Path, Callback, bRequireGameThread))
+	{
+		UE_LOG(LogHttpServer, Log, TEXT("New route added: { POST, %s }."), *Path);
+	}
 	return this;
 }
 
 UBlueprintHttpServer* UBlueprintHttpServer::Patch(const FString& Path, FHttpServerRouteCallback Callback, const bool bRequireGameThread)
 {
-	UE_LOG(LogHttpServer, Log, TEXT("New route added: { PATCH, %s }."), *Path);
-	FRouteListener::SetupRouteListener(*Server, &httplib::Server::Patch, Path, Callback, bRequireGameThread, GetMillisecondsTimeout(MaxSecondWaitTimeout));
+	if (AddRouteListener(EHttpServerVerb::Patch, Path, Callback, bRequireGameThread))
+	{
+		UE_LOG(LogHttpServer, Log, TEXT("New route added: { PATCH, %s }."), *Path);
+	}
 	return this;
 }
 
 UBlueprintHttpServer* UBlueprintHttpServer::Delete(const FString& Path, FHttpServerRouteCallback Callback, const bool bRequireGameThread)
 {
-	UE_LOG(LogHttpServer, Log, TEXT("New route added: { DELETE, %s }."), *Path);
-	FRouteListener::SetupRouteListener(*Server, &httplib::Server::Delete, Path, Callback, bRequireGameThread, GetMillisecondsTimeout(MaxSecondWaitTimeout));
+	if (AddRouteListener(EHttpServerVerb::Delete, Path, Callback, bRequireGameThread))
+	{
+		UE_LOG(LogHttpServer, Log, TEXT("New route added: { DELETE, %s }."), *Path);
+	}
 	return this;
 }
 
 UBlueprintHttpServer* UBlueprintHttpServer::Options(const FString& Path, FHttpServerRouteCallback Callback, const bool bRequireGameThread)
 {
-	UE_LOG(LogHttpServer, Log, TEXT("New route added: { OPTIONS, %s }."), *Path);
-	FRouteListener::SetupRouteListener(*Server, &httplib::Server::Options, Path, Callback, bRequireGameThread, GetMillisecondsTimeout(MaxSecondWaitTimeout));
+	if (AddRouteListener(EHttpServerVerb::Options, Path, Callback, bRequireGameThread))
+	{
+		UE_LOG(LogHttpServer, Log, TEXT("New route added: { OPTIONS, %s }."), *Path);
+	}
 	return this;
 }
 
 UBlueprintHttpServer* UBlueprintHttpServer::Put(const FString& Path, FHttpServerRouteCallback Callback, const bool bRequireGameThread)
 {
-	UE_LOG(LogHttpServer, Log, TEXT("New route added: { PUT, %s }."), *Path);
-	FRouteListener::SetupRouteListener(*Server, &httplib::Server::Put, Path, Callback, bRequireGameThread, GetMillisecondsTimeout(MaxSecondWaitTimeout));
+	if (AddRouteListener(EHttpServerVerb::Put, Path, Callback, bRequireGameThread))
+	{
+		UE_LOG(LogHttpServer, Log, TEXT("New route added: { PUT, %s }."), *Path);
+	}
 	return this;
 }
 
-bool UBlueprintHttpServer::AddMountPoint(const FString& UrlPath, const FString& DiskPath, const TMap<FString, FString>& DefaultHeaders)
+bool UBlueprintHttpServer::AddRouteListener(const EHttpServerVerb Verb, const FString& Path, FHttpServerRouteCallback& Callback, const bool bRequireGameThread)
 {
-	if (IsRunning())
+	// Metrics only get a series for routes that are added.
+	const auto MakeHandler = [&]() -> httplib::Server::Handler
+	{
+		const int32 RouteIndex = Metrics ? Metrics->RegisterRoute(Verb, Path) : INDEX_NONE;
+
+		return FRouteListener::MakeRouteHandler(Callback, bRequireGameThread, 
+			GetMillisecondsTimeout(MaxSecondWaitTimeout), bUseRequestSnapshots, GetDeferredDeadlines(), Metrics, RouteIndex, RateLimiter);
+	};
+
+	// The dispatch handler isn't swapped atomically like the routes, it's only installed when stopped.
+	if (bUseRadixRouter && !Router && IsRunning())
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("The radix router can't be enabled when the server is running, %s added as a regex route."), *Path);
+	}
+	else if (bUseRadixRouter)
+	{
+		if (!Router)
+		{
+			Router = MakeShared<FBlueprintHttpRouter, ESPMode::ThreadSafe>();
+			Server->set_pre_dispatch_handler([Router = this->Router](httplib::Request& Request, httplib::Response& Response) -> httplib::Server::HandlerResponse
+			{
+				return Router->Dispatch(Request, Response) 
+					? httplib::Server::HandlerResponse::Handled 
+					: httplib::Server::HandlerResponse::Unhandled;
+			});
+		}
+
+		return Router->Add(Verb, Path, MakeHandler);
+	}
+
+	FRouteSetupListener Listener = nullptr;
+	switch (Verb)
+	{
+	case EHttpServerVerb::Get:		Listener = &httplib::Server::Get;		break;
+	case EHttpServerVerb::Post:		Listener = &httplib::Server::Post;		break;
+	case EHttpServerVerb::Delete:	Listener = &httplib::Server::Delete;	break;
+	case EHttpServerVerb::Options:	Listener = &httplib::Server::Options;	break;
+	case EHttpServerVerb::Patch:	Listener = &httplib::Server::Patch;		break;
+	case EHttpServerVerb::Put:		Listener = &httplib::Server::Put;		break;
+	default: checkNoEntry(); return false;
+	}
+
+	((*Server).*Listener)(TCHAR_TO_UTF8(*Path), MakeHandler());
+
+	return true;
+}
+
+UBlueprintHttpServer* UBlueprintHttpServer::AddUploadListener(const EHttpServerVerb Verb, const FString& Path, FHttpServerUploadSinkFactory SinkFactory, FHttpServerUploadCallback Callback, const bool bRequireGameThread)
+{
+	FUploadSetupListener Listener = nullptr;
+	switch (Verb)
+	{
+	case EHttpServerVerb::Post:		Listener = &httplib::Server::Post;		break;
+	case EHttpServerVerb::Put:		Listener = &httplib::Server::Put;		break;
+	case EHttpServerVerb::Patch:	Listener = &httplib::Server::Patch;		break;
+	case EHttpServerVerb::Delete:	Listener = &httplib::Server::Delete;	break;
+	default:
+		UE_LOG(LogHttpServer, Warning, TEXT("Uploads can only be added for POST, PUT, PATCH and DELETE, %s ignored."), *Path);
+		return this;
+	}
+
+	const int32 RouteIndex = Metrics ? Metrics->RegisterRoute(Verb, Path) : INDEX_NONE;
+
+	// Content readers are matched before the body is read, so before the radix router.
+	((*Server).*Listener)(TCHAR_TO_UTF8(*Path), FRouteListener::MakeUploadHandler(SinkFactory, Callback, bRequireGameThread,
+		GetMillisecondsTimeout(MaxSecondWaitTimeout), bUseRequestSnapshots, GetDeferredDeadlines(), Metrics, RouteIndex, RateLimiter));
+
+	UE_LOG(LogHttpServer, Log, TEXT("New upload route added: %s."), *Path);
+
+	return this;
+}
+
+UBlueprintHttpServer* UBlueprintHttpServer::AddFileUploadListener(const EHttpServerVerb Verb, const FString& Path, const FString& Directory, FHttpServerUploadCallback Callback, const bool bRequireGameThread)
+{
+	if (!FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*Directory))
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("Failed to create the upload directory %s."), *Directory);
+	}
+
+	FHttpServerUploadSinkFactory SinkFactory = FHttpServerUploadSinkFactory::CreateLambda([Directory](const FBlueprintHttpRequest&) -> FHttpServerUploadSinkPtr
+	{
+		return FHttpServerFileUploadSink::Create(FPaths::CreateTempFilename(*Directory, TEXT("Upload-"), TEXT(".bin")));
+	});
+
+	return AddUploadListener(Verb, Path, MoveTemp(SinkFactory), MoveTemp(Callback), bRequireGameThread);
+}
+
+UBlueprintHttpServer* UBlueprintHttpServer::AddMultipartUploadListener(const EHttpServerVerb Verb, const FString& Path, FHttpServerMultipartSinkFactory SinkFactory, FHttpServerMultipartCallback Callback, const bool bRequireGameThread)
+{
+	FUploadSetupListener Listener = nullptr;
+	switch (Verb)
+	{
+	case EHttpServerVerb::Post:		Listener = &httplib::Server::Post;		break;
+	case EHttpServerVerb::Put:		Listener = &httplib::Server::Put;		break;
+	case EHttpServerVerb::Patch:	Listener = &httplib::Server::Patch;		break;
+	case EHttpServerVerb::Delete:	Listener = &httplib::Server::Delete;	break;
+	default:
+		UE_LOG(LogHttpServer, Warning, TEXT("Uploads can only be added for POST, PUT, PATCH and DELETE, %s ignored."), *Path);
+		return this;
+	}
+
+	const int32 RouteIndex = Metrics ? Metrics->RegisterRoute(Verb, Path) : INDEX_NONE;
+
+	((*Server).*Listener)(TCHAR_TO_UTF8(*Path), FRouteListener::MakeMultipartHandler(SinkFactory, Callback, bRequireGameThread,
+		GetMillisecondsTimeout(MaxSecondWaitTimeout), bUseRequestSnapshots, GetDeferredDeadlines(), Metrics, RouteIndex, RateLimiter));
+
+	UE_LOG(LogHttpServer, Log, TEXT("New multipart upload route added: %s."), *Path);
+
+	return this;
+}
+
+UBlueprintHttpServer* UBlueprintHttpServer::AddMultipartFileUploadListener(const EHttpServerVerb Verb, const FString& Path, const FString& Directory, FHttpServerMultipartCallback Callback, const bool bRequireGameThread)
+{
+	if (!FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*Directory))
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("Failed to create the upload directory %s."), *Directory);
+	}
+
+	FHttpServerMultipartSinkFactory SinkFactory = FHttpServerMultipartSinkFactory::CreateLambda([Directory](const FBlueprintHttpRequest&, const FHttpServerMultipartPart&) -> FHttpServerUploadSinkPtr
+	{
+		return FHttpServerFileUploadSink::Create(FPaths::CreateTempFilename(*Directory, TEXT("Upload-"), TEXT(".bin")));
+	});
+
+	FHttpServerMultipartCallback FileCallback = FHttpServerMultipartCallback::CreateLambda([Callback = MoveTemp(Callback)](const FBlueprintHttpRequest& Request, const TArray<FHttpServerMultipartPart>& Parts, FBlueprintHttpResponse& Response) -> void
+	{
+		TArray<FHttpServerMultipartPart> FileParts = Parts;
+
+		for (FHttpServerMultipartPart& Part : FileParts)
+		{
+			if (Part.Sink)
+			{
+				Part.FilePath = static_cast<const FHttpServerFileUploadSink&>(*Part.Sink).GetFilePath();
+			}
+		}
+
+		Callback.ExecuteIfBound(Request, FileParts, Response);
+	});
+
+	return AddMultipartUploadListener(Verb, Path, MoveTemp(SinkFactory), MoveTemp(FileCallback), bRequireGameThread);
+}
+
+bool UBlueprintHttpServer::RemoveRoute(const EHttpServerVerb Verb, const FString& Path)
+{
+	const char* Method = nullptr;
+	switch (Verb)
+	{
+	case EHttpServerVerb::Get:		Method = "GET";		break;
+	case EHttpServerVerb::Post:		Method = "POST";	break;
+	case EHttpServerVerb::Delete:	Method = "DELETE";	break;
+	case EHttpServerVerb::Options:	Method = "OPTIONS";	break;
+	case EHttpServerVerb::Patch:	Method = "PATCH";	break;
+	case EHttpServerVerb::Put:		Method = "PUT";		break;
+	default: checkNoEntry(); return false;
+	}
+
+	// The route is either in the radix router or in httplib's regexes, depending on when it was added.
+	const bool bRemovedRadix = Router && Router->Remove(Verb, Path);
+	const bool bRemovedRegex = Server->remove_route(Method, TCHAR_TO_UTF8(*Path));
+
+	if (!bRemovedRadix && !bRemovedRegex)
 	{
-		UE_LOG(LogHttpServer, Warning, TEXT("Mount points can't be added when the server is running."));
+		UE_LOG(LogHttpServer, Warning, TEXT("Route { %s, %s } not found."), UTF8_TO_TCHAR(Method), *Path);
 		return false;
 	}
 
+	UE_LOG(LogHttpServer, Log, TEXT("Route removed: { %s, %s }."), UTF8_TO_TCHAR(Method), *Path);
+
+	return true;
+}
+
+bool UBlueprintHttpServer::AddMountPoint(const FString& UrlPath, const FString& DiskPath, const TMap<FString, FString>& DefaultHeaders)
+{
 	httplib::Headers Headers;
 
 	for (const auto& Header : DefaultHeaders)
@@ -567,12 +1466,6 @@ bool UBlueprintHttpServer::AddMountPoint(const FString& UrlPath, const FString&
 
 bool UBlueprintHttpServer::RemoveMountPoint(const FString& Path)
 {
-	if (IsRunning())
-	{
-		UE_LOG(LogHttpServer, Warning, TEXT("Mount points can't be removed when the server is running."));
-		return false;
-	}
-
 	return Server->remove_mount_point(TCHAR_TO_UTF8(*Path));
 }
 
@@ -592,13 +1485,42 @@ void UBlueprintHttpServer::Listen(FString Host, const uint16 Port, FHttpServerLi
 		return;
 	}
 
+#if PLATFORM_LINUX
+	if (bUseEventLoop)
+	{
+		EventLoop = MakeShared<FBlueprintHttpEpollServer, ESPMode::ThreadSafe>(Server.ToSharedRef(), EventLoopThreadCount);
+
+		const bool bResult = EventLoop->Listen(TCHAR_TO_UTF8(*Host), Port);
+
+		if (bResult)
+		{
+			UE_LOG(LogHttpServer, Log, TEXT("Started listening on %s:%d with %d epoll threads."), *Host, Port, EventLoopThreadCount);
+		}
+		else
+		{
+			EventLoop.Reset();
+		}
+
+		if (Callback.IsBound())
+		{
+			AsyncTask(ENamedThreads::GameThread, [bResult, LAMBDA_MOVE(Callback)]() -> void
+			{
+				Callback.ExecuteIfBound(bResult);
+			});
+		}
+
+		return;
+	}
+#endif
+
 	Thread.Reset(new std::thread([Server = this->Server, LAMBDA_MOVE(Host), Port, LAMBDA_MOVE(Callback)]() mutable -> void
 	{
 		const bool bResult = Server->bind_to_port(TCHAR_TO_UTF8(*Host), Port);
 
 		if (bResult)
 		{
-			UE_LOG(LogHttpServer, Log, TEXT("Started listening on %s:%d."), *Host, Port);
+			// Fewer than requested if the port couldn't be shared.
+			UE_LOG(LogHttpServer, Log, TEXT("Started listening on %s:%d with %d acceptors."), *Host, Port, static_cast<int32>(Server->bound_acceptor_count()));
 		}
 		else
 		{
@@ -636,6 +1558,54 @@ void UBlueprintHttpServer::SetFileExtensionAndMimeTypeMapping(const FString& Ext
 	Server->set_file_extension_and_mimetype_mapping(TCHAR_TO_UTF8(*Extension), TCHAR_TO_UTF8(*MimeType));
 }
 
+void UBlueprintHttpServer::SetResponseCompression(const bool bEnabled, const TArray<FString>& MimeTypes, const int32 MinSizeBytes, const int32 Level)
+{
+	if (IsRunning())
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("Compression can't be changed when the server is running."));
+		return;
+	}
+
+	httplib::Server::CompressionPolicy Policy;
+	Policy.enabled	= bEnabled;
+	Policy.min_size = static_cast<size_t>(FMath::Max(0, MinSizeBytes));
+	Policy.level	= FMath::Clamp(Level, 1, 9);
+
+	for (const FString& MimeType : MimeTypes)
+	{
+		Policy.mime_types.push_back(TCHAR_TO_UTF8(*MimeType));
+	}
+
+	Server->set_compression_policy(MoveTemp(Policy));
+}
+
+void UBlueprintHttpServer::EnableAssetCache(const int32 MaxSizeMegabytes, const int32 MaxFileSizeKilobytes)
+{
+	if (IsRunning())
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("The asset cache can't be enabled when the server is running."));
+		return;
+	}
+
+	if (!ensure(MaxSizeMegabytes > 0 && MaxFileSizeKilobytes > 0))
+	{
+		return;
+	}
+
+	AssetCache = MakeShared<FBlueprintHttpAssetCache, ESPMode::ThreadSafe>(
+		static_cast<int64>(MaxSizeMegabytes) * 1024 * 1024, static_cast<int64>(MaxFileSizeKilobytes) * 1024);
+
+	Server->set_file_content_handler([AssetCache = this->AssetCache](const httplib::Request& Request, httplib::Response& Response, const httplib::Server::FileInfo& File) -> bool
+	{
+		return AssetCache->Serve(Request, Response, File);
+	});
+}
+
+FHttpServerAssetCacheStats UBlueprintHttpServer::GetAssetCacheStats() const
+{
+	return AssetCache ? AssetCache->GetStats() : FHttpServerAssetCacheStats();
+}
+
 void UBlueprintHttpServer::SetKeepAliveMaxCount(const int32 Count)
 {
 	ensure(Count > 0);
@@ -662,12 +1632,49 @@ void UBlueprintHttpServer::SetTcpNodelay(const bool bTcpNodelay)
 	Server->set_tcp_nodelay(bTcpNodelay);
 }
 
+/**
+ * Wraps a task queue factory to measure the queues it creates, if metrics are enabled.
+*/
+static std::function<httplib::TaskQueue*()> InstrumentTaskQueue(std::function<httplib::TaskQueue*()> Factory, 
+	const TSharedPtr<FBlueprintHttpMetrics, ESPMode::ThreadSafe>& Metrics)
+{
+	if (!Metrics)
+	{
+		return Factory;
+	}
+
+	return [LAMBDA_MOVE(Factory), Metrics = Metrics.ToSharedRef()]() -> httplib::TaskQueue*
+	{
+		return FBlueprintHttpMetrics::InstrumentQueue(Metrics, Factory());
+	};
+}
+
 void UBlueprintHttpServer::SetHttpThreadPoolSize(const int32 ThreadPoolSize)
 {
-	Server->new_task_queue = [ThreadPoolSize]() -> httplib::ThreadPool*
+	Server->new_task_queue = InstrumentTaskQueue([ThreadPoolSize]() -> httplib::TaskQueue*
 	{
 		return new httplib::ThreadPool(ThreadPoolSize);
-	};
+	}, Metrics);
+}
+
+void UBlueprintHttpServer::SetHttpTaskQueue(const EHttpServerTaskQueue QueueType, const int32 ThreadCount)
+{
+	ensure(ThreadCount > 0);
+
+	switch (QueueType)
+	{
+	case EHttpServerTaskQueue::WorkStealing:
+		Server->new_task_queue = InstrumentTaskQueue([ThreadCount]() -> httplib::TaskQueue*
+		{
+			return new FBlueprintHttpWorkStealingQueue(ThreadCount);
+		}, Metrics);
+		break;
+
+	case EHttpServerTaskQueue::ThreadPool:
+	default:
+		SetHttpThreadPoolSize(ThreadCount);
+		break;
+	}
 }
 
 void UBlueprintHttpServer::SetMaxWaitingDelayForResponse(const float InSecondsToWait)
@@ -677,3 +1684,301 @@ void UBlueprintHttpServer::SetMaxWaitingDelayForResponse(const float InSecondsTo
 	MaxSecondWaitTimeout = InSecondsToWait;
 }
 
+void UBlueprintHttpServer::SetUseRequestSnapshots(const bool bEnabled)
+{
+	bUseRequestSnapshots = bEnabled;
+}
+
+void UBlueprintHttpServer::SetUseDeferredResponses(const bool bEnabled)
+{
+	bUseDeferredResponses = bEnabled;
+}
+
+void UBlueprintHttpServer::AddRateLimit(const FString& PathPrefix, const float RequestsPerSecond, const int32 Burst, const EHttpServerRateLimitKey Key, const FString& HeaderName)
+{
+	if (!ensure(RequestsPerSecond > 0.f && Burst > 0))
+	{
+		return;
+	}
+
+	if (Key != EHttpServerRateLimitKey::RemoteAddress && !ensure(!HeaderName.IsEmpty()))
+	{
+		return;
+	}
+
+	if (IsRunning())
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("Rate limits can't be added when the server is running."));
+		return;
+	}
+
+	if (!RateLimiter->HasRules())
+	{
+		// Runs before the body is read and before mount points, WebSockets and event streams.
+		Server->set_pre_routing_handler([RateLimiter = this->RateLimiter](const httplib::Request& Request, httplib::Response& Response) -> httplib::Server::HandlerResponse
+		{
+			return RateLimiter->Admit(Request, Response)
+				? httplib::Server::HandlerResponse::Unhandled
+				: httplib::Server::HandlerResponse::Handled;
+		});
+	}
+
+	RateLimiter->AddRule(PathPrefix, RequestsPerSecond, Burst, Key, HeaderName);
+
+	UE_LOG(LogHttpServer, Log, TEXT("Rate limit added: { %s, %.2f/s, burst %d }."), *PathPrefix, RequestsPerSecond, Burst);
+}
+
+void UBlueprintHttpServer::SetMaxInFlightRequests(const int32 MaxRequests)
+{
+	ensure(MaxRequests >= 0);
+
+	RateLimiter->SetMaxInFlight(MaxRequests);
+}
+
+FHttpServerRateLimitStats UBlueprintHttpServer::GetRateLimitStats() const
+{
+	return RateLimiter->GetStats();
+}
+
+void UBlueprintHttpServer::SetGameThreadDispatchBudget(const float BudgetMilliseconds)
+{
+	FBlueprintHttpGameThreadDispatcher::Get().SetBudget(BudgetMilliseconds);
+}
+
+FHttpGameThreadDispatchStats UBlueprintHttpServer::GetGameThreadDispatchStats()
+{
+	return FBlueprintHttpGameThreadDispatcher::Get().GetStats();
+}
+
+void UBlueprintHttpServer::SetUseRadixRouter(const bool bEnabled)
+{
+	bUseRadixRouter = bEnabled;
+}
+
+void UBlueprintHttpServer::SetUseEventLoop(const bool bEnabled, const int32 IoThreadCount)
+{
+	ensure(IoThreadCount > 0);
+
+#if PLATFORM_LINUX
+	if (bEnabled && IsA<UBlueprintHttpsServer>())
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("The epoll event loop doesn't support HTTPS servers."));
+		return;
+	}
+
+	bUseEventLoop		 = bEnabled;
+	EventLoopThreadCount = FMath::Max(1, IoThreadCount);
+#else
+	if (bEnabled)
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("The epoll event loop is only available on Linux."));
+	}
+#endif
+}
+
+void UBlueprintHttpServer::SetUseBufferedHeaderParsing(const bool bEnabled)
+{
+	if (IsRunning())
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("Header parsing can't be changed when the server is running."));
+		return;
+	}
+
+	Server->set_buffered_header_parsing(bEnabled);
+}
+
+void UBlueprintHttpServer::SetAcceptorCount(const int32 Count)
+{
+	ensure(Count > 0);
+
+	if (IsRunning())
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("The acceptor count can't be changed when the server is running."));
+		return;
+	}
+
+#if PLATFORM_LINUX
+	AcceptorCount = FMath::Max(1, Count);
+
+	Server->set_acceptor_count(static_cast<size_t>(AcceptorCount));
+#else
+	if (Count > 1)
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("SO_REUSEPORT acceptors are only available on Linux, the server keeps a single acceptor."));
+	}
+#endif
+}
+
+void UBlueprintHttpServer::EnableMetrics(const FString& Path)
+{
+	if (Metrics)
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("Metrics are already enabled."));
+		return;
+	}
+
+	if (IsRunning())
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("Metrics can't be enabled when the server is running."));
+		return;
+	}
+
+	Metrics = MakeShared<FBlueprintHttpMetrics, ESPMode::ThreadSafe>();
+
+	Server->new_task_queue = InstrumentTaskQueue(MoveTemp(Server->new_task_queue), Metrics);
+
+	Server->set_logger([Metrics = this->Metrics](const httplib::Request& Request, const httplib::Response& Response) -> void
+	{
+		Metrics->RecordResponse(Request, Response);
+	});
+
+	Server->set_compression_logger([Metrics = this->Metrics](const size_t InLength, const size_t OutLength, const std::chrono::nanoseconds Elapsed) -> void
+	{
+		Metrics->RecordCompression(InLength, OutLength, Elapsed.count());
+	});
+
+	// Served from the worker, scrapes don't wait for the game thread.
+	Server->Get(TCHAR_TO_UTF8(*Path), [Metrics = this->Metrics](const httplib::Request& Request, httplib::Response& Response) -> void
+	{
+		Response.set_content(Metrics->Export(), "text/plain; version=0.0.4; charset=utf-8");
+	});
+
+	UE_LOG(LogHttpServer, Log, TEXT("Metrics enabled on { GET, %s }."), *Path);
+}
+
+void UBlueprintHttpServer::AddWebSocketListener(const FString& Path, FHttpServerWebSocketCallback Callback, const bool bRequireGameThread)
+{
+	if (IsA<UBlueprintHttpsServer>())
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("WebSockets aren't supported by HTTPS servers, upgrades to %s will be answered with 501."), *Path);
+	}
+	else if (bUseEventLoop)
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("WebSockets aren't supported by the event loop, upgrades to %s will be answered with 501."), *Path);
+	}
+
+	if (!WebSockets)
+	{
+		WebSockets = MakeShared<FBlueprintHttpWebSocketHub, ESPMode::ThreadSafe>();
+	}
+
+	const FBlueprintHttpWebSocketHub::FEndpointPtr Endpoint = FBlueprintHttpWebSocketHub::MakeEndpoint(MoveTemp(Callback), bRequireGameThread);
+
+	Server->Get(TCHAR_TO_UTF8(*Path), [WebSockets = this->WebSockets, Endpoint](const httplib::Request& Request, httplib::Response& Response) -> void
+	{
+		WebSockets->Upgrade(Endpoint, Request, Response);
+	});
+
+	UE_LOG(LogHttpServer, Log, TEXT("New WebSocket route added: { GET, %s }."), *Path);
+}
+
+bool UBlueprintHttpServer::SendWebSocketText(const int64 ConnectionId, const FString& Text)
+{
+	if (!WebSockets)
+	{
+		return false;
+	}
+
+	const FTCHARToUTF8 Utf8(*Text);
+
+	return WebSockets->Send(ConnectionId, false, Utf8.Get(), Utf8.Length());
+}
+
+bool UBlueprintHttpServer::SendWebSocketBinary(const int64 ConnectionId, const TArray<uint8>& Data)
+{
+	return WebSockets && WebSockets->Send(ConnectionId, true, reinterpret_cast<const char*>(Data.GetData()), Data.Num());
+}
+
+void UBlueprintHttpServer::CloseWebSocket(const int64 ConnectionId, const int32 StatusCode)
+{
+	if (!ensure(StatusCode >= 1000 && StatusCode <= 4999))
+	{
+		return;
+	}
+
+	if (WebSockets)
+	{
+		WebSockets->Close(ConnectionId, static_cast<uint16>(StatusCode));
+	}
+}
+
+bool UBlueprintHttpServer::SubscribeWebSocket(const int64 ConnectionId, const FString& Channel)
+{
+	return WebSockets && WebSockets->Subscribe(ConnectionId, TCHAR_TO_UTF8(*Channel));
+}
+
+bool UBlueprintHttpServer::UnsubscribeWebSocket(const int64 ConnectionId, const FString& Channel)
+{
+	return WebSockets && WebSockets->Unsubscribe(ConnectionId, TCHAR_TO_UTF8(*Channel));
+}
+
+int32 UBlueprintHttpServer::BroadcastWebSocketText(const FString& Channel, const FString& Text)
+{
+	if (!WebSockets)
+	{
+		return 0;
+	}
+
+	const FTCHARToUTF8 Utf8(*Text);
+
+	return WebSockets->Broadcast(TCHAR_TO_UTF8(*Channel), false, Utf8.Get(), Utf8.Length());
+}
+
+int32 UBlueprintHttpServer::BroadcastWebSocketBinary(const FString& Channel, const TArray<uint8>& Data)
+{
+	return WebSockets ? WebSockets->Broadcast(TCHAR_TO_UTF8(*Channel), true, reinterpret_cast<const char*>(Data.GetData()), Data.Num()) : 0;
+}
+
+int32 UBlueprintHttpServer::GetWebSocketConnectionCount() const
+{
+	return WebSockets ? WebSockets->GetNumConnections() : 0;
+}
+
+void UBlueprintHttpServer::AddEventStream(const FString& Path, const TArray<FString>& Topics)
+{
+	if (IsA<UBlueprintHttpsServer>())
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("Event streams aren't supported by HTTPS servers, requests to %s will be answered with 501."), *Path);
+	}
+	else if (bUseEventLoop)
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("Event streams aren't supported by the event loop, requests to %s will be answered with 501."), *Path);
+	}
+
+	if (!EventStreams)
+	{
+		EventStreams = MakeShared<FBlueprintHttpEventStreamHub, ESPMode::ThreadSafe>();
+	}
+
+	const FBlueprintHttpEventStreamHub::FStreamPtr Stream = EventStreams->MakeStream(Topics);
+
+	Server->Get(TCHAR_TO_UTF8(*Path), [EventStreams = this->EventStreams, Stream](const httplib::Request& Request, httplib::Response& Response) -> void
+	{
+		EventStreams->Subscribe(Stream, Request, Response);
+	});
+
+	UE_LOG(LogHttpServer, Log, TEXT("New event stream added: { GET, %s }."), *Path);
+}
+
+void UBlueprintHttpServer::PublishEvent(const FString& Topic, const FString& Data)
+{
+	if (EventStreams)
+	{
+		const FTCHARToUTF8 Utf8(*Data);
+
+		EventStreams->Publish(TCHAR_TO_UTF8(*Topic), Utf8.Get(), Utf8.Length());
+	}
+}
+
+void UBlueprintHttpServer::PublishEventUtf8(const FString& Topic, const FUtf8StringView Data)
+{
+	if (EventStreams)
+	{
+		EventStreams->Publish(TCHAR_TO_UTF8(*Topic), reinterpret_cast<const char*>(Data.GetData()), Data.Len());
+	}
+}
+
+int32 UBlueprintHttpServer::GetEventStreamSubscriberCount() const
+{
+	return EventStreams ? EventStreams->GetNumSubscribers() : 0;
+}
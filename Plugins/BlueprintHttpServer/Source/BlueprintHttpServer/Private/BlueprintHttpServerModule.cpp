@@ -2,17 +2,20 @@
 
 #include "BlueprintHttpServerModule.h"
 
+#include "BlueprintHttpGameThreadDispatcher.h"
+
 DEFINE_LOG_CATEGORY(LogHttpServer);
 
 #define LOCTEXT_NAMESPACE "FBlueprintHttpServerModule"
 
 void FBlueprintHttpServerModule::StartupModule()
 {
-	
+	FBlueprintHttpGameThreadDispatcher::Get().Startup();
 }
 
 void FBlueprintHttpServerModule::ShutdownModule()
 {
+	FBlueprintHttpGameThreadDispatcher::Get().Shutdown();
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,115 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#include "BlueprintHttpSocket.h"
+
+#include "BlueprintHttpServerModule.h"
+
+int BlueprintHttpSocket::Poll(pollfd* const Fds, const size_t Count, const int TimeoutMs)
+{
+#if PLATFORM_WINDOWS
+	return WSAPoll(Fds, static_cast<ULONG>(Count), TimeoutMs);
+#else
+	return poll(Fds, static_cast<nfds_t>(Count), TimeoutMs);
+#endif
+}
+
+bool BlueprintHttpSocket::WouldBlock()
+{
+#if PLATFORM_WINDOWS
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+ssize_t BlueprintHttpSocket::Send(const socket_t Socket, const char* const Data, const size_t Size)
+{
+#if PLATFORM_WINDOWS
+	return send(Socket, Data, static_cast<int>(Size), 0);
+#elif defined(MSG_NOSIGNAL)
+	return send(Socket, Data, Size, MSG_NOSIGNAL);
+#else
+	return send(Socket, Data, Size, 0);
+#endif
+}
+
+ssize_t BlueprintHttpSocket::Recv(const socket_t Socket, char* const Data, const size_t Size)
+{
+#if PLATFORM_WINDOWS
+	return recv(Socket, Data, static_cast<int>(Size), 0);
+#else
+	return recv(Socket, Data, Size, 0);
+#endif
+}
+
+void BlueprintHttpSocket::Adopt(const socket_t Socket)
+{
+	httplib::detail::set_nonblocking(Socket, true);
+
+	// Messages are small and latency sensitive.
+	const int NoDelay = 1;
+	setsockopt(Socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&NoDelay), sizeof(NoDelay));
+}
+
+FBlueprintHttpWakeSocket::FBlueprintHttpWakeSocket()
+	: Socket(socket(AF_INET, SOCK_DGRAM, 0))
+	, bPending(false)
+{
+	if (Socket != INVALID_SOCKET)
+	{
+		sockaddr_in Address;
+		FMemory::Memzero(Address);
+		Address.sin_family		= AF_INET;
+		Address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		Address.sin_port		= 0;
+
+		socklen_t AddressLength = sizeof(Address);
+
+		const bool bConnected =
+			bind(Socket, reinterpret_cast<const sockaddr*>(&Address), sizeof(Address)) == 0 &&
+			getsockname(Socket, reinterpret_cast<sockaddr*>(&Address), &AddressLength) == 0 &&
+			connect(Socket, reinterpret_cast<const sockaddr*>(&Address), AddressLength) == 0;
+
+		if (bConnected)
+		{
+			httplib::detail::set_nonblocking(Socket, true);
+		}
+		else
+		{
+			httplib::detail::close_socket(Socket);
+			Socket = INVALID_SOCKET;
+		}
+	}
+
+	if (Socket == INVALID_SOCKET)
+	{
+		UE_LOG(LogHttpServer, Error, TEXT("Failed to create a wake up socket, falling back to polling."));
+	}
+}
+
+FBlueprintHttpWakeSocket::~FBlueprintHttpWakeSocket()
+{
+	if (Socket != INVALID_SOCKET)
+	{
+		httplib::detail::close_socket(Socket);
+	}
+}
+
+void FBlueprintHttpWakeSocket::Wake()
+{
+	if (Socket != INVALID_SOCKET && !bPending.exchange(true))
+	{
+		const char Byte = 0;
+		BlueprintHttpSocket::Send(Socket, &Byte, 1);
+	}
+}
+
+void FBlueprintHttpWakeSocket::Drain()
+{
+	bPending = false;
+
+	char Buffer[64];
+	while (BlueprintHttpSocket::Recv(Socket, Buffer, sizeof(Buffer)) > 0)
+	{
+	}
+}
@@ -0,0 +1,70 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "BlueprintHttpLib.h"
+
+#include <atomic>
+
+#if !PLATFORM_WINDOWS
+#	include <poll.h>
+#endif
+
+/**
+ * Non-blocking socket calls of the threads serving the connections taken over from httplib.
+*/
+namespace BlueprintHttpSocket
+{
+	int Poll(pollfd* const Fds, const size_t Count, const int TimeoutMs);
+
+	/**
+	 * If the last failed call only has to be retried later.
+	*/
+	bool WouldBlock();
+
+	ssize_t Send(const socket_t Socket, const char* const Data, const size_t Size);
+	ssize_t Recv(const socket_t Socket, char* const Data, const size_t Size);
+
+	/**
+	 * Makes a socket handed over by httplib non-blocking, without Nagle's delay.
+	*/
+	void Adopt(const socket_t Socket);
+}
+
+/**
+ * Wakes a thread up from poll().
+ * A loopback UDP socket connected to itself, polled for reads by the thread.
+*/
+class FBlueprintHttpWakeSocket final
+{
+public:
+	FBlueprintHttpWakeSocket();
+	~FBlueprintHttpWakeSocket();
+
+	/**
+	 * False if the socket couldn't be created, the thread must poll with a timeout.
+	*/
+	bool IsValid() const { return Socket != INVALID_SOCKET; }
+
+	socket_t GetSocket() const { return Socket; }
+
+	/**
+	 * Makes the socket readable. Thread safe.
+	*/
+	void Wake();
+
+	/**
+	 * Reads the pending wake ups. Called by the polling thread.
+	*/
+	void Drain();
+
+private:
+	socket_t Socket;
+
+	/**
+	 * Set between a Wake() and the next Drain(), so each wait costs one datagram.
+	*/
+	std::atomic<bool> bPending;
+};
@@ -0,0 +1,408 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#include "BlueprintHttpTaskQueue.h"
+
+#include "HAL/IConsoleManager.h"
+
+#include "BlueprintHttpServerModule.h"
+
+namespace BlueprintHttpTaskQueue
+{
+	// Times an idle worker looks for work before sleeping.
+	static constexpr int32 SpinCount = 64;
+}
+
+FBlueprintHttpWorkStealingQueue::FRing::FRing(const int32 Capacity)
+	: Slots(MakeUnique<FSlot[]>(FMath::RoundUpToPowerOfTwo(FMath::Max(2, Capacity))))
+	, Mask(FMath::RoundUpToPowerOfTwo(FMath::Max(2, Capacity)) - 1)
+	, Head(0)
+	, Tail(0)
+{
+	for (size_t i = 0; i <= Mask; ++i)
+	{
+		Slots[i].Sequence.store(i, std::memory_order_relaxed);
+	}
+}
+
+bool FBlueprintHttpWorkStealingQueue::FRing::Push(std::function<void()>& Job)
+{
+	size_t Position = Tail.load(std::memory_order_relaxed);
+
+	for (;;)
+	{
+		FSlot& Slot = Slots[Position & Mask];
+
+		const size_t   Sequence = Slot.Sequence.load(std::memory_order_acquire);
+		const intptr_t Diff		= static_cast<intptr_t>(Sequence) - static_cast<intptr_t>(Position);
+
+		if (Diff == 0)
+		{
+			if (Tail.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed))
+			{
+				Slot.Job = MoveTemp(Job);
+				Slot.Sequence.store(Position + 1, std::memory_order_release);
+				return true;
+			}
+		}
+		else if (Diff < 0)
+		{
+			// Full.
+			return false;
+		}
+		else
+		{
+			Position = Tail.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+bool FBlueprintHttpWorkStealingQueue::FRing::Pop(std::function<void()>& OutJob)
+{
+	size_t Position = Head.load(std::memory_order_relaxed);
+
+	for (;;)
+	{
+		FSlot& Slot = Slots[Position & Mask];
+
+		const size_t   Sequence = Slot.Sequence.load(std::memory_order_acquire);
+		const intptr_t Diff		= static_cast<intptr_t>(Sequence) - static_cast<intptr_t>(Position + 1);
+
+		if (Diff == 0)
+		{
+			if (Head.compare_exchange_weak(Position, Position + 1, std::memory_order_relaxed))
+			{
+				OutJob = MoveTemp(Slot.Job);
+				Slot.Job = nullptr;
+				Slot.Sequence.store(Position + Mask + 1, std::memory_order_release);
+				return true;
+			}
+		}
+		else if (Diff < 0)
+		{
+			// Empty.
+			return false;
+		}
+		else
+		{
+			Position = Head.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+FBlueprintHttpWorkStealingQueue::FBlueprintHttpWorkStealingQueue(const int32 NumWorkers, const int32 RingCapacity)
+	: OverflowCount(0)
+	, NextRing(0)
+	, NumPending(0)
+	, NumSleeping(0)
+	, bShutdown(false)
+{
+	const int32 WorkerCount = FMath::Max(1, NumWorkers);
+
+	Rings.Reserve(WorkerCount);
+	for (int32 i = 0; i < WorkerCount; ++i)
+	{
+		Rings.Emplace(MakeUnique<FRing>(RingCapacity));
+	}
+
+	Workers.Reserve(WorkerCount);
+	for (int32 i = 0; i < WorkerCount; ++i)
+	{
+		Workers.Emplace([this, i]() -> void
+		{
+			WorkerLoop(i);
+		});
+	}
+}
+
+FBlueprintHttpWorkStealingQueue::~FBlueprintHttpWorkStealingQueue()
+{
+	shutdown();
+}
+
+void FBlueprintHttpWorkStealingQueue::enqueue(std::function<void()> Job)
+{
+	const int32  NumRings = Rings.Num();
+	const uint32 First	  = NextRing.fetch_add(1, std::memory_order_relaxed);
+
+	bool bQueued = false;
+	for (int32 i = 0; i < NumRings && !bQueued; ++i)
+	{
+		bQueued = Rings[(First + i) % NumRings]->Push(Job);
+	}
+
+	if (!bQueued)
+	{
+		std::lock_guard<std::mutex> Lock(OverflowMutex);
+		Overflow.push_back(MoveTemp(Job));
+		OverflowCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Pairs with the sleeping worker's check of NumPending.
+	NumPending.fetch_add(1);
+
+	if (NumSleeping.load() > 0)
+	{
+		std::lock_guard<std::mutex> Lock(SleepMutex);
+		SleepCondition.notify_one();
+	}
+}
+
+void FBlueprintHttpWorkStealingQueue::shutdown()
+{
+	if (bShutdown.exchange(true))
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> Lock(SleepMutex);
+		SleepCondition.notify_all();
+	}
+
+	for (std::thread& Worker : Workers)
+	{
+		Worker.join();
+	}
+	Workers.Empty();
+}
+
+bool FBlueprintHttpWorkStealingQueue::TryGetJob(const int32 WorkerIndex, std::function<void()>& OutJob)
+{
+	// Own ring first.
+	if (Rings[WorkerIndex]->Pop(OutJob))
+	{
+		return true;
+	}
+
+	if (OverflowCount.load(std::memory_order_relaxed) > 0)
+	{
+		std::lock_guard<std::mutex> Lock(OverflowMutex);
+		if (!Overflow.empty())
+		{
+			OutJob = MoveTemp(Overflow.front());
+			Overflow.pop_front();
+			return true;
+		}
+	}
+
+	// Steal from the other workers.
+	const int32 NumRings = Rings.Num();
+	for (int32 i = 1; i < NumRings; ++i)
+	{
+		if (Rings[(WorkerIndex + i) % NumRings]->Pop(OutJob))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FBlueprintHttpWorkStealingQueue::WorkerLoop(const int32 WorkerIndex)
+{
+	std::function<void()> Job;
+	int32 Spins = 0;
+
+	for (;;)
+	{
+		if (TryGetJob(WorkerIndex, Job))
+		{
+			NumPending.fetch_sub(1);
+			Spins = 0;
+
+			Job();
+			Job = nullptr;
+			continue;
+		}
+
+		if (bShutdown.load() && NumPending.load() <= 0)
+		{
+			break;
+		}
+
+		if (++Spins < BlueprintHttpTaskQueue::SpinCount)
+		{
+			FPlatformProcess::Yield();
+			continue;
+		}
+
+		Spins = 0;
+
+		std::unique_lock<std::mutex> Lock(SleepMutex);
+
+		NumSleeping.fetch_add(1);
+
+		// A job pushed after this check sees the worker sleeping and notifies it.
+		if (NumPending.load() <= 0 && !bShutdown.load())
+		{
+			SleepCondition.wait(Lock);
+		}
+
+		NumSleeping.fetch_sub(1);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// HttpServer.BenchmarkTaskQueue
+
+static const TCHAR* const BenchmarkQueueNames[] = { TEXT("ThreadPool"), TEXT("WorkStealing") };
+
+static httplib::TaskQueue* CreateBenchmarkQueue(const int32 QueueType, const int32 NumWorkers)
+{
+	return QueueType == 0
+		? static_cast<httplib::TaskQueue*>(new httplib::ThreadPool(NumWorkers))
+		: static_cast<httplib::TaskQueue*>(new FBlueprintHttpWorkStealingQueue(NumWorkers));
+}
+
+// Queue only: producers enqueue empty jobs, measures the enqueue to completion throughput.
+static void BenchmarkQueueDispatch(const int32 NumWorkers)
+{
+	static constexpr int32 NumJobs = 200000;
+
+	for (int32 QueueType = 0; QueueType < 2; ++QueueType)
+	{
+		for (int32 Producers = 1; Producers <= 64; Producers *= 4)
+		{
+			std::unique_ptr<httplib::TaskQueue> Queue(CreateBenchmarkQueue(QueueType, NumWorkers));
+			std::atomic<int64> Done(0);
+
+			const int32	 JobsPerProducer = NumJobs / Producers;
+			const double Start			 = FPlatformTime::Seconds();
+
+			TArray<std::thread> Threads;
+			for (int32 i = 0; i < Producers; ++i)
+			{
+				Threads.Emplace([&]() -> void
+				{
+					for (int32 Job = 0; Job < JobsPerProducer; ++Job)
+					{
+						Queue->enqueue([&Done]() -> void
+						{
+							Done.fetch_add(1, std::memory_order_relaxed);
+						});
+					}
+				});
+			}
+
+			for (std::thread& Thread : Threads)
+			{
+				Thread.join();
+			}
+			Queue->shutdown();
+
+			const double Elapsed = FPlatformTime::Seconds() - Start;
+
+			UE_LOG(LogHttpServer, Display, TEXT("%-12s %2d producers: %6.2f M jobs/s"),
+				BenchmarkQueueNames[QueueType], Producers, Done.load() / Elapsed / 1e6);
+		}
+	}
+}
+
+// Loopback HTTP: clients open a connection per request, each one is a queue job.
+static void BenchmarkHttpConnections(const double Seconds, const int32 NumWorkers)
+{
+	for (int32 QueueType = 0; QueueType < 2; ++QueueType)
+	{
+		httplib::Server Server;
+		Server.new_task_queue = [QueueType, NumWorkers]() -> httplib::TaskQueue*
+		{
+			return CreateBenchmarkQueue(QueueType, NumWorkers);
+		};
+		Server.Get("/", [](const httplib::Request&, httplib::Response& Res) -> void
+		{
+			Res.set_content("ok", "text/plain");
+		});
+
+		const int Port = Server.bind_to_any_port("127.0.0.1");
+		if (Port <= 0)
+		{
+			UE_LOG(LogHttpServer, Error, TEXT("Benchmark server failed to bind."));
+			return;
+		}
+
+		std::thread ListenThread([&Server]() -> void
+		{
+			Server.listen_after_bind();
+		});
+
+		while (!Server.is_running())
+		{
+			FPlatformProcess::Sleep(0.001f);
+		}
+
+		for (int32 Connections = 1; Connections <= 64; Connections *= 2)
+		{
+			TArray<TArray<float>> LatenciesMs;
+			TArray<int32>		  Errors;
+			TArray<std::thread>	  Clients;
+
+			LatenciesMs.SetNum(Connections);
+			Errors.SetNumZeroed(Connections);
+
+			const double EndTime = FPlatformTime::Seconds() + Seconds;
+
+			for (int32 i = 0; i < Connections; ++i)
+			{
+				Clients.Emplace([&, i]() -> void
+				{
+					// No keep-alive: each request is a new connection, so a new job.
+					httplib::Client Client("127.0.0.1", Port);
+
+					while (FPlatformTime::Seconds() < EndTime)
+					{
+						const double Start = FPlatformTime::Seconds();
+						const httplib::Result Result = Client.Get("/");
+
+						if (Result && Result->status == 200)
+						{
+							LatenciesMs[i].Add(static_cast<float>((FPlatformTime::Seconds() - Start) * 1000.0));
+						}
+						else
+						{
+							Errors[i]++;
+						}
+					}
+				});
+			}
+
+			for (std::thread& Client : Clients)
+			{
+				Client.join();
+			}
+
+			TArray<float> All;
+			int32 NumErrors = 0;
+			for (int32 i = 0; i < Connections; ++i)
+			{
+				All.Append(LatenciesMs[i]);
+				NumErrors += Errors[i];
+			}
+			All.Sort();
+
+			const auto Percentile = [&All](const float Fraction) -> float
+			{
+				return All.Num() > 0 ? All[FMath::Clamp(FMath::CeilToInt(Fraction * All.Num()) - 1, 0, All.Num() - 1)] : 0.f;
+			};
+
+			UE_LOG(LogHttpServer, Display, TEXT("%-12s %2d connections: %8.0f req/s, p50 %.3f ms, p99 %.3f ms, %d errors"),
+				BenchmarkQueueNames[QueueType], Connections, All.Num() / Seconds, Percentile(0.50f), Percentile(0.99f), NumErrors);
+		}
+
+		Server.stop();
+		ListenThread.join();
+	}
+}
+
+static void BenchmarkTaskQueue(const TArray<FString>& Args)
+{
+	const double Seconds	= Args.Num() > 0 ? FCString::Atod(*Args[0]) : 0.5;
+	const int32  NumWorkers = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 8;
+
+	BenchmarkQueueDispatch(NumWorkers);
+	BenchmarkHttpConnections(Seconds, NumWorkers);
+}
+
+static FAutoConsoleCommand BenchmarkTaskQueueCommand(
+	TEXT("HttpServer.BenchmarkTaskQueue"),
+	TEXT("Compares the stock httplib thread pool with the work-stealing queue, queue only from 1 to 64 producers then on loopback HTTP from 1 to 64 connections. Args: [SecondsPerStep=0.5] [Workers=8]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkTaskQueue));
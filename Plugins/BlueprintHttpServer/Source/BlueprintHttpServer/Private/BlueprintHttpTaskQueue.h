@@ -0,0 +1,87 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "BlueprintHttpLib.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/**
+ * httplib task queue with one bounded lock-free ring per worker.
+ * Jobs are spread over the rings, a worker runs the jobs of its own ring
+ * first and steals from the other rings when it is empty. Ring slots are
+ * allocated once so enqueuing a job doesn't allocate or lock, unless
+ * every ring is full and the job goes to the locked overflow queue.
+ * Idle workers spin shortly before sleeping.
+*/
+class FBlueprintHttpWorkStealingQueue final : public httplib::TaskQueue
+{
+public:
+	/**
+	 * @param NumWorkers   The number of worker threads.
+	 * @param RingCapacity The jobs each worker's ring can hold, rounded up to a power of two.
+	*/
+	FBlueprintHttpWorkStealingQueue(const int32 NumWorkers, const int32 RingCapacity = 256);
+
+	virtual ~FBlueprintHttpWorkStealingQueue();
+
+	virtual void enqueue(std::function<void()> Job) override;
+	virtual void shutdown() override;
+
+	/**
+	 * Gets how many jobs didn't fit in the rings since creation.
+	*/
+	int64 GetOverflowCount() const { return OverflowCount.load(std::memory_order_relaxed); }
+
+private:
+	/**
+	 * Bounded multi-producer multi-consumer ring (Vyukov).
+	*/
+	class FRing
+	{
+	public:
+		explicit FRing(const int32 Capacity);
+
+		bool Push(std::function<void()>& Job);
+		bool Pop (std::function<void()>& OutJob);
+
+	private:
+		struct FSlot
+		{
+			std::atomic<size_t>	  Sequence;
+			std::function<void()> Job;
+		};
+
+		TUniquePtr<FSlot[]> Slots;
+		const size_t		Mask;
+
+		alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<size_t> Head;
+		alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<size_t> Tail;
+	};
+
+	void WorkerLoop(const int32 WorkerIndex);
+
+	bool TryGetJob(const int32 WorkerIndex, std::function<void()>& OutJob);
+
+private:
+	TArray<TUniquePtr<FRing>> Rings;
+	TArray<std::thread>		  Workers;
+
+	std::mutex						  OverflowMutex;
+	std::deque<std::function<void()>> Overflow;
+	std::atomic<int64>				  OverflowCount;
+
+	std::atomic<uint32> NextRing;
+	std::atomic<int32>  NumPending;
+	std::atomic<int32>  NumSleeping;
+	std::atomic<bool>	bShutdown;
+
+	std::mutex				SleepMutex;
+	std::condition_variable SleepCondition;
+};
@@ -0,0 +1,116 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#include "BlueprintHttpTimerWheel.h"
+
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+
+FBlueprintHttpTimerWheel::FBlueprintHttpTimerWheel(const int32 InTickMilliseconds, const int32 InNumSlots)
+	: Cursor(0)
+	, NumTimers(0)
+	, TickMilliseconds(FMath::Max(1, InTickMilliseconds))
+	, Thread(nullptr)
+	, WakeUp(FPlatformProcess::GetSynchEventFromPool())
+	, bStopping(false)
+{
+	Slots.SetNum(FMath::Max(1, InNumSlots));
+}
+
+FBlueprintHttpTimerWheel::~FBlueprintHttpTimerWheel()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+	}
+
+	FPlatformProcess::ReturnSynchEventToPool(WakeUp);
+}
+
+void FBlueprintHttpTimerWheel::Schedule(const int64 DelayMilliseconds, TUniqueFunction<void()> Callback)
+{
+	FScopeLock Lock(&Mutex);
+
+	if (!Thread)
+	{
+		Thread = FRunnableThread::Create(this, TEXT("BlueprintHttpTimerWheel"), 0, TPri_BelowNormal);
+	}
+
+	const int64 NumSlots = Slots.Num();
+	const int64 Ticks	 = FMath::Max<int64>(1, (DelayMilliseconds + TickMilliseconds - 1) / TickMilliseconds);
+
+	FTimer Timer;
+	Timer.Callback = MoveTemp(Callback);
+	Timer.Rounds   = (Ticks - 1) / NumSlots;
+
+	Slots[(Cursor + Ticks) % NumSlots].Add(MoveTemp(Timer));
+	NumTimers++;
+}
+
+int32 FBlueprintHttpTimerWheel::Num() const
+{
+	FScopeLock Lock(&Mutex);
+	return NumTimers;
+}
+
+void FBlueprintHttpTimerWheel::Advance(TArray<TUniqueFunction<void()>>& OutExpired)
+{
+	Cursor = (Cursor + 1) % Slots.Num();
+
+	TArray<FTimer>& Slot = Slots[Cursor];
+	for (int32 i = Slot.Num() - 1; i >= 0; --i)
+	{
+		if (Slot[i].Rounds > 0)
+		{
+			Slot[i].Rounds--;
+			continue;
+		}
+
+		OutExpired.Add(MoveTemp(Slot[i].Callback));
+		Slot.RemoveAtSwap(i, 1, false);
+		NumTimers--;
+	}
+}
+
+uint32 FBlueprintHttpTimerWheel::Run()
+{
+	const double TickSeconds = TickMilliseconds / 1000.0;
+	double NextTick = FPlatformTime::Seconds() + TickSeconds;
+
+	TArray<TUniqueFunction<void()>> Expired;
+
+	while (!bStopping)
+	{
+		const double Now = FPlatformTime::Seconds();
+		if (Now < NextTick)
+		{
+			WakeUp->Wait(FMath::Max(1, FMath::CeilToInt((NextTick - Now) * 1000.0)));
+			continue;
+		}
+
+		{
+			FScopeLock Lock(&Mutex);
+
+			// Catch up on the ticks missed if we were descheduled.
+			while (NextTick <= Now)
+			{
+				Advance(Expired);
+				NextTick += TickSeconds;
+			}
+		}
+
+		for (TUniqueFunction<void()>& Callback : Expired)
+		{
+			Callback();
+		}
+		Expired.Reset();
+	}
+
+	return 0;
+}
+
+void FBlueprintHttpTimerWheel::Stop()
+{
+	bStopping = true;
+	WakeUp->Trigger();
+}
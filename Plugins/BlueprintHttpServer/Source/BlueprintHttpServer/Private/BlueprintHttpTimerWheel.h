@@ -0,0 +1,64 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+
+/**
+ * Hashed timer wheel running one-shot callbacks on its own thread.
+ * Scheduling is O(1) whatever the number of pending timers, so thousands
+ * of response deadlines cost one thread instead of one blocked worker each.
+ * Deadlines are rounded up to the tick duration.
+*/
+class FBlueprintHttpTimerWheel final : public FRunnable
+{
+public:
+	/**
+	 * @param InTickMilliseconds Resolution of the wheel.
+	 * @param InNumSlots		 Slots in the wheel. Longer delays take several rounds.
+	*/
+	FBlueprintHttpTimerWheel(const int32 InTickMilliseconds = 10, const int32 InNumSlots = 512);
+
+	virtual ~FBlueprintHttpTimerWheel();
+
+	/**
+	 * Schedules a callback. The thread is started on the first call.
+	 * Callbacks run on the wheel's thread and must be short.
+	 * Pending callbacks are dropped when the wheel is destroyed.
+	 * @param DelayMilliseconds Delay before the callback runs.
+	 * @param Callback			The callback.
+	*/
+	void Schedule(const int64 DelayMilliseconds, TUniqueFunction<void()> Callback);
+
+	/**
+	 * Gets the number of pending timers.
+	*/
+	int32 Num() const;
+
+	virtual uint32 Run() override;
+	virtual void   Stop() override;
+
+private:
+	struct FTimer
+	{
+		TUniqueFunction<void()> Callback;
+		int64					Rounds = 0;
+	};
+
+	// Moves the cursor one slot and collects the expired callbacks. Mutex must be held.
+	void Advance(TArray<TUniqueFunction<void()>>& OutExpired);
+
+private:
+	mutable FCriticalSection Mutex;
+
+	TArray<TArray<FTimer>> Slots;
+	int32 Cursor;
+	int32 NumTimers;
+
+	const int32 TickMilliseconds;
+
+	FRunnableThread* Thread;
+	FEvent*			 WakeUp;
+	TAtomic<bool>	 bStopping;
+};
@@ -0,0 +1,128 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#include "BlueprintHttpServer.h"
+
+#include "BlueprintHttpServerModule.h"
+
+#include "HAL/PlatformFileManager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+
+namespace BlueprintHttpUpload
+{
+	// Chunks read from the socket are small, they are written to disk in blocks of this size.
+	static constexpr int32 BufferSize = 256 * 1024;
+}
+
+TSharedPtr<FHttpServerFileUploadSink, ESPMode::ThreadSafe> FHttpServerFileUploadSink::Create(const FString& FilePath)
+{
+	const FString PartialFilePath = FilePath + TEXT(".part");
+
+	IFileHandle* const File = FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*PartialFilePath);
+
+	if (!File)
+	{
+		UE_LOG(LogHttpServer, Error, TEXT("Failed to open %s to write an upload."), *PartialFilePath);
+		return nullptr;
+	}
+
+	return TSharedPtr<FHttpServerFileUploadSink, ESPMode::ThreadSafe>(new FHttpServerFileUploadSink(FilePath, PartialFilePath, File));
+}
+
+FHttpServerFileUploadSink::FHttpServerFileUploadSink(const FString& InFilePath, const FString& InPartialFilePath, IFileHandle* const InFile)
+	: FilePath(InFilePath)
+	, PartialFilePath(InPartialFilePath)
+	, File(InFile)
+	, Size(0)
+{
+	Buffer.Reserve(BlueprintHttpUpload::BufferSize);
+}
+
+FHttpServerFileUploadSink::~FHttpServerFileUploadSink()
+{
+	// Not finished, the upload failed.
+	if (File)
+	{
+		File.Reset();
+		FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*PartialFilePath);
+	}
+}
+
+bool FHttpServerFileUploadSink::Write(const uint8* Data, const int64 InSize)
+{
+	if (!File)
+	{
+		return false;
+	}
+
+	Size += InSize;
+
+	// Large chunks skip the buffer.
+	if (Buffer.Num() + InSize > BlueprintHttpUpload::BufferSize)
+	{
+		if (!Flush())
+		{
+			return false;
+		}
+
+		if (InSize >= BlueprintHttpUpload::BufferSize)
+		{
+			return File->Write(Data, InSize);
+		}
+	}
+
+	Buffer.Append(Data, static_cast<int32>(InSize));
+
+	return true;
+}
+
+bool FHttpServerFileUploadSink::Finish()
+{
+	if (!File || !Flush() || !File->Flush())
+	{
+		return false;
+	}
+
+	File.Reset();
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	PlatformFile.DeleteFile(*FilePath);
+
+	if (!PlatformFile.MoveFile(*FilePath, *PartialFilePath))
+	{
+		UE_LOG(LogHttpServer, Error, TEXT("Failed to move upload %s to %s."), *PartialFilePath, *FilePath);
+
+		PlatformFile.DeleteFile(*PartialFilePath);
+		return false;
+	}
+
+	return true;
+}
+
+void FHttpServerFileUploadSink::Discard()
+{
+	// Finished, the file was moved in place.
+	if (!File)
+	{
+		FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*FilePath);
+	}
+}
+
+bool FHttpServerFileUploadSink::Flush()
+{
+	if (Buffer.Num() == 0)
+	{
+		return true;
+	}
+
+	const bool bWritten = File->Write(Buffer.GetData(), Buffer.Num());
+
+	Buffer.Reset();
+
+	if (!bWritten)
+	{
+		UE_LOG(LogHttpServer, Error, TEXT("Failed to write upload to %s."), *PartialFilePath);
+	}
+
+	return bWritten;
+}
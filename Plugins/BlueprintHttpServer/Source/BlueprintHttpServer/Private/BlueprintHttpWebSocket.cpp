@@ -0,0 +1,1042 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#include "BlueprintHttpWebSocket.h"
+
+#include "Misc/Base64.h"
+#include "Misc/SecureHash.h"
+
+#include "BlueprintHttpServerModule.h"
+#include "BlueprintHttpGameThreadDispatcher.h"
+
+namespace BlueprintHttpWebSocket
+{
+	static constexpr const char* Guid = "258EAFA5-E914-47DA-95CA-C5AB0DC11B65";
+
+	enum EOpcode : uint8
+	{
+		Continuation = 0x0,
+		Text		 = 0x1,
+		Binary		 = 0x2,
+		Close		 = 0x8,
+		Ping		 = 0x9,
+		Pong		 = 0xA
+	};
+
+	// Larger messages close the connection with 1009.
+	static constexpr size_t MaxMessageSize = 16 * 1024 * 1024;
+
+	// Clients with more bytes waiting to be written can't keep up and are dropped.
+	static constexpr size_t MaxQueuedBytes = 8 * 1024 * 1024;
+
+	// Bytes read, or gathered from small frames, per socket call.
+	static constexpr size_t IoChunkSize = 64 * 1024;
+
+	// How long a close we started waits for the client's close frame.
+	static constexpr double CloseTimeoutSeconds = 5.0;
+
+	// How often the thread checks the close timeouts while closing connections.
+	static constexpr int ClosingPollMs = 250;
+
+	/**
+	 * If a comma separated header value contains a token, ignoring case.
+	*/
+	static bool HasToken(const std::string& Value, const char* const Token)
+	{
+		const size_t TokenLength = FCStringAnsi::Strlen(Token);
+
+		size_t Start = 0;
+		while (Start < Value.size())
+		{
+			size_t End = Value.find(',', Start);
+			if (End == std::string::npos)
+			{
+				End = Value.size();
+			}
+
+			size_t First = Start;
+			size_t Last	 = End;
+			while (First < Last && (Value[First] == ' ' || Value[First] == '\t')) ++First;
+			while (Last > First && (Value[Last - 1] == ' ' || Value[Last - 1] == '\t')) --Last;
+
+			if (Last - First == TokenLength && FCStringAnsi::Strnicmp(Value.data() + First, Token, TokenLength) == 0)
+			{
+				return true;
+			}
+
+			Start = End + 1;
+		}
+
+		return false;
+	}
+
+	static bool IsValidCloseCode(const uint16 Code)
+	{
+		return (Code >= 1000 && Code <= 1014 && Code != 1004 && Code != 1005 && Code != 1006)
+			|| (Code >= 3000 && Code <= 4999);
+	}
+
+	/**
+	 * Unmasks a client payload in place, eight bytes at a time.
+	*/
+	static void Unmask(uint8* const Payload, const size_t Size, const uint8* const Mask)
+	{
+		uint32 Mask32;
+		FMemory::Memcpy(&Mask32, Mask, sizeof(Mask32));
+
+		const uint64 Mask64 = (static_cast<uint64>(Mask32) << 32) | Mask32;
+
+		size_t Index = 0;
+		for (; Index + sizeof(uint64) <= Size; Index += sizeof(uint64))
+		{
+			uint64 Word;
+			FMemory::Memcpy(&Word, Payload + Index, sizeof(Word));
+			Word ^= Mask64;
+			FMemory::Memcpy(Payload + Index, &Word, sizeof(Word));
+		}
+
+		for (; Index < Size; ++Index)
+		{
+			Payload[Index] ^= Mask[Index & 3];
+		}
+	}
+}
+
+struct FBlueprintHttpWebSocketHub::FEndpoint : public std::enable_shared_from_this<FEndpoint>
+{
+	FHttpServerWebSocketCallback Callback;
+	bool bRequireGameThread = false;
+
+	/**
+	 * Events received during the current iteration. Only touched by the hub thread.
+	*/
+	TArray<FHttpServerWebSocketMessage> Batch;
+
+	/**
+	 * Events waiting for the game thread, which takes them all at once.
+	*/
+	FCriticalSection Mutex;
+	TArray<FHttpServerWebSocketMessage> Pending;
+	bool bScheduled = false;
+};
+
+struct FBlueprintHttpWebSocketHub::FConnection
+{
+	int64 Id = 0;
+	socket_t Socket = INVALID_SOCKET;
+	FEndpointPtr Endpoint;
+
+	// Only touched by the hub thread.
+
+	std::string Input;
+
+	/**
+	 * The fragments of the message being received.
+	*/
+	std::string Message;
+	uint8 MessageOpcode = BlueprintHttpWebSocket::Continuation;
+
+	/**
+	 * No more frames are parsed, the client sent a close frame or broke the protocol.
+	*/
+	bool bInputClosed = false;
+
+	// Mutex must be held.
+
+	std::deque<FFramePtr> Output;
+
+	/**
+	 * The bytes of the front frame already written.
+	*/
+	size_t OutputOffset = 0;
+	size_t QueuedBytes	= 0;
+
+	bool bCloseQueued = false;
+	bool bOverflow	  = false;
+	double CloseDeadline = 0.0;
+
+	std::vector<std::string> Channels;
+};
+
+FString FHttpServerWebSocketMessage::GetText() const
+{
+	const FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Data.GetData()), Data.Num());
+
+	return FString(Converter.Length(), Converter.Get());
+}
+
+FBlueprintHttpWebSocketHub::FBlueprintHttpWebSocketHub()
+	: NextConnectionId(1)
+	, bStopping(false)
+{
+	Thread = std::thread([this]() -> void
+	{
+		Run();
+	});
+}
+
+FBlueprintHttpWebSocketHub::~FBlueprintHttpWebSocketHub()
+{
+	bStopping = true;
+	WakeSocket.Wake();
+
+	if (Thread.joinable())
+	{
+		Thread.join();
+	}
+
+	for (const auto& Connection : Connections)
+	{
+		httplib::detail::close_socket(Connection.second->Socket);
+	}
+
+	for (const auto& Socket : Upgraded)
+	{
+		httplib::detail::close_socket(Socket.second);
+	}
+}
+
+FBlueprintHttpWebSocketHub::FEndpointPtr FBlueprintHttpWebSocketHub::MakeEndpoint(FHttpServerWebSocketCallback Callback, const bool bRequireGameThread)
+{
+	FEndpointPtr Endpoint = std::make_shared<FEndpoint>();
+
+	Endpoint->Callback			 = MoveTemp(Callback);
+	Endpoint->bRequireGameThread = bRequireGameThread;
+
+	return Endpoint;
+}
+
+void FBlueprintHttpWebSocketHub::Upgrade(const FEndpointPtr& Endpoint, const httplib::Request& Request, httplib::Response& Response)
+{
+	const std::string Key = Request.get_header_value("Sec-WebSocket-Key");
+
+	if (Key.empty() ||
+		!BlueprintHttpWebSocket::HasToken(Request.get_header_value("Upgrade"),	 "websocket") ||
+		!BlueprintHttpWebSocket::HasToken(Request.get_header_value("Connection"), "upgrade"))
+	{
+		Response.status = 400;
+		return;
+	}
+
+	if (Request.get_header_value("Sec-WebSocket-Version") != "13")
+	{
+		Response.status = 426;
+		Response.set_header("Sec-WebSocket-Version", "13");
+		return;
+	}
+
+	const std::string AcceptKey = Key + BlueprintHttpWebSocket::Guid;
+
+	uint8 Hash[FSHA1::DigestSize];
+	FSHA1::HashBuffer(AcceptKey.data(), AcceptKey.size(), Hash);
+
+	Response.status = 101;
+	Response.set_header("Upgrade",				"websocket");
+	Response.set_header("Connection",			"Upgrade");
+	Response.set_header("Sec-WebSocket-Accept", TCHAR_TO_UTF8(*FBase64::Encode(Hash, sizeof(Hash))));
+
+	// Called by httplib once the response is written.
+	Response.upgrade([this, Endpoint](socket_t Socket) -> void
+	{
+		{
+			FScopeLock Lock(&Mutex);
+			Upgraded.emplace_back(Endpoint, Socket);
+		}
+
+		WakeSocket.Wake();
+	});
+}
+
+bool FBlueprintHttpWebSocketHub::Send(const int64 ConnectionId, const bool bBinary, const char* const Data, const size_t Size)
+{
+	const FFramePtr Frame = MakeFrame(bBinary ? BlueprintHttpWebSocket::Binary : BlueprintHttpWebSocket::Text, Data, Size);
+
+	FScopeLock Lock(&Mutex);
+
+	auto Connection = Connections.find(ConnectionId);
+	if (Connection == Connections.end())
+	{
+		return false;
+	}
+
+	return Enqueue(*Connection->second, Frame);
+}
+
+void FBlueprintHttpWebSocketHub::Close(const int64 ConnectionId, const uint16 StatusCode)
+{
+	FScopeLock Lock(&Mutex);
+
+	auto Connection = Connections.find(ConnectionId);
+	if (Connection != Connections.end())
+	{
+		EnqueueClose(*Connection->second, StatusCode);
+	}
+}
+
+void FBlueprintHttpWebSocketHub::CloseAll(const uint16 StatusCode)
+{
+	FScopeLock Lock(&Mutex);
+
+	for (const auto& Connection : Connections)
+	{
+		EnqueueClose(*Connection.second, StatusCode);
+	}
+}
+
+bool FBlueprintHttpWebSocketHub::Subscribe(const int64 ConnectionId, const std::string& Channel)
+{
+	FScopeLock Lock(&Mutex);
+
+	auto Connection = Connections.find(ConnectionId);
+	if (Connection == Connections.end())
+	{
+		return false;
+	}
+
+	if (Channels[Channel].insert(ConnectionId).second)
+	{
+		Connection->second->Channels.push_back(Channel);
+	}
+
+	return true;
+}
+
+bool FBlueprintHttpWebSocketHub::Unsubscribe(const int64 ConnectionId, const std::string& Channel)
+{
+	FScopeLock Lock(&Mutex);
+
+	auto Subscribers = Channels.find(Channel);
+	if (Subscribers == Channels.end() || Subscribers->second.erase(ConnectionId) == 0)
+	{
+		return false;
+	}
+
+	if (Subscribers->second.empty())
+	{
+		Channels.erase(Subscribers);
+	}
+
+	auto Connection = Connections.find(ConnectionId);
+	if (Connection != Connections.end())
+	{
+		std::vector<std::string>& Subscriptions = Connection->second->Channels;
+		Subscriptions.erase(std::find(Subscriptions.begin(), Subscriptions.end(), Channel));
+	}
+
+	return true;
+}
+
+int32 FBlueprintHttpWebSocketHub::Broadcast(const std::string& Channel, const bool bBinary, const char* const Data, const size_t Size)
+{
+	const FFramePtr Frame = MakeFrame(bBinary ? BlueprintHttpWebSocket::Binary : BlueprintHttpWebSocket::Text, Data, Size);
+
+	int32 Count = 0;
+
+	FScopeLock Lock(&Mutex);
+
+	if (Channel.empty())
+	{
+		for (const auto& Connection : Connections)
+		{
+			Count += Enqueue(*Connection.second, Frame) ? 1 : 0;
+		}
+
+		return Count;
+	}
+
+	auto Subscribers = Channels.find(Channel);
+	if (Subscribers == Channels.end())
+	{
+		return 0;
+	}
+
+	for (const int64 ConnectionId : Subscribers->second)
+	{
+		auto Connection = Connections.find(ConnectionId);
+		if (Connection != Connections.end())
+		{
+			Count += Enqueue(*Connection->second, Frame) ? 1 : 0;
+		}
+	}
+
+	return Count;
+}
+
+int32 FBlueprintHttpWebSocketHub::GetNumConnections() const
+{
+	FScopeLock Lock(&Mutex);
+
+	return static_cast<int32>(Connections.size());
+}
+
+void FBlueprintHttpWebSocketHub::Run()
+{
+	std::vector<pollfd>			Fds;
+	std::vector<FConnectionPtr> Polled;
+
+	while (!bStopping)
+	{
+		AcceptUpgraded();
+
+		Fds.clear();
+		Polled.clear();
+
+		if (WakeSocket.IsValid())
+		{
+			pollfd& Fd = Fds.emplace_back();
+			Fd.fd	   = WakeSocket.GetSocket();
+			Fd.events  = POLLIN;
+			Fd.revents = 0;
+		}
+
+		const size_t FirstConnection = Fds.size();
+
+		bool bClosing = false;
+
+		{
+			FScopeLock Lock(&Mutex);
+
+			for (const auto& Connection : Connections)
+			{
+				pollfd& Fd = Fds.emplace_back();
+				Fd.fd	   = Connection.second->Socket;
+				Fd.events  = Connection.second->Output.empty() ? POLLIN : (POLLIN | POLLOUT);
+				Fd.revents = 0;
+
+				Polled.push_back(Connection.second);
+
+				bClosing |= Connection.second->bCloseQueued;
+			}
+		}
+
+		const int TimeoutMs = !WakeSocket.IsValid() ? 10 : (bClosing ? BlueprintHttpWebSocket::ClosingPollMs : -1);
+
+		if (BlueprintHttpSocket::Poll(Fds.data(), Fds.size(), TimeoutMs) < 0 && !BlueprintHttpSocket::WouldBlock())
+		{
+			UE_LOG(LogHttpServer, Error, TEXT("WebSocket poll() failed, closing all connections."));
+
+			for (const FConnectionPtr& Connection : Polled)
+			{
+				Remove(Connection);
+			}
+
+			Deliver();
+
+			FPlatformProcess::Sleep(0.1f);
+			continue;
+		}
+
+		if (FirstConnection > 0 && Fds[0].revents != 0)
+		{
+			WakeSocket.Drain();
+		}
+
+		const double Now = FPlatformTime::Seconds();
+
+		for (size_t Index = 0; Index < Polled.size(); ++Index)
+		{
+			const FConnectionPtr& Connection = Polled[Index];
+			const short Events = Fds[FirstConnection + Index].revents;
+
+			bool bKeep = (Events & (POLLERR | POLLNVAL)) == 0;
+
+			if (bKeep && (Events & (POLLIN | POLLHUP)))
+			{
+				bKeep = OnReadable(*Connection);
+			}
+
+			if (bKeep && (Events & POLLOUT))
+			{
+				bKeep = OnWritable(*Connection);
+			}
+
+			if (bKeep)
+			{
+				FScopeLock Lock(&Mutex);
+
+				// Once our close frame is written and the client's received, or after the timeout.
+				const bool bClosed = Connection->bCloseQueued
+					&& ((Connection->Output.empty() && Connection->bInputClosed) || Now >= Connection->CloseDeadline);
+
+				bKeep = !bClosed && !Connection->bOverflow;
+			}
+
+			if (!bKeep)
+			{
+				Remove(Connection);
+			}
+		}
+
+		Deliver();
+	}
+}
+
+void FBlueprintHttpWebSocketHub::AcceptUpgraded()
+{
+	std::vector<std::pair<FEndpointPtr, socket_t>> Sockets;
+
+	{
+		FScopeLock Lock(&Mutex);
+		Sockets.swap(Upgraded);
+	}
+
+	for (auto& Socket : Sockets)
+	{
+		BlueprintHttpSocket::Adopt(Socket.second);
+
+		FConnectionPtr Connection = std::make_shared<FConnection>();
+		Connection->Id		 = NextConnectionId++;
+		Connection->Socket	 = Socket.second;
+		Connection->Endpoint = MoveTemp(Socket.first);
+
+		{
+			FScopeLock Lock(&Mutex);
+			Connections.emplace(Connection->Id, Connection);
+		}
+
+		Push(*Connection, EHttpServerWebSocketEvent::Opened);
+	}
+}
+
+bool FBlueprintHttpWebSocketHub::OnReadable(FConnection& Connection)
+{
+	char Buffer[BlueprintHttpWebSocket::IoChunkSize];
+
+	const ssize_t Read = BlueprintHttpSocket::Recv(Connection.Socket, Buffer, sizeof(Buffer));
+
+	if (Read == 0)
+	{
+		return false;
+	}
+
+	if (Read < 0)
+	{
+		return BlueprintHttpSocket::WouldBlock();
+	}
+
+	// Anything after the close frame is ignored.
+	if (Connection.bInputClosed)
+	{
+		return true;
+	}
+
+	Connection.Input.append(Buffer, static_cast<size_t>(Read));
+
+	return ParseFrames(Connection);
+}
+
+bool FBlueprintHttpWebSocketHub::ParseFrames(FConnection& Connection)
+{
+	uint8* const Data = reinterpret_cast<uint8*>(&Connection.Input[0]);
+	const size_t Size = Connection.Input.size();
+
+	size_t Offset = 0;
+	uint16 Error  = 0;
+
+	while (!Connection.bInputClosed && Error == 0)
+	{
+		uint8* const Frame	   = Data + Offset;
+		const size_t Available = Size - Offset;
+
+		if (Available < 2)
+		{
+			break;
+		}
+
+		const bool	bFinal	= (Frame[0] & 0x80) != 0;
+		const uint8 Opcode	= Frame[0] & 0x0F;
+		const bool	bMasked = (Frame[1] & 0x80) != 0;
+
+		uint64 Length	  = Frame[1] & 0x7F;
+		size_t HeaderSize = 2;
+
+		// No extension is negotiated, and clients must mask their frames.
+		if ((Frame[0] & 0x70) != 0 || !bMasked)
+		{
+			Error = 1002;
+			break;
+		}
+
+		if (Length == 126)
+		{
+			if (Available < 4)
+			{
+				break;
+			}
+
+			Length	   = (static_cast<uint64>(Frame[2]) << 8) | Frame[3];
+			HeaderSize = 4;
+		}
+		else if (Length == 127)
+		{
+			if (Available < 10)
+			{
+				break;
+			}
+
+			Length = 0;
+			for (int32 Byte = 2; Byte < 10; ++Byte)
+			{
+				Length = (Length << 8) | Frame[Byte];
+			}
+
+			HeaderSize = 10;
+		}
+
+		HeaderSize += 4;
+
+		const bool bControl = (Opcode & 0x08) != 0;
+
+		if (bControl && (!bFinal || Length > 125))
+		{
+			Error = 1002;
+			break;
+		}
+
+		if (Length > BlueprintHttpWebSocket::MaxMessageSize - Connection.Message.size())
+		{
+			Error = 1009;
+			break;
+		}
+
+		if (Available < HeaderSize || Available - HeaderSize < Length)
+		{
+			break;
+		}
+
+		uint8* const Payload	 = Frame + HeaderSize;
+		const size_t PayloadSize = static_cast<size_t>(Length);
+
+		BlueprintHttpWebSocket::Unmask(Payload, PayloadSize, Payload - 4);
+
+		Offset += HeaderSize + PayloadSize;
+
+		const char* Message		= reinterpret_cast<const char*>(Payload);
+		size_t		MessageSize = PayloadSize;
+		uint8		MessageType = Opcode;
+
+		switch (Opcode)
+		{
+		case BlueprintHttpWebSocket::Continuation:
+			if (Connection.MessageOpcode == BlueprintHttpWebSocket::Continuation)
+			{
+				Error = 1002;
+				continue;
+			}
+
+			Connection.Message.append(Message, MessageSize);
+
+			if (!bFinal)
+			{
+				continue;
+			}
+
+			Message		= Connection.Message.data();
+			MessageSize = Connection.Message.size();
+			MessageType = Connection.MessageOpcode;
+			break;
+
+		case BlueprintHttpWebSocket::Text:
+		case BlueprintHttpWebSocket::Binary:
+			if (Connection.MessageOpcode != BlueprintHttpWebSocket::Continuation)
+			{
+				Error = 1002;
+				continue;
+			}
+
+			if (!bFinal)
+			{
+				Connection.MessageOpcode = Opcode;
+				Connection.Message.assign(Message, MessageSize);
+				continue;
+			}
+			break;
+
+		case BlueprintHttpWebSocket::Close:
+		{
+			uint16 StatusCode = 1000;
+
+			if (PayloadSize == 1)
+			{
+				StatusCode = 1002;
+			}
+			else if (PayloadSize >= 2)
+			{
+				StatusCode = static_cast<uint16>((Payload[0] << 8) | Payload[1]);
+
+				if (!BlueprintHttpWebSocket::IsValidCloseCode(StatusCode) || !IsValidUtf8(Payload + 2, PayloadSize - 2))
+				{
+					StatusCode = 1002;
+				}
+			}
+
+			Connection.bInputClosed = true;
+
+			FScopeLock Lock(&Mutex);
+			EnqueueClose(Connection, StatusCode);
+			continue;
+		}
+
+		case BlueprintHttpWebSocket::Ping:
+		{
+			const FFramePtr Pong = MakeFrame(BlueprintHttpWebSocket::Pong, Message, MessageSize);
+
+			FScopeLock Lock(&Mutex);
+			Enqueue(Connection, Pong);
+			continue;
+		}
+
+		case BlueprintHttpWebSocket::Pong:
+			continue;
+
+		default:
+			Error = 1002;
+			continue;
+		}
+
+		if (MessageType == BlueprintHttpWebSocket::Text && !IsValidUtf8(reinterpret_cast<const uint8*>(Message), MessageSize))
+		{
+			Error = 1007;
+			continue;
+		}
+
+		Push(Connection, MessageType == BlueprintHttpWebSocket::Text ? EHttpServerWebSocketEvent::Text : EHttpServerWebSocketEvent::Binary, Message, MessageSize);
+
+		if (Connection.MessageOpcode != BlueprintHttpWebSocket::Continuation)
+		{
+			Connection.MessageOpcode = BlueprintHttpWebSocket::Continuation;
+			Connection.Message.clear();
+		}
+	}
+
+	if (Error != 0)
+	{
+		Connection.bInputClosed = true;
+
+		FScopeLock Lock(&Mutex);
+		EnqueueClose(Connection, Error);
+	}
+
+	if (Connection.bInputClosed)
+	{
+		Connection.Input.clear();
+		Connection.Message.clear();
+	}
+	else
+	{
+		Connection.Input.erase(0, Offset);
+	}
+
+	return true;
+}
+
+bool FBlueprintHttpWebSocketHub::OnWritable(FConnection& Connection)
+{
+	std::string Gathered;
+
+	for (;;)
+	{
+		FFramePtr	Front;
+		const char* Data = nullptr;
+		size_t		Size = 0;
+
+		{
+			FScopeLock Lock(&Mutex);
+
+			if (Connection.Output.empty())
+			{
+				return true;
+			}
+
+			Front = Connection.Output.front();
+
+			// Small frames are gathered into one write, a large one is written from the frame itself.
+			if (Connection.Output.size() == 1 || Front->size() - Connection.OutputOffset >= BlueprintHttpWebSocket::IoChunkSize)
+			{
+				Data = Front->data() + Connection.OutputOffset;
+				Size = Front->size() - Connection.OutputOffset;
+			}
+			else
+			{
+				Gathered.clear();
+
+				size_t FrameOffset = Connection.OutputOffset;
+				for (const FFramePtr& Frame : Connection.Output)
+				{
+					const size_t Taken = FMath::Min(Frame->size() - FrameOffset, BlueprintHttpWebSocket::IoChunkSize - Gathered.size());
+
+					Gathered.append(Frame->data() + FrameOffset, Taken);
+					FrameOffset = 0;
+
+					if (Gathered.size() == BlueprintHttpWebSocket::IoChunkSize)
+					{
+						break;
+					}
+				}
+
+				Data = Gathered.data();
+				Size = Gathered.size();
+			}
+		}
+
+		const ssize_t Written = BlueprintHttpSocket::Send(Connection.Socket, Data, Size);
+
+		if (Written < 0)
+		{
+			return BlueprintHttpSocket::WouldBlock();
+		}
+
+		FScopeLock Lock(&Mutex);
+
+		size_t Remaining = static_cast<size_t>(Written);
+		while (Remaining > 0)
+		{
+			const FFramePtr& Frame = Connection.Output.front();
+			const size_t Left = Frame->size() - Connection.OutputOffset;
+
+			if (Remaining < Left)
+			{
+				Connection.OutputOffset += Remaining;
+				break;
+			}
+
+			Remaining -= Left;
+			Connection.QueuedBytes -= Frame->size();
+			Connection.OutputOffset = 0;
+			Connection.Output.pop_front();
+		}
+
+		if (static_cast<size_t>(Written) < Size)
+		{
+			return true;
+		}
+	}
+}
+
+void FBlueprintHttpWebSocketHub::Remove(const FConnectionPtr& Connection)
+{
+	{
+		FScopeLock Lock(&Mutex);
+
+		for (const std::string& Channel : Connection->Channels)
+		{
+			auto Subscribers = Channels.find(Channel);
+			if (Subscribers != Channels.end())
+			{
+				Subscribers->second.erase(Connection->Id);
+
+				if (Subscribers->second.empty())
+				{
+					Channels.erase(Subscribers);
+				}
+			}
+		}
+
+		Connection->Channels.clear();
+		Connection->Output.clear();
+
+		Connections.erase(Connection->Id);
+	}
+
+	httplib::detail::shutdown_socket(Connection->Socket);
+	httplib::detail::close_socket(Connection->Socket);
+	Connection->Socket = INVALID_SOCKET;
+
+	Push(*Connection, EHttpServerWebSocketEvent::Closed);
+}
+
+void FBlueprintHttpWebSocketHub::Push(FConnection& Connection, const EHttpServerWebSocketEvent Event, const char* const Data, const size_t Size)
+{
+	FEndpoint& Endpoint = *Connection.Endpoint;
+
+	if (Endpoint.Batch.Num() == 0)
+	{
+		PendingEndpoints.push_back(&Endpoint);
+	}
+
+	FHttpServerWebSocketMessage& Message = Endpoint.Batch.AddDefaulted_GetRef();
+	Message.ConnectionId = Connection.Id;
+	Message.Event		 = Event;
+
+	if (Size > 0)
+	{
+		Message.Data.Append(reinterpret_cast<const uint8*>(Data), static_cast<int32>(Size));
+	}
+}
+
+void FBlueprintHttpWebSocketHub::Deliver()
+{
+	for (FEndpoint* const Endpoint : PendingEndpoints)
+	{
+		if (!Endpoint->bRequireGameThread)
+		{
+			const TArray<FHttpServerWebSocketMessage> Messages = MoveTemp(Endpoint->Batch);
+			Endpoint->Callback.ExecuteIfBound(Messages);
+			continue;
+		}
+
+		bool bSchedule = false;
+
+		{
+			FScopeLock Lock(&Endpoint->Mutex);
+
+			// Appended to the batch the game thread didn't take yet.
+			Endpoint->Pending.Append(MoveTemp(Endpoint->Batch));
+			Endpoint->Batch.Reset();
+
+			bSchedule = !Endpoint->bScheduled;
+			Endpoint->bScheduled = true;
+		}
+
+		if (bSchedule)
+		{
+			FBlueprintHttpGameThreadDispatcher::Get().Enqueue([Endpoint = Endpoint->shared_from_this()]() -> void
+			{
+				TArray<FHttpServerWebSocketMessage> Messages;
+
+				{
+					FScopeLock Lock(&Endpoint->Mutex);
+					Messages = MoveTemp(Endpoint->Pending);
+					Endpoint->bScheduled = false;
+				}
+
+				Endpoint->Callback.ExecuteIfBound(Messages);
+			});
+		}
+	}
+
+	PendingEndpoints.clear();
+}
+
+bool FBlueprintHttpWebSocketHub::Enqueue(FConnection& Connection, const FFramePtr& Frame)
+{
+	if (Connection.bCloseQueued || Connection.bOverflow)
+	{
+		return false;
+	}
+
+	if (Connection.QueuedBytes + Frame->size() > BlueprintHttpWebSocket::MaxQueuedBytes)
+	{
+		UE_LOG(LogHttpServer, Warning, TEXT("WebSocket connection %lld can't keep up with the messages sent, dropping it."), Connection.Id);
+
+		Connection.bOverflow = true;
+		WakeSocket.Wake();
+		return false;
+	}
+
+	Connection.Output.push_back(Frame);
+	Connection.QueuedBytes += Frame->size();
+
+	// The thread polls for writes as long as the queue isn't empty.
+	if (Connection.Output.size() == 1)
+	{
+		WakeSocket.Wake();
+	}
+
+	return true;
+}
+
+void FBlueprintHttpWebSocketHub::EnqueueClose(FConnection& Connection, const uint16 StatusCode)
+{
+	if (Connection.bCloseQueued)
+	{
+		return;
+	}
+
+	const char Payload[2] = { static_cast<char>(StatusCode >> 8), static_cast<char>(StatusCode & 0xFF) };
+
+	const FFramePtr Frame = MakeFrame(BlueprintHttpWebSocket::Close, Payload, sizeof(Payload));
+
+	// Queued even over the budget, it is the last frame.
+	Connection.Output.push_back(Frame);
+	Connection.QueuedBytes	 += Frame->size();
+	Connection.bCloseQueued	  = true;
+	Connection.CloseDeadline  = FPlatformTime::Seconds() + BlueprintHttpWebSocket::CloseTimeoutSeconds;
+
+	WakeSocket.Wake();
+}
+
+FBlueprintHttpWebSocketHub::FFramePtr FBlueprintHttpWebSocketHub::MakeFrame(const uint8 Opcode, const char* const Data, const size_t Size)
+{
+	std::shared_ptr<std::string> Frame = std::make_shared<std::string>();
+	Frame->reserve(Size + 10);
+
+	Frame->push_back(static_cast<char>(0x80 | Opcode));
+
+	if (Size < 126)
+	{
+		Frame->push_back(static_cast<char>(Size));
+	}
+	else if (Size <= 0xFFFF)
+	{
+		Frame->push_back(static_cast<char>(126));
+		Frame->push_back(static_cast<char>(Size >> 8));
+		Frame->push_back(static_cast<char>(Size & 0xFF));
+	}
+	else
+	{
+		Frame->push_back(static_cast<char>(127));
+		for (int32 Shift = 56; Shift >= 0; Shift -= 8)
+		{
+			Frame->push_back(static_cast<char>((static_cast<uint64>(Size) >> Shift) & 0xFF));
+		}
+	}
+
+	Frame->append(Data, Size);
+
+	return Frame;
+}
+
+bool FBlueprintHttpWebSocketHub::IsValidUtf8(const uint8* Data, const size_t Size)
+{
+	size_t Index = 0;
+
+	while (Index < Size)
+	{
+		const uint8 Lead = Data[Index];
+
+		if (Lead < 0x80)
+		{
+			++Index;
+			continue;
+		}
+
+		size_t Length;
+		uint32 CodePoint;
+
+		if		((Lead & 0xE0) == 0xC0) { Length = 2; CodePoint = Lead & 0x1F; }
+		else if ((Lead & 0xF0) == 0xE0) { Length = 3; CodePoint = Lead & 0x0F; }
+		else if ((Lead & 0xF8) == 0xF0) { Length = 4; CodePoint = Lead & 0x07; }
+		else
+		{
+			return false;
+		}
+
+		if (Size - Index < Length)
+		{
+			return false;
+		}
+
+		for (size_t Continuation = 1; Continuation < Length; ++Continuation)
+		{
+			const uint8 Byte = Data[Index + Continuation];
+			if ((Byte & 0xC0) != 0x80)
+			{
+				return false;
+			}
+
+			CodePoint = (CodePoint << 6) | (Byte & 0x3F);
+		}
+
+		// Overlong encodings, surrogates and out of range code points.
+		static constexpr uint32 MinCodePoints[] = { 0, 0, 0x80, 0x800, 0x10000 };
+
+		if (CodePoint < MinCodePoints[Length] || CodePoint > 0x10FFFF || (CodePoint >= 0xD800 && CodePoint <= 0xDFFF))
+		{
+			return false;
+		}
+
+		Index += Length;
+	}
+
+	return true;
+}
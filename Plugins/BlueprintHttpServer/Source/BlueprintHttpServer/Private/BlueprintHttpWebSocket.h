@@ -0,0 +1,160 @@
+// Copyright Pandores Marketplace 2021. All Righst Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BlueprintHttpServer.h"
+
+#include "BlueprintHttpLib.h"
+#include "BlueprintHttpSocket.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * The WebSocket connections of a server (RFC 6455).
+ * Upgraded sockets leave the HTTP workers and are all polled by one thread,
+ * which parses the client frames and writes the queued server frames.
+ * Messages are sent from any thread by queuing an encoded frame, shared by
+ * all the connections of a broadcast. Received events are batched per endpoint
+ * so the callback runs once for everything received since its previous call.
+*/
+class FBlueprintHttpWebSocketHub final
+{
+public:
+	struct FEndpoint;
+
+	using FEndpointPtr = std::shared_ptr<FEndpoint>;
+
+	FBlueprintHttpWebSocketHub();
+	~FBlueprintHttpWebSocketHub();
+
+	/**
+	 * Creates the endpoint of a WebSocket route.
+	 * @param Callback			 Receives the batched events of the endpoint's connections.
+	 * @param bRequireGameThread If the batches are delivered on the game thread.
+	*/
+	static FEndpointPtr MakeEndpoint(FHttpServerWebSocketCallback Callback, const bool bRequireGameThread);
+
+	/**
+	 * Answers an upgrade request of an endpoint. The connection is
+	 * handed over to the hub once the response is written.
+	*/
+	void Upgrade(const FEndpointPtr& Endpoint, const httplib::Request& Request, httplib::Response& Response);
+
+	/**
+	 * Queues a message on a connection. Thread safe.
+	 * @return False if the connection is closed or closing.
+	*/
+	bool Send(const int64 ConnectionId, const bool bBinary, const char* const Data, const size_t Size);
+
+	/**
+	 * Sends a close frame once the queued messages are written. Thread safe.
+	*/
+	void Close(const int64 ConnectionId, const uint16 StatusCode);
+
+	/**
+	 * Closes all connections, used when the server stops. Thread safe.
+	*/
+	void CloseAll(const uint16 StatusCode);
+
+	bool Subscribe(const int64 ConnectionId, const std::string& Channel);
+	bool Unsubscribe(const int64 ConnectionId, const std::string& Channel);
+
+	/**
+	 * Queues a message on the connections subscribed to a channel. Thread safe.
+	 * @param Channel The channel, all open connections if empty.
+	 * @return The number of connections the message was queued on.
+	*/
+	int32 Broadcast(const std::string& Channel, const bool bBinary, const char* const Data, const size_t Size);
+
+	int32 GetNumConnections() const;
+
+private:
+	struct FConnection;
+
+	using FFramePtr		 = std::shared_ptr<const std::string>;
+	using FConnectionPtr = std::shared_ptr<FConnection>;
+
+	void Run();
+
+	/**
+	 * Registers the connections upgraded since the last iteration.
+	*/
+	void AcceptUpgraded();
+
+	/**
+	 * Reads and parses the available frames.
+	 * @return False if the connection must be dropped.
+	*/
+	bool OnReadable(FConnection& Connection);
+
+	/**
+	 * Parses the complete frames of the read buffer.
+	 * @return False if the connection must be dropped.
+	*/
+	bool ParseFrames(FConnection& Connection);
+
+	/**
+	 * Writes the queued frames until the socket is full.
+	 * @return False if the connection must be dropped.
+	*/
+	bool OnWritable(FConnection& Connection);
+
+	void Remove(const FConnectionPtr& Connection);
+
+	/**
+	 * Adds an event to its endpoint's batch.
+	*/
+	void Push(FConnection& Connection, const EHttpServerWebSocketEvent Event, const char* const Data = nullptr, const size_t Size = 0);
+
+	/**
+	 * Delivers the batches of the endpoints that received events this iteration.
+	*/
+	void Deliver();
+
+	/**
+	 * Queues a frame and wakes the thread. Mutex must be held.
+	 * @return False if the connection is closing.
+	*/
+	bool Enqueue(FConnection& Connection, const FFramePtr& Frame);
+
+	/**
+	 * Queues a close frame, nothing is sent after it. Mutex must be held.
+	*/
+	void EnqueueClose(FConnection& Connection, const uint16 StatusCode);
+
+	static FFramePtr MakeFrame(const uint8 Opcode, const char* const Data, const size_t Size);
+
+	static bool IsValidUtf8(const uint8* Data, const size_t Size);
+
+private:
+	mutable FCriticalSection Mutex;
+
+	std::unordered_map<int64, FConnectionPtr> Connections;
+	std::unordered_map<std::string, std::unordered_set<int64>> Channels;
+
+	/**
+	 * Sockets upgraded by the HTTP workers, waiting for the thread.
+	*/
+	std::vector<std::pair<FEndpointPtr, socket_t>> Upgraded;
+
+	std::atomic<int64> NextConnectionId;
+
+	FBlueprintHttpWakeSocket WakeSocket;
+
+	std::atomic<bool> bStopping;
+
+	/**
+	 * Endpoints with events pending delivery. Only touched by the thread.
+	*/
+	std::vector<FEndpoint*> PendingEndpoints;
+
+	std::thread Thread;
+};
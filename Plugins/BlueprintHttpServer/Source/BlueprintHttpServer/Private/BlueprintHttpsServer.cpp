@@ -2,19 +2,7 @@
 
 #include "BlueprintHttpsServer.h"
 
-#if PLATFORM_WINDOWS
-#	include "Windows/AllowWindowsPlatformTypes.h"
-#endif // PLATFORM_WINDOWS
-
-#define UI UI_ST
-THIRD_PARTY_INCLUDES_START
-#	include <httplib.h>
-THIRD_PARTY_INCLUDES_END
-#undef UI
-
-#if PLATFORM_WINDOWS
-#	include "Windows/HideWindowsPlatformTypes.h"
-#endif // PLATFORM_WINDOWS
+#include "BlueprintHttpLib.h"
 
 #include "Misc/Paths.h"
 
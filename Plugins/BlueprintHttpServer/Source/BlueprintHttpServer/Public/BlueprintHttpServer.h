@@ -5,11 +5,22 @@
 #include <thread>
 
 #include "CoreMinimal.h"
+#include "Containers/StringView.h"
 #include "BlueprintHttpServer.generated.h"
 
 // Forward declaration of internal types.
 namespace httplib { class Server; struct Request; struct Response; }
 template<class T> class FBlueprintHttpRequestInternal;
+class FBlueprintHttpRequestSnapshot;
+class FBlueprintHttpTimerWheel;
+class FBlueprintHttpRouter;
+class FBlueprintHttpEpollServer;
+class FBlueprintHttpMetrics;
+class FBlueprintHttpAssetCache;
+class FBlueprintHttpWebSocketHub;
+class FBlueprintHttpEventStreamHub;
+class FBlueprintHttpRateLimiter;
+class IFileHandle;
 
 /**
  * An HTTP verb.
@@ -27,6 +38,203 @@ enum class EHttpServerVerb : uint8
 	MAX UMETA(Hidden)
 };
 
+/**
+ * The queue running the connections of a server.
+*/
+UENUM(BlueprintType)
+enum class EHttpServerTaskQueue : uint8
+{
+	// httplib's thread pool, a single locked job list.
+	ThreadPool,
+	// Lock-free per worker rings with work stealing.
+	WorkStealing
+};
+
+/**
+ * Statistics of the route callbacks run on the game thread.
+*/
+USTRUCT(BlueprintType)
+struct BLUEPRINTHTTPSERVER_API FHttpGameThreadDispatchStats
+{
+	GENERATED_BODY()
+public:
+	/**
+	 * Callbacks run during the last frame.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server")
+	int32 LastFrameDispatched = 0;
+
+	/**
+	 * Time spent running callbacks during the last frame, in milliseconds.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server")
+	float LastFrameMs = 0.f;
+
+	/**
+	 * Longest time spent running callbacks in a frame, in milliseconds.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server")
+	float MaxFrameMs = 0.f;
+
+	/**
+	 * Callbacks waiting for the next frame.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server")
+	int32 Pending = 0;
+
+	/**
+	 * Frames where the budget was reached with callbacks left.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server")
+	int64 OverflowFrames = 0;
+
+	/**
+	 * Callbacks run since startup.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server")
+	int64 TotalDispatched = 0;
+};
+
+/**
+ * Statistics of the static asset cache of a server.
+*/
+USTRUCT(BlueprintType)
+struct BLUEPRINTHTTPSERVER_API FHttpServerAssetCacheStats
+{
+	GENERATED_BODY()
+public:
+	/**
+	 * Files served from memory.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server")
+	int64 Hits = 0;
+
+	/**
+	 * Files loaded from disk, because they weren't cached or were modified.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server")
+	int64 Misses = 0;
+
+	/**
+	 * Hits over all cacheable requests, between 0 and 1.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server")
+	float HitRate = 0.f;
+
+	/**
+	 * Entries dropped to stay under the memory budget.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server")
+	int64 Evictions = 0;
+
+	/**
+	 * Files currently cached.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server")
+	int32 Entries = 0;
+
+	/**
+	 * Bytes used by the cached files and their gzip variants.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server")
+	int64 MemoryBytes = 0;
+};
+
+/**
+ * What identifies a client for rate limiting.
+*/
+UENUM(BlueprintType)
+enum class EHttpServerRateLimitKey : uint8
+{
+	// The address of the connection.
+	RemoteAddress,
+	// A header value, such as an API key. Clients without it are limited by address.
+	Header,
+	// Both, each address has its own bucket per header value.
+	RemoteAddressAndHeader
+};
+
+/**
+ * Statistics of the admission control of a server.
+*/
+USTRUCT(BlueprintType)
+struct BLUEPRINTHTTPSERVER_API FHttpServerRateLimitStats
+{
+	GENERATED_BODY()
+public:
+	/**
+	 * Requests rejected with 429 because their client was over its rate.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server")
+	int64 RateLimited = 0;
+
+	/**
+	 * Requests rejected with 503 because too many requests were in flight.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server")
+	int64 InFlightRejected = 0;
+
+	/**
+	 * Requests currently handled by route callbacks.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server")
+	int32 InFlight = 0;
+
+	/**
+	 * Clients with a token bucket, over all rules.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server")
+	int32 TrackedClients = 0;
+};
+
+/**
+ * What happened on a WebSocket connection.
+*/
+UENUM(BlueprintType)
+enum class EHttpServerWebSocketEvent : uint8
+{
+	// The client completed the handshake.
+	Opened,
+	// A text message, UTF-8 encoded.
+	Text,
+	// A binary message.
+	Binary,
+	// The connection was closed, by either side.
+	Closed
+};
+
+/**
+ * An event received on a WebSocket connection.
+*/
+USTRUCT(BlueprintType)
+struct BLUEPRINTHTTPSERVER_API FHttpServerWebSocketMessage
+{
+	GENERATED_BODY()
+public:
+	/**
+	 * The connection, unique for the lifetime of the server.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server|WebSocket")
+	int64 ConnectionId = 0;
+
+	/**
+	 * What happened.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server|WebSocket")
+	EHttpServerWebSocketEvent Event = EHttpServerWebSocketEvent::Opened;
+
+	/**
+	 * The message payload. Empty for Opened and Closed.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server|WebSocket")
+	TArray<uint8> Data;
+
+	/**
+	 * Decodes the payload of a text message.
+	*/
+	FString GetText() const;
+};
+
 /**
  * Delegate called when a route is requested by a client.
  * @param Request The request object sent by the client.
@@ -41,6 +249,164 @@ DECLARE_DELEGATE_TwoParams(FHttpServerRouteCallback, const FBlueprintHttpRequest
 */
 DECLARE_DELEGATE_OneParam(FHttpServerListenCallback, const bool /* bSuccess */);
 
+/**
+ * Delegate called with the WebSocket events received since the previous call.
+ * @param Messages The events, in the order they were received.
+*/
+DECLARE_DELEGATE_OneParam(FHttpServerWebSocketCallback, const TArray<FHttpServerWebSocketMessage>& /* Messages */);
+
+/**
+ * Receives the body of an upload as it arrives, instead of buffering it in the request.
+ * A sink is created for each upload and written by the HTTP worker reading it.
+*/
+class BLUEPRINTHTTPSERVER_API IHttpServerUploadSink
+{
+public:
+	virtual ~IHttpServerUploadSink() = default;
+
+	/**
+	 * Receives the next chunk of the body.
+	 * @return False to abort the upload, answered with 500.
+	*/
+	virtual bool Write(const uint8* Data, const int64 Size) = 0;
+
+	/**
+	 * Called once the whole body was written, before the route callback.
+	 * @return False if the upload failed, answered with 500.
+	*/
+	virtual bool Finish() { return true; }
+
+	/**
+	 * Called after Finish() if the upload is dropped anyway,
+	 * when another part of its multipart request failed.
+	*/
+	virtual void Discard() {}
+};
+
+using FHttpServerUploadSinkPtr = TSharedPtr<IHttpServerUploadSink, ESPMode::ThreadSafe>;
+
+/**
+ * Writes an upload to a file through a fixed size buffer.
+ * The body is written next to the file and moved in place once complete,
+ * the partial file is deleted if the upload fails.
+*/
+class BLUEPRINTHTTPSERVER_API FHttpServerFileUploadSink final : public IHttpServerUploadSink
+{
+public:
+	/**
+	 * Opens a file to write an upload to, replaced once the upload completes.
+	 * @param FilePath The file.
+	 * @return Null if the file couldn't be opened.
+	*/
+	static TSharedPtr<FHttpServerFileUploadSink, ESPMode::ThreadSafe> Create(const FString& FilePath);
+
+	~FHttpServerFileUploadSink();
+
+	virtual bool Write(const uint8* Data, const int64 Size) override;
+	virtual bool Finish() override;
+	virtual void Discard() override;
+
+	const FString& GetFilePath() const { return FilePath; }
+
+	/**
+	 * The bytes received.
+	*/
+	int64 GetSize() const { return Size; }
+
+private:
+	FHttpServerFileUploadSink(const FString& FilePath, const FString& PartialFilePath, IFileHandle* const File);
+
+	bool Flush();
+
+private:
+	FString FilePath;
+	FString PartialFilePath;
+
+	TUniquePtr<IFileHandle> File;
+
+	TArray<uint8> Buffer;
+
+	int64 Size;
+};
+
+/**
+ * Delegate called when an upload starts, with its headers, to create the sink of its body.
+ * @param Request The request, without body.
+ * @return The sink, or null to refuse the upload with 500.
+*/
+DECLARE_DELEGATE_RetVal_OneParam(FHttpServerUploadSinkPtr, FHttpServerUploadSinkFactory, const FBlueprintHttpRequest& /* Request */);
+
+/**
+ * Delegate called once the body of an upload was written to its sink.
+ * @param Request The request, without body.
+ * @param Sink The sink the body was written to.
+ * @param Response The response object we will send to the client.
+*/
+DECLARE_DELEGATE_ThreeParams(FHttpServerUploadCallback, const FBlueprintHttpRequest& /* Request */, const FHttpServerUploadSinkPtr& /* Sink */, FBlueprintHttpResponse& /* Response */);
+
+/**
+ * A part of a multipart/form-data upload.
+*/
+USTRUCT(BlueprintType)
+struct BLUEPRINTHTTPSERVER_API FHttpServerMultipartPart
+{
+	GENERATED_BODY()
+public:
+	/**
+	 * The name of the form field.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server|Upload")
+	FString Name;
+
+	/**
+	 * The name of the uploaded file, empty for regular fields.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server|Upload")
+	FString FileName;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server|Upload")
+	FString ContentType;
+
+	/**
+	 * The value of a regular field. Files are written to their sink instead.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server|Upload")
+	FString Value;
+
+	/**
+	 * The file the part was written to, for multipart file uploads.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server|Upload")
+	FString FilePath;
+
+	/**
+	 * The bytes of the part.
+	*/
+	UPROPERTY(BlueprintReadOnly, Category = "Http|Server|Upload")
+	int64 Size = 0;
+
+	/**
+	 * The sink the file was written to, null for regular fields and skipped files.
+	*/
+	FHttpServerUploadSinkPtr Sink;
+};
+
+/**
+ * Delegate called when a file part of a multipart upload starts, to create its sink.
+ * @param Request The request, without body.
+ * @param Part The part, with its name, file name and content type.
+ * @return The sink, or null to skip the part.
+*/
+DECLARE_DELEGATE_RetVal_TwoParams(FHttpServerUploadSinkPtr, FHttpServerMultipartSinkFactory, const FBlueprintHttpRequest& /* Request */, const FHttpServerMultipartPart& /* Part */);
+
+/**
+ * Delegate called once all the parts of a multipart upload were received.
+ * @param Request The request, without body.
+ * @param Parts The parts, in the order they were sent.
+ * @param Response The response object we will send to the client.
+*/
+DECLARE_DELEGATE_ThreeParams(FHttpServerMultipartCallback, const FBlueprintHttpRequest& /* Request */, const TArray<FHttpServerMultipartPart>& /* Parts */, FBlueprintHttpResponse& /* Response */);
+
 /**
  * An HTTP(S) request.
  **/
@@ -55,6 +421,9 @@ private:
 	// Constructs a valid HttpResponse
 	FBlueprintHttpRequest(const httplib::Request* const	InternalRequest);
 
+	// Constructs a valid HttpRequest reading from an immutable snapshot.
+	FBlueprintHttpRequest(TSharedRef<const FBlueprintHttpRequestSnapshot, ESPMode::ThreadSafe> InSnapshot);
+
 public:
 	// Constructs an invalid HttpRequest.
 	FBlueprintHttpRequest() = default;
@@ -95,6 +464,52 @@ public:
 	*/
 	FString GetBody() const;
 
+	/**
+	 * Gets the request's raw body, without any conversion.
+	 * Use it for binary uploads.
+	 * @return A copy of the body bytes.
+	*/
+	TArray<uint8> GetBodyBytes() const;
+
+	/**
+	 * Gets a view on the request's raw body, without copying it.
+	 * For a snapshot request, the view stays valid as long as this request
+	 * or one of its copies is alive. Otherwise it is valid until the response is sent.
+	 * @return A view on the body bytes.
+	*/
+	TArrayView<const uint8> GetBodyView() const;
+
+	/**
+	 * Gets the request's body as UTF-8, without transcoding it.
+	 * Same lifetime as GetBodyView().
+	 * @return A view on the body.
+	*/
+	FUtf8StringView GetBodyUtf8() const;
+
+	/**
+	 * Gets a single header matching the key, without transcoding it.
+	 * Same lifetime as GetBodyView().
+	 * @param HeaderKey The key of the header to get, case insensitive.
+	 * @return A view on the header value, empty if not found.
+	*/
+	FUtf8StringView GetHeaderUtf8(const FUtf8StringView HeaderKey) const;
+
+	/**
+	 * Gets an URL parameter, without transcoding it.
+	 * Same lifetime as GetBodyView().
+	 * @param Name The name of the parameter.
+	 * @return A view on the parameter value, empty if not found.
+	*/
+	FUtf8StringView GetUrlParameterUtf8(const FUtf8StringView Name) const;
+
+	/**
+	 * Gets a path parameter captured by a radix router route, without transcoding it.
+	 * Same lifetime as GetBodyView().
+	 * @param Name The name of the parameter, as written in the route pattern.
+	 * @return A view on the parameter value, empty if not found.
+	*/
+	FUtf8StringView GetPathParameterUtf8(const FUtf8StringView Name) const;
+
 	/**
 	 * Checks if the URL contains the specified parameter.
 	 * @param Name The name of the parameter.
@@ -109,6 +524,22 @@ public:
 	*/
 	FString GetUrlParameter(const FString& Name) const;
 
+	/**
+	 * Checks if the route captured the specified path parameter.
+	 * Only routes added with the radix router capture path parameters.
+	 * @param Name The name of the parameter, as written in the route pattern.
+	 * @return True if the parameter was captured.
+	*/
+	bool HasPathParameter(const FString& Name) const;
+
+	/**
+	 * Gets a path parameter, e.g. "id" for the route /drone/:id.
+	 * Only routes added with the radix router capture path parameters.
+	 * @param Name The name of the parameter, as written in the route pattern.
+	 * @return The value of the parameter.
+	*/
+	FString GetPathParameter(const FString& Name) const;
+
 	/**
 	 * Get the request's remote address.
 	 * @return The request's remote address.
@@ -127,8 +558,18 @@ public:
 	*/
 	FString GetVerb() const;
 
+	/**
+	 * Checks if the request was captured as an immutable snapshot.
+	 * Snapshot requests are read without locking and stay readable
+	 * after the response has been sent.
+	 * @return True if this request reads from a snapshot.
+	*/
+	bool IsSnapshot() const;
+
 private:
 	TSharedPtr<FBlueprintHttpRequestInternal<const httplib::Request>, ESPMode::ThreadSafe> Internal;
+
+	TSharedPtr<const FBlueprintHttpRequestSnapshot, ESPMode::ThreadSafe> Snapshot;
 };
 
 /**
@@ -173,6 +614,16 @@ public:
 	void SetContent(const FString& Content, const FString& MimeType);
 	void SetContent(const TArray<uint8>& Content, const FString& MimeType);
 
+	/**
+	 * Set the response's content to a file, read from disk as it is sent.
+	 * Only the requested parts are read for Range requests, and the file gets
+	 * the same ETag and Last-Modified as mounted files so downloads can be resumed.
+	 * @param FilePath	The file to send.
+	 * @param MimeType	The response's Mime-Type.
+	 * @return False if the file couldn't be opened.
+	*/
+	bool SetContentFromFile(const FString& FilePath, const FString& MimeType);
+
 	/**
 	 * Appends a string to the current body content.
 	 * @param Body What to append to the body.
@@ -342,10 +793,26 @@ public:
 	*/
 	UBlueprintHttpServer* Options(const FString& Path, FHttpServerRouteCallback Callback, const bool bRequireGameThread = false);
 
+	/**
+	 * Removes the listeners added on a path, upload listeners included.
+	 * Routes can be added and removed while the server is running: the route
+	 * tables are copied on change and swapped in, requests never wait for it.
+	 * Requests already dispatched to the route complete.
+	 * @param Verb The route's verb.
+	 * @param Path The path the route was added with.
+	 * @return If a route was removed.
+	*/
+	bool RemoveRoute(const EHttpServerVerb Verb, const FString& Path);
+
 	/**
 	 * Adds a path to where we serve files. The search is applied
 	 * according to calls of this function.
 	 * You should call the primary mounting points first.
+	 * Files are memory mapped rather than read, and sent with sendfile() on Linux.
+	 * Responses carry an ETag and Last-Modified so clients revalidate with a 304.
+	 * Range requests are answered with the requested parts only, and If-Range
+	 * lets interrupted downloads resume as long as the file didn't change.
+	 * Can be called while the server is running.
 	 * @param UrlPath  The URL to reach the folder to mount.
 	 * @param DiskPath The path on the disk of the folder to mount.
 	 * @param DefaultHeaders The default headers added for this point.
@@ -355,6 +822,7 @@ public:
 
 	/**
 	 * Removes a path to where we serve files.
+	 * Can be called while the server is running.
 	 * @param UrlPath  The URL to reach the folder to mount.
 	 * @return If the operation succeeded.
 	*/
@@ -368,6 +836,39 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Http|Server")
 	void SetFileExtensionAndMimeTypeMapping(const FString& Extension, const FString& MimeType);
 
+	/**
+	 * Sets which responses are gzipped for clients accepting it.
+	 * Bodies set with SetBody()/SetContent() are compressed at once, streamed
+	 * content is deflated as it is written and sent chunked. Responses that
+	 * already have a Content-Encoding or answer a Range request are sent as-is.
+	 * By default, all the text, JSON, JavaScript and XML responses are compressed.
+	 * @param bEnabled	   If responses should be compressed at all.
+	 * @param MimeTypes	   The content types to compress, "text/*" matches all text types.
+	 *					   Empty for the default types.
+	 * @param MinSizeBytes Smaller bodies aren't worth compressing.
+	 * @param Level		   The zlib level, from 1 (fastest) to 9 (smallest).
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server")
+	void SetResponseCompression(const bool bEnabled, const TArray<FString>& MimeTypes, const int32 MinSizeBytes = 1024, const int32 Level = 6);
+
+	/**
+	 * Caches the files served by the mount points in memory.
+	 * Modified files are reloaded, and compressible files (text, JS, JSON, SVG...)
+	 * are gzipped once when loaded and sent compressed to clients accepting gzip.
+	 * The least recently used files are evicted to stay within the budget.
+	 * @param MaxSizeMegabytes	   The memory budget of the cache.
+	 * @param MaxFileSizeKilobytes Larger files are streamed from disk instead.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server")
+	void EnableAssetCache(const int32 MaxSizeMegabytes = 64, const int32 MaxFileSizeKilobytes = 4096);
+
+	/**
+	 * Gets the hit rate and memory use of the asset cache.
+	 * @return The statistics, all zero if the cache isn't enabled.
+	*/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Http|Server")
+	UPARAM(DisplayName = "Stats") FHttpServerAssetCacheStats GetAssetCacheStats() const;
+
 	/**
 	 * Start the server. After calling this method, your server is ready
 	 * to serve the routes and the directories mounted previously.
@@ -412,6 +913,15 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Http|Server")
 	void SetHttpThreadPoolSize(const int32 ThreadPoolSize);
 
+	/**
+	 * Sets the queue and the thread count used by the HTTP(S) server.
+	 * Takes effect the next time the server listens.
+	 * @param QueueType   The queue implementation.
+	 * @param ThreadCount The number of worker threads.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server")
+	void SetHttpTaskQueue(const EHttpServerTaskQueue QueueType, const int32 ThreadCount);
+
 	/**
 	 * The maximum seconds we wait before sending a response to a client
 	 * if the Send() method of the response hasn't been called.
@@ -419,6 +929,310 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Http|Server")
 	void SetMaxWaitingDelayForResponse(const float SecondsToWait);
 
+	/**
+	 * If requests should be copied once into an immutable snapshot
+	 * before calling the route callbacks. Getters on a snapshot request
+	 * don't lock and the request can be kept after the response is sent.
+	 * Only affects routes added after this call.
+	 * @param bEnabled If requests should be snapshotted.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server")
+	void SetUseRequestSnapshots(const bool bEnabled);
+
+	/**
+	 * If responses should be deferred instead of blocking a worker thread
+	 * until Send() is called. The worker is released as soon as the callback
+	 * is dispatched and the response is written when Send() is called, or
+	 * after the max waiting delay. Callbacks always receive request snapshots.
+	 * Has no effect on HTTPS servers, or when the max waiting delay is 0.
+	 * Only affects routes added after this call.
+	 * @param bEnabled If responses should be deferred.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server")
+	void SetUseDeferredResponses(const bool bEnabled);
+
+	/**
+	 * If routes should be matched by a radix tree instead of httplib's regexes.
+	 * Route patterns then support named parameters (/drone/:id), typed
+	 * parameters (/drone/:id<int>, :id<uint>) and trailing wildcards (/files/*path),
+	 * but not regexes. Radix routes are matched before regex routes.
+	 * Only affects routes added after this call.
+	 * @param bEnabled If the radix router should be used.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server")
+	void SetUseRadixRouter(const bool bEnabled);
+
+	/**
+	 * If the server should run on an epoll event loop instead of a thread
+	 * per connection. A few I/O threads wait on all sockets and hand complete
+	 * requests to the HTTP thread pool, so idle keep-alive connections don't
+	 * hold a thread. Linux only, ignored on other platforms and by HTTPS servers.
+	 * Takes effect on the next call to Listen().
+	 * @param bEnabled		If the event loop should be used.
+	 * @param IoThreadCount The number of I/O threads.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server")
+	void SetUseEventLoop(const bool bEnabled, const int32 IoThreadCount = 2);
+
+	/**
+	 * If the request line and headers should be read at once into a buffer
+	 * kept by each connection and parsed in place, instead of being read byte
+	 * per byte and copied into strings. Typical requests are then parsed
+	 * without allocating. Ignored by HTTPS servers and the event loop.
+	 * @param bEnabled If headers should be parsed in place.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server")
+	void SetUseBufferedHeaderParsing(const bool bEnabled);
+
+	/**
+	 * The number of listening sockets opened on the port with SO_REUSEPORT.
+	 * Each accepts connections on its own thread and serves them with its own
+	 * HTTP thread pool, the kernel spreads the connections over them so a
+	 * single accept loop doesn't limit the connection rate.
+	 * Opt-in: the server keeps a single acceptor unless this is set. Only raise it
+	 * once HttpServer.BenchmarkAcceptors shows a gain on the target machine, each
+	 * acceptor adds a thread pool.
+	 * Linux only. Windows has no SO_REUSEPORT and its SO_REUSEADDR lets another
+	 * socket take over the port rather than share it, so other platforms always
+	 * use a single acceptor, as does a server whose extra sockets fail to bind.
+	 * Ignored by the event loop, which accepts on all its I/O threads.
+	 * @param Count The number of acceptors, 1 by default.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server")
+	void SetAcceptorCount(const int32 Count);
+
+	/**
+	 * Starts recording request metrics and serves them in Prometheus text format.
+	 * Records request counts and latency histograms per route (total, task queue
+	 * wait and game thread wait), status codes, in-flight requests, task queue
+	 * depth, bytes in and out and compression time. Each thread records into its own counters,
+	 * merged when scraped, so it is cheap enough to stay on in production.
+	 * Must be called before Listen(). Only routes added after this call are measured.
+	 * @param Path The route serving the metrics.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server")
+	void EnableMetrics(const FString& Path = TEXT("/metrics"));
+
+	/**
+	 * Adds an upload route whose body is streamed to a sink as it arrives instead of
+	 * being buffered in the request, so memory stays flat whatever the payload size.
+	 * The sink is created and written on the HTTP worker, the callback is then called
+	 * like the one of a regular route. Multipart bodies are written as is.
+	 * With the event loop, bodies are still buffered by the I/O threads.
+	 * @param Verb The verb of the route: POST, PUT, PATCH or DELETE.
+	 * @param Path The route path.
+	 * @param SinkFactory Creates the sink of each upload.
+	 * @param Callback Called once the body was received.
+	 * @param bRequireGameThread If we should run the callback on game thread.
+	 * @return The server to chain methods call.
+	*/
+	UBlueprintHttpServer* AddUploadListener(const EHttpServerVerb Verb, const FString& Path, FHttpServerUploadSinkFactory SinkFactory, FHttpServerUploadCallback Callback, const bool bRequireGameThread = false);
+
+	/**
+	 * Adds an upload route whose bodies are streamed to new files in a directory.
+	 * The sink received by the callback is an FHttpServerFileUploadSink,
+	 * the callback owns the file once called.
+	 * @param Verb The verb of the route: POST, PUT, PATCH or DELETE.
+	 * @param Path The route path.
+	 * @param Directory Where the files are created, with unique names.
+	 * @param Callback Called once the body was written.
+	 * @param bRequireGameThread If we should run the callback on game thread.
+	 * @return The server to chain methods call.
+	*/
+	UBlueprintHttpServer* AddFileUploadListener(const EHttpServerVerb Verb, const FString& Path, const FString& Directory, FHttpServerUploadCallback Callback, const bool bRequireGameThread = false);
+
+	/**
+	 * Adds a multipart/form-data upload route parsed as the body arrives.
+	 * Each file part is streamed to a sink of its own, regular fields are kept in their part.
+	 * Bodies that aren't multipart are answered with 415, malformed ones with 400
+	 * and fields larger than 64 KB or bodies of more than 256 parts with 413.
+	 * With the event loop, bodies are still buffered by the I/O threads.
+	 * @param Verb The verb of the route: POST, PUT, PATCH or DELETE.
+	 * @param Path The route path.
+	 * @param SinkFactory Creates the sink of each file part.
+	 * @param Callback Called once all the parts were received.
+	 * @param bRequireGameThread If we should run the callback on game thread.
+	 * @return The server to chain methods call.
+	*/
+	UBlueprintHttpServer* AddMultipartUploadListener(const EHttpServerVerb Verb, const FString& Path, FHttpServerMultipartSinkFactory SinkFactory, FHttpServerMultipartCallback Callback, const bool bRequireGameThread = false);
+
+	/**
+	 * Adds a multipart/form-data upload route whose file parts are streamed to new files in a directory.
+	 * The files are set in FilePath, the callback owns them once called.
+	 * @param Verb The verb of the route: POST, PUT, PATCH or DELETE.
+	 * @param Path The route path.
+	 * @param Directory Where the files are created, with unique names.
+	 * @param Callback Called once all the parts were received.
+	 * @param bRequireGameThread If we should run the callback on game thread.
+	 * @return The server to chain methods call.
+	*/
+	UBlueprintHttpServer* AddMultipartFileUploadListener(const EHttpServerVerb Verb, const FString& Path, const FString& Directory, FHttpServerMultipartCallback Callback, const bool bRequireGameThread = false);
+
+	/**
+	 * Accepts WebSocket connections on a path.
+	 * All connections are served by a single thread once upgraded, they don't hold an HTTP worker.
+	 * Events received meanwhile are delivered together, so a busy connection costs one
+	 * callback per frame on the game thread instead of one per message.
+	 * Not available on HTTPS servers nor with the event loop, the upgrade is answered with 501.
+	 * @param Path The path of the upgrade requests.
+	 * @param Callback Receives the connection events and messages.
+	 * @param bRequireGameThread If the callback runs on the game thread, otherwise on the WebSocket thread.
+	*/
+	void AddWebSocketListener(const FString& Path, FHttpServerWebSocketCallback Callback, const bool bRequireGameThread = false);
+
+	/**
+	 * Sends a text message to a WebSocket connection. Thread safe.
+	 * @param ConnectionId The connection.
+	 * @param Text The message.
+	 * @return False if the connection is closed.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server|WebSocket")
+	bool SendWebSocketText(const int64 ConnectionId, const FString& Text);
+
+	/**
+	 * Sends a binary message to a WebSocket connection. Thread safe.
+	 * @param ConnectionId The connection.
+	 * @param Data The message.
+	 * @return False if the connection is closed.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server|WebSocket")
+	bool SendWebSocketBinary(const int64 ConnectionId, const TArray<uint8>& Data);
+
+	/**
+	 * Closes a WebSocket connection once its queued messages are sent.
+	 * @param ConnectionId The connection.
+	 * @param StatusCode The close status sent to the client.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server|WebSocket")
+	void CloseWebSocket(const int64 ConnectionId, const int32 StatusCode = 1000);
+
+	/**
+	 * Subscribes a WebSocket connection to the broadcasts of a channel.
+	 * Subscriptions are dropped when the connection closes.
+	 * @param ConnectionId The connection.
+	 * @param Channel The channel.
+	 * @return False if the connection is closed.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server|WebSocket")
+	bool SubscribeWebSocket(const int64 ConnectionId, const FString& Channel);
+
+	/**
+	 * Unsubscribes a WebSocket connection from a channel.
+	 * @param ConnectionId The connection.
+	 * @param Channel The channel.
+	 * @return False if the connection wasn't subscribed.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server|WebSocket")
+	bool UnsubscribeWebSocket(const int64 ConnectionId, const FString& Channel);
+
+	/**
+	 * Sends a text message to the connections subscribed to a channel.
+	 * The frame is encoded once and shared by all connections. Thread safe.
+	 * @param Channel The channel, or empty for all open connections.
+	 * @param Text The message.
+	 * @return The number of connections the message was queued for.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server|WebSocket")
+	int32 BroadcastWebSocketText(const FString& Channel, const FString& Text);
+
+	/**
+	 * Sends a binary message to the connections subscribed to a channel.
+	 * The frame is encoded once and shared by all connections. Thread safe.
+	 * @param Channel The channel, or empty for all open connections.
+	 * @param Data The message.
+	 * @return The number of connections the message was queued for.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server|WebSocket")
+	int32 BroadcastWebSocketBinary(const FString& Channel, const TArray<uint8>& Data);
+
+	/**
+	 * Gets the number of open WebSocket connections.
+	*/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Http|Server|WebSocket")
+	UPARAM(DisplayName = "Count") int32 GetWebSocketConnectionCount() const;
+
+	/**
+	 * Streams topics to Server-Sent Events subscribers (EventSource) on a path.
+	 * Subscribers receive the latest event of each topic when they connect, then the new ones.
+	 * All subscribers are written by a single thread, they don't hold an HTTP worker.
+	 * Not available on HTTPS servers nor with the event loop, the request is answered with 501.
+	 * @param Path The path of the stream.
+	 * @param Topics The topics sent to the subscribers, as the event names.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server|Events")
+	void AddEventStream(const FString& Path, const TArray<FString>& Topics);
+
+	/**
+	 * Publishes the state of a topic to its event stream subscribers, usually once per tick.
+	 * The event is serialized once and shared, so the cost doesn't depend on the number
+	 * of subscribers. A subscriber still writing an older event skips to the latest one.
+	 * @param Topic The topic.
+	 * @param Data The event data, sent as one data field per line.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server|Events")
+	void PublishEvent(const FString& Topic, const FString& Data);
+
+	/**
+	 * Same as PublishEvent(), with data already UTF-8 encoded.
+	*/
+	void PublishEventUtf8(const FString& Topic, const FUtf8StringView Data);
+
+	/**
+	 * Gets the number of connected event stream subscribers.
+	*/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Http|Server|Events")
+	UPARAM(DisplayName = "Count") int32 GetEventStreamSubscriberCount() const;
+
+	/**
+	 * Limits the rate of requests of each client on the paths starting with a prefix.
+	 * Each client gets a token bucket refilled at the given rate, requests without a
+	 * token are answered with 429 and a Retry-After header before their body is read
+	 * or their callback is dispatched. A request is limited by the rule with the longest
+	 * matching prefix, a rule replaces the previous one with the same prefix.
+	 * Must be called before Listen().
+	 * @param PathPrefix		The route class, "/" for all requests.
+	 * @param RequestsPerSecond The sustained rate allowed per client.
+	 * @param Burst				The requests a client can make at once after being idle.
+	 * @param Key				What identifies a client.
+	 * @param HeaderName		The header identifying a client, if the key uses one.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server")
+	void AddRateLimit(const FString& PathPrefix, const float RequestsPerSecond, const int32 Burst = 10,
+		const EHttpServerRateLimitKey Key = EHttpServerRateLimitKey::RemoteAddress, const FString& HeaderName = TEXT(""));
+
+	/**
+	 * Caps the requests handled by route callbacks at once, whether they wait for a
+	 * worker, the game thread or their response. Requests over the cap are answered
+	 * right away with 503 and a Retry-After header. Uploads count from before their
+	 * body is read, refused ones are never written. A game thread callback counts
+	 * until it ran, even if its response timed out. Can be changed while running.
+	 * @param MaxRequests The max requests in flight, 0 for no limit.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server")
+	void SetMaxInFlightRequests(const int32 MaxRequests);
+
+	/**
+	 * Gets the rejection counters of the rate limits and the in-flight cap.
+	*/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Http|Server")
+	UPARAM(DisplayName = "Stats") FHttpServerRateLimitStats GetRateLimitStats() const;
+
+	/**
+	 * Sets the time spent each frame running the route callbacks requiring
+	 * the game thread, shared by all servers. Callbacks over budget run on the
+	 * next frames. Same as the HttpServer.GameThreadBudgetMs console variable.
+	 * @param BudgetMilliseconds The budget, in milliseconds.
+	*/
+	UFUNCTION(BlueprintCallable, Category = "Http|Server")
+	static void SetGameThreadDispatchBudget(const float BudgetMilliseconds);
+
+	/**
+	 * Gets the statistics of the route callbacks run on the game thread.
+	 * @return The statistics, shared by all servers.
+	*/
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Http|Server")
+	static UPARAM(DisplayName = "Stats") FHttpGameThreadDispatchStats GetGameThreadDispatchStats();
+
 protected:
 	/**
 	 * Raw Http server pointer.
@@ -436,5 +1250,86 @@ private:
 	 * sending it.
 	*/
 	float MaxSecondWaitTimeout;
+
+	/**
+	 * If route callbacks receive immutable request snapshots.
+	*/
+	bool bUseRequestSnapshots;
+
+	/**
+	 * If responses are deferred instead of blocking a worker.
+	*/
+	bool bUseDeferredResponses;
+
+	/**
+	 * Deadlines of deferred responses, created with the first deferred route.
+	*/
+	TSharedPtr<FBlueprintHttpTimerWheel, ESPMode::ThreadSafe> DeferredDeadlines;
+
+	/**
+	 * Gets the deadlines for a new route, null if responses aren't deferred.
+	*/
+	TSharedPtr<FBlueprintHttpTimerWheel, ESPMode::ThreadSafe> GetDeferredDeadlines();
+
+	/**
+	 * If new routes are added to the radix router.
+	*/
+	bool bUseRadixRouter;
+
+	/**
+	 * The radix router, created with the first radix route.
+	*/
+	TSharedPtr<FBlueprintHttpRouter, ESPMode::ThreadSafe> Router;
+
+	/**
+	 * Adds a route to the radix router or to httplib.
+	 * @return False if the radix router refused the route, the reason is logged.
+	*/
+	bool AddRouteListener(const EHttpServerVerb Verb, const FString& Path, FHttpServerRouteCallback& Callback, const bool bRequireGameThread);
+
+	/**
+	 * If the next Listen() starts an epoll event loop.
+	*/
+	bool bUseEventLoop;
+
+	/**
+	 * The number of I/O threads of the event loop.
+	*/
+	int32 EventLoopThreadCount;
+
+	/**
+	 * The number of SO_REUSEPORT acceptors.
+	*/
+	int32 AcceptorCount;
+
+	/**
+	 * The event loop, while listening with it.
+	*/
+	TSharedPtr<FBlueprintHttpEpollServer, ESPMode::ThreadSafe> EventLoop;
+
+	/**
+	 * The request metrics, null until EnableMetrics() is called.
+	*/
+	TSharedPtr<FBlueprintHttpMetrics, ESPMode::ThreadSafe> Metrics;
+
+	/**
+	 * The cache of mounted files, null until EnableAssetCache() is called.
+	*/
+	TSharedPtr<FBlueprintHttpAssetCache, ESPMode::ThreadSafe> AssetCache;
+
+	/**
+	 * The WebSocket connections, created with the first WebSocket listener.
+	*/
+	TSharedPtr<FBlueprintHttpWebSocketHub, ESPMode::ThreadSafe> WebSockets;
+
+	/**
+	 * The event stream subscribers, created with the first event stream.
+	*/
+	TSharedPtr<FBlueprintHttpEventStreamHub, ESPMode::ThreadSafe> EventStreams;
+
+	/**
+	 * The rate limits and the in-flight cap, shared with the route handlers.
+	*/
+	TSharedRef<FBlueprintHttpRateLimiter, ESPMode::ThreadSafe> RateLimiter;
 };
 
@@ -72,6 +72,10 @@ DECLARE_LOG_CATEGORY_CLASS(LogHttpLib, Log, All);
 #define CPPHTTPLIB_PAYLOAD_MAX_LENGTH ((std::numeric_limits<size_t>::max)())
 #endif
 
+#ifndef CPPHTTPLIB_RANGE_MAX_COUNT
+#define CPPHTTPLIB_RANGE_MAX_COUNT 1024
+#endif
+
 #ifndef CPPHTTPLIB_TCP_NODELAY
 #define CPPHTTPLIB_TCP_NODELAY false
 #endif
@@ -80,6 +84,18 @@ DECLARE_LOG_CATEGORY_CLASS(LogHttpLib, Log, All);
 #define CPPHTTPLIB_RECV_BUFSIZ size_t(4096u)
 #endif
 
+#ifndef CPPHTTPLIB_HEADER_BUFSIZ
+#define CPPHTTPLIB_HEADER_BUFSIZ CPPHTTPLIB_RECV_BUFSIZ
+#endif
+
+#ifndef CPPHTTPLIB_HEADER_MAX_LENGTH
+#define CPPHTTPLIB_HEADER_MAX_LENGTH size_t(65536u)
+#endif
+
+#ifndef CPPHTTPLIB_HEADER_VIEW_COUNT
+#define CPPHTTPLIB_HEADER_VIEW_COUNT 32
+#endif
+
 #ifndef CPPHTTPLIB_COMPRESSION_BUFSIZ
 #define CPPHTTPLIB_COMPRESSION_BUFSIZ size_t(16384u)
 #endif
@@ -177,7 +193,11 @@ using socket_t = SOCKET;
 #endif
 #include <csignal>
 #include <pthread.h>
+#include <sys/mman.h>
 #include <sys/select.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 #include <sys/socket.h>
 #include <unistd.h>
 
@@ -190,6 +210,7 @@ using socket_t = int;
 #include <atomic>
 #include <cassert>
 #include <cctype>
+#include <chrono>
 #include <climits>
 #include <condition_variable>
 #include <errno.h>
@@ -206,8 +227,10 @@ using socket_t = int;
 #include <regex>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <sys/stat.h>
 #include <thread>
+#include <unordered_map>
 
 #ifdef CPPHTTPLIB_OPENSSL_SUPPORT
 #include <openssl/err.h>
@@ -301,10 +324,113 @@ struct ci {
   }
 };
 
+// Publishes a value read by many threads and replaced by a few. Readers
+// neither lock nor touch a reference count, they only count themselves in
+// the current epoch. A replaced value is freed by a later publish(), or with
+// the epoch_ptr, once the readers of its epoch and of the one before left.
+// Writers must be serialized by the caller.
+template <typename T> class epoch_ptr {
+public:
+  // Keeps the value it read alive while in scope.
+  class reader {
+  public:
+    reader(const reader &) = delete;
+    reader &operator=(const reader &) = delete;
+
+    reader(reader &&other)
+        : owner_(other.owner_), epoch_(other.epoch_), value_(other.value_) {
+      other.owner_ = nullptr;
+    }
+
+    ~reader() {
+      if (owner_) { owner_->readers_[epoch_ & 1].fetch_sub(1); }
+    }
+
+    const T &operator*() const { return *value_; }
+    const T *operator->() const { return value_; }
+
+  private:
+    friend class epoch_ptr;
+
+    explicit reader(const epoch_ptr &owner) : owner_(&owner) {
+      for (;;) {
+        epoch_ = owner.epoch_.load();
+        owner.readers_[epoch_ & 1].fetch_add(1);
+        // Counted in an epoch a writer may have checked already, retry.
+        if (owner.epoch_.load() == epoch_) { break; }
+        owner.readers_[epoch_ & 1].fetch_sub(1);
+      }
+      value_ = owner.value_.load();
+    }
+
+    const epoch_ptr *owner_;
+    unsigned epoch_;
+    const T *value_;
+  };
+
+  explicit epoch_ptr(std::unique_ptr<const T> value)
+      : value_(value.release()), epoch_(0) {
+    readers_[0].store(0);
+    readers_[1].store(0);
+  }
+
+  // No reader may be left.
+  ~epoch_ptr() { delete value_.load(); }
+
+  epoch_ptr(const epoch_ptr &) = delete;
+  epoch_ptr &operator=(const epoch_ptr &) = delete;
+
+  reader read() const { return reader(*this); }
+
+  // The value a writer replaces.
+  const T &current() const { return *value_.load(); }
+
+  void publish(std::unique_ptr<const T> value) {
+    retired_.emplace_back(
+        std::unique_ptr<const T>(value_.exchange(value.release())),
+        epoch_.load());
+
+    // The next epoch starts once no reader is left from the previous one,
+    // its counter is then reused. Readers are never older than the epoch
+    // before the current one.
+    for (auto i = 0; i < 2; i++) {
+      auto epoch = epoch_.load();
+      if (readers_[(epoch + 1) & 1].load() != 0) { break; }
+      epoch_.store(epoch + 1);
+    }
+
+    // Values replaced two epochs ago can't be read anymore.
+    auto epoch = epoch_.load();
+    retired_.erase(
+        std::remove_if(retired_.begin(), retired_.end(),
+                       [&](const std::pair<std::unique_ptr<const T>,
+                                           unsigned> &retired) {
+                         return epoch - retired.second >= 2;
+                       }),
+        retired_.end());
+  }
+
+private:
+  std::atomic<const T *> value_;
+  std::atomic<unsigned> epoch_;
+  mutable std::atomic<size_t> readers_[2];
+  std::vector<std::pair<std::unique_ptr<const T>, unsigned>> retired_;
+};
+
+enum class EncodingType;
+class compressor;
+class header_buffer;
+
 } // namespace detail
 
 using Headers = std::multimap<std::string, std::string, detail::ci>;
 
+// A header parsed in place, both strings are NUL terminated.
+struct HeaderView {
+  std::string_view key;
+  std::string_view value;
+};
+
 using Params = std::multimap<std::string, std::string>;
 using Match = std::smatch;
 
@@ -334,6 +460,9 @@ public:
   std::function<void(const char *data, size_t data_len)> write;
   std::function<void()> done;
   std::function<bool()> is_writable;
+  // Set when the data can go straight from a file to the socket. Returns false
+  // if the stream can't send files, in which case nothing was written.
+  std::function<bool(int fd, size_t offset, size_t length)> send_file;
   std::ostream os;
 
 private:
@@ -412,6 +541,7 @@ struct Request {
   MultipartFormDataMap files;
   Ranges ranges;
   Match matches;
+  std::unordered_map<std::string, std::string> path_params;
 
   // for client
   ResponseHandler response_handler;
@@ -425,9 +555,13 @@ struct Request {
   std::string get_header_value(const char *key, size_t id = 0) const;
   template <typename T>
   T get_header_value(const char *key, size_t id = 0) const;
+  // Valid as long as the request, empty if there is no such header.
+  std::string_view get_header_value_view(const char *key, size_t id = 0) const;
   size_t get_header_value_count(const char *key) const;
   void set_header(const char *key, const char *val);
   void set_header(const char *key, const std::string &val);
+  // Calls fn(std::string_view key, std::string_view value) for each header.
+  template <typename T> void for_each_header(T fn) const;
 
   bool has_param(const char *key) const;
   std::string get_param_value(const char *key, size_t id = 0) const;
@@ -444,6 +578,11 @@ struct Request {
   ContentProvider content_provider_;
   bool is_chunked_content_provider_ = false;
   size_t authorization_count_ = 0;
+  bool content_unread_ = false;
+  // Headers parsed in place in the connection buffer, looked up before
+  // `headers`. See Server::set_buffered_header_parsing().
+  const HeaderView *header_views_ = nullptr;
+  size_t header_view_count_ = 0;
 };
 
 struct Response {
@@ -490,11 +629,27 @@ struct Response {
     }
   }
 
+  // Releases the worker thread once the handler returns. The returned
+  // function writes the final response and resumes the connection, it must
+  // be called once, from any thread. Returns an empty function if the
+  // connection can't be deferred (SSL).
+  std::function<void(Response &)> defer();
+
+  // Takes the connection over once the handler returns: the status line and
+  // headers are written without a body, then the socket is passed to handler,
+  // which must close it. Answered 501 instead when the connection can't be
+  // taken over (SSL, external event loops).
+  void upgrade(std::function<void(socket_t sock)> handler);
+
   // private members...
   size_t content_length_ = 0;
   ContentProvider content_provider_;
   std::function<void()> content_provider_resource_releaser_;
   bool is_chunked_content_provider_ = false;
+  // How the server compresses the content provider's output.
+  detail::EncodingType content_provider_encoding_{};
+  std::function<std::function<void(Response &)>()> defer_handler_;
+  std::function<void(socket_t)> upgrade_handler_;
 };
 
 class Stream {
@@ -509,6 +664,17 @@ public:
   virtual void get_remote_ip_and_port(std::string &ip, int &port) const = 0;
   virtual socket_t socket() const = 0;
 
+  // Writes a range of an open file without copying it to user space.
+  // Returns -1 without writing anything if the stream doesn't support it,
+  // otherwise the number of bytes written, less than size on error.
+  virtual ssize_t send_file(int /*fd*/, size_t /*offset*/, size_t /*size*/) {
+    return -1;
+  }
+
+  // Reads without consuming, a later read() returns the same bytes.
+  // Returns -1 if the stream doesn't support it.
+  virtual ssize_t peek(char * /*ptr*/, size_t /*size*/) { return -1; }
+
   template <typename... Args>
   ssize_t write_format(const char *fmt, const Args &... args);
   ssize_t write(const char *ptr);
@@ -638,6 +804,36 @@ public:
   using Expect100ContinueHandler =
       std::function<int(const Request &, Response &)>;
 
+  using DispatchHandler =
+      std::function<HandlerResponse(Request &, Response &)>;
+
+  struct FileInfo {
+    const std::string &path;
+    size_t size;
+    time_t mtime;
+    const char *content_type;
+  };
+  // Returns true if it set the content of the response.
+  using FileContentHandler =
+      std::function<bool(const Request &, Response &, const FileInfo &)>;
+
+  struct CompressionPolicy {
+    bool enabled = true;
+    // Smaller bodies are sent as-is. Ignored for chunked content providers,
+    // whose length isn't known.
+    size_t min_size = 0;
+    // Content types to compress, "text/*" matches a whole type. When empty,
+    // the types detail::can_compress_content_type accepts.
+    std::vector<std::string> mime_types;
+    // zlib level, -1 for its default.
+    int level = -1;
+  };
+
+  // Called once a response body was compressed, with the time spent in the
+  // compressor only.
+  using CompressionLogger = std::function<void(
+      size_t in_length, size_t out_length, std::chrono::nanoseconds elapsed)>;
+
   Server();
 
   virtual ~Server();
@@ -673,18 +869,27 @@ public:
   bool set_mount_point(const char *mount_point, const char *dir,
                        Headers headers = Headers());
   bool remove_mount_point(const char *mount_point);
+  // Removes the handlers registered with this exact pattern for the method,
+  // content reader ones included. "GET" also covers HEAD requests.
+  bool remove_route(const char *method, const char *pattern);
   Server &set_file_extension_and_mimetype_mapping(const char *ext,
                                                   const char *mime);
   Server &set_file_request_handler(Handler handler);
+  // Called before a mounted file is opened, to serve it from elsewhere.
+  Server &set_file_content_handler(FileContentHandler handler);
 
   Server &set_error_handler(HandlerWithResponse handler);
   Server &set_error_handler(Handler handler);
   Server &set_exception_handler(ExceptionHandler handler);
   Server &set_pre_routing_handler(HandlerWithResponse handler);
   Server &set_post_routing_handler(Handler handler);
+  // Called once the body is read, before the pattern handlers.
+  Server &set_pre_dispatch_handler(DispatchHandler handler);
 
   Server &set_expect_100_continue_handler(Expect100ContinueHandler handler);
   Server &set_logger(Logger logger);
+  Server &set_compression_policy(CompressionPolicy policy);
+  Server &set_compression_logger(CompressionLogger logger);
 
   Server &set_tcp_nodelay(bool on);
   Server &set_socket_options(SocketOptions socket_options);
@@ -697,6 +902,26 @@ public:
 
   Server &set_payload_max_length(size_t length);
 
+  // Reads the request line and headers of a connection at once into a
+  // buffer reused by its requests, and parses the headers in place instead
+  // of copying them into `Request::headers`. Handlers must then read them
+  // with the Request accessors, they are only valid while the request is
+  // handled. Requests of HTTPS and external event loops aren't affected.
+  Server &set_buffered_header_parsing(bool on);
+
+  // Binds this many listening sockets to the address with SO_REUSEPORT,
+  // each accepting on its own thread into its own task queue, so the kernel
+  // spreads the connections over them. Opt-in, a single socket and accept
+  // loop by default.
+  // Linux only: Windows has no SO_REUSEPORT, and its SO_REUSEADDR lets
+  // sockets steal the port instead of sharing it, which is why listening
+  // sockets set SO_EXCLUSIVEADDRUSE there. BSD and macOS don't spread the
+  // connections over SO_REUSEPORT sockets. The count is ignored elsewhere.
+  Server &set_acceptor_count(size_t count);
+  // The acceptors bound by the last bind, valid on the thread that binds and
+  // listens. Can be lower than the count set if the port couldn't be shared.
+  size_t bound_acceptor_count() const;
+
   bool bind_to_port(const char *host, int port, int socket_flags = 0);
   int bind_to_any_port(const char *host, int socket_flags = 0);
   bool listen_after_bind();
@@ -708,10 +933,34 @@ public:
 
   std::function<TaskQueue *(void)> new_task_queue;
 
+  // External event loops (e.g. epoll) read requests themselves and hand
+  // them over one at a time instead of calling listen(). Deferred responses
+  // are resumed on `task_queue`, pass nullptr once the loop is stopped.
+  void set_external_task_queue(TaskQueue *task_queue);
+
+  // Processes exactly one request read by an external event loop. The
+  // serialized response is passed to `done`, before returning or later from
+  // the external task queue for deferred responses.
+  // Returns false if the connection must be closed after the response.
+  bool process_external_request(const char *data, size_t size,
+                                const std::string &remote_addr,
+                                int remote_port, bool close_connection,
+                                std::function<void(std::string &&)> done);
+
+  size_t get_keep_alive_max_count() const;
+  time_t get_keep_alive_timeout() const;
+  size_t get_payload_max_length() const;
+
 protected:
   bool process_request(Stream &strm, bool close_connection,
                        bool &connection_closed,
                        const std::function<void(Request &)> &setup_request);
+  bool process_request(Stream &strm, bool close_connection,
+                       bool &connection_closed,
+                       const std::function<void(Request &)> &setup_request,
+                       size_t keep_alive_remaining, bool *detached,
+                       const std::function<void(std::string &&)> &external_done,
+                       detail::header_buffer *header_buf);
 
   std::atomic<socket_t> svr_sock_;
   size_t keep_alive_max_count_ = CPPHTTPLIB_KEEPALIVE_MAX_COUNT;
@@ -725,25 +974,63 @@ protected:
   size_t payload_max_length_ = CPPHTTPLIB_PAYLOAD_MAX_LENGTH;
 
 private:
-  using Handlers = std::vector<std::pair<std::regex, Handler>>;
-  using HandlersForContentReader =
-      std::vector<std::pair<std::regex, HandlerWithContentReader>>;
+  template <typename T> struct Route {
+    std::string pattern;
+    std::regex regex;
+    T handler;
+  };
+  using Handlers = std::vector<Route<Handler>>;
+  using HandlersForContentReader = std::vector<Route<HandlerWithContentReader>>;
+
+  struct MountPointEntry {
+    std::string mount_point;
+    std::string base_dir;
+    Headers headers;
+  };
+
+  // Routes and mount points are never modified in place. Writers copy the
+  // table, change the copy and publish it, readers keep the current one for
+  // the whole request. Routes can then be added and removed while the server
+  // is running, requests read the table without locking (see epoch_ptr).
+  struct RouteTable {
+    std::vector<MountPointEntry> base_dirs;
+    Handlers get_handlers;
+    Handlers post_handlers;
+    HandlersForContentReader post_handlers_for_content_reader;
+    Handlers put_handlers;
+    HandlersForContentReader put_handlers_for_content_reader;
+    Handlers patch_handlers;
+    HandlersForContentReader patch_handlers_for_content_reader;
+    Handlers delete_handlers;
+    HandlersForContentReader delete_handlers_for_content_reader;
+    Handlers options_handlers;
+  };
+
+  detail::epoch_ptr<RouteTable>::reader route_table() const;
+  template <typename Fn> void update_route_table(Fn fn);
+  template <typename T>
+  void add_route(std::vector<Route<T>> RouteTable::*handlers,
+                 const char *pattern, size_t pattern_len, T handler);
+  template <typename T>
+  static bool erase_routes(std::vector<Route<T>> &handlers,
+                           const char *pattern);
 
   socket_t create_server_socket(const char *host, int port, int socket_flags,
                                 SocketOptions socket_options) const;
   int bind_internal(const char *host, int port, int socket_flags);
   bool listen_internal();
+  void accept_connections(socket_t sock);
 
   bool routing(Request &req, Response &res, Stream &strm);
-  bool handle_file_request(const Request &req, Response &res,
-                           bool head = false);
+  bool handle_file_request(const RouteTable &routes, const Request &req,
+                           Response &res, bool head = false);
   bool dispatch_request(Request &req, Response &res, const Handlers &handlers);
   bool
   dispatch_request_for_content_reader(Request &req, Response &res,
                                       ContentReader content_reader,
                                       const HandlersForContentReader &handlers);
 
-  bool parse_request_line(const char *s, Request &req);
+  void resolve_ranges(Request &req, Response &res);
   void apply_ranges(const Request &req, Response &res,
                     std::string &content_type, std::string &boundary);
   bool write_response(Stream &strm, bool close_connection, const Request &req,
@@ -756,6 +1043,14 @@ private:
   bool write_content_with_provider(Stream &strm, const Request &req,
                                    Response &res, const std::string &boundary,
                                    const std::string &content_type);
+  // Picks how to compress a response under the compression policy.
+  // length is 0 when unknown. negotiated is set if the choice depends on
+  // the request's Accept-Encoding.
+  detail::EncodingType compression_type(const Request &req,
+                                        const Response &res, size_t length,
+                                        bool &negotiated) const;
+  std::unique_ptr<detail::compressor>
+  make_compressor(detail::EncodingType type) const;
   bool read_content(Stream &strm, Request &req, Response &res);
   bool
   read_content_with_content_receiver(Stream &strm, Request &req, Response &res,
@@ -769,35 +1064,49 @@ private:
 
   virtual bool process_and_close_socket(socket_t sock);
 
-  struct MountPointEntry {
-    std::string mount_point;
-    std::string base_dir;
-    Headers headers;
+  // Deferred responses
+  struct DeferredConnection;
+  struct DeferredExecutor {
+    std::mutex mutex;
+    Server *server = nullptr;
+    TaskQueue *task_queue = nullptr;
   };
-  std::vector<MountPointEntry> base_dirs_;
+
+  bool process_socket(socket_t sock, size_t keep_alive_count);
+  void resume_deferred(const std::shared_ptr<DeferredConnection> &conn);
+  static void send_deferred(const std::weak_ptr<DeferredExecutor> &executor,
+                            const std::shared_ptr<DeferredConnection> &conn,
+                            Response &res);
+
+  std::shared_ptr<DeferredExecutor> deferred_executor_;
+
+  detail::epoch_ptr<RouteTable> route_table_;
+  // Serializes the writers.
+  std::mutex route_table_mutex_;
 
   std::atomic<bool> is_running_;
+  std::atomic<bool> is_external_running_;
   std::map<std::string, std::string> file_extension_and_mimetype_map_;
   Handler file_request_handler_;
-  Handlers get_handlers_;
-  Handlers post_handlers_;
-  HandlersForContentReader post_handlers_for_content_reader_;
-  Handlers put_handlers_;
-  HandlersForContentReader put_handlers_for_content_reader_;
-  Handlers patch_handlers_;
-  HandlersForContentReader patch_handlers_for_content_reader_;
-  Handlers delete_handlers_;
-  HandlersForContentReader delete_handlers_for_content_reader_;
-  Handlers options_handlers_;
+  FileContentHandler file_content_handler_;
   HandlerWithResponse error_handler_;
   ExceptionHandler exception_handler_;
   HandlerWithResponse pre_routing_handler_;
   Handler post_routing_handler_;
+  DispatchHandler pre_dispatch_handler_;
   Logger logger_;
+  CompressionPolicy compression_policy_;
+  CompressionLogger compression_logger_;
   Expect100ContinueHandler expect_100_continue_handler_;
 
   bool tcp_nodelay_ = CPPHTTPLIB_TCP_NODELAY;
   SocketOptions socket_options_ = default_socket_options;
+  bool buffered_header_parsing_ = false;
+
+  size_t acceptor_count_ = 1;
+  // The listening sockets of the acceptors after the first one, owned by
+  // the thread that binds and listens.
+  std::vector<socket_t> reuse_port_socks_;
 };
 
 enum Error {
@@ -1671,20 +1980,193 @@ inline std::string decode_url(const std::string &s,
   return result;
 }
 
-inline void read_file(const std::string &path, std::string &out) {
-  std::ifstream fs(path, std::ios_base::binary);
-  fs.seekg(0, std::ios_base::end);
-  auto size = fs.tellg();
-  fs.seekg(0);
-  out.resize(static_cast<size_t>(size));
-  fs.read(&out[0], static_cast<std::streamsize>(size));
+// Read-only view of a whole file, mapped instead of read so large files
+// don't have to fit in memory.
+class mmap {
+public:
+  explicit mmap(const char *path) { open(path); }
+  ~mmap() { close(); }
+
+  mmap(const mmap &) = delete;
+  mmap &operator=(const mmap &) = delete;
+
+  bool is_open() const { return is_open_; }
+  size_t size() const { return size_; }
+  const char *data() const { return static_cast<const char *>(addr_); }
+
+  // The descriptor of the file, -1 on Windows.
+  int fd() const {
+#ifdef _WIN32
+    return -1;
+#else
+    return fd_;
+#endif
+  }
+
+private:
+  bool open(const char *path) {
+#ifdef _WIN32
+    hFile_ = ::CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile_ == INVALID_HANDLE_VALUE) { return false; }
+
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(hFile_, &size)) { return false; }
+    size_ = static_cast<size_t>(size.QuadPart);
+
+    // Empty files can't be mapped.
+    if (size_ > 0) {
+      hMapping_ =
+          ::CreateFileMappingA(hFile_, NULL, PAGE_READONLY, 0, 0, NULL);
+      if (hMapping_ == NULL) { return false; }
+
+      addr_ = ::MapViewOfFile(hMapping_, FILE_MAP_READ, 0, 0, 0);
+      if (addr_ == nullptr) { return false; }
+    }
+#else
+    fd_ = ::open(path, O_RDONLY);
+    if (fd_ == -1) { return false; }
+
+    struct stat st;
+    if (fstat(fd_, &st) == -1) { return false; }
+    size_ = static_cast<size_t>(st.st_size);
+
+    if (size_ > 0) {
+      addr_ = ::mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+      if (addr_ == MAP_FAILED) {
+        addr_ = nullptr;
+        return false;
+      }
+    }
+#endif
+    is_open_ = true;
+    return true;
+  }
+
+  void close() {
+#ifdef _WIN32
+    if (addr_) { ::UnmapViewOfFile(addr_); }
+    if (hMapping_) { ::CloseHandle(hMapping_); }
+    if (hFile_ != INVALID_HANDLE_VALUE) { ::CloseHandle(hFile_); }
+#else
+    if (addr_) { ::munmap(addr_, size_); }
+    if (fd_ != -1) { ::close(fd_); }
+#endif
+  }
+
+#ifdef _WIN32
+  HANDLE hFile_ = INVALID_HANDLE_VALUE;
+  HANDLE hMapping_ = NULL;
+#else
+  int fd_ = -1;
+#endif
+  size_t size_ = 0;
+  void *addr_ = nullptr;
+  bool is_open_ = false;
+};
+
+inline bool get_file_info(const std::string &path, size_t &size,
+                          time_t &mtime) {
+  struct stat st;
+  if (stat(path.c_str(), &st) < 0 || !S_ISREG(st.st_mode)) { return false; }
+  size = static_cast<size_t>(st.st_size);
+  mtime = st.st_mtime;
+  return true;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date.
+inline int64_t days_from_civil(int64_t y, int64_t m, int64_t d) {
+  y -= m <= 2;
+  const auto era = (y >= 0 ? y : y - 399) / 400;
+  const auto yoe = y - era * 400;
+  const auto doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const auto doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+static const char *const http_date_days[] = {"Thu", "Fri", "Sat", "Sun",
+                                             "Mon", "Tue", "Wed"};
+static const char *const http_date_months[] = {"Jan", "Feb", "Mar", "Apr",
+                                               "May", "Jun", "Jul", "Aug",
+                                               "Sep", "Oct", "Nov", "Dec"};
+
+// Formats an IMF-fixdate, e.g. "Sun, 06 Nov 1994 08:49:37 GMT".
+inline std::string format_http_date(time_t t) {
+  auto secs = static_cast<int64_t>(t);
+  auto days = secs / 86400;
+  auto rem = secs % 86400;
+  if (rem < 0) {
+    rem += 86400;
+    days -= 1;
+  }
+
+  // civil_from_days
+  const auto z = days + 719468;
+  const auto era = (z >= 0 ? z : z - 146096) / 146097;
+  const auto doe = z - era * 146097;
+  const auto yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const auto doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const auto mp = (5 * doy + 2) / 153;
+  const auto d = doy - (153 * mp + 2) / 5 + 1;
+  const auto m = mp < 10 ? mp + 3 : mp - 9;
+  const auto y = yoe + era * 400 + (m <= 2);
+
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%s, %02d %s %04d %02d:%02d:%02d GMT",
+           http_date_days[((days % 7) + 7) % 7], static_cast<int>(d),
+           http_date_months[m - 1], static_cast<int>(y),
+           static_cast<int>(rem / 3600), static_cast<int>(rem / 60 % 60),
+           static_cast<int>(rem % 60));
+  return buf;
+}
+
+// Parses an IMF-fixdate. Obsolete formats are rejected, in which case the
+// condition using the date is ignored as RFC 7232 allows.
+inline bool parse_http_date(const std::string &s, time_t &t) {
+  char wday[4] = {}, mon[4] = {};
+  int d = 0, y = 0, hh = 0, mm = 0, ss = 0;
+  if (sscanf(s.c_str(), "%3s, %d %3s %d %d:%d:%d GMT", wday, &d, mon, &y, &hh,
+             &mm, &ss) != 7) {
+    return false;
+  }
+
+  int m = 0;
+  while (m < 12 && strcmp(mon, http_date_months[m])) {
+    m++;
+  }
+  if (m == 12 || d < 1 || d > 31 || hh > 23 || mm > 59 || ss > 60) {
+    return false;
+  }
+
+  t = static_cast<time_t>(days_from_civil(y, m + 1, d) * 86400 + hh * 3600 +
+                          mm * 60 + ss);
+  return true;
+}
+
+inline bool is_alnum(char c) {
+  return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') ||
+         ('0' <= c && c <= '9');
+}
+
+inline std::string make_file_etag(size_t size, time_t mtime) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "\"%llx-%llx\"",
+           static_cast<unsigned long long>(mtime),
+           static_cast<unsigned long long>(size));
+  return buf;
 }
 
+// The alphanumeric characters after the last dot, if nothing else follows.
 inline std::string file_extension(const std::string &path) {
-  std::smatch m;
-  static auto re = std::regex("\\.([a-zA-Z0-9]+)$");
-  if (std::regex_search(path, m, re)) { return m[1].str(); }
-  return std::string();
+  auto i = path.size();
+  while (i > 0 && is_alnum(path[i - 1])) {
+    i--;
+  }
+
+  if (i == path.size() || i == 0 || path[i - 1] != '.') {
+    return std::string();
+  }
+  return path.substr(i);
 }
 
 inline bool is_space_or_tab(char c) { return c == ' ' || c == '\t'; }
@@ -1724,6 +2206,120 @@ template <class Fn> void split(const char *b, const char *e, char d, Fn fn) {
   }
 }
 
+// Weak comparison of an If-None-Match list against an entity tag, or the
+// tags of its encoded variants (see make_encoded_etag). coding is set to the
+// coding of the variant matched, if it isn't the entity tag itself.
+inline bool etag_matches(const std::string &header, const std::string &etag,
+                         const char **coding = nullptr) {
+  static const char *codings[] = {"gzip", "br"};
+
+  auto tag = etag.compare(0, 2, "W/") ? etag : etag.substr(2);
+
+  auto matched = false;
+  split(header.data(), header.data() + header.size(), ',',
+        [&](const char *b, const char *e) {
+          if (e - b == 1 && *b == '*') { matched = true; }
+          if (e - b > 2 && b[0] == 'W' && b[1] == '/') { b += 2; }
+          auto len = static_cast<size_t>(e - b);
+          if (len == tag.size() && !tag.compare(0, tag.size(), b, len)) {
+            matched = true;
+            return;
+          }
+
+          // "tag-coding"
+          if (tag.size() < 2 || len <= tag.size() || b[len - 1] != '"' ||
+              b[tag.size() - 1] != '-' ||
+              tag.compare(0, tag.size() - 1, b, tag.size() - 1)) {
+            return;
+          }
+          for (auto c : codings) {
+            auto n = strlen(c);
+            if (len == tag.size() + n + 1 && !strncmp(b + tag.size(), c, n)) {
+              matched = true;
+              if (coding) { *coding = c; }
+            }
+          }
+        });
+  return matched;
+}
+
+// If an Accept-Encoding value accepts a coding, honouring q=0 and "*".
+inline bool accepts_encoding(const std::string &header, const char *coding) {
+  auto length = strlen(coding);
+  auto listed = false;
+  auto accepted = false;
+  auto wildcard = false;
+
+  split(header.data(), header.data() + header.size(), ',',
+        [&](const char *b, const char *e) {
+          auto name_end = std::find(b, e, ';');
+          while (name_end > b && is_space_or_tab(name_end[-1])) {
+            name_end--;
+          }
+
+          auto q = 1.0;
+          static const char q_key[] = "q=";
+          auto it = std::search(name_end, e, q_key, q_key + 2);
+          if (it != e) { q = std::strtod(std::string(it + 2, e).c_str(), nullptr); }
+
+          auto n = static_cast<size_t>(name_end - b);
+          if (n == 1 && *b == '*') {
+            wildcard = q > 0;
+          } else if (n == length) {
+            size_t i = 0;
+            while (i < n && ::tolower(b[i]) == ::tolower(coding[i])) {
+              i++;
+            }
+            if (i == n) {
+              listed = true;
+              accepted = q > 0;
+            }
+          }
+        });
+
+  return listed ? accepted : wildcard;
+}
+
+// An encoded representation gets a weak tag of its own, "x" becomes
+// W/"x-gzip", which no weak comparison matches with the original.
+inline void make_encoded_etag(Response &res, const char *coding) {
+  auto etag = res.get_header_value("ETag");
+  if (!etag.compare(0, 2, "W/")) { etag.erase(0, 2); }
+  if (etag.size() < 2 || etag.back() != '"') { return; }
+
+  etag.insert(etag.size() - 1, std::string("-") + coding);
+  res.headers.erase("ETag");
+  res.set_header("ETag", "W/" + etag);
+}
+
+// Lists a request header in Vary, once.
+inline void add_vary(Response &res, const char *field) {
+  std::string vary;
+  auto range = res.headers.equal_range("Vary");
+  for (auto it = range.first; it != range.second; ++it) {
+    if (!vary.empty()) { vary += ", "; }
+    vary += it->second;
+  }
+
+  auto listed = false;
+  auto len = strlen(field);
+  split(vary.data(), vary.data() + vary.size(), ',',
+        [&](const char *b, const char *e) {
+          if ((e - b == 1 && *b == '*') ||
+              (static_cast<size_t>(e - b) == len &&
+               std::equal(b, e, field, [](char c1, char c2) {
+                 return ::tolower(c1) == ::tolower(c2);
+               }))) {
+            listed = true;
+          }
+        });
+  if (listed) { return; }
+
+  res.headers.erase("Vary");
+  res.set_header("Vary",
+                 vary.empty() ? std::string(field) : vary + ", " + field);
+}
+
 // NOTE: until the read size reaches `fixed_buffer_size`, use `fixed_buffer`
 // to store data. The call can set memory on stack for performance.
 class stream_line_reader {
@@ -1800,6 +2396,53 @@ private:
   std::string glowable_buffer_;
 };
 
+// Holds the request line and headers of the requests of a connection. They
+// are peeked and read at once, without consuming what follows the blank
+// line, and the headers are parsed in place into views so that a typical
+// request is parsed without allocating.
+// NOTE: until the headers exceed `CPPHTTPLIB_HEADER_BUFSIZ` bytes and
+// `CPPHTTPLIB_HEADER_VIEW_COUNT` headers, only fixed buffers are used.
+class header_buffer {
+public:
+  header_buffer() = default;
+  header_buffer(const header_buffer &) = delete;
+  header_buffer &operator=(const header_buffer &) = delete;
+
+  // Reads up to the blank line, the stream must support peek().
+  bool read(Stream &strm);
+
+  // If the last read failed because of `CPPHTTPLIB_HEADER_MAX_LENGTH`.
+  bool exceeded() const { return exceeded_; }
+
+  // The size of the request line, line break included.
+  size_t request_line_size() const;
+
+  // Parses the request line and the headers read. The header views of the
+  // request are valid until the next read.
+  bool parse(Request &req);
+
+  // Adds a header after the ones read. The key must outlive the request.
+  // Returns false if it doesn't fit, it must be set on the request instead.
+  bool add_header(Request &req, const char *key, const std::string &val);
+
+private:
+  bool grow();
+  size_t find_end_of_headers(size_t from, size_t to) const;
+  void parse_header(char *beg, char *end, Request &req);
+  void add_view(Request &req, std::string_view key, std::string_view val);
+
+  char fixed_buffer_[CPPHTTPLIB_HEADER_BUFSIZ];
+  std::string glowable_buffer_;
+  char *data_ = fixed_buffer_;
+  size_t capacity_ = CPPHTTPLIB_HEADER_BUFSIZ;
+  size_t size_ = 0;
+  bool exceeded_ = false;
+
+  HeaderView fixed_views_[CPPHTTPLIB_HEADER_VIEW_COUNT];
+  std::vector<HeaderView> glowable_views_;
+  size_t view_count_ = 0;
+};
+
 inline int close_socket(socket_t sock) {
 #ifdef _WIN32
   return closesocket(sock);
@@ -1935,6 +2578,10 @@ public:
   ssize_t write(const char *ptr, size_t size) override;
   void get_remote_ip_and_port(std::string &ip, int &port) const override;
   socket_t socket() const override;
+#ifdef __linux__
+  ssize_t send_file(int fd, size_t offset, size_t size) override;
+#endif
+  ssize_t peek(char *ptr, size_t size) override;
 
 private:
   socket_t sock_;
@@ -1988,6 +2635,33 @@ private:
   size_t position = 0;
 };
 
+// Reads a request already received by an external event loop and collects
+// the response instead of writing it to a socket.
+class ExternalStream : public Stream {
+public:
+  ExternalStream(const char *data, size_t size, const std::string &remote_addr,
+                 int remote_port);
+  ~ExternalStream() override = default;
+
+  bool is_readable() const override;
+  bool is_writable() const override;
+  ssize_t read(char *ptr, size_t size) override;
+  ssize_t write(const char *ptr, size_t size) override;
+  void get_remote_ip_and_port(std::string &ip, int &port) const override;
+  socket_t socket() const override;
+  ssize_t peek(char *ptr, size_t size) override;
+
+  std::string &get_output();
+
+private:
+  const char *data_;
+  size_t size_;
+  size_t position_ = 0;
+  std::string remote_addr_;
+  int remote_port_;
+  std::string output_;
+};
+
 inline bool keep_alive(socket_t sock, time_t keep_alive_timeout_sec) {
   using namespace std::chrono;
   auto start = steady_clock::now();
@@ -2436,40 +3110,41 @@ inline const char *status_message(int status) {
   }
 }
 
-inline bool can_compress_content_type(const std::string &content_type) {
-  return (!content_type.find("text/") && content_type != "text/event-stream") ||
-         content_type == "image/svg+xml" ||
-         content_type == "application/javascript" ||
-         content_type == "application/json" ||
-         content_type == "application/xml" ||
-         content_type == "application/xhtml+xml";
-}
-
-enum class EncodingType { None = 0, Gzip, Brotli };
-
-inline EncodingType encoding_type(const Request &req, const Response &res) {
-  auto ret =
-      detail::can_compress_content_type(res.get_header_value("Content-Type"));
-  if (!ret) { return EncodingType::None; }
-
-  const auto &s = req.get_header_value("Accept-Encoding");
-  (void)(s);
+// Matches a content type against types like "application/json" or "text/*".
+inline bool matches_content_type(const std::vector<std::string> &types,
+                                 const std::string &content_type) {
+  auto end = content_type.find(';');
+  if (end == std::string::npos) { end = content_type.size(); }
+  while (end > 0 && is_space_or_tab(content_type[end - 1])) {
+    end--;
+  }
 
-#ifdef CPPHTTPLIB_BROTLI_SUPPORT
-  // TODO: 'Accept-Encoding' has br, not br;q=0
-  ret = s.find("br") != std::string::npos;
-  if (ret) { return EncodingType::Brotli; }
-#endif
+  for (const auto &type : types) {
+    auto prefix = type.size() >= 2 && !type.compare(type.size() - 2, 2, "/*");
+    auto length = prefix ? type.size() - 1 : type.size();
+    if (prefix ? end <= length : end != length) { continue; }
 
-#ifdef CPPHTTPLIB_ZLIB_SUPPORT
-  // TODO: 'Accept-Encoding' has gzip, not gzip;q=0
-  ret = s.find("gzip") != std::string::npos;
-  if (ret) { return EncodingType::Gzip; }
-#endif
+    size_t i = 0;
+    while (i < length && ::tolower(content_type[i]) == ::tolower(type[i])) {
+      i++;
+    }
+    if (i == length) { return true; }
+  }
+  return false;
+}
 
-  return EncodingType::None;
+// Parameters such as "; charset=utf-8" are ignored.
+inline bool can_compress_content_type(const std::string &content_type) {
+  static const std::vector<std::string> types = {
+      "text/*",           "image/svg+xml",   "application/javascript",
+      "application/json", "application/xml", "application/xhtml+xml"};
+  static const std::vector<std::string> event_stream = {"text/event-stream"};
+  return matches_content_type(types, content_type) &&
+         !matches_content_type(event_stream, content_type);
 }
 
+enum class EncodingType { None = 0, Gzip, Brotli };
+
 class compressor {
 public:
   virtual ~compressor(){};
@@ -2501,16 +3176,50 @@ public:
   }
 };
 
+// Measures another compressor and reports once done with the content.
+class metered_compressor : public compressor {
+public:
+  using Logger = std::function<void(size_t, size_t, std::chrono::nanoseconds)>;
+
+  metered_compressor(std::unique_ptr<compressor> compressor,
+                     const Logger &logger)
+      : compressor_(std::move(compressor)), logger_(logger) {}
+
+  ~metered_compressor() { logger_(in_length_, out_length_, elapsed_); }
+
+  bool compress(const char *data, size_t data_length, bool last,
+                Callback callback) override {
+    in_length_ += data_length;
+
+    // Callbacks only append to a buffer, their time is negligible.
+    auto start = std::chrono::steady_clock::now();
+    auto ret = compressor_->compress(data, data_length, last,
+                                     [&](const char *d, size_t n) {
+                                       out_length_ += n;
+                                       return callback(d, n);
+                                     });
+    elapsed_ += std::chrono::steady_clock::now() - start;
+    return ret;
+  }
+
+private:
+  std::unique_ptr<compressor> compressor_;
+  const Logger &logger_;
+  size_t in_length_ = 0;
+  size_t out_length_ = 0;
+  std::chrono::nanoseconds elapsed_{0};
+};
+
 #ifdef CPPHTTPLIB_ZLIB_SUPPORT
 class gzip_compressor : public compressor {
 public:
-  gzip_compressor() {
+  explicit gzip_compressor(int level = Z_DEFAULT_COMPRESSION) {
     std::memset(&strm_, 0, sizeof(strm_));
     strm_.zalloc = Z_NULL;
     strm_.zfree = Z_NULL;
     strm_.opaque = Z_NULL;
 
-    is_valid_ = deflateInit2(&strm_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 31, 8,
+    is_valid_ = deflateInit2(&strm_, level, Z_DEFLATED, 31, 8,
                              Z_DEFAULT_STRATEGY) == Z_OK;
   }
 
@@ -2719,6 +3428,29 @@ template <typename T>
 inline T get_header_value(const Headers & /*headers*/, const char * /*key*/,
                           size_t /*id*/ = 0, uint64_t /*def*/ = 0) {}
 
+// Finds the id-th view named key. Otherwise decrements id by the number of
+// views named key, so that the lookup can go on in the header map.
+inline const HeaderView *find_header_view(const HeaderView *views,
+                                          size_t count, const char *key,
+                                          size_t &id) {
+  auto len = strlen(key);
+  for (size_t i = 0; i < count; i++) {
+    const auto &view = views[i];
+    if (view.key.size() != len) { continue; }
+
+    size_t j = 0;
+    while (j < len && ::tolower(static_cast<unsigned char>(view.key[j])) ==
+                          ::tolower(static_cast<unsigned char>(key[j]))) {
+      j++;
+    }
+    if (j < len) { continue; }
+
+    if (id == 0) { return &view; }
+    id--;
+  }
+  return nullptr;
+}
+
 template <>
 inline uint64_t get_header_value<uint64_t>(const Headers &headers,
                                            const char *key, size_t id,
@@ -2946,12 +3678,14 @@ bool read_content(Stream &strm, T &x, size_t payload_max_length, int &status,
         auto ret = true;
         auto exceed_payload_max_length = false;
 
-        if (is_chunked_transfer_encoding(x.headers)) {
+        // Through the accessors, the request headers may be views.
+        if (!strcasecmp(x.get_header_value("Transfer-Encoding").c_str(),
+                        "chunked")) {
           ret = read_content_chunked(strm, out);
-        } else if (!has_header(x.headers, "Content-Length")) {
+        } else if (!x.has_header("Content-Length")) {
           ret = read_content_without_length(strm, out);
         } else {
-          auto len = get_header_value<uint64_t>(x.headers, "Content-Length");
+          auto len = x.template get_header_value<uint64_t>("Content-Length");
           if (len > payload_max_length) {
             exceed_payload_max_length = true;
             skip_content_with_length(strm, len);
@@ -3010,6 +3744,18 @@ inline bool write_content(Stream &strm, const ContentProvider &content_provider,
 
   data_sink.is_writable = [&](void) { return ok && strm.is_writable(); };
 
+  data_sink.send_file = [&](int fd, size_t file_offset, size_t l) {
+    if (!ok) { return true; }
+    auto n = strm.send_file(fd, file_offset, l);
+    if (n < 0) { return false; }
+    if (static_cast<size_t>(n) == l) {
+      offset += l;
+    } else {
+      ok = false;
+    }
+    return true;
+  };
+
   while (offset < end_offset && !is_shutting_down()) {
     if (!content_provider(offset, end_offset - offset, data_sink)) {
       error = Error::Canceled;
@@ -3192,8 +3938,9 @@ inline std::string params_to_query_str(const Params &params) {
 
 inline std::string append_query_params(const char *path, const Params &params) {
   std::string path_with_query = path;
-  const static std::regex re("[^?]+\\?.*");
-  auto delm = std::regex_match(path, re) ? '&' : '?';
+  // Appended to the query when the path already has one.
+  auto query = strchr(path, '?');
+  auto delm = query && query != path ? '&' : '?';
   path_with_query += delm + params_to_query_str(params);
   return path_with_query;
 }
@@ -3216,51 +3963,386 @@ inline void parse_query_text(const std::string &s, Params &params) {
   });
 }
 
-inline bool parse_multipart_boundary(const std::string &content_type,
-                                     std::string &boundary) {
-  auto pos = content_type.find("boundary=");
-  if (pos == std::string::npos) { return false; }
-  boundary = content_type.substr(pos + 9);
-  if (boundary.length() >= 2 && boundary.front() == '"' &&
-      boundary.back() == '"') {
-    boundary = boundary.substr(1, boundary.size() - 2);
+// Parses "method target version\r\n", `end` being past the line break.
+inline bool parse_request_line(const char *beg, const char *end,
+                               Request &req) {
+  static const char *const methods[] = {"GET",     "HEAD",    "POST",
+                                        "PUT",     "DELETE",  "CONNECT",
+                                        "OPTIONS", "TRACE",   "PATCH",
+                                        "PRI"};
+  static const size_t version_len = 8; // HTTP/1.x
+
+  if (end - beg < 2 || end[-2] != '\r' || end[-1] != '\n') { return false; }
+  end -= 2;
+  if (memchr(beg, '\0', static_cast<size_t>(end - beg))) { return false; }
+
+  auto method_end = static_cast<const char *>(
+      memchr(beg, ' ', static_cast<size_t>(end - beg)));
+  if (!method_end) { return false; }
+
+  auto method_len = static_cast<size_t>(method_end - beg);
+  auto known = false;
+  for (auto method : methods) {
+    if (strlen(method) == method_len && !strncmp(method, beg, method_len)) {
+      known = true;
+      break;
+    }
   }
-  return !boundary.empty();
-}
+  if (!known) { return false; }
 
-inline bool parse_range_header(const std::string &s, Ranges &ranges) /*try*/ {
-  static auto re_first_range = std::regex(R"(bytes=(\d*-\d*(?:,\s*\d*-\d*)*))");
-  std::smatch m;
-  if (std::regex_match(s, m, re_first_range)) {
-    auto pos = static_cast<size_t>(m.position(1));
-    auto len = static_cast<size_t>(m.length(1));
-    bool all_valid_ranges = true;
-    split(&s[pos], &s[pos + len], ',', [&](const char *b, const char *e) {
-      if (!all_valid_ranges) return;
-      static auto re_another_range = std::regex(R"(\s*(\d*)-(\d*))");
-      std::cmatch cm;
-      if (std::regex_match(b, e, cm, re_another_range)) {
-        ssize_t first = -1;
-        if (!cm.str(1).empty()) {
-          first = static_cast<ssize_t>(std::stoll(cm.str(1)));
-        }
+  auto target = method_end + 1;
+  auto target_end = static_cast<const char *>(
+      memchr(target, ' ', static_cast<size_t>(end - target)));
+  if (!target_end) { return false; }
 
-        ssize_t last = -1;
-        if (!cm.str(2).empty()) {
-          last = static_cast<ssize_t>(std::stoll(cm.str(2)));
-        }
+  auto version = target_end + 1;
+  if (static_cast<size_t>(end - version) != version_len ||
+      strncmp(version, "HTTP/1.", 7) ||
+      (version[7] != '0' && version[7] != '1')) {
+    return false;
+  }
 
-        if (first != -1 && last != -1 && first > last) {
-          all_valid_ranges = false;
-          return;
-        }
-        ranges.emplace_back(std::make_pair(first, last));
-      }
-    });
-    return all_valid_ranges;
+  auto query = static_cast<const char *>(
+      memchr(target, '?', static_cast<size_t>(target_end - target)));
+  auto path_end = query ? query : target_end;
+  if (path_end == target) { return false; }
+
+  req.version.assign(version, version_len);
+  req.method.assign(beg, method_len);
+  req.target.assign(target, target_end);
+  if (memchr(target, '%', static_cast<size_t>(path_end - target))) {
+    req.path = decode_url(std::string(target, path_end), false);
+  } else {
+    req.path.assign(target, path_end);
+  }
+
+  if (query && query + 1 < target_end) {
+    parse_query_text(std::string(query + 1, target_end), req.params);
+  }
+
+  return true;
+}
+
+inline bool header_buffer::read(Stream &strm) {
+  data_ = fixed_buffer_;
+  capacity_ = CPPHTTPLIB_HEADER_BUFSIZ;
+  size_ = 0;
+  view_count_ = 0;
+  exceeded_ = false;
+
+  for (;;) {
+    if (size_ == capacity_ && !grow()) {
+      exceeded_ = true;
+      return false;
+    }
+
+    // What follows the blank line is the body or the next request, only
+    // the bytes up to it are consumed.
+    auto n = strm.peek(data_ + size_, capacity_ - size_);
+    if (n <= 0) { return false; }
+
+    auto len = static_cast<size_t>(n);
+    auto end = find_end_of_headers(size_ < 2 ? 0 : size_ - 2, size_ + len);
+    if (end) { len = end - size_; }
+
+    for (size_t off = 0; off < len;) {
+      auto r = strm.read(data_ + size_ + off, len - off);
+      if (r <= 0) { return false; }
+      off += static_cast<size_t>(r);
+    }
+    size_ += len;
+
+    if (end) { return true; }
+  }
+}
+
+inline size_t header_buffer::request_line_size() const {
+  auto p = static_cast<const char *>(memchr(data_, '\n', size_));
+  return p ? static_cast<size_t>(p - data_) + 1 : size_;
+}
+
+inline bool header_buffer::parse(Request &req) {
+  auto beg = data_ + request_line_size();
+  if (!parse_request_line(data_, beg, req)) { return false; }
+
+  // The block ends with a blank line, each line has a line break.
+  const auto end = data_ + size_;
+  while (beg < end) {
+    auto eol = static_cast<char *>(
+        memchr(beg, '\n', static_cast<size_t>(end - beg)));
+
+    // Skip the lines that don't end with CRLF, a blank line ends the headers.
+    if (eol > beg && eol[-1] == '\r') {
+      if (eol - beg == 1) { break; }
+      parse_header(beg, eol - 1, req);
+    }
+
+    beg = eol + 1;
+  }
+
+  return true;
+}
+
+inline bool header_buffer::add_header(Request &req, const char *key,
+                                      const std::string &val) {
+  if (capacity_ - size_ < val.size() + 1) { return false; }
+
+  auto p = data_ + size_;
+  memcpy(p, val.data(), val.size());
+  p[val.size()] = '\0';
+  size_ += val.size() + 1;
+
+  add_view(req, key, std::string_view(p, val.size()));
+  return true;
+}
+
+inline bool header_buffer::grow() {
+  if (capacity_ >= CPPHTTPLIB_HEADER_MAX_LENGTH) { return false; }
+
+  // Kept by the connection once grown, larger requests are rare.
+  auto capacity = (std::min)(capacity_ * 2, CPPHTTPLIB_HEADER_MAX_LENGTH);
+  if (glowable_buffer_.size() < capacity) { glowable_buffer_.resize(capacity); }
+  if (data_ == fixed_buffer_) {
+    memcpy(&glowable_buffer_[0], fixed_buffer_, size_);
+  }
+
+  data_ = &glowable_buffer_[0];
+  capacity_ = glowable_buffer_.size();
+  return true;
+}
+
+inline size_t header_buffer::find_end_of_headers(size_t from,
+                                                 size_t to) const {
+  auto p = data_ + from;
+  const auto end = data_ + to;
+  while ((p = static_cast<char *>(
+              memchr(p, '\n', static_cast<size_t>(end - p)))) != nullptr) {
+    // The line break of the previous line, then an empty line.
+    if (end - p >= 3 && p[1] == '\r' && p[2] == '\n') {
+      return static_cast<size_t>(p + 3 - data_);
+    }
+    p++;
+  }
+  return 0;
+}
+
+// Same rules as parse_header(), the key and the value are NUL terminated in
+// place of the colon and of the line break.
+inline void header_buffer::parse_header(char *beg, char *end, Request &req) {
+  // Skip trailing spaces and tabs.
+  while (beg < end && is_space_or_tab(end[-1])) {
+    end--;
+  }
+
+  auto p = beg;
+  while (p < end && *p != ':') {
+    p++;
+  }
+
+  if (p == end) { return; }
+
+  auto key_end = p++;
+
+  while (p < end && is_space_or_tab(*p)) {
+    p++;
+  }
+
+  if (p == end) { return; }
+
+  *key_end = '\0';
+  *end = '\0';
+
+  auto len = static_cast<size_t>(end - p);
+
+  // Decoding never makes the value longer.
+  if (memchr(p, '%', len)) {
+    auto val = decode_url(std::string(p, len), false);
+    memcpy(p, val.data(), val.size());
+    p[val.size()] = '\0';
+    len = val.size();
+  }
+
+  add_view(req, std::string_view(beg, static_cast<size_t>(key_end - beg)),
+           std::string_view(p, len));
+}
+
+inline void header_buffer::add_view(Request &req, std::string_view key,
+                                    std::string_view val) {
+  if (view_count_ < CPPHTTPLIB_HEADER_VIEW_COUNT) {
+    fixed_views_[view_count_] = HeaderView{key, val};
+    req.header_views_ = fixed_views_;
+  } else {
+    if (view_count_ == CPPHTTPLIB_HEADER_VIEW_COUNT) {
+      glowable_views_.assign(fixed_views_, fixed_views_ + view_count_);
+    }
+    glowable_views_.push_back(HeaderView{key, val});
+    req.header_views_ = glowable_views_.data();
+  }
+  req.header_view_count_ = ++view_count_;
+}
+
+// Copies the header views into the header map, for a request that outlives
+// its connection buffer.
+inline void own_header_views(Request &req) {
+  for (size_t i = 0; i < req.header_view_count_; i++) {
+    const auto &view = req.header_views_[i];
+    req.headers.emplace(std::string(view.key), std::string(view.value));
+  }
+  req.header_views_ = nullptr;
+  req.header_view_count_ = 0;
+}
+
+inline bool parse_multipart_boundary(const std::string &content_type,
+                                     std::string &boundary) {
+  auto pos = content_type.find("boundary=");
+  if (pos == std::string::npos) { return false; }
+  boundary = content_type.substr(pos + 9);
+  if (boundary.length() >= 2 && boundary.front() == '"' &&
+      boundary.back() == '"') {
+    boundary = boundary.substr(1, boundary.size() - 2);
+  }
+  return !boundary.empty();
+}
+
+// Parses "bytes=" followed by "first-last", "first-" or "-suffix" specs
+// separated by commas, without resolving them against a length.
+inline bool parse_range_header(const std::string &s, Ranges &ranges) {
+  static const char unit[] = "bytes=";
+  const auto unit_len = sizeof(unit) - 1;
+
+  if (s.size() <= unit_len) { return false; }
+  for (size_t i = 0; i < unit_len; i++) {
+    if (::tolower(static_cast<unsigned char>(s[i])) != unit[i]) {
+      return false;
+    }
+  }
+
+  auto p = s.data() + unit_len;
+  const auto end = s.data() + s.size();
+
+  // -1 when there are no digits.
+  auto parse_position = [&](ssize_t &value) {
+    const auto max =
+        static_cast<size_t>((std::numeric_limits<ssize_t>::max)());
+    size_t n = 0;
+    auto digits = p;
+    while (p < end && '0' <= *p && *p <= '9') {
+      auto d = static_cast<size_t>(*p - '0');
+      if (n > (max - d) / 10) { return false; }
+      n = n * 10 + d;
+      p++;
+    }
+    value = p == digits ? -1 : static_cast<ssize_t>(n);
+    return true;
+  };
+
+  Ranges parsed;
+  while (p < end) {
+    while (p < end && is_space_or_tab(*p)) {
+      p++;
+    }
+
+    // Empty list elements are allowed.
+    if (p < end && *p == ',') {
+      p++;
+      continue;
+    }
+
+    ssize_t first = -1;
+    ssize_t last = -1;
+    if (!parse_position(first) || p == end || *p != '-') { return false; }
+    p++;
+    if (!parse_position(last)) { return false; }
+
+    if ((first == -1 && last == -1) ||
+        (first != -1 && last != -1 && first > last)) {
+      return false;
+    }
+    parsed.emplace_back(first, last);
+
+    while (p < end && is_space_or_tab(*p)) {
+      p++;
+    }
+    if (p < end && *p++ != ',') { return false; }
+  }
+
+  if (parsed.empty()) { return false; }
+
+  ranges.insert(ranges.end(), parsed.begin(), parsed.end());
+  return true;
+}
+
+inline bool is_whitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+         c == '\r';
+}
+
+// Matches Content-Disposition: form-data; name="..."[; filename="..."],
+// case-insensitively. The name ends at the first quote the rest can follow.
+// Leaves name and filename as they are if the header doesn't match.
+inline bool parse_content_disposition(const std::string &header,
+                                      std::string &name,
+                                      std::string &filename) {
+  auto p = header.data();
+  auto end = header.data() + header.size();
+
+  // Advances past a lowercase token.
+  auto consume = [&](const char *&it, const char *token) {
+    auto len = strlen(token);
+    if (static_cast<size_t>(end - it) < len) { return false; }
+    for (size_t i = 0; i < len; i++) {
+      if (::tolower(static_cast<unsigned char>(it[i])) != token[i]) {
+        return false;
+      }
+    }
+    it += len;
+    return true;
+  };
+
+  auto skip_space = [&](const char *&it) {
+    while (it < end && is_whitespace(*it)) {
+      it++;
+    }
+  };
+
+  if (!consume(p, "content-disposition:")) { return false; }
+  skip_space(p);
+  if (!consume(p, "form-data;")) { return false; }
+  skip_space(p);
+  if (!consume(p, "name=\"")) { return false; }
+
+  // Spaces are allowed after the closing quote.
+  while (end > p && is_whitespace(end[-1])) {
+    end--;
+  }
+  if (end == p || end[-1] != '"') { return false; }
+
+  for (auto q = p; q < end; q++) {
+    if (*q == '\r' || *q == '\n') { return false; }
+    if (*q != '"') { continue; }
+
+    if (q + 1 == end) {
+      name.assign(p, q);
+      filename.clear();
+      return true;
+    }
+
+    if (q[1] != ';') { continue; }
+
+    auto f = q + 2;
+    skip_space(f);
+    if (!consume(f, "filename=\"") || f == end) { continue; }
+
+    auto line_break = std::find_if(
+        f, end, [](char c) { return c == '\r' || c == '\n'; });
+    if (line_break != end) { continue; }
+
+    name.assign(p, q);
+    filename.assign(f, end - 1);
+    return true;
   }
+
   return false;
-/*} catch (...) { return false; */
 }
 
 class MultipartFormDataParser {
@@ -3273,11 +4355,6 @@ public:
 
   bool parse(const char *buf, size_t n, const ContentReceiver &content_callback,
              const MultipartContentHeader &header_callback) {
-
-    static const std::regex re_content_disposition(
-        "^Content-Disposition:\\s*form-data;\\s*name=\"(.*?)\"(?:;\\s*filename="
-        "\"(.*?)\")?\\s*$",
-        std::regex_constants::icase);
     static const std::string dash_ = "--";
     static const std::string crlf_ = "\r\n";
 
@@ -3320,11 +4397,7 @@ public:
           if (start_with_case_ignore(header, header_name)) {
             file_.content_type = trim_copy(header.substr(header_name.size()));
           } else {
-            std::smatch m;
-            if (std::regex_match(header, m, re_content_disposition)) {
-              file_.name = m[1];
-              file_.filename = m[2];
-            }
+            parse_content_disposition(header, file_.name, file_.filename);
           }
 
           buf_.erase(0, pos + crlf_.size());
@@ -3505,10 +4578,81 @@ get_range_offset_and_length(const Request &req, size_t content_length,
     r.second = slen - 1;
   }
 
-  if (r.second == -1) { r.second = slen - 1; }
+  if (r.second == -1 || r.second >= slen) { r.second = slen - 1; }
   return std::make_pair(r.first, static_cast<size_t>(r.second - r.first) + 1);
 }
 
+// If-Range holds either a strong entity tag or the exact Last-Modified date.
+inline bool if_range_matches(const Request &req, const Response &res) {
+  auto value = req.get_header_value("If-Range");
+
+  if (value.compare(0, 2, "W/") == 0) { return false; }
+
+  if (!value.empty() && value.front() == '"') {
+    auto etag = res.get_header_value("ETag");
+    return !etag.empty() && etag == value;
+  }
+
+  auto last_modified = res.get_header_value("Last-Modified");
+  return !last_modified.empty() && last_modified == value;
+}
+
+// Resolves the requested ranges against the content set by the handler,
+// clamped to it, sorted and coalesced. Unsatisfiable ranges are dropped.
+// Returns false if none is satisfiable.
+inline bool normalize_ranges(Request &req, Response &res) {
+  if (req.ranges.empty()) { return true; }
+
+  auto length = res.body.empty() ? res.content_length_ : res.body.size();
+
+  // Only whole, identity-encoded, successful content is served by ranges.
+  if ((res.status != -1 && res.status != 200) || length == 0 ||
+      res.has_header("Content-Encoding") ||
+      res.get_header_value("Accept-Ranges") == "none" ||
+      (req.has_header("If-Range") && !if_range_matches(req, res))) {
+    req.ranges.clear();
+    return true;
+  }
+
+  if (req.ranges.size() > CPPHTTPLIB_RANGE_MAX_COUNT) { return false; }
+
+  auto slen = static_cast<ssize_t>(length);
+
+  Ranges ranges;
+  for (auto r : req.ranges) {
+    if (r.first == -1) {
+      if (r.second == 0) { continue; }
+      r.first = (std::max)(static_cast<ssize_t>(0), slen - r.second);
+      r.second = slen - 1;
+    } else {
+      if (r.first >= slen) { continue; }
+      if (r.second == -1 || r.second >= slen) { r.second = slen - 1; }
+    }
+    ranges.push_back(r);
+  }
+
+  if (ranges.empty()) {
+    req.ranges.clear();
+    return false;
+  }
+
+  // Overlapping or adjacent ranges are sent once.
+  std::sort(ranges.begin(), ranges.end());
+
+  req.ranges.clear();
+  req.ranges.push_back(ranges.front());
+  for (size_t i = 1; i < ranges.size(); i++) {
+    auto &last = req.ranges.back();
+    if (ranges[i].first <= last.second + 1) {
+      last.second = (std::max)(last.second, ranges[i].second);
+    } else {
+      req.ranges.push_back(ranges[i]);
+    }
+  }
+
+  return true;
+}
+
 inline std::string make_content_range_header_field(size_t offset, size_t length,
                                                    size_t content_length) {
   std::string field = "bytes ";
@@ -3526,6 +4670,8 @@ bool process_multipart_ranges_data(const Request &req, Response &res,
                                    const std::string &content_type,
                                    SToken stoken, CToken ctoken,
                                    Content content) {
+  auto content_length = res.body.empty() ? res.content_length_ : res.body.size();
+
   for (size_t i = 0; i < req.ranges.size(); i++) {
     ctoken("--");
     stoken(boundary);
@@ -3536,12 +4682,12 @@ bool process_multipart_ranges_data(const Request &req, Response &res,
       ctoken("\r\n");
     }
 
-    auto offsets = get_range_offset_and_length(req, res.body.size(), i);
+    auto offsets = get_range_offset_and_length(req, content_length, i);
     auto offset = offsets.first;
     auto length = offsets.second;
 
     ctoken("Content-Range: ");
-    stoken(make_content_range_header_field(offset, length, res.body.size()));
+    stoken(make_content_range_header_field(offset, length, content_length));
     ctoken("\r\n");
     ctoken("\r\n");
     if (!content(offset, length)) { return false; }
@@ -3627,6 +4773,12 @@ inline bool expect_content(const Request &req) {
   return false;
 }
 
+// Whether the request carries a body, whatever its method.
+inline bool has_body(const Request &req) {
+  return req.has_header("Transfer-Encoding") ||
+         req.get_header_value<uint64_t>("Content-Length") > 0;
+}
+
 inline bool has_crlf(const char *s) {
   auto p = s;
   while (*p) {
@@ -3860,21 +5012,56 @@ make_bearer_token_authentication_header(const std::string &token,
 
 // Request implementation
 inline bool Request::has_header(const char *key) const {
-  return detail::has_header(headers, key);
+  size_t id = 0;
+  return detail::find_header_view(header_views_, header_view_count_, key,
+                                  id) ||
+         detail::has_header(headers, key);
 }
 
 inline std::string Request::get_header_value(const char *key, size_t id) const {
-  return detail::get_header_value(headers, key, id, "");
+  return std::string(get_header_value_view(key, id));
 }
 
 template <typename T>
 inline T Request::get_header_value(const char *key, size_t id) const {
+  if (auto view = detail::find_header_view(header_views_, header_view_count_,
+                                           key, id)) {
+    return static_cast<T>(std::strtoull(view->value.data(), nullptr, 10));
+  }
   return detail::get_header_value<T>(headers, key, id, 0);
 }
 
+inline std::string_view Request::get_header_value_view(const char *key,
+                                                       size_t id) const {
+  if (auto view = detail::find_header_view(header_views_, header_view_count_,
+                                           key, id)) {
+    return view->value;
+  }
+
+  auto rng = headers.equal_range(key);
+  auto it = rng.first;
+  std::advance(it, static_cast<ssize_t>(id));
+  if (it != rng.second) { return it->second; }
+  return std::string_view();
+}
+
 inline size_t Request::get_header_value_count(const char *key) const {
+  // No view is found past the last one, id is decremented for each match.
+  auto id = (std::numeric_limits<size_t>::max)();
+  detail::find_header_view(header_views_, header_view_count_, key, id);
+  auto count = (std::numeric_limits<size_t>::max)() - id;
+
   auto r = headers.equal_range(key);
-  return static_cast<size_t>(std::distance(r.first, r.second));
+  return count + static_cast<size_t>(std::distance(r.first, r.second));
+}
+
+template <typename T> inline void Request::for_each_header(T fn) const {
+  for (size_t i = 0; i < header_view_count_; i++) {
+    fn(header_views_[i].key, header_views_[i].value);
+  }
+  for (const auto &header : headers) {
+    fn(std::string_view(header.first), std::string_view(header.second));
+  }
 }
 
 inline void Request::set_header(const char *key, const char *val) {
@@ -4005,6 +5192,17 @@ Response::set_content_provider(const char *content_type,
   is_chunked_content_provider_ = false;
 }
 
+inline std::function<void(Response &)> Response::defer() {
+  if (!defer_handler_) { return nullptr; }
+  auto handler = std::move(defer_handler_);
+  defer_handler_ = nullptr;
+  return handler();
+}
+
+inline void Response::upgrade(std::function<void(socket_t sock)> handler) {
+  upgrade_handler_ = std::move(handler);
+}
+
 inline void Response::set_chunked_content_provider(
     const char *content_type, ContentProviderWithoutLength provider,
     const std::function<void()> &resource_releaser) {
@@ -4114,6 +5312,22 @@ inline ssize_t SocketStream::read(char *ptr, size_t size) {
 #endif
 }
 
+inline ssize_t SocketStream::peek(char *ptr, size_t size) {
+  if (!is_readable()) { return -1; }
+
+#ifdef _WIN32
+  if (size > static_cast<size_t>((std::numeric_limits<int>::max)())) {
+    return -1;
+  }
+  return recv(sock_, ptr, static_cast<int>(size),
+              CPPHTTPLIB_RECV_FLAGS | MSG_PEEK);
+#else
+  return handle_EINTR([&]() {
+    return recv(sock_, ptr, size, CPPHTTPLIB_RECV_FLAGS | MSG_PEEK);
+  });
+#endif
+}
+
 inline ssize_t SocketStream::write(const char *ptr, size_t size) {
   if (!is_writable()) { return -1; }
 
@@ -4128,6 +5342,25 @@ inline ssize_t SocketStream::write(const char *ptr, size_t size) {
 #endif
 }
 
+#ifdef __linux__
+inline ssize_t SocketStream::send_file(int fd, size_t offset, size_t size) {
+  size_t sent = 0;
+  while (sent < size) {
+    if (!is_writable()) { break; }
+
+    auto off = static_cast<off_t>(offset + sent);
+    auto n = handle_EINTR([&]() { return ::sendfile(sock_, fd, &off, size - sent); });
+    if (n <= 0) {
+      // Let the caller fall back to plain writes if nothing went out yet.
+      if (sent == 0 && (errno == EINVAL || errno == ENOSYS)) { return -1; }
+      break;
+    }
+    sent += static_cast<size_t>(n);
+  }
+  return static_cast<ssize_t>(sent);
+}
+#endif
+
 inline void SocketStream::get_remote_ip_and_port(std::string &ip,
                                                  int &port) const {
   return detail::get_remote_ip_and_port(sock_, ip, port);
@@ -4162,13 +5395,56 @@ inline socket_t BufferStream::socket() const { return 0; }
 
 inline const std::string &BufferStream::get_buffer() const { return buffer; }
 
+inline ExternalStream::ExternalStream(const char *data, size_t size,
+                                      const std::string &remote_addr,
+                                      int remote_port)
+    : data_(data), size_(size), remote_addr_(remote_addr),
+      remote_port_(remote_port) {}
+
+inline bool ExternalStream::is_readable() const { return true; }
+
+inline bool ExternalStream::is_writable() const { return true; }
+
+inline ssize_t ExternalStream::read(char *ptr, size_t size) {
+  auto len_read = (std::min)(size, size_ - position_);
+  memcpy(ptr, data_ + position_, len_read);
+  position_ += len_read;
+  return static_cast<ssize_t>(len_read);
+}
+
+inline ssize_t ExternalStream::peek(char *ptr, size_t size) {
+  auto len_read = (std::min)(size, size_ - position_);
+  memcpy(ptr, data_ + position_, len_read);
+  return static_cast<ssize_t>(len_read);
+}
+
+inline ssize_t ExternalStream::write(const char *ptr, size_t size) {
+  output_.append(ptr, size);
+  return static_cast<ssize_t>(size);
+}
+
+inline void ExternalStream::get_remote_ip_and_port(std::string &ip,
+                                                   int &port) const {
+  ip = remote_addr_;
+  port = remote_port_;
+}
+
+inline socket_t ExternalStream::socket() const { return INVALID_SOCKET; }
+
+inline std::string &ExternalStream::get_output() { return output_; }
+
 } // namespace detail
 
 // HTTP server implementation
 inline Server::Server()
     : new_task_queue(
           [] { return new ThreadPool(CPPHTTPLIB_THREAD_POOL_COUNT); }),
-      svr_sock_(INVALID_SOCKET), is_running_(false) {
+      svr_sock_(INVALID_SOCKET),
+      deferred_executor_(std::make_shared<DeferredExecutor>()),
+      route_table_(detail::make_unique<const RouteTable>()),
+      is_running_(false),
+      is_external_running_(false) {
+  deferred_executor_->server = this;
 #ifndef _WIN32
   signal(SIGPIPE, SIG_IGN);
 #endif
@@ -4182,8 +5458,8 @@ inline Server &Server::Get(const char *pattern, Handler handler) {
 
 inline Server &Server::Get(const char *pattern, size_t pattern_len,
                            Handler handler) {
-  get_handlers_.push_back(
-      std::make_pair(std::regex(pattern, pattern_len), std::move(handler)));
+  add_route(&RouteTable::get_handlers, pattern, pattern_len,
+            std::move(handler));
   return *this;
 }
 
@@ -4193,8 +5469,8 @@ inline Server &Server::Post(const char *pattern, Handler handler) {
 
 inline Server &Server::Post(const char *pattern, size_t pattern_len,
                             Handler handler) {
-  post_handlers_.push_back(
-      std::make_pair(std::regex(pattern, pattern_len), std::move(handler)));
+  add_route(&RouteTable::post_handlers, pattern, pattern_len,
+            std::move(handler));
   return *this;
 }
 
@@ -4205,8 +5481,8 @@ inline Server &Server::Post(const char *pattern,
 
 inline Server &Server::Post(const char *pattern, size_t pattern_len,
                             HandlerWithContentReader handler) {
-  post_handlers_for_content_reader_.push_back(
-      std::make_pair(std::regex(pattern, pattern_len), std::move(handler)));
+  add_route(&RouteTable::post_handlers_for_content_reader, pattern, pattern_len,
+            std::move(handler));
   return *this;
 }
 
@@ -4216,8 +5492,8 @@ inline Server &Server::Put(const char *pattern, Handler handler) {
 
 inline Server &Server::Put(const char *pattern, size_t pattern_len,
                            Handler handler) {
-  put_handlers_.push_back(
-      std::make_pair(std::regex(pattern, pattern_len), std::move(handler)));
+  add_route(&RouteTable::put_handlers, pattern, pattern_len,
+            std::move(handler));
   return *this;
 }
 
@@ -4228,8 +5504,8 @@ inline Server &Server::Put(const char *pattern,
 
 inline Server &Server::Put(const char *pattern, size_t pattern_len,
                            HandlerWithContentReader handler) {
-  put_handlers_for_content_reader_.push_back(
-      std::make_pair(std::regex(pattern, pattern_len), std::move(handler)));
+  add_route(&RouteTable::put_handlers_for_content_reader, pattern, pattern_len,
+            std::move(handler));
   return *this;
 }
 
@@ -4239,8 +5515,8 @@ inline Server &Server::Patch(const char *pattern, Handler handler) {
 
 inline Server &Server::Patch(const char *pattern, size_t pattern_len,
                              Handler handler) {
-  patch_handlers_.push_back(
-      std::make_pair(std::regex(pattern, pattern_len), std::move(handler)));
+  add_route(&RouteTable::patch_handlers, pattern, pattern_len,
+            std::move(handler));
   return *this;
 }
 
@@ -4251,8 +5527,8 @@ inline Server &Server::Patch(const char *pattern,
 
 inline Server &Server::Patch(const char *pattern, size_t pattern_len,
                              HandlerWithContentReader handler) {
-  patch_handlers_for_content_reader_.push_back(
-      std::make_pair(std::regex(pattern, pattern_len), std::move(handler)));
+  add_route(&RouteTable::patch_handlers_for_content_reader, pattern,
+            pattern_len, std::move(handler));
   return *this;
 }
 
@@ -4262,8 +5538,8 @@ inline Server &Server::Delete(const char *pattern, Handler handler) {
 
 inline Server &Server::Delete(const char *pattern, size_t pattern_len,
                               Handler handler) {
-  delete_handlers_.push_back(
-      std::make_pair(std::regex(pattern, pattern_len), std::move(handler)));
+  add_route(&RouteTable::delete_handlers, pattern, pattern_len,
+            std::move(handler));
   return *this;
 }
 
@@ -4274,8 +5550,8 @@ inline Server &Server::Delete(const char *pattern,
 
 inline Server &Server::Delete(const char *pattern, size_t pattern_len,
                               HandlerWithContentReader handler) {
-  delete_handlers_for_content_reader_.push_back(
-      std::make_pair(std::regex(pattern, pattern_len), std::move(handler)));
+  add_route(&RouteTable::delete_handlers_for_content_reader, pattern,
+            pattern_len, std::move(handler));
   return *this;
 }
 
@@ -4285,8 +5561,8 @@ inline Server &Server::Options(const char *pattern, Handler handler) {
 
 inline Server &Server::Options(const char *pattern, size_t pattern_len,
                                Handler handler) {
-  options_handlers_.push_back(
-      std::make_pair(std::regex(pattern, pattern_len), std::move(handler)));
+  add_route(&RouteTable::options_handlers, pattern, pattern_len,
+            std::move(handler));
   return *this;
 }
 
@@ -4299,7 +5575,9 @@ inline bool Server::set_mount_point(const char *mount_point, const char *dir,
   if (detail::is_dir(dir)) {
     std::string mnt = mount_point ? mount_point : "/";
     if (!mnt.empty() && mnt[0] == '/') {
-      base_dirs_.push_back({mnt, dir, std::move(headers)});
+      update_route_table([&](RouteTable &routes) {
+        routes.base_dirs.push_back({mnt, dir, std::move(headers)});
+      });
       return true;
     }
   }
@@ -4307,27 +5585,99 @@ inline bool Server::set_mount_point(const char *mount_point, const char *dir,
 }
 
 inline bool Server::remove_mount_point(const char *mount_point) {
-  for (auto it = base_dirs_.begin(); it != base_dirs_.end(); ++it) {
-    if (it->mount_point == mount_point) {
-      base_dirs_.erase(it);
-      return true;
+  auto ret = false;
+  update_route_table([&](RouteTable &routes) {
+    for (auto it = routes.base_dirs.begin(); it != routes.base_dirs.end();
+         ++it) {
+      if (it->mount_point == mount_point) {
+        routes.base_dirs.erase(it);
+        ret = true;
+        return;
+      }
     }
-  }
-  return false;
+  });
+  return ret;
 }
 
-inline Server &
-Server::set_file_extension_and_mimetype_mapping(const char *ext,
-                                                const char *mime) {
-  file_extension_and_mimetype_map_[ext] = mime;
-
-  return *this;
+inline bool Server::remove_route(const char *method, const char *pattern) {
+  auto ret = false;
+  std::string m = method;
+  update_route_table([&](RouteTable &routes) {
+    if (m == "GET" || m == "HEAD") {
+      ret = erase_routes(routes.get_handlers, pattern);
+    } else if (m == "POST") {
+      ret = erase_routes(routes.post_handlers, pattern) |
+            erase_routes(routes.post_handlers_for_content_reader, pattern);
+    } else if (m == "PUT") {
+      ret = erase_routes(routes.put_handlers, pattern) |
+            erase_routes(routes.put_handlers_for_content_reader, pattern);
+    } else if (m == "PATCH") {
+      ret = erase_routes(routes.patch_handlers, pattern) |
+            erase_routes(routes.patch_handlers_for_content_reader, pattern);
+    } else if (m == "DELETE") {
+      ret = erase_routes(routes.delete_handlers, pattern) |
+            erase_routes(routes.delete_handlers_for_content_reader, pattern);
+    } else if (m == "OPTIONS") {
+      ret = erase_routes(routes.options_handlers, pattern);
+    }
+  });
+  return ret;
 }
 
-inline Server &Server::set_file_request_handler(Handler handler) {
-  file_request_handler_ = std::move(handler);
+inline detail::epoch_ptr<Server::RouteTable>::reader
+Server::route_table() const {
+  return route_table_.read();
+}
 
-  return *this;
+template <typename Fn> inline void Server::update_route_table(Fn fn) {
+  std::lock_guard<std::mutex> guard(route_table_mutex_);
+  // Copying a route copies its handler and shares its compiled regex.
+  auto routes = detail::make_unique<RouteTable>(route_table_.current());
+  fn(*routes);
+  route_table_.publish(std::move(routes));
+}
+
+template <typename T>
+inline void Server::add_route(std::vector<Route<T>> RouteTable::*handlers,
+                              const char *pattern, size_t pattern_len,
+                              T handler) {
+  // Compiled outside of the writer lock.
+  Route<T> route{std::string(pattern, pattern_len),
+                 std::regex(pattern, pattern_len), std::move(handler)};
+  update_route_table([&](RouteTable &routes) {
+    (routes.*handlers).push_back(std::move(route));
+  });
+}
+
+template <typename T>
+inline bool Server::erase_routes(std::vector<Route<T>> &handlers,
+                                 const char *pattern) {
+  auto it = std::remove_if(
+      handlers.begin(), handlers.end(),
+      [&](const Route<T> &x) { return x.pattern == pattern; });
+  auto ret = it != handlers.end();
+  handlers.erase(it, handlers.end());
+  return ret;
+}
+
+inline Server &
+Server::set_file_extension_and_mimetype_mapping(const char *ext,
+                                                const char *mime) {
+  file_extension_and_mimetype_map_[ext] = mime;
+
+  return *this;
+}
+
+inline Server &Server::set_file_request_handler(Handler handler) {
+  file_request_handler_ = std::move(handler);
+
+  return *this;
+}
+
+inline Server &Server::set_file_content_handler(FileContentHandler handler) {
+  file_content_handler_ = std::move(handler);
+
+  return *this;
 }
 
 inline Server &Server::set_error_handler(HandlerWithResponse handler) {
@@ -4358,12 +5708,29 @@ inline Server &Server::set_post_routing_handler(Handler handler) {
   return *this;
 }
 
+inline Server &Server::set_pre_dispatch_handler(DispatchHandler handler) {
+  pre_dispatch_handler_ = std::move(handler);
+  return *this;
+}
+
 inline Server &Server::set_logger(Logger logger) {
   logger_ = std::move(logger);
 
   return *this;
 }
 
+inline Server &Server::set_compression_policy(CompressionPolicy policy) {
+  compression_policy_ = std::move(policy);
+
+  return *this;
+}
+
+inline Server &Server::set_compression_logger(CompressionLogger logger) {
+  compression_logger_ = std::move(logger);
+
+  return *this;
+}
+
 inline Server &
 Server::set_expect_100_continue_handler(Expect100ContinueHandler handler) {
   expect_100_continue_handler_ = std::move(handler);
@@ -4371,6 +5738,20 @@ Server::set_expect_100_continue_handler(Expect100ContinueHandler handler) {
   return *this;
 }
 
+inline Server &Server::set_buffered_header_parsing(bool on) {
+  buffered_header_parsing_ = on;
+  return *this;
+}
+
+inline Server &Server::set_acceptor_count(size_t count) {
+#if defined(__linux__) && defined(SO_REUSEPORT)
+  acceptor_count_ = count > 0 ? count : 1;
+#else
+  (void)count;
+#endif
+  return *this;
+}
+
 inline Server &Server::set_tcp_nodelay(bool on) {
   tcp_nodelay_ = on;
 
@@ -4436,7 +5817,13 @@ inline bool Server::listen(const char *host, int port, int socket_flags) {
   return bind_to_port(host, port, socket_flags) && listen_internal();
 }
 
-inline bool Server::is_running() const { return is_running_; }
+inline size_t Server::bound_acceptor_count() const {
+  return reuse_port_socks_.size() + 1;
+}
+
+inline bool Server::is_running() const {
+  return is_running_ || is_external_running_;
+}
 
 inline void Server::stop() {
   if (is_running_) {
@@ -4447,28 +5834,6 @@ inline void Server::stop() {
   }
 }
 
-inline bool Server::parse_request_line(const char *s, Request &req) {
-  const static std::regex re(
-      "(GET|HEAD|POST|PUT|DELETE|CONNECT|OPTIONS|TRACE|PATCH|PRI) "
-      "(([^? ]+)(?:\\?([^ ]*?))?) (HTTP/1\\.[01])\r\n");
-
-  std::cmatch m;
-  if (std::regex_match(s, m, re)) {
-    req.version = std::string(m[5]);
-    req.method = std::string(m[1]);
-    req.target = std::string(m[2]);
-    req.path = detail::decode_url(m[3], false);
-
-    // Parse query text
-    auto len = std::distance(m[4].first, m[4].second);
-    if (len > 0) { detail::parse_query_text(m[4], req.params); }
-
-    return true;
-  }
-
-  return false;
-}
-
 inline bool Server::write_response(Stream &strm, bool close_connection,
                                    const Request &req, Response &res) {
   return write_response_core(strm, close_connection, req, res, false);
@@ -4515,7 +5880,8 @@ inline bool Server::write_response_core(Stream &strm, bool close_connection,
     res.set_header("Content-Length", "0");
   }
 
-  if (!res.has_header("Accept-Ranges") && req.method == "HEAD") {
+  if (!res.has_header("Accept-Ranges") && req.method == "HEAD" &&
+      !res.has_header("Content-Encoding")) {
     res.set_header("Accept-Ranges", "bytes");
   }
 
@@ -4561,11 +5927,24 @@ Server::write_content_with_provider(Stream &strm, const Request &req,
                                     Response &res, const std::string &boundary,
                                     const std::string &content_type) {
   auto is_shutting_down = [this]() {
-    return this->svr_sock_ == INVALID_SOCKET;
+    return this->svr_sock_ == INVALID_SOCKET && !this->is_external_running_;
   };
 
   if (res.content_length_ > 0) {
-    if (req.ranges.empty()) {
+    if (res.content_provider_encoding_ != detail::EncodingType::None) {
+      // Compressed on the fly, the length isn't known anymore.
+      auto compressor = make_compressor(res.content_provider_encoding_);
+      auto length = res.content_length_;
+      const auto &provider = res.content_provider_;
+      ContentProvider chunked_provider = [&](size_t offset, size_t,
+                                             DataSink &sink) {
+        if (offset < length) { return provider(offset, length - offset, sink); }
+        sink.done();
+        return true;
+      };
+      return detail::write_content_chunked(strm, chunked_provider,
+                                           is_shutting_down, *compressor);
+    } else if (req.ranges.empty()) {
       return detail::write_content(strm, res.content_provider_, 0,
                                    res.content_length_, is_shutting_down);
     } else if (req.ranges.size() == 1) {
@@ -4581,20 +5960,7 @@ Server::write_content_with_provider(Stream &strm, const Request &req,
     }
   } else {
     if (res.is_chunked_content_provider_) {
-      auto type = detail::encoding_type(req, res);
-
-      std::unique_ptr<detail::compressor> compressor;
-      if (type == detail::EncodingType::Gzip) {
-#ifdef CPPHTTPLIB_ZLIB_SUPPORT
-        compressor = detail::make_unique<detail::gzip_compressor>();
-#endif
-      } else if (type == detail::EncodingType::Brotli) {
-#ifdef CPPHTTPLIB_BROTLI_SUPPORT
-        compressor = detail::make_unique<detail::brotli_compressor>();
-#endif
-      } else {
-        compressor = detail::make_unique<detail::nocompressor>();
-      }
+      auto compressor = make_compressor(res.content_provider_encoding_);
       assert(compressor != nullptr);
 
       return detail::write_content_chunked(strm, res.content_provider_,
@@ -4606,6 +5972,74 @@ Server::write_content_with_provider(Stream &strm, const Request &req,
   }
 }
 
+inline detail::EncodingType Server::compression_type(const Request &req,
+                                                     const Response &res,
+                                                     size_t length,
+                                                     bool &negotiated) const {
+  negotiated = false;
+
+  const auto &policy = compression_policy_;
+  if (!policy.enabled || res.has_header("Content-Encoding")) {
+    return detail::EncodingType::None;
+  }
+
+  if (length > 0 && length < policy.min_size) {
+    return detail::EncodingType::None;
+  }
+
+  const auto &content_type = res.get_header_value("Content-Type");
+  auto compressible =
+      policy.mime_types.empty()
+          ? detail::can_compress_content_type(content_type)
+          : detail::matches_content_type(policy.mime_types, content_type);
+  if (!compressible) { return detail::EncodingType::None; }
+
+  // Ranges are served from the identity representation, which another
+  // request for the same content may not get.
+  negotiated = true;
+  if (!req.ranges.empty()) { return detail::EncodingType::None; }
+
+  const auto &accept_encoding = req.get_header_value("Accept-Encoding");
+  (void)(accept_encoding);
+
+#ifdef CPPHTTPLIB_BROTLI_SUPPORT
+  if (detail::accepts_encoding(accept_encoding, "br")) {
+    return detail::EncodingType::Brotli;
+  }
+#endif
+
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+  if (detail::accepts_encoding(accept_encoding, "gzip")) {
+    return detail::EncodingType::Gzip;
+  }
+#endif
+
+  return detail::EncodingType::None;
+}
+
+inline std::unique_ptr<detail::compressor>
+Server::make_compressor(detail::EncodingType type) const {
+  std::unique_ptr<detail::compressor> compressor;
+  if (type == detail::EncodingType::Gzip) {
+#ifdef CPPHTTPLIB_ZLIB_SUPPORT
+    compressor =
+        detail::make_unique<detail::gzip_compressor>(compression_policy_.level);
+#endif
+  } else if (type == detail::EncodingType::Brotli) {
+#ifdef CPPHTTPLIB_BROTLI_SUPPORT
+    compressor = detail::make_unique<detail::brotli_compressor>();
+#endif
+  } else {
+    return detail::make_unique<detail::nocompressor>();
+  }
+
+  if (compressor && compression_logger_) {
+    compressor = detail::make_unique<detail::metered_compressor>(
+        std::move(compressor), compression_logger_);
+  }
+  return compressor;
+}
+
 inline bool Server::read_content(Stream &strm, Request &req, Response &res) {
   MultipartFormDataMap::iterator cur;
   if (read_content_core(
@@ -4652,7 +6086,10 @@ inline bool Server::read_content_core(Stream &strm, Request &req, Response &res,
   detail::MultipartFormDataParser multipart_form_data_parser;
   ContentReceiverWithProgress out;
 
-  if (req.is_multipart_form_data()) {
+  // Without multipart callbacks, multipart bodies are received as is.
+  const auto is_multipart = mulitpart_header && req.is_multipart_form_data();
+
+  if (is_multipart) {
     const auto &content_type = req.get_header_value("Content-Type");
     std::string boundary;
     if (!detail::parse_multipart_boundary(content_type, boundary)) {
@@ -4690,7 +6127,7 @@ inline bool Server::read_content_core(Stream &strm, Request &req, Response &res,
     return false;
   }
 
-  if (req.is_multipart_form_data()) {
+  if (is_multipart) {
     if (!multipart_form_data_parser.is_valid()) {
       res.status = 400;
       return false;
@@ -4700,9 +6137,10 @@ inline bool Server::read_content_core(Stream &strm, Request &req, Response &res,
   return true;
 }
 
-inline bool Server::handle_file_request(const Request &req, Response &res,
+inline bool Server::handle_file_request(const RouteTable &routes,
+                                        const Request &req, Response &res,
                                         bool head) {
-  for (const auto &entry : base_dirs_) {
+  for (const auto &entry : routes.base_dirs) {
     // Prefix match
     if (!req.path.compare(0, entry.mount_point.size(), entry.mount_point)) {
       std::string sub_path = "/" + req.path.substr(entry.mount_point.size());
@@ -4710,15 +6148,64 @@ inline bool Server::handle_file_request(const Request &req, Response &res,
         auto path = entry.base_dir + sub_path;
         if (path.back() == '/') { path += "index.html"; }
 
-        if (detail::is_file(path)) {
-          detail::read_file(path, res.body);
-          auto type =
-              detail::find_content_type(path, file_extension_and_mimetype_map_);
-          if (type) { res.set_header("Content-Type", type); }
+        size_t size = 0;
+        time_t mtime = 0;
+        if (detail::get_file_info(path, size, mtime)) {
           for (const auto &kv : entry.headers) {
             res.set_header(kv.first.c_str(), kv.second);
           }
-          res.status = req.has_header("Range") ? 206 : 200;
+
+          auto etag = detail::make_file_etag(size, mtime);
+          auto last_modified = detail::format_http_date(mtime);
+          res.set_header("ETag", etag);
+          res.set_header("Last-Modified", last_modified);
+
+          // If-None-Match takes precedence, If-Modified-Since is only
+          // evaluated without it (RFC 7232 section 6).
+          auto not_modified = false;
+          const char *coding = nullptr;
+          time_t since = 0;
+          if (req.has_header("If-None-Match")) {
+            not_modified = detail::etag_matches(
+                req.get_header_value("If-None-Match"), etag, &coding);
+          } else if (detail::parse_http_date(
+                         req.get_header_value("If-Modified-Since"), since)) {
+            not_modified = mtime <= since;
+          }
+
+          if (not_modified) {
+            // Validated with an encoded variant, its tag is sent back.
+            if (coding) {
+              detail::make_encoded_etag(res, coding);
+              detail::add_vary(res, "Accept-Encoding");
+            }
+            res.status = 304;
+            return true;
+          }
+
+          auto type =
+              detail::find_content_type(path, file_extension_and_mimetype_map_);
+
+          if (!file_content_handler_ ||
+              !file_content_handler_(req, res, {path, size, mtime, type})) {
+            auto mm = std::make_shared<detail::mmap>(path.c_str());
+            if (!mm->is_open()) { return false; }
+
+            if (mm->size() > 0) {
+              res.set_content_provider(
+                  mm->size(), type ? type : "application/octet-stream",
+                  [mm](size_t offset, size_t length, DataSink &sink) -> bool {
+                    if (!sink.send_file ||
+                        !sink.send_file(mm->fd(), offset, length)) {
+                      sink.write(mm->data() + offset, length);
+                    }
+                    return true;
+                  });
+            } else if (type) {
+              res.set_header("Content-Type", type);
+            }
+          }
+          res.status = 200;
           if (!head && file_request_handler_) {
             file_request_handler_(req, res);
           }
@@ -4751,7 +6238,20 @@ Server::create_server_socket(const char *host, int port, int socket_flags,
 inline int Server::bind_internal(const char *host, int port, int socket_flags) {
   if (!is_valid()) { return -1; }
 
-  svr_sock_ = create_server_socket(host, port, socket_flags, socket_options_);
+  auto socket_options = socket_options_;
+#if defined(__linux__) && defined(SO_REUSEPORT)
+  // All the acceptors must set it, whatever the socket options.
+  if (acceptor_count_ > 1) {
+    socket_options = [this](socket_t sock) {
+      if (socket_options_) { socket_options_(sock); }
+      int yes = 1;
+      setsockopt(sock, SOL_SOCKET, SO_REUSEPORT,
+                 reinterpret_cast<void *>(&yes), sizeof(yes));
+    };
+  }
+#endif
+
+  svr_sock_ = create_server_socket(host, port, socket_flags, socket_options);
   if (svr_sock_ == INVALID_SOCKET) { 
     UE_LOG(LogHttpLib, Error, TEXT("create_server_socket failed."));
     return -1; 
@@ -4766,16 +6266,41 @@ inline int Server::bind_internal(const char *host, int port, int socket_flags) {
       return -1;
     }
     if (addr.ss_family == AF_INET) {
-      return ntohs(reinterpret_cast<struct sockaddr_in *>(&addr)->sin_port);
+      port = ntohs(reinterpret_cast<struct sockaddr_in *>(&addr)->sin_port);
     } else if (addr.ss_family == AF_INET6) {
-      return ntohs(reinterpret_cast<struct sockaddr_in6 *>(&addr)->sin6_port);
+      port = ntohs(reinterpret_cast<struct sockaddr_in6 *>(&addr)->sin6_port);
     } else {
         UE_LOG(LogHttpLib, Error, TEXT("Invalid ss_family: %d"), addr.ss_family);
       return -1;
     }
-  } else {
-    return port;
   }
+
+  // The other acceptors join the port the first one got. If one can't,
+  // the server keeps the single acceptor it would have without them.
+  while (reuse_port_socks_.size() + 1 < acceptor_count_) {
+    auto sock = create_server_socket(host, port, socket_flags, socket_options);
+    if (sock == INVALID_SOCKET) {
+      UE_LOG(LogHttpLib, Warning,
+             TEXT("create_server_socket failed for acceptor %d, accepting "
+                  "on a single socket."),
+             static_cast<int>(reuse_port_socks_.size() + 2));
+      for (auto other : reuse_port_socks_) { detail::close_socket(other); }
+      reuse_port_socks_.clear();
+
+      // Alone, the first socket must not let others share its port.
+      detail::close_socket(svr_sock_);
+      svr_sock_ = create_server_socket(host, port, socket_flags,
+                                       socket_options_);
+      if (svr_sock_ == INVALID_SOCKET) {
+        UE_LOG(LogHttpLib, Error, TEXT("create_server_socket failed."));
+        return -1;
+      }
+      break;
+    }
+    reuse_port_socks_.push_back(sock);
+  }
+
+  return port;
 }
 
 inline bool Server::listen_internal() {
@@ -4785,6 +6310,18 @@ inline bool Server::listen_internal() {
   {
     std::unique_ptr<TaskQueue> task_queue(new_task_queue());
 
+    {
+      std::lock_guard<std::mutex> guard(deferred_executor_->mutex);
+      deferred_executor_->task_queue = task_queue.get();
+    }
+
+    // The other acceptors have their own task queue. Deferred responses are
+    // all resumed on the first one's.
+    std::vector<std::thread> acceptors;
+    for (auto sock : reuse_port_socks_) {
+      acceptors.emplace_back([this, sock]() { accept_connections(sock); });
+    }
+
     while (svr_sock_ != INVALID_SOCKET) {
 #ifndef _WIN32
       if (idle_interval_sec_ > 0 || idle_interval_usec_ > 0) {
@@ -4823,6 +6360,21 @@ inline bool Server::listen_internal() {
 #endif
     }
 
+    // Wakes the other acceptors up, their sockets are closed once they
+    // don't use them anymore.
+    for (auto sock : reuse_port_socks_) { detail::shutdown_socket(sock); }
+    for (auto &acceptor : acceptors) {
+      acceptor.join();
+    }
+    for (auto sock : reuse_port_socks_) { detail::close_socket(sock); }
+    reuse_port_socks_.clear();
+
+    // Deferred responses sent from now on close their connection.
+    {
+      std::lock_guard<std::mutex> guard(deferred_executor_->mutex);
+      deferred_executor_->task_queue = nullptr;
+    }
+
     task_queue->shutdown();
   }
 
@@ -4830,77 +6382,134 @@ inline bool Server::listen_internal() {
   return ret;
 }
 
+inline void Server::accept_connections(socket_t sock) {
+  std::unique_ptr<TaskQueue> task_queue(new_task_queue());
+
+  while (svr_sock_ != INVALID_SOCKET) {
+    if (idle_interval_sec_ > 0 || idle_interval_usec_ > 0) {
+      auto val = detail::select_read(sock, idle_interval_sec_,
+                                     idle_interval_usec_);
+      if (val == 0) { // Timeout
+        task_queue->on_idle();
+        continue;
+      }
+    }
+
+    socket_t client = accept(sock, nullptr, nullptr);
+
+    if (client == INVALID_SOCKET) {
+      if (errno == EMFILE) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        continue;
+      }
+      // Leaves the SO_REUSEPORT group so the kernel stops picking it.
+      detail::shutdown_socket(sock);
+      break;
+    }
+
+    task_queue->enqueue([this, client]() { process_and_close_socket(client); });
+  }
+
+  task_queue->shutdown();
+}
+
 inline bool Server::routing(Request &req, Response &res, Stream &strm) {
+  // Bodies of methods that don't expect one are never read. Left on the
+  // connection, they would be parsed as the next request.
+  if (!detail::expect_content(req) && detail::has_body(req)) {
+    req.content_unread_ = true;
+  }
+
   if (pre_routing_handler_ &&
       pre_routing_handler_(req, res) == HandlerResponse::Handled) {
+    // Answered before the body is read, the connection is closed after the
+    // response instead.
+    if (detail::has_body(req)) { req.content_unread_ = true; }
     return true;
   }
 
+  // Kept for the whole request, routes changed meanwhile apply to the next.
+  auto routes = route_table();
+
   // File handler
   bool is_head_request = req.method == "HEAD";
   if ((req.method == "GET" || is_head_request) &&
-      handle_file_request(req, res, is_head_request)) {
+      handle_file_request(*routes, req, res, is_head_request)) {
     return true;
   }
 
   if (detail::expect_content(req)) {
     // Content reader handler
     {
+      // Cleared once the handler read the whole body.
+      req.content_unread_ = true;
+
       ContentReader reader(
           [&](ContentReceiver receiver) {
-            return read_content_with_content_receiver(
+            auto ret = read_content_with_content_receiver(
                 strm, req, res, std::move(receiver), nullptr, nullptr);
+            req.content_unread_ = !ret;
+            return ret;
           },
           [&](MultipartContentHeader header, ContentReceiver receiver) {
-            return read_content_with_content_receiver(strm, req, res, nullptr,
-                                                      std::move(header),
-                                                      std::move(receiver));
+            auto ret = read_content_with_content_receiver(
+                strm, req, res, nullptr, std::move(header),
+                std::move(receiver));
+            req.content_unread_ = !ret;
+            return ret;
           });
 
       if (req.method == "POST") {
         if (dispatch_request_for_content_reader(
                 req, res, std::move(reader),
-                post_handlers_for_content_reader_)) {
+                routes->post_handlers_for_content_reader)) {
           return true;
         }
       } else if (req.method == "PUT") {
         if (dispatch_request_for_content_reader(
                 req, res, std::move(reader),
-                put_handlers_for_content_reader_)) {
+                routes->put_handlers_for_content_reader)) {
           return true;
         }
       } else if (req.method == "PATCH") {
         if (dispatch_request_for_content_reader(
                 req, res, std::move(reader),
-                patch_handlers_for_content_reader_)) {
+                routes->patch_handlers_for_content_reader)) {
           return true;
         }
       } else if (req.method == "DELETE") {
         if (dispatch_request_for_content_reader(
                 req, res, std::move(reader),
-                delete_handlers_for_content_reader_)) {
+                routes->delete_handlers_for_content_reader)) {
           return true;
         }
       }
     }
 
+    req.content_unread_ = false;
+
     // Read content into `req.body`
     if (!read_content(strm, req, res)) { return false; }
   }
 
+  if (pre_dispatch_handler_ &&
+      pre_dispatch_handler_(req, res) == HandlerResponse::Handled) {
+    return true;
+  }
+
   // Regular handler
   if (req.method == "GET" || req.method == "HEAD") {
-    return dispatch_request(req, res, get_handlers_);
+    return dispatch_request(req, res, routes->get_handlers);
   } else if (req.method == "POST") {
-    return dispatch_request(req, res, post_handlers_);
+    return dispatch_request(req, res, routes->post_handlers);
   } else if (req.method == "PUT") {
-    return dispatch_request(req, res, put_handlers_);
+    return dispatch_request(req, res, routes->put_handlers);
   } else if (req.method == "DELETE") {
-    return dispatch_request(req, res, delete_handlers_);
+    return dispatch_request(req, res, routes->delete_handlers);
   } else if (req.method == "OPTIONS") {
-    return dispatch_request(req, res, options_handlers_);
+    return dispatch_request(req, res, routes->options_handlers);
   } else if (req.method == "PATCH") {
-    return dispatch_request(req, res, patch_handlers_);
+    return dispatch_request(req, res, routes->patch_handlers);
   }
 
   res.status = 400;
@@ -4910,8 +6519,8 @@ inline bool Server::routing(Request &req, Response &res, Stream &strm) {
 inline bool Server::dispatch_request(Request &req, Response &res,
                                      const Handlers &handlers) {
   for (const auto &x : handlers) {
-    const auto &pattern = x.first;
-    const auto &handler = x.second;
+    const auto &pattern = x.regex;
+    const auto &handler = x.handler;
 
     if (std::regex_match(req.path, req.matches, pattern)) {
       handler(req, res);
@@ -4921,6 +6530,31 @@ inline bool Server::dispatch_request(Request &req, Response &res,
   return false;
 }
 
+inline void Server::resolve_ranges(Request &req, Response &res) {
+  auto length = res.body.empty() ? res.content_length_ : res.body.size();
+
+  if (!detail::normalize_ranges(req, res)) {
+    res.status = 416;
+    res.body.clear();
+    res.content_length_ = 0;
+    res.content_provider_ = nullptr;
+    res.is_chunked_content_provider_ = false;
+    res.set_header("Content-Range", "bytes */" + std::to_string(length));
+    return;
+  }
+
+  if (res.status == -1 || (res.status == 200 && !req.ranges.empty())) {
+    res.status = req.ranges.empty() ? 200 : 206;
+  }
+
+  // Sized content can be resumed, unless it's encoded: ranges are offsets
+  // of the identity content.
+  if (res.status == 200 && length > 0 && !res.has_header("Accept-Ranges") &&
+      !res.has_header("Content-Encoding")) {
+    res.set_header("Accept-Ranges", "bytes");
+  }
+}
+
 inline void Server::apply_ranges(const Request &req, Response &res,
                                  std::string &content_type,
                                  std::string &boundary) {
@@ -4937,10 +6571,31 @@ inline void Server::apply_ranges(const Request &req, Response &res,
                         "multipart/byteranges; boundary=" + boundary);
   }
 
-  auto type = detail::encoding_type(req, res);
+  auto negotiated = false;
+  auto type = compression_type(
+      req, res, res.body.empty() ? res.content_length_ : res.body.size(),
+      negotiated);
+  if (negotiated) { detail::add_vary(res, "Accept-Encoding"); }
+
+  if (type != detail::EncodingType::None && res.body.empty() &&
+      (res.content_length_ > 0 || res.is_chunked_content_provider_)) {
+    // Sized content is streamed as chunks once compressed, which
+    // HTTP/1.0 clients can't read.
+    if (res.content_length_ > 0 && req.version == "HTTP/1.0") {
+      type = detail::EncodingType::None;
+    }
+    res.content_provider_encoding_ = type;
+  }
 
   if (res.body.empty()) {
-    if (res.content_length_ > 0) {
+    if (res.content_provider_encoding_ != detail::EncodingType::None) {
+      auto coding = type == detail::EncodingType::Gzip ? "gzip" : "br";
+      res.set_header("Transfer-Encoding", "chunked");
+      res.set_header("Content-Encoding", coding);
+      detail::make_encoded_etag(res, coding);
+      // Offsets of the identity content, not of the chunks sent.
+      res.headers.erase("Accept-Ranges");
+    } else if (res.content_length_ > 0) {
       size_t length = 0;
       if (req.ranges.empty()) {
         length = res.content_length_;
@@ -4961,11 +6616,6 @@ inline void Server::apply_ranges(const Request &req, Response &res,
       if (res.content_provider_) {
         if (res.is_chunked_content_provider_) {
           res.set_header("Transfer-Encoding", "chunked");
-          if (type == detail::EncodingType::Gzip) {
-            res.set_header("Content-Encoding", "gzip");
-          } else if (type == detail::EncodingType::Brotli) {
-            res.set_header("Content-Encoding", "br");
-          }
         }
       }
     }
@@ -4998,20 +6648,7 @@ inline void Server::apply_ranges(const Request &req, Response &res,
     }
 
     if (type != detail::EncodingType::None) {
-      std::unique_ptr<detail::compressor> compressor;
-      std::string content_encoding;
-
-      if (type == detail::EncodingType::Gzip) {
-#ifdef CPPHTTPLIB_ZLIB_SUPPORT
-        compressor = detail::make_unique<detail::gzip_compressor>();
-        content_encoding = "gzip";
-#endif
-      } else if (type == detail::EncodingType::Brotli) {
-#ifdef CPPHTTPLIB_BROTLI_SUPPORT
-        compressor = detail::make_unique<detail::brotli_compressor>();
-        content_encoding = "br";
-#endif
-      }
+      auto compressor = make_compressor(type);
 
       if (compressor) {
         std::string compressed;
@@ -5020,8 +6657,11 @@ inline void Server::apply_ranges(const Request &req, Response &res,
                                    compressed.append(data, data_len);
                                    return true;
                                  })) {
+          auto coding = type == detail::EncodingType::Gzip ? "gzip" : "br";
           res.body.swap(compressed);
-          res.set_header("Content-Encoding", content_encoding);
+          res.set_header("Content-Encoding", coding);
+          detail::make_encoded_etag(res, coding);
+          res.headers.erase("Accept-Ranges");
         }
       }
     }
@@ -5035,8 +6675,8 @@ inline bool Server::dispatch_request_for_content_reader(
     Request &req, Response &res, ContentReader content_reader,
     const HandlersForContentReader &handlers) {
   for (const auto &x : handlers) {
-    const auto &pattern = x.first;
-    const auto &handler = x.second;
+    const auto &pattern = x.regex;
+    const auto &handler = x.handler;
 
     if (std::regex_match(req.path, req.matches, pattern)) {
       handler(req, res, content_reader);
@@ -5046,30 +6686,74 @@ inline bool Server::dispatch_request_for_content_reader(
   return false;
 }
 
+struct Server::DeferredConnection {
+  std::mutex mutex;
+  Request req;
+  Response res;
+  socket_t sock = INVALID_SOCKET;
+  bool close_connection = false;
+  size_t keep_alive_remaining = 0;
+  bool detached = false;
+  bool sent = false;
+  // Set when the request came from an external event loop.
+  std::function<void(std::string &&)> external_done;
+
+  ~DeferredConnection() {
+    // Never sent or sent after the server stopped.
+    if (sock != INVALID_SOCKET) {
+      detail::shutdown_socket(sock);
+      detail::close_socket(sock);
+    }
+  }
+};
+
 inline bool
 Server::process_request(Stream &strm, bool close_connection,
                         bool &connection_closed,
                         const std::function<void(Request &)> &setup_request) {
+  return process_request(strm, close_connection, connection_closed,
+                         setup_request, 0, nullptr, nullptr, nullptr);
+}
+
+inline bool
+Server::process_request(Stream &strm, bool close_connection,
+                        bool &connection_closed,
+                        const std::function<void(Request &)> &setup_request,
+                        size_t keep_alive_remaining, bool *detached,
+                        const std::function<void(std::string &&)> &external_done,
+                        detail::header_buffer *header_buf) {
   std::array<char, 2048> buf{};
 
   detail::stream_line_reader line_reader(strm, buf.data(), buf.size());
 
   // Connection has been closed on client
-  if (!line_reader.getline()) { return false; }
+  if (header_buf) {
+    if (!header_buf->read(strm) && !header_buf->exceeded()) { return false; }
+  } else if (!line_reader.getline()) {
+    return false;
+  }
 
   Request req;
   Response res;
 
   res.version = "HTTP/1.1";
 
+  // The rest of the headers is still on the connection, it can't be reused.
+  if (header_buf && header_buf->exceeded()) {
+    close_connection = true;
+    connection_closed = true;
+  }
+
 #ifdef _WIN32
   // TODO: Increase FD_SETSIZE statically (libzmq), dynamically (MySQL).
 #else
 #ifndef CPPHTTPLIB_USE_POLL
   // Socket file descriptor exceeded FD_SETSIZE...
   if (strm.socket() >= FD_SETSIZE) {
-    Headers dummy;
-    detail::read_headers(strm, dummy);
+    if (!header_buf) {
+      Headers dummy;
+      detail::read_headers(strm, dummy);
+    }
     res.status = 500;
     return write_response(strm, close_connection, req, res);
   }
@@ -5077,16 +6761,29 @@ Server::process_request(Stream &strm, bool close_connection,
 #endif
 
   // Check if the request URI doesn't exceed the limit
-  if (line_reader.size() > CPPHTTPLIB_REQUEST_URI_MAX_LENGTH) {
-    Headers dummy;
-    detail::read_headers(strm, dummy);
+  auto request_line_size =
+      header_buf ? header_buf->request_line_size() : line_reader.size();
+  if (request_line_size > CPPHTTPLIB_REQUEST_URI_MAX_LENGTH) {
+    if (!header_buf) {
+      Headers dummy;
+      detail::read_headers(strm, dummy);
+    }
     res.status = 414;
     return write_response(strm, close_connection, req, res);
   }
 
+  if (header_buf && header_buf->exceeded()) {
+    res.status = 431;
+    return write_response(strm, close_connection, req, res);
+  }
+
   // Request line and headers
-  if (!parse_request_line(line_reader.ptr(), req) ||
-      !detail::read_headers(strm, req.headers)) {
+  auto parsed = header_buf ? header_buf->parse(req)
+                           : detail::parse_request_line(
+                                 line_reader.ptr(),
+                                 line_reader.ptr() + line_reader.size(), req) &&
+                                 detail::read_headers(strm, req.headers);
+  if (!parsed) {
     res.status = 400;
     return write_response(strm, close_connection, req, res);
   }
@@ -5101,14 +6798,21 @@ Server::process_request(Stream &strm, bool close_connection,
   }
 
   strm.get_remote_ip_and_port(req.remote_addr, req.remote_port);
-  req.set_header("REMOTE_ADDR", req.remote_addr);
-  req.set_header("REMOTE_PORT", std::to_string(req.remote_port));
+  auto remote_port = std::to_string(req.remote_port);
+  if (!header_buf ||
+      !header_buf->add_header(req, "REMOTE_ADDR", req.remote_addr)) {
+    req.set_header("REMOTE_ADDR", req.remote_addr);
+  }
+  if (!header_buf ||
+      !header_buf->add_header(req, "REMOTE_PORT", remote_port)) {
+    req.set_header("REMOTE_PORT", remote_port);
+  }
 
+  // A malformed Range is ignored, the whole content is sent.
   if (req.has_header("Range")) {
     const auto &range_header_value = req.get_header_value("Range");
     if (!detail::parse_range_header(range_header_value, req.ranges)) {
-      res.status = 416;
-      return write_response(strm, close_connection, req, res);
+      req.ranges.clear();
     }
   }
 
@@ -5129,6 +6833,19 @@ Server::process_request(Stream &strm, bool close_connection,
     }
   }
 
+  std::shared_ptr<DeferredConnection> deferred;
+  if (detached) {
+    std::weak_ptr<DeferredExecutor> executor = deferred_executor_;
+    res.defer_handler_ = [&deferred, executor]() {
+      deferred = std::make_shared<DeferredConnection>();
+      auto conn = deferred;
+      return std::function<void(Response &)>(
+          [executor, conn](Response &final_res) {
+            send_deferred(executor, conn, final_res);
+          });
+    };
+  }
+
   // Rounting
   bool routed = false;
   //try {
@@ -5146,8 +6863,66 @@ Server::process_request(Stream &strm, bool close_connection,
     res.set_header("EXCEPTION_WHAT", "UNKNOWN");
   } */
 
+  res.defer_handler_ = nullptr;
+
+  // The rest of the body is still on the connection, it can't be reused.
+  if (req.content_unread_) {
+    close_connection = true;
+    connection_closed = true;
+  }
+
+  if (deferred) {
+    std::lock_guard<std::mutex> guard(deferred->mutex);
+    if (deferred->sent) {
+      // Already sent by the handler, write it on this thread.
+      res = std::move(deferred->res);
+    } else {
+      // The connection buffer is reused or released once detached.
+      detail::own_header_views(req);
+      deferred->req = std::move(req);
+      deferred->sock = strm.socket();
+      deferred->close_connection = close_connection || connection_closed;
+      deferred->keep_alive_remaining = keep_alive_remaining;
+      deferred->detached = true;
+      deferred->external_done = external_done;
+      *detached = true;
+      return true;
+    }
+  }
+
+  if (res.upgrade_handler_) {
+    auto handler = std::move(res.upgrade_handler_);
+    res.upgrade_handler_ = nullptr;
+
+    if (routed && detached && strm.socket() != INVALID_SOCKET) {
+      if (res.status == -1) { res.status = 101; }
+
+      detail::BufferStream bstrm;
+      if (!bstrm.write_format("HTTP/1.1 %d %s\r\n", res.status,
+                              detail::status_message(res.status)) ||
+          !detail::write_headers(bstrm, res.headers)) {
+        return false;
+      }
+
+      auto &data = bstrm.get_buffer();
+      if (!detail::write_data(strm, data.data(), data.size())) { return false; }
+
+      if (logger_) { logger_(req, res); }
+
+      // Nothing was read past the headers, the handler gets the first frame.
+      *detached = true;
+      handler(strm.socket());
+      return true;
+    }
+
+    res.status = 501;
+    res.headers.clear();
+    res.body.clear();
+    return write_response(strm, close_connection, req, res);
+  }
+
   if (routed) {
-    if (res.status == -1) { res.status = req.ranges.empty() ? 200 : 206; }
+    resolve_ranges(req, res);
     return write_response_with_content(strm, close_connection, req, res);
   } else {
     if (res.status == -1) { res.status = 404; }
@@ -5158,19 +6933,132 @@ Server::process_request(Stream &strm, bool close_connection,
 inline bool Server::is_valid() const { return true; }
 
 inline bool Server::process_and_close_socket(socket_t sock) {
+  return process_socket(sock, keep_alive_max_count_);
+}
+
+inline bool Server::process_socket(socket_t sock, size_t keep_alive_count) {
+  auto remaining = keep_alive_count;
+  auto detached = false;
+  detail::header_buffer header_buf;
   auto ret = detail::process_server_socket(
-      sock, keep_alive_max_count_, keep_alive_timeout_sec_, read_timeout_sec_,
+      sock, keep_alive_count, keep_alive_timeout_sec_, read_timeout_sec_,
       read_timeout_usec_, write_timeout_sec_, write_timeout_usec_,
-      [this](Stream &strm, bool close_connection, bool &connection_closed) {
-        return process_request(strm, close_connection, connection_closed,
-                               nullptr);
+      [&](Stream &strm, bool close_connection, bool &connection_closed) {
+        remaining--;
+        auto ret = process_request(
+            strm, close_connection, connection_closed, nullptr, remaining,
+            &detached, nullptr,
+            buffered_header_parsing_ ? &header_buf : nullptr);
+        // Leave the keep-alive loop, the socket now belongs to the
+        // deferred response.
+        if (detached) { connection_closed = true; }
+        return ret;
       });
 
-  detail::shutdown_socket(sock);
-  detail::close_socket(sock);
+  if (!detached) {
+    detail::shutdown_socket(sock);
+    detail::close_socket(sock);
+  }
   return ret;
 }
 
+inline void
+Server::send_deferred(const std::weak_ptr<DeferredExecutor> &executor,
+                      const std::shared_ptr<DeferredConnection> &conn,
+                      Response &res) {
+  {
+    std::lock_guard<std::mutex> guard(conn->mutex);
+    if (conn->sent) { return; }
+    conn->sent = true;
+    conn->res = std::move(res);
+
+    // The worker writes it when the handler returns.
+    if (!conn->detached) { return; }
+  }
+
+  if (auto exec = executor.lock()) {
+    std::lock_guard<std::mutex> guard(exec->mutex);
+    if (exec->task_queue) {
+      auto server = exec->server;
+      exec->task_queue->enqueue([server, conn]() { server->resume_deferred(conn); });
+      return;
+    }
+  }
+
+  // The server is stopped, the connection is closed with conn.
+}
+
+inline void
+Server::resume_deferred(const std::shared_ptr<DeferredConnection> &conn) {
+  auto sock = conn->sock;
+  conn->sock = INVALID_SOCKET;
+
+  auto &req = conn->req;
+  auto &res = conn->res;
+  resolve_ranges(req, res);
+
+  if (conn->external_done) {
+    detail::ExternalStream strm(nullptr, 0, req.remote_addr, req.remote_port);
+    write_response_with_content(strm, conn->close_connection, req, res);
+    conn->external_done(std::move(strm.get_output()));
+    return;
+  }
+
+  auto ret = false;
+  {
+    detail::SocketStream strm(sock, read_timeout_sec_, read_timeout_usec_,
+                              write_timeout_sec_, write_timeout_usec_);
+    ret = write_response_with_content(strm, conn->close_connection, req, res);
+  }
+
+  if (ret && !conn->close_connection && conn->keep_alive_remaining > 0) {
+    process_socket(sock, conn->keep_alive_remaining);
+  } else {
+    detail::shutdown_socket(sock);
+    detail::close_socket(sock);
+  }
+}
+
+inline void Server::set_external_task_queue(TaskQueue *task_queue) {
+  {
+    std::lock_guard<std::mutex> guard(deferred_executor_->mutex);
+    deferred_executor_->task_queue = task_queue;
+  }
+  is_external_running_ = task_queue != nullptr;
+}
+
+inline bool Server::process_external_request(
+    const char *data, size_t size, const std::string &remote_addr,
+    int remote_port, bool close_connection,
+    std::function<void(std::string &&)> done) {
+  detail::ExternalStream strm(data, size, remote_addr, remote_port);
+
+  auto connection_closed = false;
+  auto detached = false;
+
+  // The event loop already answered `Expect: 100-continue` to get the body.
+  auto ret = process_request(
+      strm, close_connection, connection_closed,
+      [](Request &req) { req.headers.erase("Expect"); }, 0, &detached, done,
+      nullptr);
+
+  if (!detached) { done(std::move(strm.get_output())); }
+
+  return ret && !close_connection && !connection_closed;
+}
+
+inline size_t Server::get_keep_alive_max_count() const {
+  return keep_alive_max_count_;
+}
+
+inline time_t Server::get_keep_alive_timeout() const {
+  return keep_alive_timeout_sec_;
+}
+
+inline size_t Server::get_payload_max_length() const {
+  return payload_max_length_;
+}
+
 // HTTP client implementation
 inline ClientImpl::ClientImpl(const std::string &host)
     : ClientImpl(host, 80, std::string(), std::string()) {}
@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CaptureFrameDeduplicator.h"
+
+void FCaptureFrameDeduplicator::ComputeSignature(const TArray<FColor>& Pixels, const int32 Width, const int32 Height, TArray<uint8>& OutSignature)
+{
+	const int32 TilesX = FMath::DivideAndRoundUp(Width,  TileSize);
+	const int32 TilesY = FMath::DivideAndRoundUp(Height, TileSize);
+
+	OutSignature.SetNumUninitialized(TilesX * TilesY * 3);
+
+	// FColor 在内存中是 BGRA，按 uint32 读取后 (P & 0x00FF00FF) 得到 B/R 两个 16 位通道，
+	// ((P >> 8) & 0x00FF00FF) 得到 G/A。16x16 的 tile 最大和为 256 * 255 = 65280，不会溢出 16 位，
+	// 所以一次加法同时累加两个通道 (SWAR)，内层循环编译器也能直接向量化。
+	TArray<uint32> SumBR;
+	TArray<uint32> SumGA;
+	SumBR.SetNumUninitialized(TilesX);
+	SumGA.SetNumUninitialized(TilesX);
+
+	const uint32* const Data = reinterpret_cast<const uint32*>(Pixels.GetData());
+
+	for (int32 TileY = 0; TileY < TilesY; ++TileY)
+	{
+		FMemory::Memzero(SumBR.GetData(), TilesX * sizeof(uint32));
+		FMemory::Memzero(SumGA.GetData(), TilesX * sizeof(uint32));
+
+		const int32 RowBegin = TileY * TileSize;
+		const int32 RowEnd   = FMath::Min(RowBegin + TileSize, Height);
+
+		for (int32 Y = RowBegin; Y < RowEnd; ++Y)
+		{
+			const uint32* const Row = Data + static_cast<int64>(Y) * Width;
+
+			for (int32 TileX = 0; TileX < TilesX; ++TileX)
+			{
+				const int32 ColBegin = TileX * TileSize;
+				const int32 ColEnd   = FMath::Min(ColBegin + TileSize, Width);
+
+				uint32 BR = 0;
+				uint32 GA = 0;
+				for (int32 X = ColBegin; X < ColEnd; ++X)
+				{
+					const uint32 P = Row[X];
+					BR += P & 0x00FF00FFu;
+					GA += (P >> 8) & 0x00FF00FFu;
+				}
+
+				SumBR[TileX] += BR;
+				SumGA[TileX] += GA;
+			}
+		}
+
+		const int32 TileRows = RowEnd - RowBegin;
+		for (int32 TileX = 0; TileX < TilesX; ++TileX)
+		{
+			const int32 TileCols = FMath::Min(TileX * TileSize + TileSize, Width) - TileX * TileSize;
+			const uint32 Count   = static_cast<uint32>(TileRows * TileCols);
+
+			uint8* const Out = &OutSignature[(TileY * TilesX + TileX) * 3];
+			Out[0] = static_cast<uint8>((SumBR[TileX] & 0xFFFFu) / Count); // B
+			Out[1] = static_cast<uint8>((SumGA[TileX] & 0xFFFFu) / Count); // G
+			Out[2] = static_cast<uint8>((SumBR[TileX] >> 16)     / Count); // R
+		}
+	}
+}
+
+bool FCaptureFrameDeduplicator::IsUnchanged(const TArray<FColor>& Pixels, const int32 Width, const int32 Height, const float Threshold)
+{
+	if (Width <= 0 || Height <= 0 || Pixels.Num() != Width * Height)
+	{
+		Reset();
+		return false;
+	}
+
+	TArray<uint8> NewSignature;
+	ComputeSignature(Pixels, Width, Height, NewSignature);
+
+	bool bUnchanged = Width == SignatureWidth && Height == SignatureHeight && Signature.Num() == NewSignature.Num();
+
+	if (bUnchanged)
+	{
+		// 取所有 tile 中变化最大的一个，局部运动（如画面里移动的物体）也能被检测到
+		const int32 MaxDifference = FMath::FloorToInt(Threshold * 3.f);
+
+		for (int32 Index = 0; Index < NewSignature.Num(); Index += 3)
+		{
+			const int32 Difference =
+				FMath::Abs(NewSignature[Index + 0] - Signature[Index + 0]) +
+				FMath::Abs(NewSignature[Index + 1] - Signature[Index + 1]) +
+				FMath::Abs(NewSignature[Index + 2] - Signature[Index + 2]);
+
+			if (Difference > MaxDifference)
+			{
+				bUnchanged = false;
+				break;
+			}
+		}
+	}
+
+	// 只和最后一次真正写入的帧比较，缓慢漂移累积到阈值后仍会写入新帧
+	if (!bUnchanged)
+	{
+		Signature       = MoveTemp(NewSignature);
+		SignatureWidth  = Width;
+		SignatureHeight = Height;
+		++ReferenceId;
+		PendingDuplicates = 0;
+		LastFilePath.Empty();
+	}
+	else if (IsWritePending())
+	{
+		// 参考帧还在写盘，先记下，写完后由 SetLastFilePath 返回
+		++PendingDuplicates;
+	}
+
+	return bUnchanged;
+}
+
+uint32 FCaptureFrameDeduplicator::GetReference() const
+{
+	return ReferenceId;
+}
+
+int32 FCaptureFrameDeduplicator::SetLastFilePath(const FString& FilePath, const uint32 Reference)
+{
+	if (Reference != ReferenceId)
+	{
+		return 0;
+	}
+
+	LastFilePath = FilePath;
+
+	const int32 Duplicates = PendingDuplicates;
+	PendingDuplicates = 0;
+	return Duplicates;
+}
+
+int32 FCaptureFrameDeduplicator::DiscardPendingWrite(const uint32 Reference)
+{
+	if (Reference != ReferenceId)
+	{
+		return 0;
+	}
+
+	const int32 Duplicates = PendingDuplicates;
+	Reset();
+	return Duplicates;
+}
+
+bool FCaptureFrameDeduplicator::IsWritePending() const
+{
+	return Signature.Num() > 0 && LastFilePath.IsEmpty();
+}
+
+const FString& FCaptureFrameDeduplicator::GetLastFilePath() const
+{
+	return LastFilePath;
+}
+
+void FCaptureFrameDeduplicator::Reset()
+{
+	Signature.Empty();
+	SignatureWidth  = 0;
+	SignatureHeight = 0;
+	++ReferenceId;
+	PendingDuplicates = 0;
+	LastFilePath.Empty();
+}
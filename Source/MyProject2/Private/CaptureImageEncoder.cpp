@@ -0,0 +1,426 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CaptureImageEncoder.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Math/RandomStream.h"
+#include "Modules/ModuleManager.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+THIRD_PARTY_INCLUDES_END
+
+namespace CapturePng
+{
+	static constexpr int32 BytesPerPixel = 4;
+
+	// 每个 band 至少这么多行，太小的 band 压缩率下降明显
+	static constexpr int32 MinRowsPerBand = 32;
+
+	static void WriteBigEndian(TArray64<uint8>& Out, const uint32 Value)
+	{
+		Out.Add(static_cast<uint8>(Value >> 24));
+		Out.Add(static_cast<uint8>(Value >> 16));
+		Out.Add(static_cast<uint8>(Value >> 8));
+		Out.Add(static_cast<uint8>(Value));
+	}
+
+	// 写一个 PNG chunk，数据可以由多段拼成（第一个 IDAT 带 zlib 头，最后一个带 Adler-32）
+	static void WriteChunk(TArray64<uint8>& Out, const char (&Type)[5], std::initializer_list<TArrayView64<const uint8>> Parts)
+	{
+		int64 Length = 0;
+		for (const TArrayView64<const uint8>& Part : Parts)
+		{
+			Length += Part.Num();
+		}
+
+		WriteBigEndian(Out, static_cast<uint32>(Length));
+
+		const uint8* const TypeBytes = reinterpret_cast<const uint8*>(Type);
+		Out.Append(TypeBytes, 4);
+
+		uLong Crc = crc32(0L, TypeBytes, 4);
+		for (const TArrayView64<const uint8>& Part : Parts)
+		{
+			Out.Append(Part.GetData(), Part.Num());
+			Crc = crc32(Crc, Part.GetData(), static_cast<uInt>(Part.Num()));
+		}
+
+		WriteBigEndian(Out, static_cast<uint32>(Crc));
+	}
+
+	static FORCEINLINE uint8 Paeth(const uint8 A, const uint8 B, const uint8 C)
+	{
+		const int32 P  = int32(A) + int32(B) - int32(C);
+		const int32 PA = FMath::Abs(P - int32(A));
+		const int32 PB = FMath::Abs(P - int32(B));
+		const int32 PC = FMath::Abs(P - int32(C));
+		return (PA <= PB && PA <= PC) ? A : (PB <= PC ? B : C);
+	}
+
+	// BGRA -> RGBA
+	static void ToRgba(const FColor* const Src, const int32 Width, uint8* const Dst)
+	{
+		for (int32 X = 0; X < Width; ++X)
+		{
+			Dst[X * 4 + 0] = Src[X].R;
+			Dst[X * 4 + 1] = Src[X].G;
+			Dst[X * 4 + 2] = Src[X].B;
+			Dst[X * 4 + 3] = Src[X].A;
+		}
+	}
+
+	static void ApplyFilter(const uint8 Filter, const uint8* const Row, const uint8* const Prior, const int32 RowBytes, uint8* const Out)
+	{
+		Out[0] = Filter;
+		uint8* const Dst = Out + 1;
+
+		for (int32 I = 0; I < RowBytes; ++I)
+		{
+			const uint8 A = I >= BytesPerPixel ? Row[I - BytesPerPixel] : 0;
+			const uint8 B = Prior ? Prior[I] : 0;
+			const uint8 C = (Prior && I >= BytesPerPixel) ? Prior[I - BytesPerPixel] : 0;
+
+			switch (Filter)
+			{
+			case 0: Dst[I] = Row[I];												  break;
+			case 1: Dst[I] = static_cast<uint8>(Row[I] - A);						  break;
+			case 2: Dst[I] = static_cast<uint8>(Row[I] - B);						  break;
+			case 3: Dst[I] = static_cast<uint8>(Row[I] - ((int32(A) + int32(B)) >> 1)); break;
+			case 4: Dst[I] = static_cast<uint8>(Row[I] - Paeth(A, B, C));			  break;
+			}
+		}
+	}
+
+	static uint64 FilterCost(const uint8* const Filtered, const int32 RowBytes)
+	{
+		// 与 libpng 一致的启发式：有符号字节绝对值之和最小
+		uint64 Cost = 0;
+		for (int32 I = 0; I < RowBytes; ++I)
+		{
+			Cost += static_cast<uint64>(FMath::Abs(static_cast<int32>(static_cast<int8>(Filtered[I]))));
+		}
+		return Cost;
+	}
+
+	// 为一行选择代价最小的滤波器，结果写到 Out (1 + RowBytes)
+	static void FilterRow(const uint8* const Row, const uint8* const Prior, const int32 RowBytes, uint8* const Out, uint8* const Scratch)
+	{
+		ApplyFilter(0, Row, Prior, RowBytes, Out);
+		uint64 BestCost = FilterCost(Out + 1, RowBytes);
+
+		for (uint8 Filter = 1; Filter <= 4; ++Filter)
+		{
+			ApplyFilter(Filter, Row, Prior, RowBytes, Scratch);
+
+			const uint64 Cost = FilterCost(Scratch + 1, RowBytes);
+			if (Cost < BestCost)
+			{
+				BestCost = Cost;
+				FMemory::Memcpy(Out, Scratch, RowBytes + 1);
+			}
+		}
+	}
+
+	struct FBand
+	{
+		TArray64<uint8> Compressed;
+		uLong			Adler		= 1;
+		int64			RawLength	= 0;
+		bool			bSucceeded	= false;
+	};
+
+	static void EncodeBand(const TArray<FColor>& Pixels, const int32 Width, const int32 RowBegin, const int32 RowEnd,
+		const bool bLastBand, const int32 CompressionLevel, FBand& OutBand)
+	{
+		const int32 RowBytes	= Width * BytesPerPixel;
+		const int64 StrideBytes = RowBytes + 1;
+
+		TArray64<uint8> Filtered;
+		Filtered.SetNumUninitialized(StrideBytes * (RowEnd - RowBegin));
+
+		TArray<uint8> Prior;
+		TArray<uint8> Current;
+		TArray<uint8> Scratch;
+		Prior  .SetNumUninitialized(RowBytes);
+		Current.SetNumUninitialized(RowBytes);
+		Scratch.SetNumUninitialized(RowBytes + 1);
+
+		// 第一行的 Up/Avg/Paeth 需要上一个 band 的最后一行
+		const bool bHasPriorBand = RowBegin > 0;
+		if (bHasPriorBand)
+		{
+			ToRgba(&Pixels[(RowBegin - 1) * Width], Width, Prior.GetData());
+		}
+
+		for (int32 Y = RowBegin; Y < RowEnd; ++Y)
+		{
+			ToRgba(&Pixels[Y * Width], Width, Current.GetData());
+
+			const bool bHasPrior = Y > RowBegin || bHasPriorBand;
+			FilterRow(Current.GetData(), bHasPrior ? Prior.GetData() : nullptr, RowBytes, &Filtered[StrideBytes * (Y - RowBegin)], Scratch.GetData());
+
+			Swap(Prior, Current);
+		}
+
+		OutBand.RawLength = Filtered.Num();
+		OutBand.Adler	  = adler32(adler32(0L, Z_NULL, 0), Filtered.GetData(), static_cast<uInt>(Filtered.Num()));
+
+		// 独立的 raw deflate 流：非最后一个 band 用 Z_SYNC_FLUSH 结束在字节边界且不设 BFINAL，
+		// 这样所有 band 直接拼接就是一个合法的 deflate 流
+		z_stream Stream;
+		FMemory::Memzero(Stream);
+
+		if (deflateInit2(&Stream, CompressionLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		{
+			return;
+		}
+
+		OutBand.Compressed.SetNumUninitialized(deflateBound(&Stream, static_cast<uLong>(Filtered.Num())) + 16);
+
+		Stream.next_in	 = Filtered.GetData();
+		Stream.avail_in	 = static_cast<uInt>(Filtered.Num());
+
+		const int32 Flush = bLastBand ? Z_FINISH : Z_SYNC_FLUSH;
+		int32 Result	  = Z_OK;
+		int64 Written	  = 0;
+
+		do
+		{
+			if (Written == OutBand.Compressed.Num())
+			{
+				OutBand.Compressed.SetNumUninitialized(OutBand.Compressed.Num() * 2);
+			}
+
+			Stream.next_out	 = OutBand.Compressed.GetData() + Written;
+			Stream.avail_out = static_cast<uInt>(OutBand.Compressed.Num() - Written);
+
+			Result = deflate(&Stream, Flush);
+
+			Written = OutBand.Compressed.Num() - Stream.avail_out;
+		}
+		while (Result == Z_OK && (bLastBand || Stream.avail_in > 0 || Stream.avail_out == 0));
+
+		deflateEnd(&Stream);
+
+		OutBand.Compressed.SetNum(Written, false);
+		OutBand.bSucceeded = bLastBand ? Result == Z_STREAM_END : (Result == Z_OK || Result == Z_BUF_ERROR) && Stream.avail_in == 0;
+	}
+
+	static uint8 ZlibHeaderLevelFlag(const int32 CompressionLevel)
+	{
+		// FLG 字段（FLEVEL 只是提示），保证 (CMF << 8 | FLG) % 31 == 0
+		if (CompressionLevel <= 1) return 0x01;
+		if (CompressionLevel <= 5) return 0x5E;
+		if (CompressionLevel == 6) return 0x9C;
+		return 0xDA;
+	}
+}
+
+bool FCaptureImageEncoder::EncodePng(const TArray<FColor>& Pixels, const int32 Width, const int32 Height, const ECapturePngEncoder Encoder, TArray64<uint8>& OutPng)
+{
+	switch (Encoder)
+	{
+	case ECapturePngEncoder::Parallel:		return EncodePngParallel(Pixels, Width, Height, OutPng);
+	case ECapturePngEncoder::ImageWrapper:	return EncodePngWithImageWrapper(Pixels, Width, Height, OutPng);
+	}
+
+	return false;
+}
+
+bool FCaptureImageEncoder::EncodePngWithImageWrapper(const TArray<FColor>& Pixels, const int32 Width, const int32 Height, TArray64<uint8>& OutPng)
+{
+	IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+	TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+
+	// 直接声明 BGRA 8 位
+	if (!ImageWrapper.IsValid() || !ImageWrapper->SetRaw(Pixels.GetData(), Pixels.Num() * sizeof(FColor), Width, Height, ERGBFormat::BGRA, 8))
+	{
+		return false;
+	}
+
+	OutPng = ImageWrapper->GetCompressed(100);
+
+	return OutPng.Num() > 0;
+}
+
+bool FCaptureImageEncoder::EncodePngParallel(const TArray<FColor>& Pixels, const int32 Width, const int32 Height, TArray64<uint8>& OutPng,
+	const int32 CompressionLevel, int32 NumBands)
+{
+	using namespace CapturePng;
+
+	if (Width <= 0 || Height <= 0 || Pixels.Num() != Width * Height)
+	{
+		return false;
+	}
+
+	const int32 Level = FMath::Clamp(CompressionLevel, 1, 9);
+
+	if (NumBands <= 0)
+	{
+		NumBands = FMath::Max(1, FTaskGraphInterface::Get().GetNumWorkerThreads() * 2);
+	}
+	NumBands = FMath::Clamp(NumBands, 1, FMath::Max(1, Height / MinRowsPerBand));
+
+	TArray<FBand> Bands;
+	Bands.SetNum(NumBands);
+
+	ParallelFor(NumBands, [&](const int32 BandIndex)
+	{
+		const int32 RowBegin = static_cast<int32>(static_cast<int64>(Height) *  BandIndex	   / NumBands);
+		const int32 RowEnd	 = static_cast<int32>(static_cast<int64>(Height) * (BandIndex + 1) / NumBands);
+
+		EncodeBand(Pixels, Width, RowBegin, RowEnd, BandIndex == NumBands - 1, Level, Bands[BandIndex]);
+	});
+
+	uLong Adler = Bands[0].Adler;
+	for (int32 BandIndex = 0; BandIndex < NumBands; ++BandIndex)
+	{
+		if (!Bands[BandIndex].bSucceeded)
+		{
+			return false;
+		}
+
+		if (BandIndex > 0)
+		{
+			Adler = adler32_combine(Adler, Bands[BandIndex].Adler, static_cast<z_off_t>(Bands[BandIndex].RawLength));
+		}
+	}
+
+	static const uint8 Signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	uint8 Header[13];
+	Header[0]  = static_cast<uint8>(Width  >> 24);
+	Header[1]  = static_cast<uint8>(Width  >> 16);
+	Header[2]  = static_cast<uint8>(Width  >> 8);
+	Header[3]  = static_cast<uint8>(Width);
+	Header[4]  = static_cast<uint8>(Height >> 24);
+	Header[5]  = static_cast<uint8>(Height >> 16);
+	Header[6]  = static_cast<uint8>(Height >> 8);
+	Header[7]  = static_cast<uint8>(Height);
+	Header[8]  = 8; // Bit depth
+	Header[9]  = 6; // RGBA
+	Header[10] = 0; // Deflate
+	Header[11] = 0; // Adaptive filtering
+	Header[12] = 0; // No interlace
+
+	const uint8 ZlibHeader[2]  = { 0x78, ZlibHeaderLevelFlag(Level) };
+	const uint8 ZlibTrailer[4] =
+	{
+		static_cast<uint8>(Adler >> 24), static_cast<uint8>(Adler >> 16),
+		static_cast<uint8>(Adler >> 8),  static_cast<uint8>(Adler)
+	};
+
+	int64 TotalSize = sizeof(Signature) + 25 + 12 + sizeof(ZlibHeader) + sizeof(ZlibTrailer);
+	for (const FBand& Band : Bands)
+	{
+		TotalSize += Band.Compressed.Num() + 12;
+	}
+
+	OutPng.Reset(TotalSize);
+	OutPng.Append(Signature, sizeof(Signature));
+
+	WriteChunk(OutPng, "IHDR", { TArrayView64<const uint8>(Header, sizeof(Header)) });
+
+	// 一个 band 一个 IDAT，第一个带 zlib 头，最后一个带 Adler-32
+	for (int32 BandIndex = 0; BandIndex < NumBands; ++BandIndex)
+	{
+		const bool bFirst = BandIndex == 0;
+		const bool bLast  = BandIndex == NumBands - 1;
+
+		WriteChunk(OutPng, "IDAT",
+		{
+			TArrayView64<const uint8>(ZlibHeader, bFirst ? sizeof(ZlibHeader) : 0),
+			TArrayView64<const uint8>(Bands[BandIndex].Compressed),
+			TArrayView64<const uint8>(ZlibTrailer, bLast ? sizeof(ZlibTrailer) : 0)
+		});
+	}
+
+	WriteChunk(OutPng, "IEND", {});
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// 基准测试：Capture.BenchmarkPngEncoders [Width] [Height] [Iterations]
+
+static void BenchmarkPngEncoders(const TArray<FString>& Args)
+{
+	const int32 Width	   = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 3840;
+	const int32 Height	   = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 2160;
+	const int32 Iterations = Args.Num() > 2 ? FMath::Max(1, FCString::Atoi(*Args[2])) : 3;
+
+	if (Width <= 0 || Height <= 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: Capture.BenchmarkPngEncoders [Width] [Height] [Iterations]"));
+		return;
+	}
+
+	// 渐变加噪声，接近真实渲染画面的可压缩程度
+	TArray<FColor> Pixels;
+	Pixels.SetNumUninitialized(Width * Height);
+
+	FRandomStream Random(1337);
+	for (int32 Y = 0; Y < Height; ++Y)
+	{
+		for (int32 X = 0; X < Width; ++X)
+		{
+			const int32 Noise = Random.RandRange(-6, 6);
+			Pixels[Y * Width + X] = FColor(
+				static_cast<uint8>(FMath::Clamp(X * 255 / Width + Noise, 0, 255)),
+				static_cast<uint8>(FMath::Clamp(Y * 255 / Height + Noise, 0, 255)),
+				static_cast<uint8>(FMath::Clamp((X + Y) * 255 / (Width + Height) + Noise, 0, 255)),
+				255);
+		}
+	}
+
+	const auto Measure = [&](const ECapturePngEncoder Encoder, TArray64<uint8>& OutPng) -> double
+	{
+		double Best = TNumericLimits<double>::Max();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			const double Start = FPlatformTime::Seconds();
+			if (!FCaptureImageEncoder::EncodePng(Pixels, Width, Height, Encoder, OutPng))
+			{
+				return -1.0;
+			}
+			Best = FMath::Min(Best, FPlatformTime::Seconds() - Start);
+		}
+		return Best * 1000.0;
+	};
+
+	TArray64<uint8> ImageWrapperPng;
+	TArray64<uint8> ParallelPng;
+
+	const double ImageWrapperMs = Measure(ECapturePngEncoder::ImageWrapper, ImageWrapperPng);
+	const double ParallelMs		= Measure(ECapturePngEncoder::Parallel,		ParallelPng);
+
+	// 用 ImageWrapper 解码并逐像素比较，确认并行编码结果正确
+	bool bRoundTrip = false;
+	{
+		IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+		TSharedPtr<IImageWrapper> Decoder = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+
+		TArray64<uint8> Decoded;
+		if (Decoder.IsValid() && Decoder->SetCompressed(ParallelPng.GetData(), ParallelPng.Num()) && Decoder->GetRaw(ERGBFormat::BGRA, 8, Decoded))
+		{
+			bRoundTrip = Decoded.Num() == Pixels.Num() * sizeof(FColor) && FMemory::Memcmp(Decoded.GetData(), Pixels.GetData(), Decoded.Num()) == 0;
+		}
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("PNG %dx%d, best of %d: ImageWrapper %.1f ms (%lld bytes), Parallel %.1f ms (%lld bytes), speedup %.2fx, round-trip %s."),
+		Width, Height, Iterations,
+		ImageWrapperMs, ImageWrapperPng.Num(),
+		ParallelMs, ParallelPng.Num(),
+		ParallelMs > 0.0 ? ImageWrapperMs / ParallelMs : 0.0,
+		bRoundTrip ? TEXT("OK") : TEXT("FAILED"));
+}
+
+static FAutoConsoleCommand BenchmarkPngEncodersCommand(
+	TEXT("Capture.BenchmarkPngEncoders"),
+	TEXT("Compares the IImageWrapper PNG encoder with the parallel one. Args: [Width] [Height] [Iterations]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkPngEncoders));
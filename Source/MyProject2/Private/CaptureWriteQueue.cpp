@@ -0,0 +1,217 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CaptureWriteQueue.h"
+
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+
+namespace CaptureWriteQueue
+{
+	// 每个优先级保留最近的样本数，用来计算 p50/p99
+	static constexpr int32 MaxSamples = 1024;
+
+	static float Percentile(TArray<float> Samples, const float Fraction)
+	{
+		if (Samples.Num() == 0)
+		{
+			return 0.f;
+		}
+
+		Samples.Sort();
+		const int32 Index = FMath::Clamp(FMath::CeilToInt(Fraction * Samples.Num()) - 1, 0, Samples.Num() - 1);
+		return Samples[Index];
+	}
+}
+
+FCaptureWriteQueue& FCaptureWriteQueue::Get()
+{
+	static FCaptureWriteQueue Instance;
+	return Instance;
+}
+
+FCaptureWriteQueue::FCaptureWriteQueue()
+	: MaxRunningJobs(FMath::Max(2, FPlatformMisc::NumberOfCoresIncludingHyperthreads() / 2))
+	, BulkSlotsUnderLoad(1)
+{
+}
+
+FCaptureWriteQueue::FLane& FCaptureWriteQueue::GetLane(const ECapturePriority Priority)
+{
+	return Priority == ECapturePriority::Interactive ? Interactive : Bulk;
+}
+
+const FCaptureWriteQueue::FLane& FCaptureWriteQueue::GetLane(const ECapturePriority Priority) const
+{
+	return Priority == ECapturePriority::Interactive ? Interactive : Bulk;
+}
+
+void FCaptureWriteQueue::SetConcurrency(const int32 InMaxRunningJobs, const int32 InBulkSlotsUnderLoad)
+{
+	FScopeLock Lock(&Mutex);
+
+	MaxRunningJobs	   = FMath::Max(2, InMaxRunningJobs);
+	BulkSlotsUnderLoad = FMath::Clamp(InBulkSlotsUnderLoad, 0, MaxRunningJobs - 1);
+
+	UE_LOG(LogTemp, Display, TEXT("Capture write queue: %d jobs at once, %d bulk while interactive work is pending."), MaxRunningJobs, BulkSlotsUnderLoad);
+
+	StartJobs();
+}
+
+void FCaptureWriteQueue::Enqueue(const ECapturePriority Priority, TUniqueFunction<void()> Job)
+{
+	FScopeLock Lock(&Mutex);
+
+	FLane& Lane = GetLane(Priority);
+	Lane.Jobs.Enqueue(FJob{ MoveTemp(Job), FPlatformTime::Seconds() });
+	Lane.Queued++;
+
+	StartJobs();
+}
+
+void FCaptureWriteQueue::StartJobs()
+{
+	while (Interactive.Running + Bulk.Running < MaxRunningJobs)
+	{
+		ECapturePriority Priority;
+
+		// 交互拍照永远先于排队中的批量任务
+		if (Interactive.Queued > 0)
+		{
+			Priority = ECapturePriority::Interactive;
+		}
+		else if (Bulk.Queued > 0)
+		{
+			// 始终为交互任务保留一个槽位；有交互任务排队或在跑时批量任务进一步限流
+			const bool  bUnderLoad = Interactive.Queued + Interactive.Running > 0;
+			const int32 BulkLimit  = bUnderLoad ? BulkSlotsUnderLoad : MaxRunningJobs - 1;
+
+			if (Bulk.Running >= BulkLimit)
+			{
+				break;
+			}
+
+			Priority = ECapturePriority::Bulk;
+		}
+		else
+		{
+			break;
+		}
+
+		FLane& Lane = GetLane(Priority);
+
+		FJob Job;
+		Lane.Jobs.Dequeue(Job);
+		Lane.Queued--;
+		Lane.Running++;
+
+		const ENamedThreads::Type Thread = Priority == ECapturePriority::Interactive
+			? ENamedThreads::AnyBackgroundHiPriTask
+			: ENamedThreads::AnyBackgroundThreadNormalTask;
+
+		AsyncTask(Thread, [this, Priority, Job = MoveTemp(Job)]() mutable
+		{
+			RunJob(Priority, MoveTemp(Job));
+		});
+	}
+}
+
+void FCaptureWriteQueue::RunJob(const ECapturePriority Priority, FJob Job)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	Job.Work();
+
+	const double EndTime = FPlatformTime::Seconds();
+
+	FScopeLock Lock(&Mutex);
+
+	FLane& Lane = GetLane(Priority);
+	Lane.Running--;
+	Lane.Completed++;
+
+	const float QueueWaitMs = static_cast<float>((StartTime - Job.EnqueueTime) * 1000.0);
+	const float TotalMs		= static_cast<float>((EndTime   - Job.EnqueueTime) * 1000.0);
+
+	if (Lane.TotalMs.Num() < CaptureWriteQueue::MaxSamples)
+	{
+		Lane.QueueWaitMs.Add(QueueWaitMs);
+		Lane.TotalMs	.Add(TotalMs);
+	}
+	else
+	{
+		Lane.QueueWaitMs[Lane.NextSample] = QueueWaitMs;
+		Lane.TotalMs	[Lane.NextSample] = TotalMs;
+	}
+	Lane.NextSample = (Lane.NextSample + 1) % CaptureWriteQueue::MaxSamples;
+
+	StartJobs();
+}
+
+FCaptureQueueStats FCaptureWriteQueue::GetStats(const ECapturePriority Priority) const
+{
+	TArray<float> QueueWaitMs;
+	TArray<float> TotalMs;
+
+	FCaptureQueueStats Stats;
+	{
+		FScopeLock Lock(&Mutex);
+
+		const FLane& Lane = GetLane(Priority);
+		Stats.Completed = Lane.Completed;
+		Stats.Queued	= Lane.Queued;
+		Stats.Running	= Lane.Running;
+
+		QueueWaitMs = Lane.QueueWaitMs;
+		TotalMs		= Lane.TotalMs;
+	}
+
+	Stats.QueueWaitP50Ms = CaptureWriteQueue::Percentile(QueueWaitMs, 0.50f);
+	Stats.QueueWaitP99Ms = CaptureWriteQueue::Percentile(QueueWaitMs, 0.99f);
+	Stats.TotalP50Ms	 = CaptureWriteQueue::Percentile(TotalMs, 0.50f);
+	Stats.TotalP99Ms	 = CaptureWriteQueue::Percentile(TotalMs, 0.99f);
+	Stats.TotalMaxMs	 = CaptureWriteQueue::Percentile(TotalMs, 1.00f);
+
+	return Stats;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Capture.QueueStats
+
+static void LogCaptureQueueStats()
+{
+	for (const ECapturePriority Priority : { ECapturePriority::Interactive, ECapturePriority::Bulk })
+	{
+		const FCaptureQueueStats Stats = FCaptureWriteQueue::Get().GetStats(Priority);
+
+		UE_LOG(LogTemp, Display, TEXT("%-11s completed %lld, queued %d, running %d, wait p50 %.1f ms p99 %.1f ms, total p50 %.1f ms p99 %.1f ms max %.1f ms"),
+			Priority == ECapturePriority::Interactive ? TEXT("Interactive") : TEXT("Bulk"),
+			Stats.Completed, Stats.Queued, Stats.Running,
+			Stats.QueueWaitP50Ms, Stats.QueueWaitP99Ms,
+			Stats.TotalP50Ms, Stats.TotalP99Ms, Stats.TotalMaxMs);
+	}
+}
+
+static FAutoConsoleCommand CaptureQueueStatsCommand(
+	TEXT("Capture.QueueStats"),
+	TEXT("Logs per priority class latency of the capture encode/write queue."),
+	FConsoleCommandDelegate::CreateStatic(&LogCaptureQueueStats));
+
+//////////////////////////////////////////////////////////////////////////
+// Capture.SetQueueConcurrency
+
+static void SetCaptureQueueConcurrency(const TArray<FString>& Args)
+{
+	if (Args.Num() < 2)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Usage: Capture.SetQueueConcurrency <MaxRunningJobs> <BulkSlotsUnderLoad>"));
+		return;
+	}
+
+	FCaptureWriteQueue::Get().SetConcurrency(FCString::Atoi(*Args[0]), FCString::Atoi(*Args[1]));
+}
+
+static FAutoConsoleCommand SetCaptureQueueConcurrencyCommand(
+	TEXT("Capture.SetQueueConcurrency"),
+	TEXT("Sets the slots of the capture encode/write queue, applied to the next jobs. Args: <MaxRunningJobs> (at least 2) <BulkSlotsUnderLoad> (bulk jobs running while interactive work is pending)"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&SetCaptureQueueConcurrency));
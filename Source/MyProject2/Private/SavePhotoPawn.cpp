@@ -2,6 +2,8 @@
 
 
 #include "SavePhotoPawn.h"
+#include "CaptureImageEncoder.h"
+#include "CaptureWriteQueue.h"
 #include "Engine/TextureRenderTarget2D.h"
 #include "Components/SceneCaptureComponent2D.h"
 #include "Async/Async.h"
@@ -169,14 +171,14 @@ void ASavePhotoPawn::SetupPlayerInputComponent(UInputComponent* PlayerInputCompo
 //////////////////////////////////////////////////////////////////////////
 // 1) 外部调用的延迟拍照接口
 
-void ASavePhotoPawn::RequestSaveImage(const FString& SavePath, const FString& FileName, bool bOverride, bool Debug)
+void ASavePhotoPawn::RequestSaveImage(const FString& SavePath, const FString& FileName, bool bOverride, bool Debug, ECapturePriority Priority)
 {
     // 保证在 GameThread 中执行
     if (!IsInGameThread())
     {
-        AsyncTask(ENamedThreads::GameThread, [this, SavePath, FileName, bOverride, Debug]()
+        AsyncTask(ENamedThreads::GameThread, [this, SavePath, FileName, bOverride, Debug, Priority]()
         {
-            RequestSaveImage(SavePath, FileName, bOverride, Debug);
+            RequestSaveImage(SavePath, FileName, bOverride, Debug, Priority);
         });
         return;
     }
@@ -187,9 +189,9 @@ void ASavePhotoPawn::RequestSaveImage(const FString& SavePath, const FString& Fi
         FTimerHandle DummyHandle;
         // 延迟到下一帧执行 SaveImage，避免当前帧 PostTick 阶段操作组件
         World->GetTimerManager().SetTimerForNextTick(
-            FTimerDelegate::CreateWeakLambda(this, [this, SavePath, FileName, bOverride, Debug]()
+            FTimerDelegate::CreateWeakLambda(this, [this, SavePath, FileName, bOverride, Debug, Priority]()
             {
-                SaveImage(SavePath, FileName, bOverride, Debug);
+                SaveImage(SavePath, FileName, bOverride, Debug, Priority);
             })
         );
     }
@@ -210,14 +212,14 @@ void ASavePhotoPawn::RequestSaveImage(const FString& SavePath, const FString& Fi
 #include "Misc/FileHelper.h"
 
 // 复制这段到你的 ASavePhotoPawn.cpp
-void ASavePhotoPawn::SaveImage(const FString& SavePath, const FString& FileName, bool bOverride, bool Debug)
+void ASavePhotoPawn::SaveImage(const FString& SavePath, const FString& FileName, bool bOverride, bool Debug, ECapturePriority Priority)
 {
     if (!IsInGameThread())
     {
         // 如果在非GameThread调用，切回GameThread
-        AsyncTask(ENamedThreads::GameThread, [this, SavePath, FileName, bOverride, Debug]()
+        AsyncTask(ENamedThreads::GameThread, [this, SavePath, FileName, bOverride, Debug, Priority]()
         {
-            this->SaveImage(SavePath, FileName, bOverride, Debug);
+            this->SaveImage(SavePath, FileName, bOverride, Debug, Priority);
         });
         return;
     }
@@ -255,32 +257,6 @@ void ASavePhotoPawn::SaveImage(const FString& SavePath, const FString& FileName,
     // 确保 GPU 渲染完成，否则可能读到空数据
     FlushRenderingCommands();
 
-    // 拼接完整文件名，改为 PNG 后缀
-    FString FullFilePath;
-    if (bOverride)
-    {
-        FullFilePath = FPaths::Combine(SavePath, FileName + TEXT(".png"));
-    }
-    else
-    {
-        int32 FileIndex = LastFileIndex;
-        do
-        {
-            FullFilePath = FPaths::Combine(
-                SavePath, 
-                FString::Printf(TEXT("%s_%d%d%d%d.png"), *FileName, 0, 0, 0, FileIndex)
-            );
-            FileIndex++;
-        } while (FPaths::FileExists(FullFilePath));
-        LastFileIndex = FileIndex;
-    }
-
-    if (FullFilePath.IsEmpty())
-    {
-        UE_LOG(LogTemp, Error, TEXT("File path is empty!"));
-        return;
-    }
-
     // 读取 Float16 像素（跟BMP版一致）
     FTextureRenderTargetResource* RTResource = RenderTarget->GameThread_GetRenderTargetResource();
     if (!RTResource)
@@ -324,36 +300,106 @@ void ASavePhotoPawn::SaveImage(const FString& SavePath, const FString& FileName,
         LDRBitmap.Add(Linear.ToFColor(true));
     }
 
-    // 后台线程写 PNG，避免卡主线程
-    AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [this, FullFilePath, LDRBitmap = MoveTemp(LDRBitmap), Debug, Width, Height]()
+    // 悬停时连续帧几乎相同：与上一次写入的帧比较，变化低于阈值时不编码也不写盘，直接引用上一张
+    if (bSkipUnchangedFrames && FrameDeduplicator.IsUnchanged(LDRBitmap, Width, Height, UnchangedFrameThreshold))
     {
-        IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
-        TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
-
-        // 直接声明 BGRA 8 位
-        if (ImageWrapper.IsValid() && ImageWrapper->SetRaw(
-            LDRBitmap.GetData(),
-            LDRBitmap.Num() * sizeof(FColor),
-            Width, Height,
-            ERGBFormat::BGRA, 8))
+        // 上一张还在写盘，写完后再广播
+        if (FrameDeduplicator.IsWritePending())
+        {
+            if (Debug)
+            {
+                UE_LOG(LogTemp, Warning, TEXT("Frame unchanged, waiting for the previous frame to be written"));
+            }
+            return;
+        }
+
+        const FString& PreviousFilePath = FrameDeduplicator.GetLastFilePath();
+        if (Debug)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Frame unchanged, reusing: %s"), *PreviousFilePath);
+        }
+        OnImageSaved.Broadcast(PreviousFilePath, true);
+        return;
+    }
+
+    // 拼接完整文件名，改为 PNG 后缀
+    FString FullFilePath;
+    if (bOverride)
+    {
+        FullFilePath = FPaths::Combine(SavePath, FileName + TEXT(".png"));
+    }
+    else
+    {
+        int32 FileIndex = LastFileIndex;
+        do
+        {
+            FullFilePath = FPaths::Combine(
+                SavePath, 
+                FString::Printf(TEXT("%s_%d%d%d%d.png"), *FileName, 0, 0, 0, FileIndex)
+            );
+            FileIndex++;
+        } while (FPaths::FileExists(FullFilePath));
+        LastFileIndex = FileIndex;
+    }
+
+    if (FullFilePath.IsEmpty())
+    {
+        UE_LOG(LogTemp, Error, TEXT("File path is empty!"));
+        FrameDeduplicator.Reset();
+        return;
+    }
+
+    // 写盘成功后才记录路径，写入期间的相同帧在写完后一并广播
+    const uint32 Reference = FrameDeduplicator.GetReference();
+
+    // 后台线程写 PNG，避免卡主线程；交互拍照优先于批量采集
+    FCaptureWriteQueue::Get().Enqueue(Priority, [WeakThis = TWeakObjectPtr<ASavePhotoPawn>(this), FullFilePath, LDRBitmap = MoveTemp(LDRBitmap), Debug, Width, Height, Encoder = PngEncoder, Reference]()
+    {
+        // 大图用并行编码器，按行分带并发 deflate
+        TArray64<uint8> PNGData;
+        if (FCaptureImageEncoder::EncodePng(LDRBitmap, Width, Height, Encoder, PNGData))
         {
-            const TArray64<uint8>& PNGData = ImageWrapper->GetCompressed(100);
             if (FFileHelper::SaveArrayToFile(PNGData, *FullFilePath))
             {
                 if (Debug)
                 {
                     UE_LOG(LogTemp, Warning, TEXT("Saved PNG image to: %s"), *FullFilePath);
                 }
+
+                AsyncTask(ENamedThreads::GameThread, [WeakThis, FullFilePath, Reference]()
+                {
+                    if (ASavePhotoPawn* const Pawn = WeakThis.Get())
+                    {
+                        const int32 Duplicates = Pawn->FrameDeduplicator.SetLastFilePath(FullFilePath, Reference);
+                        Pawn->OnImageSaved.Broadcast(FullFilePath, false);
+                        for (int32 Index = 0; Index < Duplicates; ++Index)
+                        {
+                            Pawn->OnImageSaved.Broadcast(FullFilePath, true);
+                        }
+                    }
+                });
+                return;
             }
-            else
-            {
-                UE_LOG(LogTemp, Error, TEXT("Failed to save PNG to: %s"), *FullFilePath);
-            }
+
+            UE_LOG(LogTemp, Error, TEXT("Failed to save PNG to: %s"), *FullFilePath);
         }
         else
         {
             UE_LOG(LogTemp, Error, TEXT("Failed to encode PNG image!"));
         }
+
+        // 写入失败，下一帧重新写盘，等待中的相同帧一起丢弃
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, Reference]()
+        {
+            if (ASavePhotoPawn* const Pawn = WeakThis.Get())
+            {
+                const int32 Duplicates = Pawn->FrameDeduplicator.DiscardPendingWrite(Reference);
+                if (Duplicates > 0)
+                {
+                    UE_LOG(LogTemp, Error, TEXT("Dropped %d unchanged frames of the failed capture"), Duplicates);
+                }
+            }
+        });
     });
 }
 
@@ -369,6 +415,11 @@ void ASavePhotoPawn::SaveImage(const FString& SavePath, const FString& FileName,
 
 
 
+FCaptureQueueStats ASavePhotoPawn::GetCaptureQueueStats(ECapturePriority Priority)
+{
+	return FCaptureWriteQueue::Get().GetStats(Priority);
+}
+
 void ASavePhotoPawn::Print(const FString& Target)
 {
 	if (GEngine)
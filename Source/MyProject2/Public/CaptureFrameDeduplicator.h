@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Cheap change detector for consecutive captures of the same camera.
+ * A frame is reduced to a grid of per-tile channel averages and compared
+ * against the signature of the last frame that was actually written.
+ */
+class MYPROJECT2_API FCaptureFrameDeduplicator
+{
+public:
+	// Tile edge in pixels. 16x16 keeps the per-tile sums inside 16 bits.
+	static constexpr int32 TileSize = 16;
+
+	/**
+	 * Checks if a frame is close enough to the last accepted frame to be skipped.
+	 * When it is not, the frame becomes the new reference.
+	 * A frame matching a reference that is still being written is counted as
+	 * a duplicate of it, see SetLastFilePath.
+	 * @param Pixels    The BGRA pixels, Width * Height entries.
+	 * @param Width     The frame width.
+	 * @param Height    The frame height.
+	 * @param Threshold The largest per-tile mean difference (0-255) still considered unchanged.
+	 * @return True if the frame is unchanged and doesn't need to be written.
+	*/
+	bool IsUnchanged(const TArray<FColor>& Pixels, const int32 Width, const int32 Height, const float Threshold);
+
+	/**
+	 * Identifies the current reference frame, changes with it.
+	*/
+	uint32 GetReference() const;
+
+	/**
+	 * Remembers the file written for a reference frame, once it was written.
+	 * @param FilePath  The file.
+	 * @param Reference The reference frame it was written for, ignored if it was replaced since.
+	 * @return The number of skipped frames that matched the reference while it was written.
+	*/
+	int32 SetLastFilePath(const FString& FilePath, const uint32 Reference);
+
+	/**
+	 * Forgets a reference frame that failed to be written, the next frame will be written.
+	 * @param Reference The reference frame, ignored if it was replaced since.
+	 * @return The number of skipped frames that matched the reference while it was written.
+	*/
+	int32 DiscardPendingWrite(const uint32 Reference);
+
+	/**
+	 * Checks if the current reference frame is still being written.
+	*/
+	bool IsWritePending() const;
+
+	/**
+	 * Gets the file written for the current reference frame.
+	*/
+	const FString& GetLastFilePath() const;
+
+	/**
+	 * Forgets the reference frame, the next frame will always be written.
+	*/
+	void Reset();
+
+private:
+	static void ComputeSignature(const TArray<FColor>& Pixels, const int32 Width, const int32 Height, TArray<uint8>& OutSignature);
+
+private:
+	// 3 bytes (B, G, R averages) per tile.
+	TArray<uint8> Signature;
+
+	int32 SignatureWidth  = 0;
+	int32 SignatureHeight = 0;
+
+	uint32 ReferenceId = 0;
+
+	// Frames skipped while the reference was being written.
+	int32 PendingDuplicates = 0;
+
+	FString LastFilePath;
+};
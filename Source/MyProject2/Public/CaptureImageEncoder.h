@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CaptureImageEncoder.generated.h"
+
+/**
+ * The PNG encoder used to write captures.
+ */
+UENUM(BlueprintType)
+enum class ECapturePngEncoder : uint8
+{
+	// Single threaded libpng encode through IImageWrapper.
+	ImageWrapper,
+	// Row bands filtered and deflated concurrently, joined into one zlib stream.
+	Parallel
+};
+
+/**
+ * Encodes captured frames to PNG.
+ */
+class MYPROJECT2_API FCaptureImageEncoder
+{
+public:
+	/**
+	 * Encodes BGRA pixels to an RGBA PNG.
+	 * @param Pixels  The pixels, Width * Height entries.
+	 * @param Width   The image width.
+	 * @param Height  The image height.
+	 * @param Encoder The encoder to use.
+	 * @param OutPng  The encoded PNG file content.
+	 * @return True if the image was encoded.
+	*/
+	static bool EncodePng(const TArray<FColor>& Pixels, const int32 Width, const int32 Height, const ECapturePngEncoder Encoder, TArray64<uint8>& OutPng);
+
+	/**
+	 * Encodes through IImageWrapper. Must not be called before the ImageWrapper module can be loaded.
+	*/
+	static bool EncodePngWithImageWrapper(const TArray<FColor>& Pixels, const int32 Width, const int32 Height, TArray64<uint8>& OutPng);
+
+	/**
+	 * Encodes by splitting the image in row bands deflated concurrently (pigz-style).
+	 * Every band is an independent raw deflate stream ended on a byte boundary,
+	 * the bands are concatenated into a single zlib stream with a combined Adler-32.
+	 * @param CompressionLevel The zlib level, 1 (fastest) to 9 (smallest).
+	 * @param NumBands		   The band count, 0 to pick one from the worker count.
+	*/
+	static bool EncodePngParallel(const TArray<FColor>& Pixels, const int32 Width, const int32 Height, TArray64<uint8>& OutPng,
+		const int32 CompressionLevel = 6, int32 NumBands = 0);
+};
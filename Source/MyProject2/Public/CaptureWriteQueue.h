@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "CaptureWriteQueue.generated.h"
+
+/**
+ * Priority class of a capture.
+ */
+UENUM(BlueprintType)
+enum class ECapturePriority : uint8
+{
+	// Operator-triggered photo, jumps ahead of queued bulk work.
+	Interactive,
+	// Dataset capture, throttled while interactive work is pending.
+	Bulk
+};
+
+/**
+ * Latency statistics of one priority class, in milliseconds.
+ * Percentiles are computed over the most recent jobs.
+ */
+USTRUCT(BlueprintType)
+struct MYPROJECT2_API FCaptureQueueStats
+{
+	GENERATED_BODY()
+
+	// Jobs completed since startup
+	UPROPERTY(BlueprintReadOnly, Category = "Capture")
+	int64 Completed = 0;
+
+	// Jobs waiting for a slot
+	UPROPERTY(BlueprintReadOnly, Category = "Capture")
+	int32 Queued = 0;
+
+	// Jobs currently encoding or writing
+	UPROPERTY(BlueprintReadOnly, Category = "Capture")
+	int32 Running = 0;
+
+	// Time spent waiting in the queue
+	UPROPERTY(BlueprintReadOnly, Category = "Capture")
+	float QueueWaitP50Ms = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Capture")
+	float QueueWaitP99Ms = 0.f;
+
+	// Time from enqueue to the file being written
+	UPROPERTY(BlueprintReadOnly, Category = "Capture")
+	float TotalP50Ms = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Capture")
+	float TotalP99Ms = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Capture")
+	float TotalMaxMs = 0.f;
+};
+
+/**
+ * Encode/write stage of the capture pipeline, shared by every capture pawn.
+ * Interactive jobs always start before queued bulk jobs, one slot is kept free
+ * for interactive work and bulk concurrency drops to BulkSlotsUnderLoad while
+ * interactive jobs are queued or running.
+ */
+class MYPROJECT2_API FCaptureWriteQueue
+{
+public:
+	static FCaptureWriteQueue& Get();
+
+	/**
+	 * Queues a job running on a background thread.
+	 * @param Priority The priority class of the job.
+	 * @param Job	   The encode and write work.
+	*/
+	void Enqueue(const ECapturePriority Priority, TUniqueFunction<void()> Job);
+
+	/**
+	 * Gets the latency statistics of a priority class.
+	*/
+	FCaptureQueueStats GetStats(const ECapturePriority Priority) const;
+
+	/**
+	 * Sets the slot counts, also exposed as Capture.SetQueueConcurrency.
+	 * @param InMaxRunningJobs	   Jobs running at the same time, all classes.
+	 * @param InBulkSlotsUnderLoad Bulk jobs allowed to run while interactive work is pending.
+	*/
+	void SetConcurrency(const int32 InMaxRunningJobs, const int32 InBulkSlotsUnderLoad);
+
+private:
+	FCaptureWriteQueue();
+
+	struct FJob
+	{
+		TUniqueFunction<void()> Work;
+		double					EnqueueTime = 0.0;
+	};
+
+	struct FLane
+	{
+		TQueue<FJob>	Jobs;
+		int32			Queued	  = 0;
+		int32			Running	  = 0;
+		int64			Completed = 0;
+
+		// Most recent samples, ring buffers.
+		TArray<float>	QueueWaitMs;
+		TArray<float>	TotalMs;
+		int32			NextSample = 0;
+	};
+
+	// Starts as many queued jobs as the slots allow. Mutex must be held.
+	void StartJobs();
+	void RunJob(const ECapturePriority Priority, FJob Job);
+
+	FLane& GetLane(const ECapturePriority Priority);
+	const FLane& GetLane(const ECapturePriority Priority) const;
+
+private:
+	mutable FCriticalSection Mutex;
+
+	FLane Interactive;
+	FLane Bulk;
+
+	int32 MaxRunningJobs;
+	int32 BulkSlotsUnderLoad;
+};
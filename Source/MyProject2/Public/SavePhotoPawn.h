@@ -4,8 +4,15 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Pawn.h"
+#include "CaptureFrameDeduplicator.h"
+#include "CaptureImageEncoder.h"
+#include "CaptureWriteQueue.h"
 #include "SavePhotoPawn.generated.h"
 
+// Called once a capture has been handled. bReusedPreviousFrame is true when the frame
+// was skipped as unchanged and FilePath points to the previously written image.
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnCaptureImageSaved, const FString&, FilePath, bool, bReusedPreviousFrame);
+
 UCLASS()
 class MYPROJECT2_API ASavePhotoPawn : public APawn
 {
@@ -31,6 +38,22 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Capture")
 	USceneCaptureComponent2D* SceneCaptureComponent;
 
+	// Skip encoding and writing captures that barely differ from the last written one
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture|Deduplication")
+	bool bSkipUnchangedFrames = false;
+
+	// Largest per-tile mean color difference (0-255) still treated as an unchanged frame
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture|Deduplication", meta = (ClampMin = "0.0", ClampMax = "255.0", EditCondition = "bSkipUnchangedFrames"))
+	float UnchangedFrameThreshold = 2.0f;
+
+	// Encoder used by SaveImage. Parallel splits the image in row bands deflated concurrently
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture")
+	ECapturePngEncoder PngEncoder = ECapturePngEncoder::ImageWrapper;
+
+	// Broadcast on the game thread after a capture was written or skipped
+	UPROPERTY(BlueprintAssignable, Category = "Capture")
+	FOnCaptureImageSaved OnImageSaved;
+
 	// Timer for capture function
 	FTimerHandle CaptureTimerHandle;
 	
@@ -43,9 +66,12 @@ public:
 
 	//316
 	UFUNCTION(BlueprintCallable, Category = "Screenshot")
-	void SaveImage(const FString& SavePath, const FString& FileName,bool bOverride, bool Debug);
+	void SaveImage(const FString& SavePath, const FString& FileName,bool bOverride, bool Debug, ECapturePriority Priority = ECapturePriority::Bulk);
 	UFUNCTION(BlueprintCallable, Category = "Screenshot")
-	void RequestSaveImage(const FString& SavePath, const FString& FileName, bool bOverride, bool Debug);
+	void RequestSaveImage(const FString& SavePath, const FString& FileName, bool bOverride, bool Debug, ECapturePriority Priority = ECapturePriority::Bulk);
+	// Latency of the shared encode/write queue for a priority class
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Screenshot")
+	static FCaptureQueueStats GetCaptureQueueStats(ECapturePriority Priority);
 	static void Print(const FString& Target);
 	UFUNCTION(BlueprintCallable, Category = "Screenshot")
 	void SaveHighResImage(const FString& SavePath, const FString& FileName, bool bOverride, bool Debug);
@@ -55,4 +81,7 @@ private:
 	UTextureRenderTarget2D* RenderTarget;
 
 	int32 LastFileIndex = 1;
+
+	// 与上一次写入帧做差分，用于悬停时跳过重复帧
+	FCaptureFrameDeduplicator FrameDeduplicator;
 };